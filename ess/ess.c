@@ -8,11 +8,13 @@
  */
 
 #include "ess.h"
+#include "error.h"
+#include "checkpoint.h"
 
 
 
-FILE *refSet_history_file;
-FILE *best_sols_history_file;
+HistLog *refSet_history_log;
+HistLog *best_sols_history_log;
 FILE *freqs_matrix_file;
 FILE *freq_mat_final_file;
 FILE *prob_mat_final_file;
@@ -40,23 +42,54 @@ void init_eSS(eSSType *eSSParams, void *inp, void *out, char *inname){
 
 	print_Inputs(eSSParams);
 
-	if (!eSSParams->warmStart)
+	/**
+	 * It sets to 0 at first, and then increments until it hits the 100. Because we don't wanted
+	 * to spend time and checking archive members that are not already assigned!
+	 */
+	eSSParams->archiveSet->size = 0;
+	eSSParams->archive_index = 0;
+
+	eSSParams->checkpoint_filename = (char *)calloc(MAX_RECORD + 1, sizeof(char));
+	sprintf(eSSParams->checkpoint_filename, "%s.ckpt", inname);
+
+	if (eSSParams->perform_resume)
+	{
+		/**
+		 * Everything, including the random generator, comes from the checkpoint
+		 */
+		restore_Checkpoint(eSSParams);
+	}
+	else if (!eSSParams->warmStart)
 	{
 		init_scatterSet(eSSParams, inp, out);
 
-		evaluate_Set(eSSParams, eSSParams->scatterSet, inp, out);
+		if (!eSSParams->perform_screening)
+			evaluate_Set(eSSParams, eSSParams->scatterSet, inp, out);
+		else if (!screen_Set(eSSParams, eSSParams->scatterSet, inp, out)){
+			warning("init_eSS: solver has no single precision version, no screening");
+			eSSParams->perform_screening = 0;
+		}
 
 		init_refSet(eSSParams, inp, out);
 
+		/**
+		 * The refSet was picked by the screening costs, now it gets the exact ones
+		 */
+		if (eSSParams->perform_screening){
+			int n;
+			double rho = rescore_Set(eSSParams, eSSParams->refSet, HUGE_VAL, inp, out, &n);
+			printf("Screening: rank agreement of single and double precision costs %.3f (%d sets)\n", rho, n);
+		}
+
 		quickSort_Set(eSSParams, eSSParams->refSet, 0, eSSParams->refSet->size - 1, 'c');
 
-		write_Set(eSSParams, eSSParams->refSet, refSet_history_file, 0);
+		log_Set(eSSParams, eSSParams->refSet, refSet_history_log, 0);
 
 		eSSParams->best = &(eSSParams->refSet->members[0]);
 
 		// print_Set(eSSParams, eSSParams->refSet, 1);
 
-		write_Ind(eSSParams, eSSParams->best, best_sols_history_file, 0);
+		log_Ind(eSSParams, eSSParams->best, best_sols_history_log, 0);
 	}else{
 		printf("Perform Warm Start...\n");
 
@@ -79,21 +112,30 @@ void run_eSS(eSSType *eSSParams, void *inp, void *out, char *inname){
 	int label[eSSParams->n_refSet];
 	
 	int candidate_index;
+	Set *candidates;
 
 	int n_currentUpdated;
 
-	int archive_index = 0;
-
-	/**
-	 * It sets to 0 at first, and then increments until it hits the 100. Because we don't wanted
-	 * to spend time and checking archive members that are not already assigned!
-	 */
-	eSSParams->archiveSet->size = 0;
+	for (int i = 0; i < eSSParams->n_refSet; ++i)
+		label[i] = 0;
 
 	printf("Starting the optimization....\n\n");
-	for (eSSParams->iter = 1; eSSParams->iter < eSSParams->maxiter; ++eSSParams->iter)
+	for (eSSParams->iter = (eSSParams->perform_resume ? eSSParams->iter + 1 : 1); 
+			eSSParams->iter < eSSParams->maxiter; ++eSSParams->iter)
 	{
 		n_currentUpdated = 0;
+
+		/**
+		 * The candidates only depend on the refSet at the start of the iteration, so unless they
+		 * are screened, all of them are generated and evaluated at once.
+		 */
+		if ( !(eSSParams->perform_screening && eSSParams->iter <= eSSParams->screen_iters) ){
+			recombine_Set(eSSParams, inp, out);
+			candidates = eSSParams->recombinedSet;
+		}
+		else
+			candidates = eSSParams->candidateSet;
+
 		// int i_lCandidate = 0;
 		for (int i = 0; i < eSSParams->n_refSet; ++i)
 		{
@@ -104,7 +146,10 @@ void run_eSS(eSSType *eSSParams, void *inp, void *out, char *inname){
 			/**
 			 * TODO: Implement the flatzone and diversity detection routines.
 			 */
-			candidate_index = recombine(eSSParams, &(eSSParams->refSet->members[i]), i, inp, out);
+			if (candidates == eSSParams->recombinedSet)
+				candidate_index = pick_Candidate(eSSParams, i);
+			else
+				candidate_index = recombine(eSSParams, &(eSSParams->refSet->members[i]), i, inp, out);
 
 			if (-1 != candidate_index){
 				
@@ -113,7 +158,7 @@ void run_eSS(eSSType *eSSParams, void *inp, void *out, char *inname){
 				label[i] = 1;
 				n_currentUpdated++;
 
-				copy_Ind(eSSParams, &(eSSParams->childsSet->members[i]), &(eSSParams->candidateSet->members[candidate_index]));
+				copy_Ind(eSSParams, &(eSSParams->childsSet->members[i]), &(candidates->members[candidate_index]));
 
 				/**
 				 * goBeyond for already selected candidate from recombinedSet which is copied to 
@@ -191,14 +236,14 @@ void run_eSS(eSSType *eSSParams, void *inp, void *out, char *inname){
 				if (eSSParams->refSet->members[i].nStuck > eSSParams->maxStuck ){
 					/* Add the stuck individual to the archiveSet */
 
-					if (archive_index == 100)
-						archive_index = 0;
+					if (eSSParams->archive_index == 100)
+						eSSParams->archive_index = 0;
 
-					if (archive_index < 100 && eSSParams->archiveSet->size < 100)
+					if (eSSParams->archive_index < 100 && eSSParams->archiveSet->size < 100)
 						eSSParams->archiveSet->size++;
 
-					copy_Ind(eSSParams, &(eSSParams->archiveSet->members[archive_index]), &(eSSParams->refSet->members[i]));
-					archive_index++;
+					copy_Ind(eSSParams, &(eSSParams->archiveSet->members[eSSParams->archive_index]), &(eSSParams->refSet->members[i]));
+					eSSParams->archive_index++;
 
 					random_Ind(eSSParams, &(eSSParams->refSet->members[i]), 
 										eSSParams->min_real_var, eSSParams->max_real_var);
@@ -215,6 +260,11 @@ void run_eSS(eSSType *eSSParams, void *inp, void *out, char *inname){
 		
 		quickSort_Set(eSSParams, eSSParams->refSet, 0, eSSParams->n_refSet - 1, 'c');
 
+		if (eSSParams->perform_screening && eSSParams->iter <= eSSParams->screen_iters &&
+			(eSSParams->iter == eSSParams->screen_iters || eSSParams->iter == eSSParams->maxiter - 1))
+			printf("Screening: rank agreement of single and double precision costs %.3f (%d candidates)\n",
+				eSSParams->screen_n ? eSSParams->screen_rho / eSSParams->screen_n : 1., eSSParams->screen_n);
+
 		/**
 		 * Apply the local search on the best solution
 		 */
@@ -225,8 +275,8 @@ void run_eSS(eSSType *eSSParams, void *inp, void *out, char *inname){
 		}
 
 		if (eSSParams->iter % eSSParams->inter_save == 0){
-			write_Set(eSSParams, eSSParams->refSet, refSet_history_file, eSSParams->iter);
-			write_Ind(eSSParams, eSSParams->best, best_sols_history_file, eSSParams->iter);
+			log_Set(eSSParams, eSSParams->refSet, refSet_history_log, eSSParams->iter);
+			log_Ind(eSSParams, eSSParams->best, best_sols_history_log, eSSParams->iter);
 		}
 
 		/**
@@ -294,8 +344,19 @@ void run_eSS(eSSType *eSSParams, void *inp, void *out, char *inname){
 		print_Ind(eSSParams, eSSParams->best, 1);
 	// printf("Final refSet: \n");
 	// print_Set(eSSParams, eSSParams->refSet);
+
+		/**
+		 * Periodic checkpoint, written in the background
+		 */
+		if (eSSParams->checkpoint_freq > 0 && eSSParams->iter % eSSParams->checkpoint_freq == 0)
+			write_Checkpoint(eSSParams);
 	}
 
+	/**
+	 * Make sure the last checkpoint is on disk before we go on
+	 */
+	WaitCheckpoint();
+
 
 	printf("\nbestSol: \n");
 	print_Ind(eSSParams, eSSParams->best, 1);
@@ -315,13 +376,15 @@ void run_eSS(eSSType *eSSParams, void *inp, void *out, char *inname){
 
 	refSet_final_file     = fopen("ref_set_final.csv", "w");
 	write_Set(eSSParams, eSSParams->refSet, refSet_final_file, -1);
-	write_Ind(eSSParams, eSSParams->best, best_sols_history_file, eSSParams->maxiter);	
+	log_Ind(eSSParams, eSSParams->best, best_sols_history_log, eSSParams->maxiter);	
 	write_params_to_fly_output_standard(eSSParams, inp, inname);
-	printf("ref_set_final.csv, ref_set_history_file.out, best_sols_history_file.out, and stats_file is generated. \n");
+	printf("ref_set_final.csv, ref_set_history_file.bin, best_sols_history_file.bin, and stats_file is generated. \n");
+	printf("(use histlog2txt to convert the .bin history logs to text)\n");
 
 
 	fclose(refSet_final_file);
-	fclose(best_sols_history_file);
+	CloseHistLog(refSet_history_log);
+	CloseHistLog(best_sols_history_log);
 	fclose(stats_file);
 	// fclose(file)
 
@@ -24,6 +24,9 @@
 
 #include "maternal.h"
 #include "../utils/random.h"
+#include "../utils/histlog.h"
+#include "../utils/distance.h"
+#include "../utils/farm.h"
 
 /**
  * Colors code for printing
@@ -40,6 +43,15 @@
 #define eul 2.71828182845905
 #define pi 3.14159265358979
 
+/* kinds of random streams (see InitStream()); recombination draws from
+   stream (iter, ind_index * n_refSet + j) for the candidate of refSet
+   members ind_index and j, goBeyond() from stream (iter, parent_index) */
+#define ESS_STREAM_RECOMBINE 1
+#define ESS_STREAM_GOBEYOND  2
+
+/* most goBeyond() steps that are evaluated at once, see speculation_Depth() */
+#define ESS_GOBEYOND_DEPTH   8
+
 #ifndef MAX
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
@@ -102,6 +114,9 @@ typedef struct eSSType{
 	int strategy;
 	int inter_save;
 	int warmStart;
+	int perform_resume;					/* Continue the run from its checkpoint (`--resume`). */
+	int checkpoint_freq;				/* Write a checkpoint every `checkpoint_freq` iterations, 0 disables checkpointing. */
+	char *checkpoint_filename;
 	int n_subRegions;
 	int debug;
 	int log;
@@ -141,11 +156,15 @@ typedef struct eSSType{
 	int n_candidateSet;
 	Set *candidateSet;					// Stores childs generated from each refSet in each generation, size: n_refSet - 1
 
+	Set *recombinedSet;					/* All candidates of an iteration, generated and evaluated at once by recombine_Set(),
+	size: n_refSet * (n_refSet - 1) */
+
 	int n_localSearch_Candidate;
 	Set *localSearchCandidateSet;
 
 	int n_archiveSet;
 	Set *archiveSet;
+	int archive_index;					/* Index of the next archiveSet member to be overwritten. */
 
 	individual *best;
 
@@ -161,6 +180,14 @@ typedef struct eSSType{
 	int equality_type;				/* Specify how the equality of two individuals should be computed, either by the closness of its parameters (1) or by euclidean distance between two individuals (0)*/
 	double dist_Tol;
 	double param_Tol;
+	int perform_normalize_distances;	/* Measure distances relative to the parameter ranges (`--normalize-distances`). */
+	double *dist_weights;				/* Per parameter weights used by the distance kernels, NULL for plain Euclidean distances. */
+	int perform_screening;				/* Screen parameter sets in single precision first (`--screen`). */
+	int screen_iters;					/* Number of iterations whose candidates are screened; the scatterSet always is. */
+	double screen_rho;					/* Sum of the rank agreements of the rescored candidates, weighted by their number, */
+	int screen_n;						/* and that number. */
+	int lockstep;						/* Number of parameter sets evaluate_Set() runs at once, see ScoreBatch() (`--lockstep`). */
+	Farm *farm;							/* Workers evaluate_Set() hands its sets to (`--farm`), NULL for none. */
 	int maxStuck;
 
 	int perform_refSet_convergence_stopping;
@@ -201,8 +228,8 @@ typedef struct eSSType{
 /**
  * Gloabl output files...
  */
-extern FILE *refSet_history_file;
-extern FILE *best_sols_history_file;
+extern HistLog *refSet_history_log;
+extern HistLog *best_sols_history_log;
 extern FILE *freqs_matrix_file;
 extern FILE *freq_mat_final_file;
 extern FILE *prob_mat_final_file;
@@ -249,6 +276,8 @@ int neldermead_localSearch(eSSType *eSSParams, individual *ind, void *inp, void
  * essRecombine.c
  */
 int recombine(eSSType*, individual*, int, void*, void*);
+void recombine_Set(eSSType*, void*, void*);
+int pick_Candidate(eSSType*, int);
 
 /**
  * essSort.c
@@ -292,6 +321,10 @@ void random_Ind(eSSType*, individual*, double*, double* );
  * essProblem.c
  */
 double objectiveFunction(eSSType*, individual*, void*, void*);
+int screenFunction(eSSType*, individual*, void*, void*);
+void objectiveFunctionBatch(eSSType*, individual*, int, void*);
+int lockstep_Lanes(eSSType*);
+double rankAgreement(const double *, const double *, int);
 
 double objfn(double []);
 void bounds(double lb[], double ub[]);
@@ -314,6 +347,8 @@ double nelder_objfn(const gsl_vector *x, void *data);
  */
 void evaluate_Individual(eSSType*, individual*, void*, void*);
 void evaluate_Set(eSSType*, Set*, void*, void*);
+int screen_Set(eSSType*, Set*, void*, void*);
+double rescore_Set(eSSType*, Set*, double, void*, void*, int*);
 
 /**
  * ess.c
@@ -322,6 +357,12 @@ void init_eSS(eSSType*, void*, void*, char*);
 void run_eSS(eSSType*, void*, void*, char*);
 
 
+/**
+ * essCheckpoint.c
+ */
+void write_Checkpoint(eSSType *);
+void restore_Checkpoint(eSSType *);
+
 /**
  * essIO.c
  */
@@ -331,6 +372,8 @@ void print_Set(eSSType*, Set*, int);
 void print_Ind(eSSType*, individual*, int);
 void write_Set(eSSType*, Set*, FILE*, int);
 void write_Ind(eSSType*, individual*, FILE*, int);
+void log_Set(eSSType*, Set*, HistLog*, int);
+void log_Ind(eSSType*, individual*, HistLog*, int);
 void write_params_to_fly_output_standard(eSSType*, Input*, char*);
 void print_Stats(eSSType *);
 void write_Stats(eSSType *, FILE *);
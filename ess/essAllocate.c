@@ -76,6 +76,9 @@ void deallocate_eSSParams(eSSType *eSSParams){
 	deallocate_Set(eSSParams, eSSParams->candidateSet);
 	free(eSSParams->candidateSet);
 
+	deallocate_Set(eSSParams, eSSParams->recombinedSet);
+	free(eSSParams->recombinedSet);
+
 	eSSParams->archiveSet->size = 100;
 	deallocate_Set(eSSParams, eSSParams->archiveSet);
 	free(eSSParams->archiveSet);
@@ -85,6 +88,7 @@ void deallocate_eSSParams(eSSType *eSSParams){
 
 	free(eSSParams->min_real_var);
 	free(eSSParams->max_real_var);
+	free(eSSParams->dist_weights);
 
 	/**
 	 * Deallocating the stats struct
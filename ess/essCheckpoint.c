@@ -0,0 +1,176 @@
+/**
+ *
+ *   @file essCheckpoint.c
+ *
+ *****************************************************************
+ *
+ *   writing and restoring checkpoints of an eSS run
+ *
+ *   The file format and the writer thread are in
+ *   utils/checkpoint.c.
+ *
+ */
+
+#include "ess.h"
+#include "error.h"
+#include "checkpoint.h"
+
+
+/**
+ * Store every field of an individual, except its parameters pointer
+ */
+static void put_Ind(eSSType *eSSParams, CkptBuffer *b, individual *ind){
+
+	CkptPut(b, ind->params, eSSParams->n_Params * sizeof(double));
+	CkptPut(b, &(ind->mean_cost), sizeof(double));
+	CkptPut(b, &(ind->var_cost), sizeof(double));
+	CkptPut(b, &(ind->cost), sizeof(double));
+	CkptPut(b, &(ind->dist), sizeof(double));
+	CkptPut(b, &(ind->n_notRandomized), sizeof(int));
+	CkptPut(b, &(ind->nStuck), sizeof(int));
+}
+
+static void get_Ind(eSSType *eSSParams, CkptBuffer *b, individual *ind){
+
+	CkptGet(b, ind->params, eSSParams->n_Params * sizeof(double));
+	CkptGet(b, &(ind->mean_cost), sizeof(double));
+	CkptGet(b, &(ind->var_cost), sizeof(double));
+	CkptGet(b, &(ind->cost), sizeof(double));
+	CkptGet(b, &(ind->dist), sizeof(double));
+	CkptGet(b, &(ind->n_notRandomized), sizeof(int));
+	CkptGet(b, &(ind->nStuck), sizeof(int));
+}
+
+/**
+ * Serialize the state of the optimization and hand it over to the background checkpoint
+ * writer. It should be called at the end of an iteration.
+ * @param eSSParams
+ */
+void write_Checkpoint(eSSType *eSSParams){
+
+	CkptBuffer *b = NewCkptBuffer("ess");
+
+	/**
+	 * Dimensions, only used for checking that the checkpoint fits the run
+	 */
+	CkptPut(b, &(eSSParams->n_Params), sizeof(int));
+	CkptPut(b, &(eSSParams->n_refSet), sizeof(int));
+	CkptPut(b, &(eSSParams->n_subRegions), sizeof(int));
+	CkptPut(b, &(eSSParams->n_archiveSet), sizeof(int));
+
+	CkptPut(b, &(eSSParams->iter), sizeof(int));
+
+	CkptPut(b, &(eSSParams->stats->n_successful_goBeyond), sizeof(int));
+	CkptPut(b, &(eSSParams->stats->n_local_search_performed), sizeof(int));
+	CkptPut(b, &(eSSParams->stats->n_successful_localSearch), sizeof(int));
+	CkptPut(b, &(eSSParams->stats->n_local_search_iterations), sizeof(int));
+	CkptPut(b, &(eSSParams->stats->n_Stuck), sizeof(int));
+	CkptPut(b, &(eSSParams->stats->n_successful_recombination), sizeof(int));
+	CkptPut(b, &(eSSParams->stats->n_refSet_randomized), sizeof(int));
+
+	/**
+	 * Rank agreement of the screened candidates so far, for --screen
+	 */
+	CkptPut(b, &(eSSParams->screen_rho), sizeof(double));
+	CkptPut(b, &(eSSParams->screen_n), sizeof(int));
+
+	for (int i = 0; i < eSSParams->n_Params; ++i){
+		CkptPut(b, eSSParams->stats->freqs_matrix[i], eSSParams->n_subRegions * sizeof(int));
+		CkptPut(b, eSSParams->stats->probs_matrix[i], eSSParams->n_subRegions * sizeof(double));
+	}
+
+	/**
+	 * refSet, `best` always points to its first member
+	 */
+	CkptPut(b, &(eSSParams->refSet->mean_cost), sizeof(double));
+	CkptPut(b, &(eSSParams->refSet->std_cost), sizeof(double));
+	for (int i = 0; i < eSSParams->n_refSet; ++i)
+		put_Ind(eSSParams, b, &(eSSParams->refSet->members[i]));
+
+	/**
+	 * archiveSet, only the members that are already assigned
+	 */
+	CkptPut(b, &(eSSParams->archiveSet->size), sizeof(int));
+	CkptPut(b, &(eSSParams->archive_index), sizeof(int));
+	for (int i = 0; i < eSSParams->archiveSet->size; ++i)
+		put_Ind(eSSParams, b, &(eSSParams->archiveSet->members[i]));
+
+	CkptPutRand(b);
+
+	CkptPutHist(b, refSet_history_log);
+	CkptPutHist(b, best_sols_history_log);
+	CkptPutLog(b, freqs_matrix_file);
+	CkptPutLog(b, stats_file);
+	CkptPutLog(b, ref_set_stats_history_file);
+
+	WriteCheckpoint(b, eSSParams->checkpoint_filename);
+}
+
+/**
+ * Restore the state of the optimization from `eSSParams->checkpoint_filename`. It assumes
+ * that `init_essParams` and `init_report_files` are already called.
+ * @param eSSParams
+ */
+void restore_Checkpoint(eSSType *eSSParams){
+
+	int n_Params, n_refSet, n_subRegions, n_archiveSet;
+
+	printf("Resuming from %s...\n", eSSParams->checkpoint_filename);
+
+	CkptBuffer *b = ReadCheckpoint(eSSParams->checkpoint_filename, "ess");
+
+	CkptGet(b, &n_Params, sizeof(int));
+	CkptGet(b, &n_refSet, sizeof(int));
+	CkptGet(b, &n_subRegions, sizeof(int));
+	CkptGet(b, &n_archiveSet, sizeof(int));
+	if (n_Params != eSSParams->n_Params || n_refSet != eSSParams->n_refSet ||
+			n_subRegions != eSSParams->n_subRegions || n_archiveSet != eSSParams->n_archiveSet)
+		error("restore_Checkpoint: checkpoint was written for a different problem or ess section");
+
+	CkptGet(b, &(eSSParams->iter), sizeof(int));
+
+	CkptGet(b, &(eSSParams->stats->n_successful_goBeyond), sizeof(int));
+	CkptGet(b, &(eSSParams->stats->n_local_search_performed), sizeof(int));
+	CkptGet(b, &(eSSParams->stats->n_successful_localSearch), sizeof(int));
+	CkptGet(b, &(eSSParams->stats->n_local_search_iterations), sizeof(int));
+	CkptGet(b, &(eSSParams->stats->n_Stuck), sizeof(int));
+	CkptGet(b, &(eSSParams->stats->n_successful_recombination), sizeof(int));
+	CkptGet(b, &(eSSParams->stats->n_refSet_randomized), sizeof(int));
+
+	/**
+	 * Rank agreement of the screened candidates so far, for --screen
+	 */
+	CkptGet(b, &(eSSParams->screen_rho), sizeof(double));
+	CkptGet(b, &(eSSParams->screen_n), sizeof(int));
+
+	for (int i = 0; i < eSSParams->n_Params; ++i){
+		CkptGet(b, eSSParams->stats->freqs_matrix[i], eSSParams->n_subRegions * sizeof(int));
+		CkptGet(b, eSSParams->stats->probs_matrix[i], eSSParams->n_subRegions * sizeof(double));
+	}
+
+	CkptGet(b, &(eSSParams->refSet->mean_cost), sizeof(double));
+	CkptGet(b, &(eSSParams->refSet->std_cost), sizeof(double));
+	for (int i = 0; i < eSSParams->n_refSet; ++i)
+		get_Ind(eSSParams, b, &(eSSParams->refSet->members[i]));
+	eSSParams->best = &(eSSParams->refSet->members[0]);
+
+	CkptGet(b, &(eSSParams->archiveSet->size), sizeof(int));
+	CkptGet(b, &(eSSParams->archive_index), sizeof(int));
+	for (int i = 0; i < eSSParams->archiveSet->size; ++i)
+		get_Ind(eSSParams, b, &(eSSParams->archiveSet->members[i]));
+
+	CkptGetRand(b);
+
+	/**
+	 * Drop whatever was logged after the checkpoint was taken
+	 */
+	CkptGetHist(b, refSet_history_log);
+	CkptGetHist(b, best_sols_history_log);
+	CkptGetLog(b, freqs_matrix_file);
+	CkptGetLog(b, stats_file);
+	CkptGetLog(b, ref_set_stats_history_file);
+
+	FreeCkptBuffer(b);
+
+	printf("Continuing after iteration %d, best cost: %lf\n", eSSParams->iter, eSSParams->best->cost);
+}
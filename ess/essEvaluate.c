@@ -15,10 +15,100 @@ void evaluate_Individual(eSSType *eSSParams, individual *ind, void *inp, void *o
 	// print_Ind(eSSParams, ind);
 }
 
+/**
+ * What the master needs to score individuals itself while the workers of the
+ * farm are busy, see farmScore().
+ */
+typedef struct FarmLocal {
+	eSSType *eSSParams;
+	void *inp;
+	void *out;
+} FarmLocal;
+
+/**
+ * Like objectiveFunction(), for FarmEvaluate().
+ */
+static double farmScore(const double *params, void *arg){
+
+	FarmLocal *local = (FarmLocal *)arg;
+	individual ind;
+
+	ind.params = (double *)params;
+	return objectiveFunction(local->eSSParams, &ind, local->inp, local->out);
+}
+
 void evaluate_Set(eSSType *eSSParams, Set *set, void *inp, void *out){
 
+	if (eSSParams->farm){
+		// Hand the set to the workers, the master scores what it can meanwhile
+		double **params = (double **)malloc(set->size * sizeof(double *));
+		double *cost = (double *)malloc(set->size * sizeof(double));
+		FarmLocal local = { eSSParams, inp, out };
+
+		for (int i = 0; i < set->size; ++i)
+			params[i] = set->members[i].params;
+		FarmEvaluate(eSSParams->farm, params, set->size, cost, farmScore, &local);
+		for (int i = 0; i < set->size; ++i)
+			set->members[i].cost = cost[i];
+
+		free(params);
+		free(cost);
+		return;
+	}
+
+	if (eSSParams->lockstep > 1){
+		for (int i = 0; i < set->size; i += eSSParams->lockstep)
+			objectiveFunctionBatch(eSSParams, &(set->members[i]),
+				set->size - i < eSSParams->lockstep ? set->size - i : eSSParams->lockstep, inp);
+		return;
+	}
+
 	for (int i = 0; i < set->size; ++i)
 	{
 		evaluate_Individual(eSSParams, &(set->members[i]), inp, out);
 	}
-}
\ No newline at end of file
+}
+
+/**
+ * Evaluate the members of a set with the single precision solver. Returns the
+ * number of members that were really scored in single precision; 0 means the
+ * solver or the model has no single precision version.
+ */
+int screen_Set(eSSType *eSSParams, Set *set, void *inp, void *out){
+
+	int n_single = 0;
+
+	for (int i = 0; i < set->size; ++i)
+	{
+		n_single += screenFunction(eSSParams, &(set->members[i]), inp, out);
+	}
+	return n_single;
+}
+
+/**
+ * Evaluate the members of a screened set whose cost is below `threshold` again
+ * in double precision; returns the rank agreement of their single and double
+ * precision costs and their number in `n_rescored`.
+ */
+double rescore_Set(eSSType *eSSParams, Set *set, double threshold, void *inp, void *out, int *n_rescored){
+
+	double *single = (double *)malloc(set->size * sizeof(double));
+	double *full = (double *)malloc(set->size * sizeof(double));
+	double rho;
+	int n = 0;
+
+	for (int i = 0; i < set->size; ++i)
+	{
+		if (set->members[i].cost < threshold){
+			single[n] = set->members[i].cost;
+			evaluate_Individual(eSSParams, &(set->members[i]), inp, out);
+			full[n++] = set->members[i].cost;
+		}
+	}
+	rho = rankAgreement(single, full, n);
+
+	free(single);
+	free(full);
+	*n_rescored = n;
+	return rho;
+}
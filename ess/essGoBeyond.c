@@ -11,12 +11,37 @@
 
 
 
+/**
+ * Number of goBeyond() steps that are generated and evaluated at once: one, unless
+ * evaluate_Set() can score several parameter sets at the same time (in lockstep or
+ * on the farm), then as many as it can, up to ESS_GOBEYOND_DEPTH. Without a lockstep
+ * solver the extra steps would only cost full model runs that are thrown away.
+ */
+static int speculation_Depth(eSSType *eSSParams){
+
+	int depth = lockstep_Lanes(eSSParams);
+
+	if (eSSParams->farm)
+		depth = MAX(depth, FarmWorkers(eSSParams->farm) + 1);
+	return MIN(depth, ESS_GOBEYOND_DEPTH);
+}
+
+/**
+ * Extrapolate from the child of refSet member `parent_index` in `childsSet` away from
+ * its parent as long as that improves it. Each step only depends on the two before it
+ * and on its random stream, and the chain goes on only if all of its steps improved,
+ * so the next `depth` steps are generated as if they all do and evaluated at once;
+ * the chain then takes them up to the first one that does not improve, which is what
+ * doing them one by one would give as well.
+ */
 void goBeyond(eSSType *eSSParams, int parent_index,
 						void *inp, void *out){
 
-	bool improved;
 	int gamma       = 1;
 	int improvement = 1;
+	int depth       = speculation_Depth(eSSParams);
+	int g, imp, n;
+	double last;
 
 	// parent = eSSParams->refSet->members[parent_index];
 	// child = eSSParams->childsSet->members[parent_index];
@@ -27,47 +52,78 @@ void goBeyond(eSSType *eSSParams, int parent_index,
 	copy_Ind(eSSParams, &parent, &(eSSParams->refSet->members[parent_index]));
 	copy_Ind(eSSParams, &child, &(eSSParams->childsSet->members[parent_index]));
 
+	Set steps;
+	steps.size = depth;
+	steps.members = (individual *)malloc(depth * sizeof(individual));
+	for (int s = 0; s < depth; ++s){
+		allocate_Ind(eSSParams, &(steps.members[s]));
+		copy_Ind(eSSParams, &(steps.members[s]), &child);
+	}
+
 	double c1, c2;
+	double *prev, *cur;
+	RandStream rs;
 
-	improved = false;
+	InitStream(&rs, ESS_STREAM_GOBEYOND, eSSParams->iter, parent_index);
 	for(;;) {
 
-		for (int k = 0; k < eSSParams->n_Params; ++k){
+		/* the next `depth` steps, as if all of them improve */
+		g = gamma;
+		imp = improvement;
+		for (int s = 0; s < depth; ++s){
 
-			c1 = child.params[k] - (parent.params[k] - child.params[k]) / gamma;
-			c2 = child.params[k];
+			prev = (s == 0) ? parent.params : (s == 1) ? child.params : steps.members[s - 2].params;
+			cur  = (s == 0) ? child.params : steps.members[s - 1].params;
 
-			c1 = MAX(eSSParams->min_real_var[k], c1); c1 = MIN(eSSParams->max_real_var[k], c1);
-			c2 = MAX(eSSParams->min_real_var[k], c2); c2 = MIN(eSSParams->max_real_var[k], c2);
+			for (int k = 0; k < eSSParams->n_Params; ++k){
 
-			// Copying child to parent in time.
-			parent.params[k] = child.params[k];
-			child.params[k] = c1 + (c2 - c1) * rndreal(0, 1);
-		}
+				c1 = cur[k] - (prev[k] - cur[k]) / g;
+				c2 = cur[k];
+
+				c1 = MAX(eSSParams->min_real_var[k], c1); c1 = MIN(eSSParams->max_real_var[k], c1);
+				c2 = MAX(eSSParams->min_real_var[k], c2); c2 = MIN(eSSParams->max_real_var[k], c2);
 
-		parent.cost = child.cost;
+				steps.members[s].params[k] = c1 + (c2 - c1) * StreamReal(&rs);
+			}
 
-		evaluate_Individual(eSSParams, &child, inp, out);
+			imp++;
+			if ( 2 == imp ){
+				imp = 0;
+				g /= 2;
+			}
+		}
 
-		if ( child.cost < parent.cost )
-		{
-			// IMPROVE: Move the copy out of the for, so, there is only one
-			// copy needed.
-			copy_Ind(eSSParams, &(eSSParams->childsSet->members[parent_index]), &child);
+		if (depth > 1)
+			evaluate_Set(eSSParams, &steps, inp, out);
+		else
+			evaluate_Individual(eSSParams, &(steps.members[0]), inp, out);
 
-			improved = true;
+		/* take the steps up to the first one that does not improve */
+		last = child.cost;
+		for (n = 0; n < depth && steps.members[n].cost < last; ++n){
+			last = steps.members[n].cost;
 			improvement++;
 			if ( 2 == improvement ){
 				improvement = 0;
 				gamma /= 2;
 			}
 			eSSParams->stats->n_successful_goBeyond++;
-		}else{
-			break;
 		}
 
+		if (n > 0)
+			copy_Ind(eSSParams, &(eSSParams->childsSet->members[parent_index]), &(steps.members[n - 1]));
+		if (n < depth)
+			break;
+
+		/* all of them improved, go on from the last two */
+		copy_Ind(eSSParams, &parent, (depth > 1) ? &(steps.members[depth - 2]) : &child);
+		copy_Ind(eSSParams, &child, &(steps.members[depth - 1]));
 	}
+
+	for (int s = 0; s < depth; ++s)
+		deallocate_Ind(eSSParams, &(steps.members[s]));
+	free(steps.members);
 	deallocate_Ind(eSSParams, &parent);
 	deallocate_Ind(eSSParams, &child);
 
-}
\ No newline at end of file
+}
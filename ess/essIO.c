@@ -9,6 +9,7 @@
 
 #include "ess.h"
 #include "fly_io.h"
+#include "solvers.h"
 #include <unistd.h>
 #include <ctype.h>
 
@@ -85,6 +86,23 @@ void write_Set(eSSType *eSSParams, Set *set, FILE *fpt, int iter){
 	}
 }
 
+/**
+ * Queue a Set in a binary history log, `histlog2txt` turns it into
+ * the `write_Set` text format.
+ */
+void log_Set(eSSType *eSSParams, Set *set, HistLog *log, int iter){
+
+	for (int i = 0; i < set->size; ++i)
+	{
+		log_Ind(eSSParams, &(set->members[i]), log, iter);
+	}
+}
+
+void log_Ind(eSSType *eSSParams, individual *ind, HistLog *log, int iter){
+
+	HistLogWrite(log, iter, ind->params, ind->cost);
+}
+
 void write_Ind(eSSType *eSSParams, individual *ind, FILE *fpt, int iter){
 
 	if (iter != -1)
@@ -119,8 +137,14 @@ void print_Stats(eSSType *eSSParams){
 
 }
 
+/**
+ * Writes one line per iteration; the last columns are the solver work done
+ * since the previous line, see WriteSolverStats().
+ */
 void write_Stats(eSSType *eSSParams, FILE *fpt){
 
+	static SolverStats work;
+
 	fprintf(fpt, "%d\t", eSSParams->iter);
 	fprintf(fpt, "%d\t", eSSParams->stats->n_successful_goBeyond);
 	fprintf(fpt, "%d\t", eSSParams->stats->n_local_search_performed);
@@ -128,6 +152,7 @@ void write_Stats(eSSType *eSSParams, FILE *fpt){
 	fprintf(fpt, "%d\t", eSSParams->stats->n_local_search_iterations);
 	fprintf(fpt, "%d\t", eSSParams->stats->n_Stuck);
 	fprintf(fpt, "%d\t", eSSParams->stats->n_successful_recombination);
+	WriteSolverStats(fpt, &work);
 	fprintf(fpt, "\n");
 
 }
@@ -17,6 +17,12 @@ void init_defaultSettings(eSSType *eSSParams){
 	
 	eSSParams->debug               = 0;
 	eSSParams->warmStart           = 0;
+	eSSParams->perform_resume      = 0;
+	eSSParams->checkpoint_freq     = 0;
+	eSSParams->perform_normalize_distances = 0;
+	eSSParams->perform_screening   = 0;
+	eSSParams->lockstep            = 1;
+	eSSParams->farm                = NULL;
 	eSSParams->user_guesses        = 0;
 	eSSParams->collectStats        = 0;
 	eSSParams->saveOutput          = 1;
@@ -63,6 +69,10 @@ void init_essParams(eSSType *eSSParams){
 	eSSParams->candidateSet->size = eSSParams->n_candidateSet;
 	allocate_Set(eSSParams, eSSParams->candidateSet);
 
+	eSSParams->recombinedSet = (Set*)malloc(sizeof(Set));
+	eSSParams->recombinedSet->size = eSSParams->n_refSet * (eSSParams->n_refSet - 1);
+	allocate_Set(eSSParams, eSSParams->recombinedSet);
+
 	eSSParams->localSearchCandidateSet = (Set *)malloc(sizeof(Set));
 	eSSParams->localSearchCandidateSet->size = eSSParams->n_refSet;
 	allocate_Set(eSSParams, eSSParams->localSearchCandidateSet);
@@ -102,15 +112,22 @@ void init_essParams(eSSType *eSSParams){
 		}
 	}
 
+	// Weighting parameters by 1 / range^2 puts them on the same scale in distances
+	eSSParams->dist_weights = NULL;
+	if (eSSParams->perform_normalize_distances){
+		eSSParams->dist_weights = (double *)malloc(eSSParams->n_Params * sizeof(double));
+		DistWeights(eSSParams->min_real_var, eSSParams->max_real_var, eSSParams->n_Params, eSSParams->dist_weights);
+	}
 
 }
 
 void init_report_files(eSSType *eSSParams){
 	char mode = 'w';
-	if (eSSParams->warmStart)
+	if (eSSParams->warmStart || eSSParams->perform_resume)
 		mode = 'a';
-	refSet_history_file   = fopen("ref_set_history_file.out", &mode);
-	best_sols_history_file = fopen("best_sols_history_file.out", &mode);
+	/* Binary logs, written in the background; convert them with histlog2txt */
+	refSet_history_log    = OpenHistLog("ref_set_history_file.bin", eSSParams->n_Params, mode == 'a');
+	best_sols_history_log = OpenHistLog("best_sols_history_file.bin", eSSParams->n_Params, mode == 'a');
 	freqs_matrix_file      = fopen("freqs_matrix_history.out", &mode);
 	stats_file			   = fopen("stats_file.csv", &mode);	
 	ref_set_stats_history_file = fopen("ref_set_stats_history_file.csv", &mode);
@@ -207,52 +224,42 @@ void init_refSet(eSSType *eSSParams, void* inp, void *out){
 	/************************************************************/
 	/* Expanding the refSet by applying the diversity distance */
 	/************************************************************/
-	
-	// dist_matrix will store the distances between the rest of scatterSet and the refSet
-	double **dist_matrix = (double **)malloc( (m - h) * sizeof(double *));;
-	for (int i = 0; i < (m - h); ++i)
-		dist_matrix[i] = (double *)malloc( (b) * sizeof(double));
-
-	double *min_dists = (double *)malloc((m - h) * sizeof(double));
 
-	int min_index = 0;
-	int max_index = 0;
+	// Each step adds the member of the rest of the scatterSet whose minimum distance to
+	// the refSet is maximal; MaxMinSelect keeps these minimum distances up to date
+	// instead of recomputing the whole distance matrix after each selection.
+	double **selected = (double **)malloc( h * sizeof(double *));
+	double **rest = (double **)malloc( (m - h) * sizeof(double *));
+	int *picked = (int *)malloc( (b - h) * sizeof(int));
+	char *is_picked = (char *)calloc( (m - h), sizeof(char));
 
-	int i = 0;
-	for (int k = h; k < b; ++k, --m)		// Iterate through the refSet for expanding
-	{										// --m is reduce the depth that the second `for` should go through it
-											// since the array is shifted after each iteration
+	for (int i = 0; i < h; ++i)
+		selected[i] = eSSParams->refSet->members[i].params;
+	for (int i = h; i < m; ++i)
+		rest[i - h] = eSSParams->scatterSet->members[i].params;
 
-		for (i = h; i < m; ++i)		// Iterate through the rest of scatterSet
-		{							 
+	MaxMinSelect(selected, h, rest, m - h, b - h, eSSParams->dist_weights, eSSParams->n_Params, picked);
 
-			for (int j = 0; j < k; ++j)		// Iterate trhough the selected members of refSet
-			{								
-				/* Computing the distance */
-				dist_matrix[i - (b / 2)][j] = euclidean_distance(eSSParams, &(eSSParams->scatterSet->members[i]), &(eSSParams->refSet->members[j]));
-			}
+	for (int k = h; k < b; ++k){
+		copy_Ind(eSSParams, &(eSSParams->refSet->members[k]), &(eSSParams->scatterSet->members[h + picked[k - h]]));
+		is_picked[picked[k - h]] = 1;
+	}
 
-			// Find the minimum of each row into a new variable, then finding it's max
-			min_dists[i - (b / 2)] = min(dist_matrix[i - (b / 2)], k, &min_index);
+	// The selected members are taken out of the scatterSet, the rest is shifted to the left
+	int left = h;
+	for (int i = h; i < m; ++i){
+		if ( !is_picked[i - h] ){
+			if ( left != i )
+				copy_Ind(eSSParams, &(eSSParams->scatterSet->members[left]), &(eSSParams->scatterSet->members[i]));
+			left++;
 		}
-		
-		// Now, the min_dists of vectors to all the members of R is computed,
-		// we could compute the maximum of them and also it's index
-		
-		// Finding the place of the max/min distance
-		max(min_dists, i - (b / 2), &max_index); 
-
-		// Adding the vector in max_index to the refSet
-		copy_Ind(eSSParams, &(eSSParams->refSet->members[k]), &(eSSParams->scatterSet->members[h + max_index]));
-
-		// After assignment, the rest of should be shift into the left form the position that the 
-		// vector is selected
-		
-		// It could be done more complicated!
-		delete_and_shift(eSSParams, eSSParams->scatterSet, eSSParams->n_scatterSet, (b / 2) + max_index);
-
 	}
 
+	free(selected);
+	free(rest);
+	free(picked);
+	free(is_picked);
+
 	/**
 	 * It checks if the user initial guesses are available, if so, then add them to the
 	 * end of the refSet.
@@ -278,12 +285,6 @@ void init_refSet(eSSType *eSSParams, void* inp, void *out){
 	    }
 	}
 
-	free(min_dists);
-	for (int i = 0; i < (eSSParams->n_scatterSet - b/2); ++i){
-		free(dist_matrix[i]);
-	}
-	free(dist_matrix);
-
 }
 
 
@@ -9,23 +9,83 @@
 
  #include "ess.h"
 
+#include "integrate.h"        /* for ps */
 #include "score.h"
+#include "solvers.h"
 #include "zygotic.h"
 
 /**
  * This will call the problem simulator to the cost function for the individual.
- * The function should first copy ind->params to the inp->params and call the 
- * simulator like `simulator(inp, out)`, and finally write the `out` to `ind->cost`
+ * The function checks ind->params against the search space, copies them to
+ * the inp->params and calls the simulator (see ScoreParams()), and finally
+ * returns the cost in `out`
  */
 double objectiveFunction(eSSType *eSSParams, individual *ind, void *inp, void *out){
 
+    /* out of bounds is rejected before the parameters go into the model */
+	ScoreParams(inp, ind->params, out);
+    return ((ScoreOutput*)out)->score + ((ScoreOutput*)out)->penalty;
+
+}
+
+
+/**
+ * Number of individuals objectiveFunctionBatch() really runs at once: the
+ * `--lockstep` sets if the solver can run them in lockstep (see LockstepSolver()),
+ * otherwise ScoreBatch() scores them one by one and this is 1.
+ */
+int lockstep_Lanes(eSSType *eSSParams){
+
+    if (eSSParams->lockstep > 1 && LockstepSolver(ps))
+        return eSSParams->lockstep;
+    return 1;
+}
+
+
+/**
+ * Like objectiveFunction() for the `n` individuals `inds`, but runs the
+ * simulator for all of them at once if the solver allows it (see ScoreBatch());
+ * writes their costs to `inds[i].cost`.
+ */
+void objectiveFunctionBatch(eSSType *eSSParams, individual *inds, int n, void *inp){
+
+    double **params = (double **)malloc(n * sizeof(double *));
+    double *cost = (double *)malloc(n * sizeof(double));
+
+    for (int i = 0; i < n; ++i)
+        params[i] = inds[i].params;
+    ScoreBatch(inp, params, n, cost);
+    for (int i = 0; i < n; ++i)
+        inds[i].cost = cost[i];
+
+    free(params);
+    free(cost);
+}
+
+
+/**
+ * Like objectiveFunction(), but runs the simulator with the single precision
+ * solver if there is one (see ScreenScore()); the cost is only good for ranking.
+ * Returns 1 if the single precision solver was used.
+ */
+int screenFunction(eSSType *eSSParams, individual *ind, void *inp, void *out){
+
+    int single;
+
     for (int i = 0; i < ((Input *)inp)->tra.size; ++i){
         *( ((Input *)inp)->tra.array[i].param  ) = ind->params[i];
     }
 
-	Score(inp, out, 0);
-    return ((ScoreOutput*)out)->score + ((ScoreOutput*)out)->penalty;
+	single = ScreenScore(inp, out);
+    ind->cost = ((ScoreOutput*)out)->score + ((ScoreOutput*)out)->penalty;
+    return single;
+}
 
+/**
+ * Spearman rank correlation of `a` and `b`, see RankAgreement().
+ */
+double rankAgreement(const double *a, const double *b, int n){
+	return RankAgreement(a, b, n);
 }
 
 
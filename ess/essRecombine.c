@@ -9,6 +9,40 @@
 
  #include "ess.h"
 
+/**
+ * Generate the candidate of refSet members `ind_index` and `j` into `cand`. It draws from its
+ * own random stream, so the candidate does not depend on the order they are generated in.
+ */
+static void make_Candidate(eSSType *eSSParams, int ind_index, int j, individual *cand){
+
+	double c1;
+	double c2;
+	double d;
+	double alpha, beta;
+	RandStream rs;
+
+	alpha = ( ind_index < j ) ? 1 : -1;
+	beta = abs(j - ind_index);
+	InitStream(&rs, ESS_STREAM_RECOMBINE, eSSParams->iter, ind_index * eSSParams->n_refSet + j);
+
+	for (int k = 0; k < eSSParams->n_Params; ++k)
+	{
+		d = eSSParams->refSet->members[j].params[k] - eSSParams->refSet->members[ind_index].params[k];
+		c1 = eSSParams->refSet->members[ind_index].params[k] - d * ( 1 + alpha * beta);
+		c2 = eSSParams->refSet->members[ind_index].params[k] + d * ( 1 + alpha * beta);
+		
+		c1 = MAX(eSSParams->min_real_var[k], c1); c1 = MIN(eSSParams->max_real_var[k], c1);
+		c2 = MAX(eSSParams->min_real_var[k], c2); c2 = MIN(eSSParams->max_real_var[k], c2);
+
+		cand->params[k] = c1 + (c2 - c1) * StreamReal(&rs);
+	}
+
+	cand->dist   = 0;
+	cand->mean_cost   = 0;
+	cand->var_cost    = 0;
+	cand->nStuck = 0;
+}
+
 /**
  * Recombined `ind` with `ind_index` in the refSet with all the other members of refSet
  * and return the index of the best recombined solution that outperform its parent.
@@ -24,37 +58,29 @@
 int recombine(eSSType *eSSParams, individual *ind, int ind_index,/* individual *bestInd,*/
 					 void *inp, void *out){
 
-	double c1;
-	double c2;
-	double d;
-	double alpha, beta;
-
 	int p = 0;
 	int best_index = -1;
+
+	/* in the screening iterations, only candidates that beat their parent get their exact cost */
+	int screening = eSSParams->perform_screening && eSSParams->iter <= eSSParams->screen_iters;
+	double single[eSSParams->n_refSet], full[eSSParams->n_refSet];
+	int n_rescored = 0;
 	for (int j = 0; j < eSSParams->n_refSet; ++j)
 	{
 		if ( j != ind_index ){
 
-			alpha = ( ind_index < j ) ? 1 : -1;
-			beta = abs(j - ind_index);
+			make_Candidate(eSSParams, ind_index, j, &(eSSParams->candidateSet->members[p]));
 
-			for (int k = 0; k < eSSParams->n_Params; ++k)
-			{
-				d = eSSParams->refSet->members[j].params[k] - eSSParams->refSet->members[ind_index].params[k];
-				c1 = eSSParams->refSet->members[ind_index].params[k] - d * ( 1 + alpha * beta);
-				c2 = eSSParams->refSet->members[ind_index].params[k] + d * ( 1 + alpha * beta);
-				
-				c1 = MAX(eSSParams->min_real_var[k], c1); c1 = MIN(eSSParams->max_real_var[k], c1);
-				c2 = MAX(eSSParams->min_real_var[k], c2); c2 = MIN(eSSParams->max_real_var[k], c2);
-
-				eSSParams->candidateSet->members[p].params[k] = c1 + (c2 - c1) * rndreal(0, 1);
+			if (screening){
+				screenFunction(eSSParams, &(eSSParams->candidateSet->members[p]), inp, out);
+				if (eSSParams->candidateSet->members[p].cost < eSSParams->refSet->members[ind_index].cost){
+					single[n_rescored] = eSSParams->candidateSet->members[p].cost;
+					evaluate_Individual(eSSParams, &(eSSParams->candidateSet->members[p]), inp, out);
+					full[n_rescored++] = eSSParams->candidateSet->members[p].cost;
+				}
 			}
-
-			evaluate_Individual(eSSParams, &(eSSParams->candidateSet->members[p]), inp, out);
-			eSSParams->candidateSet->members[p].dist   = 0;
-			eSSParams->candidateSet->members[p].mean_cost   = 0;
-			eSSParams->candidateSet->members[p].var_cost    = 0;
-			eSSParams->candidateSet->members[p].nStuck = 0;
+			else
+				evaluate_Individual(eSSParams, &(eSSParams->candidateSet->members[p]), inp, out);
 
 			if ( eSSParams->candidateSet->members[p].cost < eSSParams->refSet->members[ind_index].cost )
 				best_index = p;
@@ -63,6 +89,53 @@ int recombine(eSSType *eSSParams, individual *ind, int ind_index,/* individual *
 		}
 	}
 
+	if (n_rescored > 0){
+		eSSParams->screen_rho += n_rescored * rankAgreement(single, full, n_rescored);
+		eSSParams->screen_n += n_rescored;
+	}
+
 	return best_index;
 
-}
\ No newline at end of file
+}
+
+/**
+ * Generate the candidates of all refSet members at once into `recombinedSet`, the ones of
+ * member `i` at `i * (n_refSet - 1)` onwards, and evaluate them as one set, so that
+ * `evaluate_Set()` can run them in lockstep or hand them to the farm. The candidates only
+ * depend on the refSet at the start of the iteration and have their own random streams, so
+ * this gives the same candidates and costs as calling `recombine()` member by member.
+ * @param  eSSParams 
+ * @param  inp       
+ * @param  out       
+ */
+void recombine_Set(eSSType *eSSParams, void *inp, void *out){
+
+	int p = 0;
+
+	for (int i = 0; i < eSSParams->n_refSet; ++i)
+		for (int j = 0; j < eSSParams->n_refSet; ++j)
+			if ( j != i )
+				make_Candidate(eSSParams, i, j, &(eSSParams->recombinedSet->members[p++]));
+
+	evaluate_Set(eSSParams, eSSParams->recombinedSet, inp, out);
+}
+
+/**
+ * Pick the candidate of refSet member `ind_index` from `recombinedSet` after
+ * `recombine_Set()`, by the same rule as `recombine()`.
+ * @param  eSSParams 
+ * @param  ind_index index of the parent individual
+ * @return           index in `recombinedSet` of the best candidate that outperform its
+ *                   parent, `-1` if there is none.
+ */
+int pick_Candidate(eSSType *eSSParams, int ind_index){
+
+	int first = ind_index * (eSSParams->n_refSet - 1);
+	int best_index = -1;
+
+	for (int p = first; p < first + eSSParams->n_refSet - 1; ++p)
+		if ( eSSParams->recombinedSet->members[p].cost < eSSParams->refSet->members[ind_index].cost )
+			best_index = p;
+
+	return best_index;
+}
@@ -58,14 +58,13 @@ double max(double* array, int len, int* max_index){
 
 }
 
+/*
+	Euclidean distance between two individuals; with `--normalize-distances` each
+	parameter is measured relative to its range.
+ */
 double euclidean_distance(eSSType *eSSParams, individual *ind1, individual *ind2){
 
-	double distance = 0;
-	for (int i = 0; i < eSSParams->n_Params; ++i)
-	{
-		distance += (ind1->params[i] - ind2->params[i]) * (ind1->params[i] - ind2->params[i]);
-	}
-	return sqrt(distance);
+	return sqrt(SqDist(ind1->params, ind2->params, eSSParams->dist_weights, eSSParams->n_Params));
 
 }
 
@@ -88,36 +87,12 @@ void delete_and_shift(eSSType *eSSParams, Set *set, int set_size, int index_to_d
  * @return           index of the closest member of a set to `ind`
  */
 int closest_member(eSSType *eSSParams, Set *set, int set_size, individual *ind, int ind_index){
-	double dist;
-	double min;
-	int min_index;
-
-	if (ind_index == set_size - 1 ){
-		min = euclidean_distance(eSSParams, ind, &(set->members[set_size - 2]));
-		min_index = set_size - 2;
-	}
-	else if (ind_index == 0){
-		min = euclidean_distance(eSSParams, ind, &(set->members[1]));
-		min_index = 1;		
-	}
-	else{
-		min = euclidean_distance(eSSParams, ind, &(set->members[ind_index - 1]));
-		min_index = ind_index - 1;		
-	}
-
 
+	double *rows[set_size];
 	for (int i = 0; i < set_size; ++i)
-	{
-		if ( i != ind_index ){
-			
-			dist = euclidean_distance(eSSParams, ind, &(set->members[i]));
-			if (dist < min ){
-				min = dist;
-				min_index = i;
-			}
-		}
-	}
-	return min_index;
+		rows[i] = set->members[i].params;
+
+	return NearestRow(ind->params, rows, set_size, ind_index, eSSParams->dist_weights, eSSParams->n_Params, NULL);
 }
 
 bool is_equal_dist(eSSType *eSSParams, individual *ind1, individual *ind2){
@@ -145,21 +120,24 @@ bool is_equal_pairwise(eSSType *eSSParams, individual *ind1, individual *ind2){
  */
 int is_exist(eSSType *eSSParams, Set *set, individual *ind){
 
-	int index = -1;
+	/**
+	 * Check the value of eSSParams->equality_type, if its 0 then consider the euclidean_distance as a measurment
+	 * otherwise, check the pairwise equality of parameters.
+	 */
+	if (eSSParams->equality_type == 0){
+		double **rows = (double **)malloc(set->size * sizeof(double *));
+		for (int i = 0; i < set->size; ++i)
+			rows[i] = set->members[i].params;
+
+		int index = FindWithin(ind->params, rows, set->size, eSSParams->dist_weights, eSSParams->n_Params, eSSParams->dist_Tol, 0);
+		free(rows);
+		return index;
+	}
+
 	for (int i = 0; i < set->size; ++i)
 	{
-		/**
-		 * Check the value of eSSParams->equality_type, if its 0 then consider the euclidean_distance as a measurment
-		 * otherwise, check the pairwise equality of parameters.
-		 */
-		if ( true == (eSSParams->equality_type == 0 ? 
-				is_equal_dist(eSSParams, &(set->members[i]), ind) : is_equal_pairwise(eSSParams, &(set->members[i]), ind)))
-		{
-			index = i;
-			break;
-		}
-
+		if ( is_equal_pairwise(eSSParams, &(set->members[i]), ind) )
+			return i;
 	}
-
-	return index;
-}
\ No newline at end of file
+	return -1;
+}
@@ -0,0 +1,227 @@
+/**
+ * @file autotune.c
+ *
+ * @brief Automatic choice of solver, stepsize and accuracy (--autotune).
+ *
+ * The sample is the parameter set of the input file plus random parameter
+ * sets drawn uniformly within the limits of the tweaked parameters (the
+ * ones with a penalty instead of limits keep their input value); sets the
+ * reference cannot score (FORBIDDEN_MOVE) are drawn again. The reference
+ * is Runge-Kutta Cash-Karp, or the delay solver for delay models, at
+ * accuracy REF_ACCURACY.
+ *
+ * Adaptive solvers are tried from loose to tight accuracy at the stepsize
+ * given with -i, Rk4 and Imex from large to small stepsizes. A solver is
+ * dropped as soon as one of its settings is good enough (tighter ones are
+ * only slower) or takes longer than the best setting found so far; the
+ * latter also cuts the scoring of a setting short.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "error.h"
+#include "random.h"
+#include "integrate.h"
+#include "maternal.h"
+#include "score.h"
+#include "solvers.h"
+#include "autotune.h"
+
+
+/*** CONSTANTS *************************************************************/
+
+#define AUTOTUNE_SEED     936899377     /* seed for drawing the sample */
+#define AUTOTUNE_SAMPLES  8     /* parameter sets in the sample */
+#define AUTOTUNE_DRAWS    200   /* random draws allowed to fill the sample */
+#define REF_ACCURACY      1e-8  /* accuracy of the reference solver */
+#define REF_STEPSIZE      0.1   /* stepsize (hint) of the reference solver */
+
+typedef void ( *Solver ) ( double *, double *, double, double, double, double, int, FILE *, SolverInput *, Input * );
+
+/* candidate solvers by their -s names (see SolverByName()); adaptive ones
+ * are tuned by accuracy, the others by stepsize */
+static const struct {
+    const char *name;
+    int adaptive;
+} candidates[] = {
+    {"rck", 1}, {"dp", 1}, {"rf", 1}, {"bs", 1}, {"bd", 1},
+    {"kr", 1}, {"r4", 0}, {"im", 0}, {NULL, 0}
+};
+
+/* settings tried, from the cheapest to the most expensive one; 0 ends a list */
+static const double accuracies[] = { 1e-2, 3e-3, 1e-3, 3e-4, 1e-4, 3e-5, 1e-5, 0. };
+static const double stepsizes[] = { 4., 2., 1., .5, .2, .1, .05, 0. };
+
+
+/*** HELPERS ***************************************************************/
+
+/** Now: monotonic wall clock time in seconds */
+static double
+Now( void ) {
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/** SetParams: installs parameter set 'p' in the tweaked parameters */
+static void
+SetParams( Input * inp, const double *p ) {
+    int i;
+
+    for( i = 0; i < inp->tra.size; i++ )
+        *( inp->tra.array[i].param ) = p[i];
+}
+
+/** ScoreWith: chisq of parameter set 'p' with the given solver setting */
+static double
+ScoreWith( Input * inp, Solver solver, double stepsize, double accuracy, const double *p, ScoreOutput * out ) {
+    ps = solver;
+    inp->ste.stepsize = stepsize;
+    inp->ste.accuracy = accuracy;
+    SetParams( inp, p );
+    Score( inp, out, 0 );
+    return out->score;
+}
+
+/** TrySetting: scores the sample with setting 'c' and fills in its error
+ *               and time; returns 1 if the setting is good enough, 0 if its
+ *               error is too large and -1 if it took longer than 'limit'
+ *               seconds in total
+ */
+static int
+TrySetting( Input * inp, SolverChoice * c, double **sample, const double *ref, int n, double max_error, double limit, ScoreOutput * out ) {
+    double total = 0.;
+    double chisq, err, t;
+    int k;
+
+    c->error = 0.;
+    for( k = 0; k < n; k++ ) {
+        t = Now(  );
+        chisq = ScoreWith( inp, c->solver, c->stepsize, c->accuracy, sample[k], out );
+        total += Now(  ) - t;
+
+        err = fabs( chisq - ref[k] ) / ( ref[k] > 0. ? ref[k] : 1. );
+        if( !( err <= max_error ) ) {   /* also catches NaN */
+            c->error = err;
+            c->time = total / ( k + 1 );
+            return 0;
+        }
+        if( err > c->error )
+            c->error = err;
+        if( total > limit ) {
+            c->time = total / ( k + 1 );
+            return -1;
+        }
+    }
+    c->time = total / n;
+    return 1;
+}
+
+
+/*** AUTOTUNE **************************************************************/
+
+/** AutoTune: returns the fastest solver setting within 'max_error' */
+SolverChoice
+AutoTune( Input * inp, double max_error ) {
+    Solver solver0 = ps;        /* what we have to restore at the end */
+    double stepsize0 = inp->ste.stepsize;
+    double accuracy0 = inp->ste.accuracy;
+    double *params0;
+    double **sample;
+    double ref[AUTOTUNE_SAMPLES];
+    Solver ref_solver;
+    int delay = ( ps == SoDe ); /* delay model: only the delay solver will do */
+    int nparams = inp->tra.size;
+    int n, draws, i, j, r;
+    const double *values;
+    Range *range;
+    ScoreOutput out;
+    SolverChoice best, c;
+
+    out.score = 1e38;
+    out.penalty = 0;
+    out.size_resid_arr = 0;
+    out.jacobian = NULL;
+    out.residuals = NULL;
+
+    params0 = ( double * ) malloc( nparams * sizeof( double ) );
+    sample = ( double ** ) malloc( AUTOTUNE_SAMPLES * sizeof( double * ) );
+    if( !params0 || !sample )
+        error( "AutoTune: could not allocate memory for the sample" );
+    for( j = 0; j < nparams; j++ )
+        params0[j] = *( inp->tra.array[j].param );
+
+    /* score the sample with the reference; the first set is the input one */
+    ref_solver = delay ? SoDe : Rkck;
+    InitRand( AUTOTUNE_SEED );
+    for( n = 0, draws = 0; n < AUTOTUNE_SAMPLES && draws <= AUTOTUNE_DRAWS; draws++ ) {
+        if( !( sample[n] = ( double * ) malloc( nparams * sizeof( double ) ) ) )
+            error( "AutoTune: could not allocate memory for the sample" );
+        for( j = 0; j < nparams; j++ ) {
+            range = inp->tra.array[j].param_range;
+            if( draws == 0 || !range )
+                sample[n][j] = params0[j];
+            else
+                sample[n][j] = range->lower + ( range->upper - range->lower ) * RandomReal(  );
+        }
+        ref[n] = ScoreWith( inp, ref_solver, REF_STEPSIZE, REF_ACCURACY, sample[n], &out );
+        if( ref[n] == FORBIDDEN_MOVE || !isfinite( ref[n] ) )
+            free( sample[n] );
+        else
+            n++;
+    }
+    if( n == 0 )
+        error( "AutoTune: no parameter set of the sample could be scored" );
+
+    printf( "Autotune: %d parameter sets, max. chisq error %g\n", n, max_error );
+
+    /* time the candidates */
+    best.solver = NULL;
+    best.name = NULL;
+    best.stepsize = stepsize0;
+    best.accuracy = accuracy0;
+    best.error = 0.;
+    best.time = HUGE_VAL;
+    for( i = 0; delay ? i < 1 : candidates[i].name != NULL; i++ ) {
+        c.solver = delay ? SoDe : SolverByName( candidates[i].name );
+        c.name = delay ? "sd" : candidates[i].name;
+        values = ( delay || candidates[i].adaptive ) ? accuracies : stepsizes;
+
+        for( j = 0; values[j] > 0.; j++ ) {
+            c.stepsize = ( values == accuracies ) ? stepsize0 : values[j];
+            c.accuracy = ( values == accuracies ) ? values[j] : accuracy0;
+
+            r = TrySetting( inp, &c, sample, ref, n, max_error, best.time * n, &out );
+            printf( "  -s %-3s -i %-5g -a %-7g", c.name, c.stepsize, c.accuracy );
+            if( r == 1 )
+                printf( "  error %.2e  %8.3f ms per Score\n", c.error, 1000. * c.time );
+            else if( r == 0 )
+                printf( "  error %.2e  too large\n", c.error );
+            else
+                printf( "  slower than the best\n" );
+
+            if( r == 1 && c.time < best.time )
+                best = c;
+            if( r != 0 )
+                break;
+        }
+    }
+
+    /* put everything back */
+    ps = solver0;
+    inp->ste.stepsize = stepsize0;
+    inp->ste.accuracy = accuracy0;
+    SetParams( inp, params0 );
+
+    for( i = 0; i < n; i++ )
+        free( sample[i] );
+    free( sample );
+    free( params0 );
+    free( out.residuals );
+
+    return best;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file autotune.h
+ *
+ * @brief Automatic choice of solver, stepsize and accuracy (--autotune).
+ *
+ * AutoTune() scores a sample of parameter sets with a high-accuracy
+ * reference solver, then times the candidate solver settings on the same
+ * sample and picks the fastest one whose chisq stays within a relative
+ * error bound of the reference for every parameter set.
+ */
+
+#ifndef AUTOTUNE_INCLUDED
+#define AUTOTUNE_INCLUDED
+
+#include <stdio.h>
+#include "maternal.h"
+
+/** SolverChoice: a solver setting and how it did against the reference */
+typedef struct SolverChoice {
+    void ( *solver ) ( double *, double *, double, double, double, double, int, FILE *, SolverInput *, Input * );
+    const char *name;           /* solver name as for -s */
+    double stepsize;            /* -i */
+    double accuracy;            /* -a */
+    double error;               /* max. relative chisq error over the sample */
+    double time;                /* mean wall clock seconds per Score() */
+} SolverChoice;
+
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+/** AutoTune: returns the fastest solver setting whose chisq differs from
+ *             the reference by at most 'max_error' (relative) for all
+ *             parameter sets of the sample; the sample is the parameter
+ *             set of the input plus random ones within the limits of the
+ *             tweaked parameters. If the current solver in 'ps' is the
+ *             delay solver, only its accuracy is tuned. The solver, step-
+ *             size and accuracy in 'ps' and inp->ste are left as they
+ *             were, so is the parameter set. If no setting is good
+ *             enough, the returned choice has solver == NULL.
+ */
+SolverChoice AutoTune( Input * inp, double max_error );
+
+#endif
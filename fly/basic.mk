@@ -3,16 +3,17 @@
 
 # Utilites objects
 FOBJ = zygotic.o fly_io.o maternal.o integrate.o translate.o solvers.o score.o \
-         ../utils/error.o ../utils/distributions.o ../utils/random.o ../utils/ioTools.o ../utils/dSFMT.o ../utils/dSFMT_str_state.o
+         ../utils/error.o ../utils/distributions.o ../utils/random.o ../utils/ioTools.o ../utils/dSFMT.o ../utils/dSFMT_str_state.o \
+         ../utils/checkpoint.o ../utils/histlog.o ../utils/distance.o ../utils/farm.o
 
 # Fly object
-FSOBJ =  fly.o 
+FSOBJ =  fly.o autotune.o ensemble.o
 
 # Scatter Search objects
-SSOBJ = ../ss/allocate.o ../ss/evaluate.o ../ss/init.o ../ss/local_search.o ../ss/recombine.o ../ss/refine.o ../ss/report.o ../ss/sort.o ../ss/ss.o ../ss/ssTools.o ../ss/stats.o ../ss/update.o 
+SSOBJ = ../ss/allocate.o ../ss/checkpoint.o ../ss/evaluate.o ../ss/init.o ../ss/local_search.o ../ss/recombine.o ../ss/refine.o ../ss/report.o ../ss/sort.o ../ss/ss.o ../ss/ssTools.o ../ss/stats.o ../ss/update.o 
 
 # Enhanced Scatter Search objects
-ESSOBJ = ../ess/ess.o ../ess/essAllocate.o ../ess/essEvaluate.o ../ess/essGoBeyond.o ../ess/essIO.o ../ess/essInit.o ../ess/essLocalSearch.o ../ess/essProblem.o ../ess/essRand.o ../ess/essRecombine.o ../ess/essSort.o ../ess/essStats.o ../ess/essTools.o
+ESSOBJ = ../ess/ess.o ../ess/essAllocate.o ../ess/essCheckpoint.o ../ess/essEvaluate.o ../ess/essGoBeyond.o ../ess/essIO.o ../ess/essInit.o ../ess/essLocalSearch.o ../ess/essProblem.o ../ess/essRand.o ../ess/essRecombine.o ../ess/essSort.o ../ess/essStats.o ../ess/essTools.o
 
 
 
@@ -25,13 +26,27 @@ endif
 
 
 #printscore objects
-POBJ = zygotic.o fly_io.o maternal.o integrate.o translate.o solvers.o score.o printscore.o \
+POBJ = zygotic.o fly_io.o maternal.o integrate.o translate.o solvers.o score.o flysim.o printscore.o \
        ../utils/error.o ../utils/distributions.o ../utils/random.o ../utils/ioTools.o ../utils/dSFMT.o ../utils/dSFMT_str_state.o
 
 #unfold objects
-UOBJ = zygotic.o fly_io.o maternal.o integrate.o translate.o solvers.o score.o unfold.o \
+UOBJ = zygotic.o fly_io.o maternal.o integrate.o translate.o solvers.o score.o flysim.o unfold.o \
 	  ../utils/error.o ../utils/distributions.o ../utils/random.o ../utils/ioTools.o ../utils/dSFMT.o ../utils/dSFMT_str_state.o
 
+#libflysim objects
+LOBJ = zygotic.o fly_io.o maternal.o integrate.o translate.o solvers.o score.o flysim.o \
+	  ../utils/error.o ../utils/distributions.o ../utils/random.o ../utils/ioTools.o ../utils/dSFMT.o ../utils/dSFMT_str_state.o
+
+#flybench objects; linked with the optimizer objects of METHODOBJ
+BOBJ = zygotic.o fly_io.o maternal.o integrate.o translate.o solvers.o score.o flybench.o \
+         ../utils/error.o ../utils/distributions.o ../utils/random.o ../utils/ioTools.o ../utils/dSFMT.o ../utils/dSFMT_str_state.o \
+         ../utils/checkpoint.o ../utils/histlog.o ../utils/distance.o ../utils/farm.o
+
+#fly_worker objects
+WOBJ = zygotic.o fly_io.o maternal.o integrate.o translate.o solvers.o score.o flysim.o flyworker.o \
+	  ../utils/error.o ../utils/distributions.o ../utils/random.o ../utils/ioTools.o ../utils/dSFMT.o ../utils/dSFMT_str_state.o \
+	  ../utils/farm.o
+
 #scramble objects
 SOBJ = zygotic.o fly_io.o maternal.o integrate.o translate.o solvers.o score.o scramble.o \
 	  ../utils/error.o ../utils/distributions.o ../utils/random.o ../utils/ioTools.o ../utils/dSFMT.o ../utils/dSFMT_str_state.o
@@ -50,12 +65,18 @@ fly.o: fly.c
 printscore.o: printscore.c
 	$(CC) -c $(CFLAGS) $(VFLAGS) printscore.c
 
+flybench.o: flybench.c
+	$(CC) -c $(CFLAGS) $(VFLAGS) flybench.c
+
 scramble.o: scramble.c
 	$(CC) -c $(CFLAGS) $(VFLAGS) scramble.c
 
 unfold.o: unfold.c
 	$(CC) -c $(CFLAGS) $(VFLAGS) unfold.c
 
+flyworker.o: flyworker.c
+	$(CC) -c $(CFLAGS) $(VFLAGS) flyworker.c
+
 zygotic.o: zygotic.c
 	$(CC) -c $(CFLAGS) $(KFLAGS) zygotic.c
 
@@ -65,18 +86,29 @@ $(execFile): $(FOBJ) $(FSOBJ)
 	$(CC) -o $(execFile) $(CFLAGS) $(LDFLAGS) $(FOBJ) $(METHODOBJ) $(FLIBS) $(FSOBJ)
 
 printscore: $(POBJ)
-	$(CC) -o printscore $(CFLAGS) $(LDFLAGS) $(POBJ) $(LIBS) 
+	$(CC) -o printscore $(CFLAGS) $(LDFLAGS) $(POBJ) $(LIBS) -lpthread
 
 unfold: $(UOBJ)
-	$(CC) -o unfold $(CFLAGS) $(LDFLAGS) $(UOBJ) $(LIBS) 
+	$(CC) -o unfold $(CFLAGS) $(LDFLAGS) $(UOBJ) $(LIBS) -lpthread
+
+flybench: $(BOBJ)
+	$(CC) -o flybench $(CFLAGS) $(LDFLAGS) $(BOBJ) $(METHODOBJ) $(FLIBS)
+
+fly_worker: $(WOBJ)
+	$(CC) -o fly_worker $(CFLAGS) $(LDFLAGS) $(WOBJ) $(LIBS) -lpthread
 
 scramble: $(SOBJ)
 	$(CC) -o scramble $(CFLAGS) $(LDFLAGS) $(SOBJ) $(LIBS) 
 
+# link programs against it with $(LIBS) -lpthread
+libflysim.a: $(LOBJ)
+	rm -f libflysim.a
+	ar rcs libflysim.a $(LOBJ)
+
 # ... and here are the cleanup and make deps rules
 
 clean:
-	rm -f *.o core*
+	rm -f *.o core* libflysim.a flybench fly_worker
 
 Makefile: ${FRC}
 	rm -f $@
@@ -0,0 +1,326 @@
+/**
+ * @file ensemble.c
+ *
+ * @brief Many optimization runs of one input file in one go (--ensemble).
+ *
+ * Runs are child processes, not threads: the model keeps its state
+ * (solver, derivative buffers, statistics) in globals, and a process of
+ * its own also keeps a run that fails from taking the others down. The
+ * children write the costs of their final reference sets into memory
+ * shared with the parent, which collects them for the summary.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE             /* for sched_setaffinity() and CPU_SET */
+#include <sched.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "error.h"
+#include "ensemble.h"
+
+
+/*** CONSTANTS *************************************************************/
+
+#define ENSEMBLE_TOP 10         /* best final parameter sets in the summary */
+
+
+/*** HELPERS ***************************************************************/
+
+/** EnsembleMember: a member of a final reference set, for the summary */
+typedef struct EnsembleMember {
+    int run;
+    int member;
+    double cost;
+} EnsembleMember;
+
+/** Now: monotonic wall clock time in seconds */
+static double
+Now( void ) {
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/** CompareDouble, CompareMember: for qsort() */
+static int
+CompareDouble( const void *a, const void *b ) {
+    double x = *( const double * ) a, y = *( const double * ) b;
+
+    return ( x > y ) - ( x < y );
+}
+
+static int
+CompareMember( const void *a, const void *b ) {
+    return CompareDouble( &( ( const EnsembleMember * ) a )->cost, &( ( const EnsembleMember * ) b )->cost );
+}
+
+/** MakePath: prints 'fmt' into 'path' (of MAX_RECORD chars); a path that
+ *             doesn't fit is an error, not a file somewhere else
+ */
+static void
+MakePath( char *path, const char *fmt, ... ) {
+    va_list ap;
+    int n;
+
+    va_start( ap, fmt );
+    n = vsnprintf( path, MAX_RECORD, fmt, ap );
+    va_end( ap );
+    if( n < 0 || n >= MAX_RECORD )
+        error( "RunEnsemble: path too long (%d chars, at most %d)", n, MAX_RECORD - 1 );
+}
+
+/** CopyFile: copies file 'from' to 'to' */
+static void
+CopyFile( const char *from, const char *to ) {
+    char buf[BUFSIZ];
+    size_t n;
+    FILE *in, *out;
+
+    if( !( in = fopen( from, "r" ) ) )
+        error( "RunEnsemble: could not open %s", from );
+    if( !( out = fopen( to, "w" ) ) )
+        error( "RunEnsemble: could not create %s", to );
+    while( ( n = fread( buf, 1, sizeof( buf ), in ) ) > 0 )
+        if( fwrite( buf, 1, n, out ) != n )
+            error( "RunEnsemble: error writing %s", to );
+    if( ferror( in ) || fclose( out ) )
+        error( "RunEnsemble: error copying %s to %s", from, to );
+    fclose( in );
+}
+
+/** PinToCore: binds the calling process to the 'slot'th core it may run
+ *              on (Linux only, elsewhere the scheduler decides)
+ */
+static void
+PinToCore( int slot ) {
+#ifdef __linux__
+    cpu_set_t allowed, one;
+    int cpu, n = 0;
+
+    if( sched_getaffinity( 0, sizeof( allowed ), &allowed ) )
+        return;
+    slot %= CPU_COUNT( &allowed );
+    for( cpu = 0; cpu < CPU_SETSIZE; cpu++ )
+        if( CPU_ISSET( cpu, &allowed ) && n++ == slot ) {
+            CPU_ZERO( &one );
+            CPU_SET( cpu, &one );
+            sched_setaffinity( 0, sizeof( one ), &one );
+            return;
+        }
+#else
+    ( void ) slot;
+#endif
+}
+
+/** StartRun: forks run 'k' in 'slot'; returns the pid of the child */
+static pid_t
+StartRun( const char *infile, const char *dir, const char *name, int k, int slot, int seed, double *costs, int ncosts, EnsembleRun run, void *arg ) {
+    char rundir[MAX_RECORD], copy[MAX_RECORD], path[MAX_RECORD];
+    pid_t pid;
+    int fd;
+
+    MakePath( rundir, "%s/%03d", dir, k );
+    MakePath( copy, "%s_%03d", name, k );
+    MakePath( path, "%s/%s", rundir, copy );
+    if( mkdir( rundir, 0755 ) && errno != EEXIST )
+        error( "RunEnsemble: could not create directory %s", rundir );
+    CopyFile( infile, path );
+
+    /* nothing the parent printed so far may come out twice */
+    fflush( NULL );
+    if( ( pid = fork(  ) ) < 0 )
+        error( "RunEnsemble: could not start run %d", k );
+    if( pid > 0 )
+        return pid;
+
+    if( chdir( rundir ) )
+        error( "RunEnsemble: could not change to directory %s", rundir );
+    if( ( fd = open( "terminal_output.txt", O_WRONLY | O_CREAT | O_TRUNC, 0644 ) ) < 0 )
+        error( "RunEnsemble: could not create %s/terminal_output.txt", rundir );
+    dup2( fd, STDOUT_FILENO );
+    dup2( fd, STDERR_FILENO );
+    close( fd );
+    PinToCore( slot );
+
+    run( k, seed, copy, costs, ncosts, arg );
+    fflush( NULL );
+    _exit( 0 );
+}
+
+/** WriteSummary: prints the summary of the runs to 'fp' */
+static void
+WriteSummary( FILE * fp, const char *dir, int runs, int seed, const int *status, const double *secs, const double *costs, int ncosts ) {
+    double *best;
+    double mean, var, sum, lo, hi;
+    EnsembleMember *pool;
+    int k, i, n = 0, npool = 0;
+
+    best = ( double * ) malloc( runs * sizeof( double ) );
+    pool = ( EnsembleMember * ) malloc( runs * ncosts * sizeof( EnsembleMember ) );
+    if( !best || !pool )
+        error( "RunEnsemble: could not allocate memory for the summary" );
+
+    fprintf( fp, "Ensemble: %d runs in %s\n", runs, dir );
+    fprintf( fp, "%5s %11s %9s %15s %15s %15s\n", "run", "seed", "seconds", "best", "mean", "worst" );
+    for( k = 0; k < runs; k++ ) {
+        if( status[k] ) {
+            fprintf( fp, "%5d %11d %9.1f %15s\n", k, seed + k, secs[k], "failed" );
+            continue;
+        }
+        sum = 0.;
+        lo = HUGE_VAL;
+        hi = -HUGE_VAL;
+        for( i = 0; i < ncosts; i++ ) {
+            const double c = costs[k * ncosts + i];
+
+            sum += c;
+            lo = fmin( lo, c );
+            hi = fmax( hi, c );
+            pool[npool].run = k;
+            pool[npool].member = i;
+            pool[npool++].cost = c;
+        }
+        best[n++] = lo;
+        fprintf( fp, "%5d %11d %9.1f %15.6f %15.6f %15.6f\n", k, seed + k, secs[k], lo, sum / ncosts, hi );
+    }
+
+    if( n > 0 ) {
+        qsort( best, n, sizeof( double ), CompareDouble );
+        mean = var = 0.;
+        for( k = 0; k < n; k++ )
+            mean += best[k] / n;
+        for( k = 0; k < n; k++ )
+            var += ( best[k] - mean ) * ( best[k] - mean ) / ( n > 1 ? n - 1 : 1 );
+        fprintf( fp, "\nBest costs of %d runs: min %f, median %f, mean %f, sd %f, max %f\n",
+                 n, best[0], ( n % 2 ) ? best[n / 2] : .5 * ( best[n / 2 - 1] + best[n / 2] ), mean, sqrt( var ), best[n - 1] );
+
+        qsort( pool, npool, sizeof( EnsembleMember ), CompareMember );
+        fprintf( fp, "\nBest members of all final reference sets:\n" );
+        fprintf( fp, "%5s %7s %15s\n", "run", "member", "cost" );
+        for( i = 0; i < npool && i < ENSEMBLE_TOP; i++ )
+            fprintf( fp, "%5d %7d %15.6f\n", pool[i].run, pool[i].member, pool[i].cost );
+    }
+    if( n < runs )
+        fprintf( fp, "\n%d runs failed, see terminal_output.txt in their directories\n", runs - n );
+
+    free( best );
+    free( pool );
+}
+
+
+/*** ENSEMBLE **************************************************************/
+
+/** EnsembleJobs: number of cores this process may run on */
+int
+EnsembleJobs( void ) {
+#ifdef __linux__
+    cpu_set_t allowed;
+
+    if( !sched_getaffinity( 0, sizeof( allowed ), &allowed ) )
+        return CPU_COUNT( &allowed );
+#endif
+    long n = sysconf( _SC_NPROCESSORS_ONLN );
+
+    return n > 0 ? ( int ) n : 1;
+}
+
+/** RunEnsemble: does the runs, at most 'jobs' at a time */
+int
+RunEnsemble( const char *infile, const char *outfile, int runs, int jobs, int seed, int ncosts, EnsembleRun run, void *arg ) {
+    char dir[MAX_RECORD], name[MAX_RECORD], summary[MAX_RECORD];
+    const char *slash;
+    double *costs, *secs, *start;
+    int *status, *run_of;
+    pid_t *pids, pid;
+    int next = 0, active = 0, failed = 0;
+    int k, s, wstatus;
+    FILE *fp;
+
+    if( jobs > runs )
+        jobs = runs;
+    MakePath( dir, "%s.runs", outfile );
+    slash = strrchr( outfile, '/' );
+    MakePath( name, "%s", slash ? slash + 1 : outfile );
+    if( mkdir( dir, 0755 ) && errno != EEXIST )
+        error( "RunEnsemble: could not create directory %s", dir );
+
+    /* the children write their costs here, the parent reads them */
+    costs = ( double * ) mmap( NULL, runs * ncosts * sizeof( double ), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+    if( costs == MAP_FAILED )
+        error( "RunEnsemble: could not allocate shared memory for the costs" );
+
+    secs = ( double * ) calloc( runs, sizeof( double ) );
+    start = ( double * ) calloc( runs, sizeof( double ) );
+    status = ( int * ) calloc( runs, sizeof( int ) );
+    run_of = ( int * ) calloc( jobs, sizeof( int ) );
+    pids = ( pid_t * ) calloc( jobs, sizeof( pid_t ) );
+    if( !secs || !start || !status || !run_of || !pids )
+        error( "RunEnsemble: could not allocate memory" );
+
+    printf( "Ensemble: %d runs, %d at a time, seeds %d to %d\n", runs, jobs, seed, seed + runs - 1 );
+
+    /* start a new run whenever a slot is free */
+    while( next < runs || active > 0 ) {
+        for( s = 0; s < jobs && next < runs; s++ )
+            if( !pids[s] ) {
+                run_of[s] = next;
+                start[next] = Now(  );
+                pids[s] = StartRun( infile, dir, name, next, s, seed + next, costs + next * ncosts, ncosts, run, arg );
+                next++;
+                active++;
+            }
+
+        if( ( pid = wait( &wstatus ) ) < 0 ) {
+            if( errno == EINTR )
+                continue;
+            error( "RunEnsemble: lost track of the runs" );
+        }
+        for( s = 0; s < jobs && pids[s] != pid; s++ );
+        if( s == jobs )
+            continue;           /* not one of ours */
+
+        k = run_of[s];
+        pids[s] = 0;
+        active--;
+        secs[k] = Now(  ) - start[k];
+        status[k] = !WIFEXITED( wstatus ) || WEXITSTATUS( wstatus );
+        failed += status[k];
+        if( status[k] )
+            printf( "Ensemble: run %d failed after %.1f s\n", k, secs[k] );
+        else
+            printf( "Ensemble: run %d done in %.1f s\n", k, secs[k] );
+        fflush( stdout );
+    }
+
+    printf( "\n" );
+    WriteSummary( stdout, dir, runs, seed, status, secs, costs, ncosts );
+    MakePath( summary, "%s/summary.txt", dir );
+    if( !( fp = fopen( summary, "w" ) ) )
+        error( "RunEnsemble: could not create %s", summary );
+    WriteSummary( fp, dir, runs, seed, status, secs, costs, ncosts );
+    fclose( fp );
+
+    munmap( costs, runs * ncosts * sizeof( double ) );
+    free( secs );
+    free( start );
+    free( status );
+    free( run_of );
+    free( pids );
+
+    return failed;
+}
@@ -0,0 +1,47 @@
+/**
+ * @file ensemble.h
+ *
+ * @brief Many optimization runs of one input file in one go (--ensemble).
+ *
+ * The input is read and translated once; every run is a child process
+ * forked from the optimizer after that, so all runs share the parsed
+ * facts, weights, history, external inputs and bicoid tables copy-on-write
+ * instead of reading them again. At most 'jobs' runs go at the same time,
+ * each pinned to a core of its own, and a new run starts as soon as one
+ * finishes. Run k works in the directory <datafile>.runs/<kkk> on a copy
+ * of the data file called <datafile>_<kkk> with seed <seed> + k, where
+ * <kkk> is k with three digits (run 7 in .runs/007 on <datafile>_007),
+ * just like the runs of run_many_sss.sh (<datafile> is the output file of
+ * -w, if any); its terminal output goes to terminal_output.txt in that
+ * directory.
+ * RunEnsemble() prints a summary of the final reference sets of all runs
+ * and writes it to <datafile>.runs/summary.txt.
+ */
+
+#ifndef ENSEMBLE_INCLUDED
+#define ENSEMBLE_INCLUDED
+
+/** EnsembleRun: does optimization run 'run' with seed 'seed' on the copy
+ *                'datafile' of the data file (in the working directory)
+ *                and stores the costs of its final reference set in
+ *                'costs' (of 'ncosts' doubles); called in a child process
+ */
+typedef void ( *EnsembleRun ) ( int run, int seed, const char *datafile, double *costs, int ncosts, void *arg );
+
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+/** EnsembleJobs: number of cores this process may run on, the default
+ *                 number of runs at a time
+ */
+int EnsembleJobs( void );
+
+/** RunEnsemble: does 'runs' optimizations of 'infile' with 'run' (which
+ *                gets 'arg'), at most 'jobs' at a time, in the directory
+ *                <outfile>.runs, and prints a summary of their final
+ *                reference sets (of 'ncosts' members each); returns the
+ *                number of runs that failed
+ */
+int RunEnsemble( const char *infile, const char *outfile, int runs, int jobs, int seed, int ncosts, EnsembleRun run, void *arg );
+
+#endif
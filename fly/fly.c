@@ -23,6 +23,7 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>             /* for command line option stuff */
+#include <getopt.h>             /* for long command line options */
 
 /*======
     Utils*/
@@ -38,6 +39,9 @@
 #include "solvers.h"            /* for name of solver funcs */
 #include "zygotic.h"            /* for init, mutators and derivative funcs */
 #include "fly_io.h"
+#include "autotune.h"           /* for --autotune */
+#include "farm.h"               /* for --farm */
+#include "ensemble.h"           /* for --ensemble */
 
 /*=================
     Scatter Search
@@ -73,6 +77,19 @@ const char *OPTS = ":a:b:Bc:C:De:Ef:g:hi:lLm:nNopQr:s:StTvw:W:y:";
 /* D will be debug, like scramble, score */
 /* must start with :, option with argument must have a : following */
 
+/* long options, each of them maps to a short option that is not in OPTS */
+static struct option LONG_OPTS[] = {
+    {"resume", no_argument, NULL, 'R'},
+    {"normalize-distances", no_argument, NULL, 'Z'},
+    {"autotune", optional_argument, NULL, 'U'},
+    {"screen", optional_argument, NULL, 'X'},
+    {"lockstep", optional_argument, NULL, 'K'},
+    {"farm", required_argument, NULL, 'F'},
+    {"ensemble", required_argument, NULL, 'J'},
+    {"budget", required_argument, NULL, 'G'},
+    {NULL, 0, NULL, 0}
+};
+
 
 /*** STATIC VARIABLES ******************************************************/
 
@@ -81,7 +98,11 @@ static const char usage[] =
     "Usage: fly_X [-a <accuracy>] [-b <bkup_freq>] [-B] [-e <freeze_crit>] [-E]\n"
     "              [-f <param_prec>] [-g <g(u)>] [-h] [-i <stepsize>] [-l] [-L] \n"
     "              [-m <score_method>] [-n] [-N] [-p] [-Q] [-s <solver>] [-t] [-v]\n"
-    "              [-w <out_file>] [-y <log_freq>]\n" "              <datafile>\n";
+    "              [-w <out_file>] [-y <log_freq>] [--resume]\n"
+    "              [--normalize-distances] [--autotune[=<max_error>]]\n"
+    "              [--screen[=<iterations>]] [--lockstep[=<sets>]]\n"
+    "              [--farm=<port>] [--ensemble=<runs>[:<jobs>]]\n"
+    "              [--budget=<derivs>[:<steps>[:<seconds>[:<max_conc>]]]] <datafile>\n";
 
 static const char help[] =
     "Usage: fly_X [options] <datafile>\n\n"
@@ -89,7 +110,7 @@ static const char help[] =
     "  <datafile>          input data file\n\n"
     "Options:\n"
     "  -a <accuracy>       solver accuracy for adaptive stepsize ODE solvers\n"
-    "  -b <bkup_freq>      write state file every <bkup_freq> * tau moves\n" "  -B                  run in benchmark mode (only do fixed initial steps)\n"
+    "  -b <bkup_freq>      write a checkpoint every <bkup_freq> iterations (0: never)\n" "  -B                  run in benchmark mode (only do fixed initial steps)\n"
     "  -D                  debugging mode, prints all kinds of debugging info\n"
     "  -e <freeze_crit>    set annealing freeze criterion to <freeze_crit>\n"
     "  -E                  run in equilibration mode\n"
@@ -103,7 +124,32 @@ static const char help[] =
     "  -o                  use oldstyle cell division times (3 div only)\n" "  -p                  prints move acceptance stats to .prolix file\n"
     "  -s <solver>         choose ODE solver\n"
     "  -v                  print version and compilation date\n" "  -w <out_file>       write output to <out_file> instead of <datafile>\n"
-    "  -y <log_freq>       write log every <log_freq> * tau moves\n\n" "Please report bugs to <yoginho@usa.net>. Thank you!\n";
+    "  -y <log_freq>       write log every <log_freq> * tau moves\n"
+    "  --resume            continue the run from its last checkpoint\n"
+    "  --normalize-distances\n"
+    "                      measure distances between parameter sets relative to\n"
+    "                      the parameter ranges\n"
+    "  --autotune[=<max_error>]\n"
+    "                      choose the fastest solver, stepsize and accuracy whose\n"
+    "                      chisq is within <max_error> (relative, default 0.001)\n"
+    "                      of a high-accuracy reference (with -s sd: its accuracy)\n"
+    "  --screen[=<iterations>]\n"
+    "                      rank the initial scatter set and the candidates of the\n"
+    "                      first <iterations> (default 10) iterations in single\n"
+    "                      precision (-s r4 and rck only)\n"
+    "  --lockstep[=<sets>] integrate the model for <sets> (default 16) parameter\n"
+    "                      sets at once (-s e, me, h, r2 and r4 only)\n"
+    "  --farm=<port>       let fly_worker processes that connect to TCP <port>\n"
+    "                      score the parameter sets\n"
+    "  --ensemble=<runs>[:<jobs>]\n"
+    "                      do <runs> runs with seeds <seed>, <seed> + 1, ... on\n"
+    "                      the input read once, <jobs> (default: all cores) at a\n"
+    "                      time, in <out_file>.runs\n"
+    "  --budget=<derivs>[:<steps>[:<seconds>[:<max_conc>]]]\n"
+    "                      stop a model run after <derivs> derivative evaluations,\n"
+    "                      <steps> solver steps or <seconds> seconds (0: no limit)\n"
+    "                      or once a concentration is beyond <max_conc> or not\n"
+    "                      finite, and score its parameter set as forbidden\n\n" "Please report bugs to <yoginho@usa.net>. Thank you!\n";
 
 static char version[MAX_RECORD];        /* version gets set below */
 static char *argvsave;          /* static string for saving command line */
@@ -112,6 +158,17 @@ static double stepsize = 1.;    /* stepsize for solver */
 static double accuracy = 0.001; /* accuracy for solver (not used yet) */
 static int precision = 8;       /* precision for eqparms */
 static int method = 0;          /* 0 for wls, 1 for ols */
+static int bkup_freq = 10;      /* checkpoint every bkup_freq iterations */
+static int resume = 0;          /* continue from the last checkpoint? */
+static int normalize_dist = 0;  /* distances relative to parameter ranges? */
+static double autotune = 0.;    /* max. chisq error for --autotune, 0: off */
+static int screen = -1;         /* iterations screened by --screen, -1: off */
+static int lockstep = 1;        /* parameter sets per model run (--lockstep) */
+static int farm_port = 0;       /* TCP port for fly_worker (--farm), 0: off */
+static int ensemble_runs = 0;   /* runs of --ensemble, 0: off */
+static int ensemble_jobs = 0;   /* runs at a time, 0: one per core */
+static const char *solver_name = "rck"; /* -s and g(u) as the workers need them */
+static char gofu_name = 's';
 
 // static int prolix_flag = 0;     /* to prolix or not to prolix */
 // static int landscape_flag = 0;  /* generate energy landscape data */
@@ -144,6 +201,7 @@ int
 ParseCommandLine( int argc, char **argv ) {
 
     int c, i;                   /* used to parse command line options */
+    double budget[4];           /* fields of --budget */
 
     /* external declarations for command line option parsing (unistd.h) */
     extern char *optarg;        /* command line option argument */
@@ -165,13 +223,60 @@ ParseCommandLine( int argc, char **argv ) {
 
     /* parse command line for options and their arguments */
     optarg = NULL;
-    while( ( c = getopt( argc, argv, OPTS ) ) != -1 ) {
+    while( ( c = getopt_long( argc, argv, OPTS, LONG_OPTS, NULL ) ) != -1 ) {
         switch ( c ) {
         case 'a':
             accuracy = atof( optarg );
             if( accuracy <= 0 )
                 error( "fly_X: accuracy (%g) is too small", accuracy );
             break;
+        case 'b':              /* -b sets the checkpoint frequency */
+            bkup_freq = atoi( optarg );
+            if( bkup_freq < 0 )
+                error( "fly_X: checkpoint frequency (%d) must be positive or 0", bkup_freq );
+            break;
+        case 'R':              /* --resume continues from the checkpoint */
+            resume = 1;
+            break;
+        case 'Z':              /* --normalize-distances */
+            normalize_dist = 1;
+            break;
+        case 'U':              /* --autotune[=<max_error>] */
+            autotune = optarg ? atof( optarg ) : 0.001;
+            if( autotune <= 0 )
+                error( "fly_X: autotune error bound (%s) must be positive", optarg );
+            break;
+        case 'X':              /* --screen[=<iterations>] */
+            screen = optarg ? atoi( optarg ) : 10;
+            if( screen < 0 )
+                error( "fly_X: number of screened iterations (%d) must be positive or 0", screen );
+            break;
+        case 'K':              /* --lockstep[=<sets>] */
+            lockstep = optarg ? atoi( optarg ) : 16;
+            if( lockstep < 1 )
+                error( "fly_X: number of lockstep parameter sets (%d) must be positive", lockstep );
+            break;
+        case 'F':              /* --farm=<port> */
+            farm_port = atoi( optarg );
+            if( farm_port < 1 || farm_port > 65535 )
+                error( "fly_X: invalid farm port (%s)", optarg );
+            break;
+        case 'J':              /* --ensemble=<runs>[:<jobs>] */
+            if( sscanf( optarg, "%d:%d", &ensemble_runs, &ensemble_jobs ) < 1 || ensemble_runs < 1 || ensemble_jobs < 0 )
+                error( "fly_X: invalid ensemble (%s), use <runs>[:<jobs>]", optarg );
+            break;
+        case 'G':              /* --budget=<derivs>[:<steps>[:<seconds>[:<max_conc>]]] */
+            budget[1] = budget[2] = budget[3] = 0.;
+            /* the counts have to fit their unsigned longs (NaN fails too) */
+            if( sscanf( optarg, "%lf:%lf:%lf:%lf", &budget[0], &budget[1], &budget[2], &budget[3] ) < 1
+                || !( budget[0] >= 0 && budget[0] < ( double ) ULONG_MAX ) || !( budget[1] >= 0 && budget[1] < ( double ) ULONG_MAX )
+                || !( budget[2] >= 0 ) || !( budget[3] >= 0 ) )
+                error( "fly_X: invalid budget (%s), use <derivs>[:<steps>[:<seconds>[:<max_conc>]]]", optarg );
+            solver_budget.derivs = ( unsigned long ) budget[0];
+            solver_budget.steps = ( unsigned long ) budget[1];
+            solver_budget.seconds = budget[2];
+            solver_budget.max_conc = budget[3];
+            break;
         case 'D':
             debug = 1;
             break;
@@ -196,6 +301,7 @@ ParseCommandLine( int argc, char **argv ) {
                 gofu = Kolja;
             } else
                 error( "fly_X: %s is an invalid g(u), should be e, h, s or t", optarg );
+            gofu_name = optarg[0];
             break;
         case 'h':              /* -h help option */
             PrintMsg( help, 0 );
@@ -219,36 +325,9 @@ ParseCommandLine( int argc, char **argv ) {
             olddivstyle = 1;
             break;
         case 's':              /* -s sets solver to be used */
-            if( !( strcmp( optarg, "a" ) ) )
-                ps = Adams;
-            else if( !( strcmp( optarg, "bd" ) ) )
-                ps = BaDe;
-            else if( !( strcmp( optarg, "bs" ) ) )
-                ps = BuSt;
-            else if( !( strcmp( optarg, "e" ) ) )
-                ps = Euler;
-            else if( !( strcmp( optarg, "h" ) ) )
-                ps = Heun;
-            else if( !( strcmp( optarg, "mi" ) ) || !( strcmp( optarg, "m" ) ) )
-                ps = Milne;
-            else if( !( strcmp( optarg, "me" ) ) )
-                ps = Meuler;
-            else if( !( strcmp( optarg, "r4" ) ) || !( strcmp( optarg, "r" ) ) )
-                ps = Rk4;
-            else if( !( strcmp( optarg, "r2" ) ) )
-                ps = Rk2;
-            else if( !( strcmp( optarg, "rck" ) ) )
-                ps = Rkck;
-            else if( !( strcmp( optarg, "rf" ) ) )
-                ps = Rkf;
-            else if( !( strcmp( optarg, "sd" ) ) )
-                ps = SoDe;
-            else if( !( strcmp( optarg, "kr" ) ) )
-                ps = Krylov;
-            /* else if (!(strcmp(optarg, "bnd")))
-               ps = Band; */
-            else
-                error( "fly_X: invalid solver (%s), use: a,bs,e,h,kr,mi,me,r{2,4,ck,f}", optarg );
+            if( !( ps = SolverByName( optarg ) ) )
+                error( "fly_X: invalid solver (%s), use: " SOLVER_NAMES, optarg );
+            solver_name = optarg;
             break;
         case 'v':              /* -v prints version message */
             fprintf( stderr, "%s\n", version );
@@ -270,6 +349,10 @@ ParseCommandLine( int argc, char **argv ) {
     /* error checking here */
     if( ( ( argc - ( optind - 1 ) ) != 2 ) )
         PrintMsg( usage, 1 );
+    if( farm_port && method != 0 )
+        error( "fly_X: fly_worker only scores with -m w, can't use --farm with -m o" );
+    if( farm_port && ensemble_runs )
+        error( "fly_X: can't use --farm with --ensemble, the runs would share the port" );
 
     argvsave = ( char * ) calloc( MAX_RECORD, sizeof( char ) );
     for( i = 0; i < argc; i++ ) {
@@ -282,6 +365,89 @@ ParseCommandLine( int argc, char **argv ) {
     return optind;
 }
 
+/** AutoTuneSolver: installs the solver settings chosen by AutoTune() and
+ *                   appends them to the command line for the version section
+ */
+static void
+AutoTuneSolver( void ) {
+    SolverChoice c;
+    char *line;
+
+    c = AutoTune( &inp, autotune );
+    if( !c.solver ) {
+        warning( "fly_X: no solver setting is within the autotune error bound %g, keeping -s/-i/-a", autotune );
+        return;
+    }
+    printf( "Autotune: using -s %s -i %g -a %g\n", c.name, c.stepsize, c.accuracy );
+
+    ps = c.solver;
+    solver_name = c.name;
+    stepsize = inp.ste.stepsize = c.stepsize;
+    accuracy = inp.ste.accuracy = c.accuracy;
+
+    line = ( char * ) calloc( MAX_RECORD, sizeof( char ) );
+    sprintf( line, "autotune: -s %s -i %g -a %g (max. chisq error %.2e, %.3f ms per Score)\n", c.name, c.stepsize, c.accuracy, c.error, 1000. * c.time );
+    argvsave = ( char * ) realloc( argvsave, strlen( argvsave ) + strlen( line ) + 1 );
+    argvsave = strcat( argvsave, line );
+    free( line );
+}
+
+/** OpenWorkerFarm: listens for fly_worker on the --farm port; the
+ *                   workers get the solver settings in use (see Setup()
+ *                   in flyworker.c)
+ */
+static Farm *
+OpenWorkerFarm( void ) {
+    char config[MAX_RECORD];
+
+    sprintf( config, "input %s %c %.17g %.17g %d %lu %lu %.17g %.17g", solver_name, gofu_name, inp.ste.stepsize, inp.ste.accuracy, olddivstyle,
+             solver_budget.derivs, solver_budget.steps, solver_budget.seconds, solver_budget.max_conc );
+    return OpenFarm( farm_port, inp.tra.size, config );
+}
+
+/** RunOptimizer: writes the version section and runs the optimizer on
+ *                 files.outputfile
+ */
+static void
+RunOptimizer( ScoreOutput *out ) {
+
+    /* write out command line to version string */
+    WriteVersion( files.outputfile, version, argvsave );
+
+    /* do actual optimization */
+    #ifdef SS
+        InitSS(&inp, &ssParams, &files);
+        RunSS(&inp, &ssParams, &files);
+        if( ssParams.farm )
+            CloseFarm( ssParams.farm, stdout );
+    #elif defined(ESS)
+        init_eSS( &essParams, &inp, out, files.inputfile);
+        run_eSS( &essParams, &inp, out, files.inputfile);
+        if( essParams.farm )
+            CloseFarm( essParams.farm, stdout );
+    #endif
+}
+
+/** EnsembleOptimize: one run of --ensemble, see EnsembleRun in ensemble.h */
+static void
+EnsembleOptimize( int run, int seed, const char *datafile, double *costs, int ncosts, void *arg ) {
+
+    printf( "Ensemble: run %d, seed %d\n", run, seed );
+    strcpy( files.inputfile, datafile );
+    strcpy( files.outputfile, datafile );
+
+    #ifdef SS
+        ssParams.seed = seed;
+        ssParams.final_costs = costs;
+        RunOptimizer( ( ScoreOutput * ) arg );
+    #elif defined(ESS)
+        essParams.seed = seed;
+        RunOptimizer( ( ScoreOutput * ) arg );
+        for( int i = 0; i < ncosts; i++ )
+            costs[i] = essParams.refSet->members[i].cost;
+    #endif
+}
+
 /*
     Initializing optimization specific variables and call the select optimization procedure.
 */
@@ -320,28 +486,60 @@ Optimize( DistParms *distp, ScoreOutput *out ) {
     /* reading optimization algorithm specific paramters */
     #ifdef SS
         ssParams = ReadSSParameters(infile, &inp);
+        ssParams.perform_resume = resume;
+        ssParams.checkpoint_freq = bkup_freq;
+        ssParams.perform_normalize_distances = normalize_dist;
+        ssParams.perform_screening = ( screen >= 0 );
+        ssParams.screen_iters = screen;
+        ssParams.lockstep = lockstep;
     #elif defined(ESS)
         init_defaultSettings(&essParams);
         essParams = ReadeSSParameters(infile, &inp);
+        essParams.perform_resume = resume;
+        essParams.checkpoint_freq = bkup_freq;
+        essParams.perform_normalize_distances = normalize_dist;
+        essParams.perform_screening = ( screen >= 0 );
+        essParams.screen_iters = screen;
+        essParams.screen_rho = 0;
+        essParams.screen_n = 0;
+        essParams.lockstep = lockstep;
     #endif        
 
     /* input file read, copy parameters */
     fclose( infile );
     inp.lparm = CopyParm( inp.zyg.parm, &( inp.zyg.defs ) );
-    /* write out command line to version string */
-    WriteVersion( files.outputfile, version, argvsave );
 
-    /* do actual optimization */
+    /* pick solver settings; they go into the version section below */
+    if( autotune > 0 )
+        AutoTuneSolver(  );
+
+    /* workers score with these settings as well */
     #ifdef SS
-        InitSS(&inp, &ssParams, &files);
-        RunSS(&inp, &ssParams, &files);
+        ssParams.farm = farm_port ? OpenWorkerFarm(  ) : NULL;
+        ssParams.final_costs = NULL;
     #elif defined(ESS)
-        init_eSS( &essParams, &inp, out, files.inputfile);
-        run_eSS( &essParams, &inp, out, files.inputfile);
+        essParams.farm = farm_port ? OpenWorkerFarm(  ) : NULL;
     #endif
 
+    /* the runs of an ensemble share everything read so far */
+    if( ensemble_runs ) {
+        #ifdef SS
+            int seed = ssParams.seed, ncosts = ssParams.ref_set_size;
+        #elif defined(ESS)
+            int seed = essParams.seed, ncosts = essParams.n_refSet;
+        #endif
+        int failed = RunEnsemble( files.inputfile, files.outputfile, ensemble_runs, ensemble_jobs ? ensemble_jobs : EnsembleJobs(  ),
+                                  seed, ncosts, EnsembleOptimize, out );
+
+        if( failed )
+            warning( "fly_X: %d of %d ensemble runs failed", failed, ensemble_runs );
+    } else
+        RunOptimizer( out );
+
     /* Clean up */
     FreeMutant( inp.lparm );
+    FreeSolvers(  );
+    FreeLanes(  );
 }
 
 
@@ -18,6 +18,7 @@
 #include <unistd.h>
 
 #include "fly_io.h"
+#include "zygotic.h"             /* for AllocParm() */
 
 
 /** Eliminate newline characters */
@@ -212,19 +213,8 @@ ReadParameters( FILE * fp, TheProblem defs, char *section_title ) {
         skip1 = strcat( skip1, skip_fmt );
     }
 
-    // initialize the EqParm struct
-    l_parm.R = ( double * ) calloc( defs.ngenes, sizeof( double ) );
-    l_parm.T = ( double * ) calloc( defs.ngenes * defs.ngenes, sizeof( double ) );
-    l_parm.E = ( double * ) calloc( defs.ngenes * defs.egenes, sizeof( double ) );
-    l_parm.m = ( double * ) calloc( defs.ngenes, sizeof( double ) );
-    l_parm.h = ( double * ) calloc( defs.ngenes, sizeof( double ) );
-    if( ( defs.diff_schedule == 'A' ) || ( defs.diff_schedule == 'C' ) ) {
-        l_parm.d = ( double * ) malloc( sizeof( double ) );
-    } else {
-        l_parm.d = ( double * ) calloc( defs.ngenes, sizeof( double ) );
-    }
-    l_parm.lambda = ( double * ) calloc( defs.ngenes, sizeof( double ) );
-    l_parm.tau = ( double * ) calloc( defs.ngenes, sizeof( double ) );
+    // initialize the EqParm struct (one buffer, see AllocParm())
+    l_parm = AllocParm( &defs );
 
     fp = FindSection( fp, section_title );      // find input section
     if( !fp )
@@ -366,19 +356,8 @@ ReadParametersX( double *x, TheProblem defs ) {
     int i, j;                   // local loop counter
     //int len_x;                // length of the input (parameter) array
 
-    // initialize the EqParm struct
-    l_parm.R = ( double * ) calloc( defs.ngenes, sizeof( double ) );
-    l_parm.T = ( double * ) calloc( defs.ngenes * defs.ngenes, sizeof( double ) );
-    l_parm.E = ( double * ) calloc( defs.ngenes * defs.egenes, sizeof( double ) );
-    l_parm.m = ( double * ) calloc( defs.ngenes, sizeof( double ) );
-    l_parm.h = ( double * ) calloc( defs.ngenes, sizeof( double ) );
-    if( ( defs.diff_schedule == 'A' ) || ( defs.diff_schedule == 'C' ) ) {
-        l_parm.d = ( double * ) calloc( defs.ngenes, sizeof( double ) );
-    } else {
-        l_parm.d = ( double * ) calloc( defs.ngenes, sizeof( double ) );
-    }
-    l_parm.lambda = ( double * ) calloc( defs.ngenes, sizeof( double ) );
-    l_parm.tau = ( double * ) calloc( defs.ngenes, sizeof( double ) );
+    // initialize the EqParm struct (one buffer, see AllocParm())
+    l_parm = AllocParm( &defs );
 
     // len_x = sizeof( x ) / sizeof( double );
     j = 0;
@@ -539,6 +518,154 @@ WriteParameters( char *filename, EqParms * p, char *title, int ndigits, TheProbl
     free( shell_cmd );
 }
 
+/** NextLine: start of the line after the one at 'p' in a file in memory
+ *             that ends at 'end'
+ */
+static char *
+NextLine( char *p, char *end ) {
+    char *nl = memchr( p, '\n', end - p );
+
+    return nl ? nl + 1 : end;
+}
+
+/** FindLine: first line from 'p' on that starts with 'prefix', or NULL */
+static char *
+FindLine( char *p, char *end, const char *prefix ) {
+    size_t length = strlen( prefix );
+
+    for( ; p < end; p = NextLine( p, end ) )
+        if( !strncmp( p, prefix, length ) )
+            return p;
+    return NULL;
+}
+
+/** SectionEnd: start of the line after the '$$' of the section at 'p' */
+static char *
+SectionEnd( char *p, char *end ) {
+    for( p = NextLine( p, end ); p < end && strncmp( p, "$$", 2 ); p = NextLine( p, end ) );
+    return NextLine( p, end );
+}
+
+/** NextSection: start of the next line from 'p' on that starts with '$' */
+static char *
+NextSection( char *p, char *end ) {
+    for( ; p < end && *p != '$'; p = NextLine( p, end ) );
+    return p;
+}
+
+/** ReadParmTemplate: reads 'filename' into memory, cut where
+ *                     WriteParameters() would put the section 'title'
+ *                     ('input' or 'eqparms') and without the old one
+ */
+ParmTemplate *
+ReadParmTemplate( char *filename, char *title ) {
+    char fulltitle[MAX_RECORD];
+    char *buf, *end, *p, *q;
+    long size;
+    FILE *fp;
+    ParmTemplate *t;
+
+    if( !( fp = fopen( filename, "r" ) ) )
+        error( "ReadParmTemplate: error opening file %s", filename );
+    if( fseek( fp, 0, SEEK_END ) )
+        error( "ReadParmTemplate: error reading file %s", filename );
+    size = ftell( fp );
+    if( size < 0 )
+        error( "ReadParmTemplate: error reading file %s", filename );
+    rewind( fp );
+    if( !( buf = ( char * ) malloc( size + 1 ) ) )
+        error( "ReadParmTemplate: could not allocate memory for %s", filename );
+    if( fread( buf, 1, size, fp ) != ( size_t ) size )
+        error( "ReadParmTemplate: error reading file %s", filename );
+    fclose( fp );
+    buf[size] = '\0';
+    end = buf + size;
+
+    /* erase the old section like KillSection() */
+    snprintf( fulltitle, MAX_RECORD, "$%s", title );
+    if( ( p = FindLine( buf, end, fulltitle ) ) ) {
+        q = NextSection( SectionEnd( p, end ), end );
+        memmove( p, q, end - q + 1 );
+        end -= q - p;
+    }
+
+    /* the new one goes after 'input' (eqparms) or 'genotypes' (input) */
+    if( !strcmp( title, "input" ) )
+        p = FindLine( buf, end, "$genotypes" );
+    else if( !strcmp( title, "eqparms" ) )
+        p = FindLine( buf, end, "$input" );
+    else
+        error( "ReadParmTemplate: can't place section %s", title );
+    if( !p )
+        error( "ReadParmTemplate: no section to put %s after in %s", title, filename );
+    p = SectionEnd( p, end );
+    q = NextSection( p, end );
+
+    t = ( ParmTemplate * ) malloc( sizeof( ParmTemplate ) );
+    t->nhead = p - buf + 1;
+    t->ntail = end - q + 1;
+    t->head = ( char * ) malloc( t->nhead + 1 );
+    t->tail = ( char * ) malloc( t->ntail + 1 );
+    if( !t->head || !t->tail )
+        error( "ReadParmTemplate: could not allocate memory for %s", filename );
+    memcpy( t->head, buf, p - buf );
+    strcpy( t->head + ( p - buf ), "\n" );
+    t->tail[0] = '\n';
+    memcpy( t->tail + 1, q, end - q + 1 );
+
+    free( buf );
+    return t;
+}
+
+/** ReplaceInTemplate: replaces the first 'from' in the template by 'to' */
+void
+ReplaceInTemplate( ParmTemplate * t, const char *from, const char *to ) {
+    char **text = &( t->head );
+    size_t *n = &( t->nhead );
+    size_t lfrom = strlen( from ), lto = strlen( to );
+    char *p, *s;
+
+    if( !( p = strstr( t->head, from ) ) ) {
+        if( !( p = strstr( t->tail, from ) ) )
+            return;
+        text = &( t->tail );
+        n = &( t->ntail );
+    }
+    if( !( s = ( char * ) malloc( *n - lfrom + lto + 1 ) ) )
+        error( "ReplaceInTemplate: could not allocate memory" );
+    memcpy( s, *text, p - *text );
+    memcpy( s + ( p - *text ), to, lto );
+    strcpy( s + ( p - *text ) + lto, p + lfrom );
+    free( *text );
+    *text = s;
+    *n += lto - lfrom;
+}
+
+/** WriteParmTemplate: writes the template to 'filename' with the section
+ *                      'title' of 'p' in its place; gives the same file as
+ *                      copying the template file and WriteParameters()
+ */
+void
+WriteParmTemplate( ParmTemplate * t, char *filename, EqParms * p, char *title, int ndigits, TheProblem defs ) {
+    FILE *fp;
+
+    if( !( fp = fopen( filename, "w" ) ) )
+        error( "WriteParmTemplate: error opening output file %s", filename );
+    if( fwrite( t->head, 1, t->nhead, fp ) != t->nhead )
+        error( "WriteParmTemplate: error writing output file %s", filename );
+    PrintParameters( fp, p, title, ndigits, defs );
+    if( fwrite( t->tail, 1, t->ntail, fp ) != t->ntail || fclose( fp ) )
+        error( "WriteParmTemplate: error writing output file %s", filename );
+}
+
+/** FreeParmTemplate: frees a template of ReadParmTemplate() */
+void
+FreeParmTemplate( ParmTemplate * t ) {
+    free( t->head );
+    free( t->tail );
+    free( t );
+}
+
 /** PrintParameters: prints an eqparms section with 'title' to the stream   
  *  indicated by fp 
  */
@@ -888,6 +1015,8 @@ ReadSSParameters( FILE * fp, Input *inp ) {
     inp->sco.searchspace = InitLimits( fp, inp );
     /* if necessary override with explicit limits */
     Penalty2Limits( inp->sco.searchspace, inp->zyg.defs );
+    /* and compile them for the bounds check of Score() */
+    InitBounds( inp, &( inp->tra ) );
 
     l_ssParams.min_real_var = (double*) malloc(l_ssParams.nreal * sizeof(double));
     l_ssParams.max_real_var = (double*) malloc(l_ssParams.nreal * sizeof(double));
@@ -1230,6 +1359,7 @@ ReadeSSParameters( FILE * fp, Input *inp ) {
 
     inp->sco.searchspace = InitLimits( fp, inp );               /* Reading the fly variable */
     Penalty2Limits( inp->sco.searchspace, inp->zyg.defs );      /* convert to explicit limits */
+    InitBounds( inp, &( inp->tra ) );                           /* compile them for Score() */
 
     l_eSSParams.min_real_var = (double *)malloc(l_eSSParams.n_Params * sizeof(double));
     l_eSSParams.max_real_var = (double *)malloc(l_eSSParams.n_Params * sizeof(double));
@@ -2410,26 +2540,34 @@ InitDistribution( FILE * fp ) {
  */
 void
 PrintBlastoderm( FILE * fp, NArrPtr table, char *id, int ndigits, Zygote * zyg ) {
-    int i, j, k;                /* local loop counters */
-    int lineage;                /* lineage number for nucleus */
-    int columns = zyg->defs.ngenes;
+    int i;                      /* local loop counter */
     /* print title (id) */
     fprintf( fp, "$%s\n", id );
     /* print table with correct lineage numbers (obtained from maternal.c) */
-    for( i = 0; i < table.size; i++ ) {
-        for( j = 0; j < ( table.array[i].state.size / columns ); j++ ) {
-            lineage = GetStartLin( table.array[i].time, zyg->defs, zyg->lin_start, &( zyg->times ) ) + j;
-            fprintf( fp, "%5d %9.3f", lineage, table.array[i].time );
-            for( k = 0; k < columns; k++ ) 
-                fprintf( fp, " %*.*f", ndigits + 5, ndigits, table.array[i].state.array[k + ( j * columns )] );                            
-            fprintf( fp, "\n" );
-        }
-        fprintf( fp, "\n\n" );
-    }
+    for( i = 0; i < table.size; i++ )
+        PrintBlastodermState( fp, table.array[i].time, table.array[i].state.array, table.array[i].state.size, ndigits, zyg );
     fprintf( fp, "$$\n" );
     fflush( fp );
 }
 
+/** PrintBlastodermState: prints the rows of PrintBlastoderm for the   
+ *                         'size' concentrations 'state' at 'time'     
+ */
+void
+PrintBlastodermState( FILE * fp, double time, const double *state, int size, int ndigits, Zygote * zyg ) {
+    int j, k;                   /* local loop counters */
+    int lineage;                /* lineage number for nucleus */
+    int columns = zyg->defs.ngenes;
+    for( j = 0; j < ( size / columns ); j++ ) {
+        lineage = GetStartLin( time, zyg->defs, zyg->lin_start, &( zyg->times ) ) + j;
+        fprintf( fp, "%5d %9.3f", lineage, time );
+        for( k = 0; k < columns; k++ ) 
+            fprintf( fp, " %*.*f", ndigits + 5, ndigits, state[k + ( j * columns )] );                            
+        fprintf( fp, "\n" );
+    }
+    fprintf( fp, "\n\n" );
+}
+
 
 /** WriteVersion: prints the version and the complete command line used 
  *                 to run fly_sa into the $version section of the data  
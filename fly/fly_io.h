@@ -136,6 +136,35 @@ void WriteParameters( char *filename, EqParms * p, char *title, int ndigits, The
  */
 void PrintParameters( FILE * fp, EqParms * p, char *title, int ndigits, TheProblem defs );
 
+/** ParmTemplate: a data file in memory, cut where a parameter section goes,
+ *                 for writing many copies of it with different parameters
+ *                 (the reference sets) without reading it again each time
+ */
+typedef struct ParmTemplate {
+    char *head;                 /* everything up to the section */
+    size_t nhead;
+    char *tail;                 /* everything after it */
+    size_t ntail;
+} ParmTemplate;
+
+/** ReadParmTemplate: reads 'filename' into memory, cut where
+ *                     WriteParameters() would put the section 'title'
+ *                     ('input' or 'eqparms') and without the old one
+ */
+ParmTemplate *ReadParmTemplate( char *filename, char *title );
+
+/** ReplaceInTemplate: replaces the first 'from' in the template by 'to' */
+void ReplaceInTemplate( ParmTemplate * t, const char *from, const char *to );
+
+/** WriteParmTemplate: writes the template to 'filename' with the section
+ *                      'title' of 'p' in its place; gives the same file as
+ *                      copying the template file and WriteParameters()
+ */
+void WriteParmTemplate( ParmTemplate * t, char *filename, EqParms * p, char *title, int ndigits, TheProblem defs );
+
+/** FreeParmTemplate: frees a template of ReadParmTemplate() */
+void FreeParmTemplate( ParmTemplate * t );
+
 /** ReadGuts: reads the $gutsdefs section in a data file into an array 
  *             of strings which then need to get parsed                    
  */
@@ -229,6 +258,12 @@ DistParms InitDistribution( FILE * fp );
  */
 void PrintBlastoderm( FILE * fp, NArrPtr table, char *id, int ndigits, Zygote * zyg );
 
+/** PrintBlastodermState: prints the rows of PrintBlastoderm for the   
+ *                         'size' concentrations 'state' at 'time',    
+ *                         e.g. for a TabSink of BlastodermStream()    
+ */
+void PrintBlastodermState( FILE * fp, double time, const double *state, int size, int ndigits, Zygote * zyg );
+
 /** WriteVersion: prints the version and the complete command line used 
  *                 to run fly_sa into the $version section of the data     
  *                 file                                                    
@@ -0,0 +1,720 @@
+/**
+ * @file flybench.c
+ *
+ * @brief Benchmark harness for the simulator and the optimizers.
+ *
+ * flybench reads one or more input files and times the parts of the code
+ * an optimization run spends its time in:
+ *   - the derivative functions DvdtOrig and DvdtDelay (calls per second)
+ *   - one Blastoderm run of the first genotype with each of a list of
+ *     solvers
+ *   - Blastoderm plus Eval for every genotype, and a complete Score
+ *   - one iteration of the optimizer it was compiled for (Scatter Search
+ *     with METHOD=-DSS, enhanced Scatter Search with METHOD=-DESS) at a
+ *     fixed seed
+ *
+ * Every measurement is repeated (-r) and written to a JSON file as median
+ * and variance of the repeats, so that the numbers of two builds can be
+ * compared. 'make bench' builds flybench and runs it on the sample files
+ * in output/.
+ *
+ * The optimizer iteration uses a small reference set (BENCH_REF_SET) and
+ * scatter set (BENCH_SCATTER_SET) and no local search, so that it takes
+ * seconds rather than minutes; the other optimizer settings come from the
+ * $ss section of the input file, or for eSS from an $ess section that is
+ * appended to the input if it has none (see bench_ess_section). The
+ * optimizers write their usual output files; they go to a scratch
+ * directory that is removed afterwards.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>             /* for getopt, chdir */
+#include <dirent.h>
+
+#include <error.h>
+#include <integrate.h>
+#include <maternal.h>
+#include <score.h>
+#include <solvers.h>
+#include <zygotic.h>
+#include <fly_io.h>
+
+#ifdef SS
+    #include "ss.h"
+#elif defined(ESS)
+    #include "ess.h"
+#endif
+
+
+/*** Constants *************************************************************/
+
+const char *OPTS = ":a:g:hi:o:r:s:S:x:";        /* command line option string */
+
+#define BENCH_SEED        936899377     /* fixed seed of the optimizer runs */
+#define BENCH_REF_SET     20    /* reference set size of the optimizer runs */
+#define BENCH_SCATTER_SET 100   /* scatter set size of the optimizer runs */
+#define DERIV_CALLS       1000  /* derivative calls per timed repeat */
+#define BENCH_LOCKSTEP    16    /* parameter sets of the lockstep Score runs */
+#define MAX_REPEATS       1000
+
+/* solvers timed with Blastoderm unless -S says otherwise */
+static const char default_solvers[] = "r4,rck,dp,rf,bs,bd,kr,sd";
+
+#ifdef ESS
+/* $ess section used if the input file has none; labels as in ReadeSSParameters() */
+static const char bench_ess_section[] =
+    "\n$ess\n"
+    "seed:\n936899377\n"
+    "n_Params:\n-1\n"
+    "maxeval:\n0\n"
+    "maxiter:\n2\n"
+    "maxtime:\n0\n"
+    "iterprint:\n1\n"
+    "maxStuck:\n20\n"
+    "logBound:\n0\n"
+    "inter_save:\n1\n"
+    "warmStart:\n0\n"
+    "perform_refSet_randomization:\n0\n"
+    "n_scatterSet:\n100\n"
+    "n_archiveSet:\n100\n"
+    "set_std_Tol:\n0.01\n"
+    "equality_type:\n0\n"
+    "user_guesses:\n0\n"
+    "sol:\n0.0\n"
+    "n_refSet:\n20\n"
+    "n_subRegions:\n-1\n"
+    "n_scatterSet:\n100\n"
+    "n_childsSet:\n-1\n"
+    "n_candidateSet:\n-1\n"
+    "n_delete:\n-1\n"
+    "perform_cost_tol_stopping:\n0\n"
+    "cost_Tol:\n0.0\n"
+    "dist_Tol:\n0.005\n"
+    "param_Tol:\n0.0001\n"
+    "perform_refSet_convergence_stopping:\n0\n"
+    "refSet_convergence_Tol:\n0.001\n"
+    "perform_LocalSearch:\n0\n"
+    "local_method:\nn\n"
+    "local_min_criteria:\n1e10\n"
+    "local_maxIter:\n100\n"
+    "local_Tol:\n0.001\n"
+    "local_N1:\n2\n"
+    "local_N2:\n2\n"
+    "local_atEnd:\n0\n"
+    "local_onBest_Only:\n0\n"
+    "compute_Ind_Stats:\n0\n"
+    "compute_Set_Stats:\n0\n"
+    "$$\n";
+#endif
+
+
+/*** Help, usage and version messages **************************************/
+
+static const char usage[] =
+    "Usage: flybench [-a <accuracy>] [-g <g(u)>] [-h] [-i <stepsize>]\n"
+    "                [-o <json_file>] [-r <repeats>] [-s <solver>]\n"
+    "                [-S <solver_list>] [-x <sect_title>] <datafile> ...\n";
+
+static const char help[] =
+    "Usage: flybench [options] <datafile> ...\n\n"
+    "Arguments:\n"
+    "  <datafile>          data files to run the benchmarks on\n\n"
+    "Options:\n"
+    "  -a <accuracy>       solver accuracy for adaptive stepsize ODE solvers\n"
+    "  -g <g(u)>           chooses g(u): e = exp, h = hvs, s = sqrt, t = tanh\n"
+    "  -h                  prints this help message\n"
+    "  -i <stepsize>       sets ODE solver stepsize (in minutes)\n"
+    "  -o <json_file>      write the results to <json_file> (default flybench.json)\n"
+    "  -r <repeats>        repeat each measurement <repeats> times (default 5)\n"
+    "  -s <solver>         solver for the derivative, Score and optimizer runs\n"
+    "  -S <solver_list>    comma separated solvers to time Blastoderm with\n"
+    "                      (default r4,rck,dp,rf,bs,bd,kr,sd)\n"
+    "  -x <sect_title>     uses equation paramters from section <sect_title>\n\n";
+
+
+/*** STATIC VARIABLES ******************************************************/
+
+/* a solver as installed in 'ps' (see integrate.h) */
+typedef void ( *Solver ) ( double *, double *, double, double, double, double, int, FILE *, SolverInput *, Input * );
+
+static double stepsize = 1.;    /* stepsize for solver */
+static double accuracy = 0.001; /* accuracy for solver */
+static int repeats = 5;         /* repeats of each measurement */
+static char *solver_name = "rck";       /* solver for everything but the solver list */
+static char *solver_list = NULL;        /* solvers to time Blastoderm with */
+static char *section_title = "eqparms"; /* parameter section */
+
+static ScoreOutput score_out;   /* output of Score() */
+
+/* summary of the repeats of one measurement */
+typedef struct Timing {
+    double median;
+    double variance;
+    double min;
+    double max;
+} Timing;
+
+
+/*** TIMING AND OUTPUT *****************************************************/
+
+/** Now: monotonic wall clock time in seconds */
+static double
+Now( void ) {
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+static int
+CompareDoubles( const void *a, const void *b ) {
+    double x = *( const double * ) a;
+    double y = *( const double * ) b;
+
+    return ( x > y ) - ( x < y );
+}
+
+/** Summarize: median, sample variance and range of 'n' values */
+static Timing
+Summarize( double *x, int n ) {
+    Timing t;
+    double mean = 0., ss = 0.;
+    int i;
+
+    for( i = 0; i < n; i++ )
+        mean += x[i];
+    mean /= n;
+    for( i = 0; i < n; i++ )
+        ss += ( x[i] - mean ) * ( x[i] - mean );
+
+    qsort( x, n, sizeof( double ), CompareDoubles );
+    t.median = ( n % 2 ) ? x[n / 2] : 0.5 * ( x[n / 2 - 1] + x[n / 2] );
+    t.variance = ( n > 1 ) ? ss / ( n - 1 ) : 0.;
+    t.min = x[0];
+    t.max = x[n - 1];
+    return t;
+}
+
+/** PrintJSONString: prints 's' as a quoted JSON string */
+static void
+PrintJSONString( FILE * fp, const char *s ) {
+    fputc( '"', fp );
+    for( ; *s; s++ ) {
+        if( *s == '"' || *s == '\\' )
+            fputc( '\\', fp );
+        if( ( unsigned char ) *s >= ' ' )
+            fputc( *s, fp );
+    }
+    fputc( '"', fp );
+}
+
+/** PrintResult: prints one measurement as a member of the 'results' array;
+ *                'tag' and 'value' are an optional extra string field
+ */
+static void
+PrintResult( FILE * fp, int *first, const char *name, const char *tag, const char *value, const char *unit, double *x, int n ) {
+    Timing t = Summarize( x, n );
+
+    fprintf( fp, "%s\n        {\"name\": ", *first ? "" : "," );
+    PrintJSONString( fp, name );
+    if( tag ) {
+        fprintf( fp, ", \"%s\": ", tag );
+        PrintJSONString( fp, value );
+    }
+    fprintf( fp, ", \"unit\": \"%s\", \"repeats\": %d, \"median\": %.9g, \"variance\": %.9g, \"min\": %.9g, \"max\": %.9g}",
+             unit, n, t.median, t.variance, t.min, t.max );
+    fflush( fp );
+    *first = 0;
+}
+
+
+/*** SIMULATOR BENCHMARKS **************************************************/
+
+/** BenchDerivs: calls per second of DvdtOrig and DvdtDelay for the state
+ *                of the first genotype at its last tabulated time
+ */
+static void
+BenchDerivs( Input * inp, FILE * json, int *first ) {
+    NArrPtr answer;
+    SolverInput si;
+    double *v, *vdot, **vd;
+    double *rate;
+    double t, tic;
+    int n, i, k;
+
+    answer = Blastoderm( 0, inp->sco.facts.facttype[0].genotype, inp, NULL );
+    n = answer.array[answer.size - 1].state.size;
+    t = answer.array[answer.size - 1].time;
+
+    v = ( double * ) malloc( n * sizeof( double ) );
+    vdot = ( double * ) calloc( n, sizeof( double ) );
+    vd = ( double ** ) malloc( inp->zyg.defs.ngenes * sizeof( double * ) );
+    rate = ( double * ) malloc( repeats * sizeof( double ) );
+    memcpy( v, answer.array[answer.size - 1].state.array, n * sizeof( double ) );
+    for( i = 0; i < inp->zyg.defs.ngenes; i++ )
+        vd[i] = v;              /* delayed states: same as the current one */
+    FreeSolution( &answer );
+
+    NewDerivRun(  );
+    NewSolverRun(  );
+    si.time = t;
+    si.genindex = 0;
+    si.all_fact_discons = SetFactDiscons( &( inp->his[0] ), &( inp->ext[0] ) );
+
+    for( i = 0; i < repeats; i++ ) {
+        tic = Now(  );
+        for( k = 0; k < DERIV_CALLS; k++ )
+            DvdtOrig( v, t, vdot, n, &si, inp );
+        rate[i] = DERIV_CALLS / ( Now(  ) - tic );
+    }
+    PrintResult( json, first, "DvdtOrig", NULL, NULL, "calls/s", rate, repeats );
+
+    for( i = 0; i < repeats; i++ ) {
+        tic = Now(  );
+        for( k = 0; k < DERIV_CALLS; k++ )
+            DvdtDelay( v, vd, t, vdot, n, &si, inp );
+        rate[i] = DERIV_CALLS / ( Now(  ) - tic );
+    }
+    PrintResult( json, first, "DvdtDelay", NULL, NULL, "calls/s", rate, repeats );
+
+    FreeFactDiscons( si.all_fact_discons.fact_discons );
+    free( rate );
+    free( vd );
+    free( vdot );
+    free( v );
+}
+
+/** BenchSolvers: Blastoderm of the first genotype with each solver of the
+ *                 comma separated 'list'
+ */
+static void
+BenchSolvers( Input * inp, const char *list, FILE * json, int *first ) {
+    Solver keep = ps;
+    NArrPtr answer;
+    char *names, *name, *save;
+    double *x;
+    double tic;
+    int i;
+
+    names = strdup( list );
+    x = ( double * ) malloc( repeats * sizeof( double ) );
+
+    for( name = strtok_r( names, ",", &save ); name; name = strtok_r( NULL, ",", &save ) ) {
+        ps = SolverByName( name );
+
+        /* one run that isn't timed, to get the caches warm */
+        answer = Blastoderm( 0, inp->sco.facts.facttype[0].genotype, inp, NULL );
+        FreeSolution( &answer );
+
+        for( i = 0; i < repeats; i++ ) {
+            tic = Now(  );
+            answer = Blastoderm( 0, inp->sco.facts.facttype[0].genotype, inp, NULL );
+            x[i] = Now(  ) - tic;
+            FreeSolution( &answer );
+        }
+        PrintResult( json, first, "Blastoderm", "solver", name, "s", x, repeats );
+    }
+
+    ps = keep;
+    free( x );
+    free( names );
+}
+
+/** BenchScore: Blastoderm plus Eval of each genotype, then all of Score;
+ *               last Score with Rk4 per parameter set, one at a time and  
+ *               BENCH_LOCKSTEP in lockstep (see ScoreBatch())             
+ */
+static void
+BenchScore( Input * inp, FILE * json, int *first ) {
+    static const int sets[] = { 1, BENCH_LOCKSTEP };
+    Solver keep = ps;
+    ScoreEval eval;
+    NArrPtr answer;
+    double *params[BENCH_LOCKSTEP];
+    double cost[BENCH_LOCKSTEP];
+    double *x, *p;
+    double tic;
+    char value[16];
+    int i, j, g;
+
+    x = ( double * ) malloc( repeats * sizeof( double ) );
+    p = ( double * ) malloc( inp->tra.size * sizeof( double ) );
+
+    for( g = 0; g < inp->zyg.nalleles; g++ ) {
+        for( i = 0; i < repeats; i++ ) {
+            tic = Now(  );
+            answer = Blastoderm( g, inp->sco.facts.facttype[g].genotype, inp, NULL );
+            Eval( &eval, &answer, g, inp );
+            x[i] = Now(  ) - tic;
+            free( eval.residuals );
+            FreeSolution( &answer );
+        }
+        PrintResult( json, first, "Score", "genotype", inp->sco.facts.facttype[g].genotype, "s", x, repeats );
+    }
+
+    for( i = 0; i < repeats; i++ ) {
+        tic = Now(  );
+        Score( inp, &score_out, 0 );
+        x[i] = Now(  ) - tic;
+    }
+    PrintResult( json, first, "Score", "genotype", "all", "s", x, repeats );
+
+    /* the same parameter set in every lane */
+    for( j = 0; j < inp->tra.size; j++ )
+        p[j] = *( inp->tra.array[j].param );
+    for( j = 0; j < BENCH_LOCKSTEP; j++ )
+        params[j] = p;
+    ps = Rk4;
+    for( j = 0; j < 2; j++ ) {
+        for( i = 0; i < repeats; i++ ) {
+            tic = Now(  );
+            ScoreBatch( inp, params, sets[j], cost );
+            x[i] = ( Now(  ) - tic ) / sets[j];
+        }
+        sprintf( value, "%d", sets[j] );
+        PrintResult( json, first, "ScoreBatch r4", "sets", value, "s", x, repeats );
+    }
+    ps = keep;
+
+    free( p );
+    free( x );
+}
+
+
+/*** OPTIMIZER BENCHMARKS **************************************************/
+
+/** MakeScratchDir: creates a scratch directory and changes into it; the
+ *                   old working directory goes into 'cwd'
+ */
+static char *
+MakeScratchDir( char *cwd ) {
+    static char dir[] = "/tmp/flybench.XXXXXX";
+
+    strcpy( dir + strlen( dir ) - 6, "XXXXXX" );
+    if( !getcwd( cwd, MAX_RECORD ) )
+        file_error( "flybench: can't get the working directory" );
+    if( !mkdtemp( dir ) || chdir( dir ) )
+        file_error( "flybench: can't create a scratch directory" );
+    return dir;
+}
+
+/** RemoveScratchDir: removes whatever the optimizer wrote to 'dir' and
+ *                     changes back to 'cwd'
+ */
+static void
+RemoveScratchDir( const char *dir, const char *cwd ) {
+    DIR *d;
+    struct dirent *entry;
+
+    if( ( d = opendir( "." ) ) ) {
+        while( ( entry = readdir( d ) ) )
+            if( strcmp( entry->d_name, "." ) && strcmp( entry->d_name, ".." ) )
+                unlink( entry->d_name );
+        closedir( d );
+    }
+    if( chdir( cwd ) )
+        file_error( "flybench: can't change back to the working directory" );
+    rmdir( dir );
+}
+
+#ifdef SS
+/** BenchOptimizer: Scatter Search iterations; 'fp' points to the input file */
+static void
+BenchOptimizer( FILE * fp, char *infile, Input * inp, FILE * json, int *first ) {
+    SSType ssParams;
+    Files files;
+    char cwd[MAX_RECORD];
+    char *dir;
+    double *x;
+    double tic;
+    int i;
+
+    ssParams = ReadSSParameters( fp, inp );
+    ssParams.seed = BENCH_SEED;
+    ssParams.ref_set_size = BENCH_REF_SET;
+    ssParams.scatter_set_size = BENCH_SCATTER_SET;
+    ssParams.max_elite = BENCH_REF_SET / 2;
+    ssParams.max_iter = repeats + 1;
+    ssParams.perform_local_search = 0;
+    ssParams.perform_warm_start = 0;
+    ssParams.perform_resume = 0;
+    ssParams.checkpoint_freq = 0;
+    ssParams.perform_normalize_distances = 0;
+    ssParams.perform_screening = 0;
+    ssParams.lockstep = 1;
+    ssParams.farm = NULL;
+    ssParams.final_costs = NULL;
+
+    x = ( double * ) malloc( repeats * sizeof( double ) );
+    dir = MakeScratchDir( cwd );
+    files.inputfile = infile;
+    files.outputfile = "flybench";
+
+    InitSS( inp, &ssParams, &files );
+
+    /* the body of the main loop of RunSS() */
+    for( i = 0; i < repeats; i++ ) {
+        ssParams.n_iter = i + 1;
+        tic = Now(  );
+        select_subsets_list( &ssParams, ssParams.ref_set, ssParams.ref_set_size );
+        generate_candiates( &ssParams );
+        evaluate_set( &ssParams, ssParams.candidates_set, ssParams.candidates_set_size, inp, &score_out );
+        update_ref_set( &ssParams );
+        quick_sort_set( &ssParams, ssParams.ref_set, ssParams.ref_set_size );
+        x[i] = Now(  ) - tic;
+    }
+    PrintResult( json, first, "ss_iteration", NULL, NULL, "s", x, repeats );
+
+    deallocate_ssParam( &ssParams );
+    fclose( stats_file );
+    RemoveScratchDir( dir, cwd );
+    free( x );
+}
+#elif defined(ESS)
+/** BenchOptimizer: enhanced Scatter Search iterations; 'fp' points to the
+ *                   input file
+ */
+static void
+BenchOptimizer( FILE * fp, char *infile, Input * inp, FILE * json, int *first ) {
+    eSSType essParams;
+    FILE *tmp;
+    char cwd[MAX_RECORD];
+    char *dir;
+    double *x;
+    double tic;
+    int c, i, k;
+
+    /* ReadeSSParameters() reads $limits from the same file, so if there is
+     * no $ess section, read from a copy of the input with one appended */
+    if( !( tmp = tmpfile(  ) ) )
+        file_error( "flybench: can't create a temporary file" );
+    rewind( fp );
+    while( ( c = getc( fp ) ) != EOF )
+        putc( c, tmp );
+    if( !FindSection( tmp, "ess" ) ) {
+        fseek( tmp, 0, SEEK_END );
+        fputs( bench_ess_section, tmp );
+    }
+
+    init_defaultSettings( &essParams );
+    essParams = ReadeSSParameters( tmp, inp );
+    fclose( tmp );
+    essParams.seed = BENCH_SEED;
+    essParams.n_refSet = BENCH_REF_SET;
+    essParams.n_scatterSet = BENCH_SCATTER_SET;
+    essParams.n_childsSet = BENCH_REF_SET;
+    essParams.n_candidateSet = BENCH_REF_SET - 1;
+    essParams.n_delete = BENCH_REF_SET / 4;
+    essParams.maxiter = repeats + 1;
+    essParams.goBeyond_Freqs = 1;
+    essParams.perform_LocalSearch = 0;
+    essParams.warmStart = 0;
+    essParams.perform_resume = 0;
+    essParams.checkpoint_freq = 0;
+    essParams.perform_normalize_distances = 0;
+    essParams.perform_screening = 0;
+    essParams.lockstep = 1;
+    essParams.farm = NULL;
+
+    int label[essParams.n_refSet];
+
+    x = ( double * ) malloc( repeats * sizeof( double ) );
+    dir = MakeScratchDir( cwd );
+
+    init_eSS( &essParams, inp, &score_out, infile );
+
+    /* recombination, goBeyond and refSet update of run_eSS() */
+    for( i = 0; i < repeats; i++ ) {
+        essParams.iter = i + 1;
+        tic = Now(  );
+        for( k = 0; k < essParams.n_refSet; k++ ) {
+            label[k] = 0;
+            c = recombine( &essParams, &( essParams.refSet->members[k] ), k, inp, &score_out );
+            if( c != -1 ) {
+                label[k] = 1;
+                copy_Ind( &essParams, &( essParams.childsSet->members[k] ), &( essParams.candidateSet->members[c] ) );
+                goBeyond( &essParams, k, inp, &score_out );
+            }
+        }
+        for( k = 0; k < essParams.n_refSet; k++ )
+            if( label[k] )
+                copy_Ind( &essParams, &( essParams.refSet->members[k] ), &( essParams.childsSet->members[k] ) );
+        quickSort_Set( &essParams, essParams.refSet, 0, essParams.n_refSet - 1, 'c' );
+        x[i] = Now(  ) - tic;
+    }
+    PrintResult( json, first, "ess_iteration", NULL, NULL, "s", x, repeats );
+
+    CloseHistLog( refSet_history_log );
+    CloseHistLog( best_sols_history_log );
+    fclose( freqs_matrix_file );
+    fclose( stats_file );
+    fclose( ref_set_stats_history_file );
+    deallocate_eSSParams( &essParams );
+    RemoveScratchDir( dir, cwd );
+    free( x );
+}
+#endif
+
+
+/*** MAIN ******************************************************************/
+
+/** flybench main() function */
+int
+main( int argc, char **argv ) {
+    int c;                      /* used to parse command line options */
+    char *jsonfile = "flybench.json";   /* output file */
+    FILE *json;
+    FILE *fp;
+    Input inp;
+    char *names, *name;
+    char date[64];
+    time_t now;
+    int first;
+    int f;
+
+    /* external declarations for command line option parsing (unistd.h) */
+    extern char *optarg;        /* command line option argument */
+    extern int optind;          /* pointer to current element of argv */
+    extern int optopt;          /* contain option character upon error */
+
+    /* set default values for command line options */
+    pd = DvdtOrig;
+    pj = JacobnOrig;
+    dd = DvdtDelay;
+    gofu = Sqrt;
+    debug = 0;
+
+    optarg = NULL;
+    while( ( c = getopt( argc, argv, OPTS ) ) != -1 ) {
+        switch ( c ) {
+        case 'a':
+            accuracy = atof( optarg );
+            if( accuracy <= 0 )
+                error( "flybench: accuracy (%g) is too small", accuracy );
+            break;
+        case 'g':              /* -g choose g(u) function */
+            if( !( strcmp( optarg, "s" ) ) )
+                gofu = Sqrt;
+            else if( !( strcmp( optarg, "t" ) ) )
+                gofu = Tanh;
+            else if( !( strcmp( optarg, "e" ) ) )
+                gofu = Exp;
+            else if( !( strcmp( optarg, "h" ) ) )
+                gofu = Hvs;
+            else if( !( strcmp( optarg, "k" ) ) )
+                gofu = Kolja;
+            else
+                error( "flybench: %s is an invalid g(u), should be e, h, s or t", optarg );
+            break;
+        case 'h':              /* -h help option */
+            PrintMsg( help, 0 );
+            break;
+        case 'i':              /* -i sets the stepsize */
+            stepsize = atof( optarg );
+            if( stepsize <= 0 )
+                error( "flybench: stepsize (%g) must be positive", stepsize );
+            if( stepsize > MAX_STEPSIZE )
+                error( "flybench: stepsize %g too large (max. is %g)", stepsize, MAX_STEPSIZE );
+            break;
+        case 'o':              /* -o sets the JSON output file */
+            jsonfile = optarg;
+            break;
+        case 'r':              /* -r sets the number of repeats */
+            repeats = atoi( optarg );
+            if( repeats < 1 || repeats > MAX_REPEATS )
+                error( "flybench: repeats (%d) must be between 1 and %d", repeats, MAX_REPEATS );
+            break;
+        case 's':              /* -s sets solver to be used */
+            if( !SolverByName( optarg ) )
+                error( "flybench: invalid solver (%s), use: " SOLVER_NAMES, optarg );
+            solver_name = optarg;
+            break;
+        case 'S':              /* -S sets the solvers to time */
+            solver_list = optarg;
+            break;
+        case 'x':
+            section_title = optarg;
+            break;
+        case ':':
+            error( "flybench: need an argument for option -%c", optopt );
+            break;
+        case '?':
+        default:
+            error( "flybench: unrecognized option -%c", optopt );
+        }
+    }
+
+    if( optind >= argc )
+        PrintMsg( usage, 1 );
+
+    if( !solver_list )
+        solver_list = ( char * ) default_solvers;
+    names = strdup( solver_list );
+    for( name = strtok( names, "," ); name; name = strtok( NULL, "," ) )
+        if( !SolverByName( name ) )
+            error( "flybench: invalid solver (%s) in -S", name );
+    free( names );
+    ps = SolverByName( solver_name );
+
+    if( !( json = fopen( jsonfile, "w" ) ) )
+        file_error( "flybench: error opening JSON output file" );
+
+    now = time( NULL );
+    strftime( date, sizeof( date ), "%Y-%m-%dT%H:%M:%S", localtime( &now ) );
+    fprintf( json, "{\n  \"date\": \"%s\",\n", date );
+#ifdef VERS
+    fprintf( json, "  \"version\": \"%s\",\n", VERS );
+#endif
+#ifdef SS
+    fprintf( json, "  \"optimizer\": \"ss\",\n" );
+#elif defined(ESS)
+    fprintf( json, "  \"optimizer\": \"ess\",\n" );
+#endif
+    fprintf( json, "  \"solver\": \"%s\",\n  \"stepsize\": %g,\n  \"accuracy\": %g,\n  \"repeats\": %d,\n",
+             solver_name, stepsize, accuracy, repeats );
+    fprintf( json, "  \"solvers\": " );
+    PrintJSONString( json, solver_list );
+    fprintf( json, ",\n  \"files\": [" );
+
+    for( f = optind; f < argc; f++ ) {
+        if( !( fp = fopen( argv[f], "r" ) ) )
+            file_error( "flybench: error opening input file" );
+
+        /* same sequence as in Optimize() of fly.c */
+        inp.zyg = InitZygote( fp, pd, pj, &inp, section_title );
+        inp.sco = InitScoring( fp, 0, &inp );
+        inp.his = InitHistory( fp, &inp );
+        inp.ext = InitExternalInputs( fp, &inp );
+        inp.ste = InitStepsize( stepsize, accuracy, NULL, argv[f] );
+        inp.twe = InitTweak( fp, NULL, inp.zyg.defs );
+        inp.tra = Translate( &inp );
+        inp.lparm = CopyParm( inp.zyg.parm, &( inp.zyg.defs ) );
+
+        fprintf( json, "%s\n    {\n      \"file\": ", f == optind ? "" : "," );
+        PrintJSONString( json, argv[f] );
+        fprintf( json, ",\n      \"ngenes\": %d,\n      \"ngenotypes\": %d,\n      \"nparams\": %d,\n      \"ndp\": %d,\n",
+                 inp.zyg.defs.ngenes, inp.zyg.nalleles, inp.tra.size, inp.zyg.ndp );
+        fprintf( json, "      \"results\": [" );
+        first = 1;
+
+        BenchDerivs( &inp, json, &first );
+        BenchSolvers( &inp, solver_list, json, &first );
+        BenchScore( &inp, json, &first );
+#if defined(SS) || defined(ESS)
+        BenchOptimizer( fp, argv[f], &inp, json, &first );
+#endif
+
+        fprintf( json, "\n      ]\n    }" );
+        fclose( fp );
+    }
+
+    fprintf( json, "\n  ]\n}\n" );
+    fclose( json );
+    free( score_out.residuals );
+
+    return 0;
+}
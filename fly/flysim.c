@@ -0,0 +1,710 @@
+/**
+ * @file flysim.c
+ *
+ * @brief Implementation of libflysim, see flysim.h.
+ *
+ * A handle holds everything fly_X sets up in Optimize() before the
+ * optimization starts (zygote, scoring, history, external inputs,
+ * tweak and translation table) plus the solver and g(u) it was opened
+ * with. The model code (zygotic.c, integrate.c, solvers.c) is not
+ * reentrant: the solver and g(u) are globals and the solvers and
+ * derivative functions keep scratch state in statics. Every call that
+ * runs the model therefore takes 'sim_lock', installs the globals of
+ * its handle and only then calls Score() or Blastoderm().
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <error.h>
+#include <integrate.h>
+#include <maternal.h>
+#include <solvers.h>
+#include <zygotic.h>
+#include <score.h>
+#include <fly_io.h>
+
+#include "flysim.h"
+
+
+/* a solver as installed in 'ps' (see integrate.h) */
+typedef void ( *Solver ) ( double *, double *, double, double, double, double, int, FILE *, SolverInput *, Input * );
+
+/** FlySim: the handle behind the opaque type of flysim.h */
+struct FlySim {
+    Input inp;                  /* everything that was read from infile */
+    ScoreOutput out;            /* output of Score() */
+    char *infile;               /* name of the input file */
+    char *section;              /* parameter section we started from */
+    Solver solver;              /* solver of this handle */
+    GFunc gofu;                 /* g(u) of this handle */
+    int method;                 /* score method, 0 = wls */
+    double *params0;            /* parameters as read from infile */
+};
+
+/* serializes all calls into the model code, see above */
+static pthread_mutex_t sim_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* open handles; the solver caches shared by all of them are freed when *
+ * the last one is closed (both under sim_lock)                          */
+static int nhandles = 0;
+
+
+/*** STATIC HELPERS ********************************************************/
+
+/** GetSolver: returns the solver for a -s solver name (see SolverByName()),
+ *              Rkck for NULL and NULL if there's no such solver
+ */
+static Solver
+GetSolver( const char *name ) {
+    return name ? SolverByName( name ) : Rkck;
+}
+
+/** InstallHandle: makes the model globals point to the settings of 'h';
+ *                  sim_lock must be held
+ */
+static void
+InstallHandle( FlySim * h ) {
+    ps = h->solver;
+    gofu = h->gofu;
+    p_deriv = DvdtOrig;
+    p_jacobn = JacobnOrig;
+    d_deriv = DvdtDelay;
+}
+
+/** SetParams: copies a parameter vector into the parameters of 'h';
+ *              NULL restores the parameters read from the input file
+ */
+static void
+SetParams( FlySim * h, const double *params ) {
+    int i;
+
+    if( !params )
+        params = h->params0;
+    for( i = 0; i < h->inp.tra.size; i++ )
+        *( h->inp.tra.array[i].param ) = params[i];
+}
+
+/** FreeInput: frees everything fly_open() read into 'inp'; this is the
+ *              same cleanup printscore does before it exits
+ */
+static void
+FreeInput( Input * inp, int method ) {
+    int i, j;
+
+    for( i = 0; i < inp->zyg.nalleles; i++ ) {
+        free( inp->sco.facts.tt[i].genotype );
+        free( inp->sco.facts.tt[i].ptr.times.array );
+        free( inp->sco.facts.facttype[i].genotype );
+        free( inp->sco.facts.facttype[i].ptr.times.array );
+        for( j = 0; j < inp->sco.facts.facttype[i].ptr.facts->size; j++ )
+            free( inp->sco.facts.facttype[i].ptr.facts->record[j].array );
+        free( inp->sco.facts.facttype[i].ptr.facts->record );
+        free( inp->sco.facts.facttype[i].ptr.facts );
+
+        if( method == 0 ) {
+            free( inp->sco.weights.weighttype[i].genotype );
+            free( inp->sco.weights.weighttype[i].ptr.times.array );
+            for( j = 0; j < inp->sco.weights.weighttype[i].ptr.facts->size; j++ )
+                free( inp->sco.weights.weighttype[i].ptr.facts->record[j].array );
+            free( inp->sco.weights.weighttype[i].ptr.facts->record );
+            free( inp->sco.weights.weighttype[i].ptr.facts );
+        }
+    }
+    free( inp->sco.facts.tt );
+    free( inp->sco.facts.facttype );
+    free( inp->sco.weights.weighttype );
+
+    if( ( inp->zyg.defs.diff_schedule == 'A' ) || ( inp->zyg.defs.diff_schedule == 'C' ) ) {
+        free( inp->sco.searchspace->dlim[0] );
+    } else {
+        for( i = 0; i < inp->zyg.defs.ngenes; i++ )
+            free( inp->sco.searchspace->dlim[i] );
+    }
+    for( i = 0; i < inp->zyg.defs.ngenes; i++ ) {
+        free( inp->sco.searchspace->Rlim[i] );
+        free( inp->sco.searchspace->taulim[i] );
+        free( inp->sco.searchspace->lambdalim[i] );
+    }
+    free( inp->sco.searchspace->dlim );
+    free( inp->sco.searchspace->Rlim );
+    free( inp->sco.searchspace->lambdalim );
+    free( inp->sco.searchspace->taulim );
+    free( inp->sco.searchspace->pen_vec );
+    free( inp->sco.searchspace );
+
+    free( inp->zyg.defs.egene_ids );
+    free( inp->zyg.defs.gene_ids );
+    free( inp->zyg.nnucs );
+    FreeLineageMaps( &( inp->zyg ) );
+    free( inp->zyg.full_nnucs );
+    free( inp->zyg.full_lin_start );
+    free( inp->zyg.lin_start );
+    FreeMutant( inp->zyg.parm );
+
+    for( i = 0; i < inp->zyg.nalleles; i++ ) {
+        free( inp->zyg.bias.bt[i].genotype );
+        free( inp->zyg.bias.bt[i].ptr.times.array );
+        free( inp->zyg.bias.biastype[i].genotype );
+        for( j = 0; j < inp->zyg.bias.biastype[i].ptr.bias.size; j++ )
+            free( inp->zyg.bias.biastype[i].ptr.bias.array[j].state.array );
+        free( inp->zyg.bias.biastype[i].ptr.times.array );
+        free( inp->zyg.bcdtype[i].genotype );
+        for( j = 0; j < inp->zyg.bcdtype[i].ptr.bicoid.size; j++ )
+            free( inp->zyg.bcdtype[i].ptr.bicoid.array[j].gradient.array );
+        free( inp->zyg.bcdtype[i].ptr.bicoid.array );
+    }
+    free( inp->zyg.bias.bt );
+    free( inp->zyg.bias.biastype );
+    free( inp->zyg.bcdtype );
+
+    free( inp->twe.Etweak );
+    free( inp->twe.Rtweak );
+    free( inp->twe.Ttweak );
+    free( inp->twe.dtweak );
+    free( inp->twe.htweak );
+    free( inp->twe.lambdatweak );
+    free( inp->twe.mtweak );
+    free( inp->twe.tautweak );
+
+    free( inp->tra.array );
+    FreeBounds( &( inp->tra ) );
+
+    FreeMutant( inp->lparm );
+    FreeHistory( inp->zyg.nalleles, inp->his );
+    FreeExternalInputs( inp->zyg.nalleles, inp->ext );
+}
+
+
+/*** HANDLES ***************************************************************/
+
+/** fly_open: reads the problem in 'infile' and initializes everything
+ *             needed for scoring and simulating it
+ */
+FlySim *
+fly_open( const char *infile, const char *section, const char *solver, char gofu, double stepsize, double accuracy ) {
+    FlySim *h;
+    FILE *fp;
+    Solver s;
+    GFunc g;
+    int i;
+
+    if( !infile || stepsize <= 0 || stepsize > MAX_STEPSIZE || accuracy <= 0 )
+        return NULL;
+    if( !( s = GetSolver( solver ) ) )
+        return NULL;
+    switch ( gofu ) {
+    case 0:
+    case 's':
+        g = Sqrt;
+        break;
+    case 't':
+        g = Tanh;
+        break;
+    case 'e':
+        g = Exp;
+        break;
+    case 'h':
+        g = Hvs;
+        break;
+    case 'k':
+        g = Kolja;
+        break;
+    default:
+        return NULL;
+    }
+
+    if( !( h = ( FlySim * ) calloc( 1, sizeof( FlySim ) ) ) )
+        error( "fly_open: could not allocate handle" );
+
+    h->infile = strdup( infile );
+    h->section = strdup( section ? section : "eqparms" );
+    h->solver = s;
+    h->gofu = g;
+    h->method = 0;
+    h->out.score = 1e38;
+
+    if( !( fp = fopen( infile, "r" ) ) ) {
+        free( h->infile );
+        free( h->section );
+        free( h );
+        return NULL;
+    }
+
+    /* same sequence as in Optimize() of fly.c */
+    pthread_mutex_lock( &sim_lock );
+    InstallHandle( h );
+    h->inp.zyg = InitZygote( fp, DvdtOrig, JacobnOrig, &( h->inp ), h->section );
+    h->inp.sco = InitScoring( fp, h->method, &( h->inp ) );
+    h->inp.his = InitHistory( fp, &( h->inp ) );
+    h->inp.ext = InitExternalInputs( fp, &( h->inp ) );
+    h->inp.ste = InitStepsize( stepsize, accuracy, NULL, h->infile );
+    h->inp.twe = InitTweak( fp, NULL, h->inp.zyg.defs );
+    h->inp.tra = Translate( &( h->inp ) );
+    h->inp.lparm = CopyParm( h->inp.zyg.parm, &( h->inp.zyg.defs ) );
+    nhandles++;
+    pthread_mutex_unlock( &sim_lock );
+
+    fclose( fp );
+
+    h->params0 = ( double * ) calloc( h->inp.tra.size, sizeof( double ) );
+    for( i = 0; i < h->inp.tra.size; i++ )
+        h->params0[i] = *( h->inp.tra.array[i].param );
+
+    return h;
+}
+
+/** fly_close: frees a handle and everything loaded with it */
+void
+fly_close( FlySim * h ) {
+    if( !h )
+        return;
+
+    pthread_mutex_lock( &sim_lock );
+    FreeInput( &( h->inp ), h->method );
+    if( --nhandles == 0 ) {
+        FreeSolvers(  );
+        FreeLanes(  );
+    }
+    pthread_mutex_unlock( &sim_lock );
+    free( h->out.residuals );
+    free( h->params0 );
+    free( h->section );
+    free( h->infile );
+    free( h );
+}
+
+/** fly_nparams: number of parameters in a parameter vector */
+int
+fly_nparams( FlySim * h ) {
+    return h->inp.tra.size;
+}
+
+/** fly_ngenes: number of zygotic genes of the problem */
+int
+fly_ngenes( FlySim * h ) {
+    return h->inp.zyg.defs.ngenes;
+}
+
+/** fly_ngenotypes: number of genotypes in the input file */
+int
+fly_ngenotypes( FlySim * h ) {
+    return h->inp.zyg.nalleles;
+}
+
+/** fly_get_params: copies the parameters read from the input file */
+void
+fly_get_params( FlySim * h, double *params ) {
+    memcpy( params, h->params0, h->inp.tra.size * sizeof( double ) );
+}
+
+
+/*** SCORING AND SIMULATION ************************************************/
+
+/** fly_score_batch: scores 'n' parameter vectors */
+int
+fly_score_batch( FlySim * h, const double *params, int n, double *costs ) {
+    int i;
+    int np;
+
+    if( !h || !params || !costs || n < 0 )
+        return -1;
+
+    np = h->inp.tra.size;
+    for( i = 0; i < n; i++ ) {
+        /* one score at a time, so that other handles get their turn */
+        pthread_mutex_lock( &sim_lock );
+        InstallHandle( h );
+        SetParams( h, params + ( long ) i * np );
+        h->out.penalty = 0;
+        Score( &( h->inp ), &( h->out ), 0 );
+        pthread_mutex_unlock( &sim_lock );
+
+        if( h->out.score == FORBIDDEN_MOVE )
+            costs[i] = FORBIDDEN_MOVE;
+        else
+            costs[i] = h->out.score + h->out.penalty;
+    }
+    return 0;
+}
+
+/** fly_output_size: number of doubles fly_simulate() writes */
+long
+fly_output_size( FlySim * h, const double *times, int ntimes ) {
+    long size = 0;
+    int i;
+
+    /* a time right at a division returns the state after it, see
+     * ConvertAnswer() */
+    for( i = 0; i < ntimes; i++ )
+        size += h->inp.zyg.defs.ngenes * GetNNucs( &( h->inp.zyg.defs ), h->inp.zyg.nnucs, times[i] + EPSILON, &( h->inp.zyg.times ) );
+    return size;
+}
+
+/** CheckTimes: checks that the output times are increasing and within
+ *               the time the model runs
+ */
+static int
+CheckTimes( FlySim * h, const double *times, int ntimes ) {
+    int i;
+
+    if( !times || ntimes <= 0 )
+        return -1;
+    for( i = 0; i < ntimes; i++ ) {
+        if( times[i] < 0 || times[i] > h->inp.zyg.times.gast_time )
+            return -1;
+        if( i > 0 && times[i] <= times[i - 1] )
+            return -1;
+    }
+    return 0;
+}
+
+/** RunModel: runs the model for genotype 'genindex' with 'params' and
+ *             returns its output at the 'ntimes' 'times'
+ */
+static NArrPtr
+RunModel( FlySim * h, const double *params, int genindex, const double *times, int ntimes ) {
+    DArrPtr tt;                 /* requested times */
+    DArrPtr data_tt;            /* times with data, put back afterwards */
+    NArrPtr answer;             /* model output */
+    NArrPtr outtab;             /* model output at the requested times */
+
+    tt.size = ntimes;
+    tt.array = ( double * ) calloc( ntimes, sizeof( double ) );
+    memcpy( tt.array, times, ntimes * sizeof( double ) );
+
+    pthread_mutex_lock( &sim_lock );
+    InstallHandle( h );
+    SetParams( h, params );
+
+    /* BlastodermStream() keeps the states at the tabulated times of the
+     * genotype, as in unfold we temporarily replace them by the requested
+     * times */
+    data_tt = h->inp.sco.facts.tt[genindex].ptr.times;
+    h->inp.sco.facts.tt[genindex].ptr.times = tt;
+    answer = BlastodermStream( genindex, h->inp.sco.facts.facttype[genindex].genotype, &( h->inp ), NULL, NULL, NULL );
+    h->inp.sco.facts.tt[genindex].ptr.times = data_tt;
+    pthread_mutex_unlock( &sim_lock );
+
+    outtab = ConvertAnswer( answer, tt );
+    FreeSolution( &answer );
+    free( tt.array );
+    return outtab;
+}
+
+/** fly_simulate: runs the model for one genotype and writes its state at
+ *                 the requested times to 'out'
+ */
+long
+fly_simulate( FlySim * h, const double *params, int genindex, const double *times, int ntimes, double *out, long outsize ) {
+    NArrPtr outtab;             /* model output at the requested times */
+    long written = 0;
+    int i;
+
+    if( !h || !out || CheckTimes( h, times, ntimes ) )
+        return -1;
+    if( genindex < 0 || genindex >= h->inp.zyg.nalleles )
+        return -1;
+    if( fly_output_size( h, times, ntimes ) > outsize )
+        return -1;
+
+    outtab = RunModel( h, params, genindex, times, ntimes );
+    for( i = 0; i < outtab.size; i++ ) {
+        memcpy( out + written, outtab.array[i].state.array, outtab.array[i].state.size * sizeof( double ) );
+        written += outtab.array[i].state.size;
+    }
+    FreeSolution( &outtab );
+
+    return written;
+}
+
+
+/*** SERVER ****************************************************************/
+
+/** ServeSession: what a client has set up so far */
+typedef struct ServeSession {
+    double *params;             /* current parameter vector */
+    int genindex;               /* current genotype */
+    double *times;              /* current output times */
+    int ntimes;
+} ServeSession;
+
+/** ParseDoubles: reads all numbers in 's' into a newly allocated array
+ *                 and returns how many there were, -1 if 's' contains
+ *                 something that is not a number
+ */
+static int
+ParseDoubles( const char *s, double **values ) {
+    char *end;
+    double v;
+    int n = 0;
+
+    *values = NULL;
+    for( ;; ) {
+        while( *s == ' ' || *s == '\t' || *s == '\n' || *s == '\r' )
+            s++;
+        if( !*s )
+            return n;
+        v = strtod( s, &end );
+        if( end == s ) {
+            free( *values );
+            *values = NULL;
+            return -1;
+        }
+        *values = ( double * ) realloc( *values, ( n + 1 ) * sizeof( double ) );
+        ( *values )[n++] = v;
+        s = end;
+    }
+}
+
+/** ServeScore: scores 'params' like printscore does and prints its
+ *               chisq and rms line
+ */
+static void
+ServeScore( FlySim * h, double *params, FILE * out, int ndigits ) {
+    double chisq, ols_chisq;
+
+    pthread_mutex_lock( &sim_lock );
+    InstallHandle( h );
+    SetParams( h, params );
+    h->out.penalty = 0;
+    Score( &( h->inp ), &( h->out ), 0 );
+    chisq = h->out.score + h->out.penalty;
+    h->inp.sco.method = 1;      /* ols score for calculating rms */
+    Score( &( h->inp ), &( h->out ), 0 );
+    ols_chisq = h->out.score;
+    h->inp.sco.method = h->method;
+    pthread_mutex_unlock( &sim_lock );
+
+    fprintf( out, " chisq = %.*f     rms = %.*f\n", ndigits, chisq, ndigits, sqrt( ols_chisq / ( double ) h->inp.zyg.ndp ) );
+}
+
+/** CheckGutsDef: checks a guts definition the way GetGutsComps() would,
+ *                 so that a typo is answered by an error message instead
+ *                 of ending the server
+ */
+static int
+CheckGutsDef( FlySim * h, const char *gutsdef ) {
+    char *copy, *word, *c;
+    int nwords = 0;
+    int ok = 1;
+
+    copy = strdup( gutsdef );
+    for( word = strtok( copy, " \t" ); word && ok; word = strtok( NULL, " \t" ), nwords++ ) {
+        if( nwords == 0 )
+            ok = ( strlen( word ) == 1 && strchr( h->inp.zyg.defs.gene_ids, *word ) );
+        else if( strchr( word, 'U' ) )
+            ok = !strcmp( word, "U" );
+        else
+            for( c = word; *c && ok; c++ )
+                ok = ( strchr( h->inp.zyg.defs.gene_ids, *c ) || strchr( h->inp.zyg.defs.egene_ids, *c ) || strchr( "BALXYDJZ", *c ) );
+    }
+    free( copy );
+    return ok && nwords > 1;
+}
+
+/** ServeGuts: prints the guts in 'gutsdef' (a line of a $gutsdefs
+ *              section) for the current session, as unfold -G does
+ */
+static void
+ServeGuts( FlySim * h, ServeSession * ses, char *gutsdef, FILE * out, int ndigits ) {
+    NArrPtr outtab;             /* model output */
+    NArrPtr goutput;            /* guts */
+    Zygote fakezyg;             /* for printing numguts columns */
+    char *title;
+    int numguts;
+
+    outtab = RunModel( h, ses->params, ses->genindex, ses->times, ses->ntimes );
+
+    pthread_mutex_lock( &sim_lock );
+    InstallHandle( h );
+    FreeMutant( h->inp.lparm ); /* CalcGuts mutates the parameters again */
+    numguts = CalcGuts( ses->genindex, h->inp.sco.facts.facttype[ses->genindex].genotype, h->inp.his, h->inp.ext, outtab, &goutput, gutsdef, &( h->inp ) );
+    /* CalcGuts frees what it mutated, Blastoderm expects a valid one */
+    h->inp.lparm = Mutate( h->inp.sco.facts.facttype[ses->genindex].genotype, h->inp.zyg.parm, &( h->inp.zyg.defs ) );
+    pthread_mutex_unlock( &sim_lock );
+
+    if( numguts ) {
+        fakezyg = h->inp.zyg;
+        fakezyg.defs.ngenes = numguts;
+        title = ( char * ) calloc( strlen( gutsdef ) + 12, sizeof( char ) );
+        sprintf( title, "guts_for_%s\n", gutsdef );    /* as read by ReadGuts() */
+        PrintBlastoderm( out, goutput, title, ndigits, &fakezyg );
+        FreeSolution( &goutput );
+        free( title );
+    } else {
+        fprintf( out, "$$\n" );
+    }
+    FreeSolution( &outtab );
+}
+
+/** fly_serve: answers requests read from 'in' on 'out' */
+int
+fly_serve( FlySim * h, FILE * in, FILE * out, int ndigits ) {
+    ServeSession ses;
+    char *line = NULL;
+    size_t linecap = 0;
+    char *cmd, *args;
+    double *values;
+    NArrPtr outtab;
+    int stop = 0;
+    int n, i;
+
+    ses.params = ( double * ) calloc( h->inp.tra.size, sizeof( double ) );
+    memcpy( ses.params, h->params0, h->inp.tra.size * sizeof( double ) );
+    ses.genindex = 0;
+    ses.ntimes = 1;
+    ses.times = ( double * ) calloc( 1, sizeof( double ) );
+    ses.times[0] = h->inp.zyg.times.gast_time;
+
+    while( getline( &line, &linecap, in ) > 0 ) {
+        line[strcspn( line, "\r\n" )] = '\0';
+        cmd = line + strspn( line, " \t" );
+        args = cmd + strcspn( cmd, " \t" );
+        if( *args )
+            *args++ = '\0';
+
+        if( !*cmd || *cmd == '#' ) {
+            continue;
+
+        } else if( !strcmp( cmd, "params" ) ) {
+            n = ParseDoubles( args, &values );
+            if( n == 0 ) {
+                memcpy( ses.params, h->params0, h->inp.tra.size * sizeof( double ) );
+                fprintf( out, "ok\n" );
+            } else if( n != h->inp.tra.size ) {
+                fprintf( out, "error: params needs %d numbers\n", h->inp.tra.size );
+            } else {
+                memcpy( ses.params, values, n * sizeof( double ) );
+                fprintf( out, "ok\n" );
+            }
+            free( values );
+
+        } else if( !strcmp( cmd, "genotype" ) ) {
+            n = ParseDoubles( args, &values );
+            if( n != 1 || values[0] < 0 || ( int ) values[0] >= h->inp.zyg.nalleles )
+                fprintf( out, "error: genotype needs an index below %d\n", h->inp.zyg.nalleles );
+            else {
+                ses.genindex = ( int ) values[0];
+                fprintf( out, "ok\n" );
+            }
+            free( values );
+
+        } else if( !strcmp( cmd, "times" ) ) {
+            n = ParseDoubles( args, &values );
+            if( n == 0 ) {
+                ses.ntimes = 1;
+                ses.times[0] = h->inp.zyg.times.gast_time;
+                fprintf( out, "ok\n" );
+            } else if( n < 0 || CheckTimes( h, values, n ) ) {
+                fprintf( out, "error: times must increase from 0 to %g\n", h->inp.zyg.times.gast_time );
+                free( values );
+            } else {
+                free( ses.times );
+                ses.times = values;
+                ses.ntimes = n;
+                fprintf( out, "ok\n" );
+            }
+
+        } else if( !strcmp( cmd, "unfold" ) ) {
+            outtab = RunModel( h, ses.params, ses.genindex, ses.times, ses.ntimes );
+            PrintBlastoderm( out, outtab, "output\n", ndigits, &( h->inp.zyg ) );
+            FreeSolution( &outtab );
+
+        } else if( !strcmp( cmd, "guts" ) ) {
+            if( !CheckGutsDef( h, args ) )
+                fprintf( out, "error: bad guts definition '%s'\n", args );
+            else
+                ServeGuts( h, &ses, args, out, ndigits );
+
+        } else if( !strcmp( cmd, "score" ) ) {
+            n = ParseDoubles( args, &values );
+            if( n == 0 )
+                ServeScore( h, ses.params, out, ndigits );
+            else if( n != h->inp.tra.size )
+                fprintf( out, "error: score needs 0 or %d numbers\n", h->inp.tra.size );
+            else
+                ServeScore( h, values, out, ndigits );
+            free( values );
+
+        } else if( !strcmp( cmd, "batch" ) ) {
+            n = atoi( args );
+            for( i = 0; i < n && getline( &line, &linecap, in ) > 0; i++ ) {
+                double cost;
+
+                if( ParseDoubles( line, &values ) != h->inp.tra.size ) {
+                    fprintf( out, "error: batch line %d needs %d numbers\n", i + 1, h->inp.tra.size );
+                } else {
+                    fly_score_batch( h, values, 1, &cost );
+                    fprintf( out, "%.17g\n", cost );
+                }
+                free( values );
+            }
+
+        } else if( !strcmp( cmd, "quit" ) ) {
+            break;
+
+        } else if( !strcmp( cmd, "shutdown" ) ) {
+            stop = 1;
+            break;
+
+        } else {
+            fprintf( out, "error: unknown request '%s'\n", cmd );
+        }
+        fflush( out );
+    }
+
+    fflush( out );
+    free( line );
+    free( ses.params );
+    free( ses.times );
+    return stop;
+}
+
+/** fly_serve_socket: serves clients connecting to a Unix socket */
+int
+fly_serve_socket( FlySim * h, const char *path, int ndigits ) {
+    struct sockaddr_un addr;
+    FILE *in, *out;
+    int fd, conn;
+    int stop = 0;
+
+    if( strlen( path ) >= sizeof( addr.sun_path ) )
+        return -1;
+    if( ( fd = socket( AF_UNIX, SOCK_STREAM, 0 ) ) < 0 )
+        return -1;
+
+    memset( &addr, 0, sizeof( addr ) );
+    addr.sun_family = AF_UNIX;
+    strcpy( addr.sun_path, path );
+    unlink( path );
+    if( bind( fd, ( struct sockaddr * ) &addr, sizeof( addr ) ) || listen( fd, 8 ) ) {
+        close( fd );
+        return -1;
+    }
+
+    /* one client at a time; they all share the handle */
+    while( !stop ) {
+        if( ( conn = accept( fd, NULL, NULL ) ) < 0 ) {
+            if( errno == EINTR )
+                continue;
+            break;
+        }
+        in = fdopen( conn, "r" );
+        out = fdopen( dup( conn ), "w" );
+        stop = fly_serve( h, in, out, ndigits );
+        fclose( in );
+        fclose( out );
+    }
+
+    close( fd );
+    unlink( path );
+    return 0;
+}
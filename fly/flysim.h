@@ -0,0 +1,121 @@
+/**
+ * @file flysim.h
+ *
+ * @brief Embeddable simulator and scoring library (libflysim).
+ *
+ * libflysim loads a problem (an input file as used by fly_ss, fly_ess,
+ * unfold and printscore) once and then scores or simulates any number
+ * of parameter sets in-process. Everything is reached through an opaque
+ * ::FlySim handle.
+ *
+ * Parameter vectors contain the parameters marked in the $tweak section
+ * of the input file, in the same order the optimizers use (see
+ * Translate()); fly_nparams() tells their number.
+ *
+ * Separate handles may be used from different threads. The model code
+ * keeps scratch state in globals, so calls that run the model are
+ * serialized by a lock inside the library; a single handle must not be
+ * used by two threads at the same time.
+ *
+ * Errors in the input file are fatal (they go through error(), like in
+ * the executables); bad arguments to the functions below make them
+ * return -1.
+ */
+
+#ifndef FLYSIM_INCLUDED
+#define FLYSIM_INCLUDED
+
+#include <stdio.h>
+
+/** FlySim: opaque handle to a loaded problem */
+typedef struct FlySim FlySim;
+
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+/** fly_open: reads the problem in 'infile' and initializes everything
+ *             needed for scoring and simulating it:
+ *             - section:  parameter section to start from, NULL means
+ *                         "eqparms" (as in unfold and printscore)
+ *             - solver:   solver name as for -s (e.g. "rck"), NULL means
+ *                         Runge-Kutta Cash-Karp
+ *             - gofu:     g(u) as for -g ('s', 't', 'e', 'h' or 'k'),
+ *                         0 means the default (sqrt)
+ *             - stepsize and accuracy are those of -i and -a
+ *             Returns NULL if the arguments don't make sense.
+ */
+FlySim *fly_open( const char *infile, const char *section, const char *solver, char gofu, double stepsize, double accuracy );
+
+/** fly_close: frees a handle and everything loaded with it */
+void fly_close( FlySim * h );
+
+/** fly_nparams: number of parameters in a parameter vector */
+int fly_nparams( FlySim * h );
+
+/** fly_ngenes: number of zygotic genes of the problem */
+int fly_ngenes( FlySim * h );
+
+/** fly_ngenotypes: number of genotypes in the input file */
+int fly_ngenotypes( FlySim * h );
+
+/** fly_get_params: copies the parameters read from the input file into
+ *                   'params' (fly_nparams() doubles)
+ */
+void fly_get_params( FlySim * h, double *params );
+
+/** fly_score_batch: scores 'n' parameter vectors stored one after the
+ *                    other in 'params' (n * fly_nparams() doubles); the
+ *                    cost (score + penalty, or FORBIDDEN_MOVE for a
+ *                    parameter set outside the search space) of vector i
+ *                    goes into costs[i]. Returns 0, or -1 on bad arguments.
+ */
+int fly_score_batch( FlySim * h, const double *params, int n, double *costs );
+
+/** fly_output_size: number of doubles fly_simulate() writes for the
+ *                    given output times
+ */
+long fly_output_size( FlySim * h, const double *times, int ntimes );
+
+/** fly_simulate: runs the model for genotype number 'genindex' of the
+ *                 input file with 'params' (NULL: the parameters of the
+ *                 input file) and writes the state at each of the
+ *                 'ntimes' increasing 'times' to 'out', one time after
+ *                 the other; the state at a time is laid out as in unfold
+ *                 output, nucleus by nucleus with all genes of a nucleus
+ *                 next to each other. 'outsize' is the number of doubles
+ *                 'out' holds (see fly_output_size()).
+ *                 Returns the number of doubles written, or -1 on bad
+ *                 arguments.
+ */
+long fly_simulate( FlySim * h, const double *params, int genindex, const double *times, int ntimes, double *out, long outsize );
+
+/** fly_serve: answers requests read line by line from 'in' on 'out' until
+ *              'in' ends or a quit or shutdown request comes; this is what
+ *              unfold and printscore --serve run. The requests are:
+ *              - params [p...]:   sets the parameter vector, no numbers
+ *                                 go back to those of the input file
+ *              - genotype <i>:    sets the genotype (index into $genotypes)
+ *              - times [t...]:    sets the output times, no numbers mean
+ *                                 gastrulation time
+ *              - unfold:          prints the model output like unfold
+ *              - guts <gutsdef>:  prints guts like unfold -G, 'gutsdef' is
+ *                                 a line as in a $gutsdefs section
+ *              - score [p...]:    prints chisq and rms like printscore
+ *              - batch <n>:       reads 'n' parameter vectors, one per
+ *                                 line, and prints their costs as in
+ *                                 fly_score_batch(), one per line
+ *              - quit, shutdown:  end the session (and the server)
+ *              params, genotype and times answer 'ok'; a bad request is
+ *              answered by 'error: <why>'. Returns 1 after a shutdown
+ *              request, 0 otherwise.
+ */
+int fly_serve( FlySim * h, FILE * in, FILE * out, int ndigits );
+
+/** fly_serve_socket: listens on the Unix socket 'path' and runs
+ *                     fly_serve() for each client that connects, one
+ *                     after the other, until one asks for shutdown.
+ *                     Returns -1 if the socket can't be set up.
+ */
+int fly_serve_socket( FlySim * h, const char *path, int ndigits );
+
+#endif
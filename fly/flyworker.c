@@ -0,0 +1,177 @@
+/**
+ * @file flyworker.c
+ *
+ * @brief Worker for the distributed evaluation of fly_ss and fly_ess
+ * (--farm).
+ *
+ * fly_worker connects to an optimizer started with --farm=<port>, loads
+ * the problem from its own copy of the input file with the solver
+ * settings the optimizer sends (see FarmWork() in utils/farm.c) and
+ * then scores the batches of parameter sets it gets until the optimizer
+ * is done. With -n it starts several workers at once, e.g. one per core
+ * of a node, or a whole farm on localhost for testing.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>             /* for getopt, fork */
+#include <sys/wait.h>
+
+#include <error.h>
+#include <maternal.h>
+#include <farm.h>
+#include <flysim.h>
+#include <solvers.h>            /* for solver_budget */
+
+
+/*** Constants *************************************************************/
+
+const char *OPTS = ":hk:n:v";   /* command line option string */
+
+
+/*** Help and usage messages ***********************************************/
+
+static const char usage[] = "Usage: fly_worker [-h] [-k <batches>] [-n <workers>] [-v] <host>:<port> <datafile>\n";
+
+static const char help[] =
+    "Usage: fly_worker [options] <host>:<port> <datafile>\n\n"
+    "Arguments:\n"
+    "  <host>:<port>       where fly_ss or fly_ess --farm=<port> runs\n"
+    "  <datafile>          input file of the optimization (a copy will do)\n\n"
+    "Options:\n"
+    "  -h                  prints this help message\n"
+    "  -k <batches>        the (first) worker leaves without answering its\n"
+    "                      <batches>th batch, to test the resubmission of\n"
+    "                      lost work\n"
+    "  -n <workers>        start <workers> workers (default 1)\n"
+    "  -v                  print version and compilation date\n\n"
+    "The solver, stepsize, accuracy and g(u) are those of the optimizer.\n\n" "Please report bugs to <yoginho@usa.net>. Thank you!\n";
+
+
+/*** WORKER CALLBACKS ******************************************************/
+
+/** Worker: what the callbacks of a worker need */
+typedef struct Worker {
+    const char *infile;
+    FlySim *sim;
+} Worker;
+
+/** Setup: opens the problem for the configuration the optimizer sent;
+ *          the configuration is 'section solver gofu stepsize accuracy
+ *          olddivstyle derivs steps seconds max_conc', the last four
+ *          being the budget of a model run (see OpenWorkerFarm() in fly.c)
+ */
+static int
+Setup( const char *config, void *arg, char *why, int len ) {
+    Worker *w = ( Worker * ) arg;
+    char section[256], solver[16], gofu[4];
+    double stepsize, accuracy;
+    int olddiv;
+    SolverBudget budget;
+
+    if( sscanf( config, "%255s %15s %3s %lf %lf %d %lu %lu %lf %lf", section, solver, gofu, &stepsize, &accuracy, &olddiv,
+                &budget.derivs, &budget.steps, &budget.seconds, &budget.max_conc ) != 10 ) {
+        snprintf( why, len, "bad problem configuration '%s'", config );
+        return -1;
+    }
+    olddivstyle = olddiv;
+    solver_budget = budget;
+    if( !( w->sim = fly_open( w->infile, section, solver, gofu[0], stepsize, accuracy ) ) ) {
+        snprintf( why, len, "can't open %s with -s %s -g %s -i %g -a %g", w->infile, solver, gofu, stepsize, accuracy );
+        return -1;
+    }
+    return fly_nparams( w->sim );
+}
+
+/** Batch: scores a batch */
+static void
+Batch( const double *params, int n, double *costs, void *arg ) {
+    fly_score_batch( ( ( Worker * ) arg )->sim, params, n, costs );
+}
+
+
+/** fly_worker main() function */
+int
+main( int argc, char **argv ) {
+    int c;                      /* used to parse command line options */
+    char *host, *colon;         /* where the optimizer is */
+    int port = 0;
+    int nworkers = 1;           /* workers to start (-n) */
+    int die_after = 0;          /* batch the first worker leaves at (-k) */
+    int i, status, failed = 0;
+    pid_t pid;
+    Worker w;
+
+    extern char *optarg;        /* command line option argument */
+    extern int optind;          /* pointer to current element of argv */
+    extern int optopt;          /* contain option character upon error */
+
+    optarg = NULL;
+    while( ( c = getopt( argc, argv, OPTS ) ) != -1 ) {
+        switch ( c ) {
+        case 'h':              /* -h help option */
+            PrintMsg( help, 0 );
+            break;
+        case 'k':              /* -k leave at batch <batches> */
+            die_after = atoi( optarg );
+            if( die_after < 1 )
+                error( "fly_worker: number of batches (%d) must be positive", die_after );
+            break;
+        case 'n':              /* -n number of workers */
+            nworkers = atoi( optarg );
+            if( nworkers < 1 )
+                error( "fly_worker: number of workers (%d) must be positive", nworkers );
+            break;
+        case 'v':              /* -v prints version and compilation date */
+#ifdef VERS
+            fprintf( stderr, "fly_worker version %s (farm protocol %d), compiled on %s %s\n", VERS, FARM_VERSION, __DATE__, __TIME__ );
+#else
+            fprintf( stderr, "fly_worker (farm protocol %d), compiled on %s %s\n", FARM_VERSION, __DATE__, __TIME__ );
+#endif
+            exit( 0 );
+        case ':':
+            error( "fly_worker: need an argument for option -%c", optopt );
+            break;
+        case '?':
+        default:
+            error( "fly_worker: unrecognized option -%c", optopt );
+        }
+    }
+    if( argc - optind != 2 )
+        PrintMsg( usage, 1 );
+
+    host = strdup( argv[optind] );
+    if( !( colon = strrchr( host, ':' ) ) || ( port = atoi( colon + 1 ) ) <= 0 )
+        error( "fly_worker: %s is not <host>:<port>", argv[optind] );
+    *colon = '\0';
+    w.infile = argv[optind + 1];
+    w.sim = NULL;
+
+    if( access( w.infile, R_OK ) )
+        file_error( "fly_worker" );
+
+    /* a single worker works in this process, more of them in children */
+    if( nworkers == 1 ) {
+        failed = FarmWork( host, port, Setup, Batch, &w, die_after );
+        fly_close( w.sim );
+        free( host );
+        return failed ? 1 : 0;
+    }
+
+    for( i = 0; i < nworkers; i++ ) {
+        if( ( pid = fork(  ) ) < 0 )
+            error( "fly_worker: could not start worker %d", i );
+        if( pid == 0 ) {
+            failed = FarmWork( host, port, Setup, Batch, &w, i ? 0 : die_after );
+            fly_close( w.sim );
+            _exit( failed ? 1 : 0 );
+        }
+    }
+    while( wait( &status ) > 0 )
+        if( !WIFEXITED( status ) || WEXITSTATUS( status ) )
+            failed++;
+
+    free( host );
+    return failed ? 1 : 0;
+}
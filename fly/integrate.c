@@ -73,23 +73,36 @@ extern double finish;           /* wallclock time after run */
 
 double *delta;
 
+/* mutated parameters of the lanes of BlastodermBatch(), nlanes buffers of *
+ * lane_size doubles that are kept from one call to the next (see Size-   *
+ * Lanes() and FreeLanes())                                               */
+static EqParms *lane_parms = NULL;
+static int nlanes = 0;
+static int lane_size = 0;
+
 // For the delay solver
 //static double *fact_discons, fact_discons_size;
 
 /*** BLASTODERM FUNCTIONS **************************************************/
 
-/**  Blastoderm: runs embryo model and returns an array of concentration 
- *               arrays for each requested time (given by TabTimes) using  
- *               stephint as a suggested stepsize and accuracy as the re-  
- *               quired numerical accuracy (in case of adaptive stepsize   
- *               solvers or global stepsize control) for the solver.       
- *         NOTE: TabTimes *must* start from 0 and have increasing times.   
- *               It includes times when bias is added, cell division times 
- *               and times for which we have data and ends with the time   
- *               of gastrulation.                                          
+/**  RunBlastoderm: the guts of Blastoderm(), BlastodermStream() and     
+ *                  BlastodermBatch(); runs 'lanes' embryos in lockstep,   
+ *                  all with the same time table and ops. The state of     
+ *                  lane c of gene k in nucleus ap is at                   
+ *                  [(ap * ngenes + k) * lanes + c], so one lane is just   
+ *                  the usual state. With more than one lane the deriva-   
+ *                  tive function has to be DvdtOrigBatch(), which takes   
+ *                  the (mutated) parameters of the lanes from 'lparms';   
+ *                  with one lane it uses inp->lparm as usual.             
+ *                  Without 'stream' it returns the states of all entries  
+ *                  of the time table. With 'stream' the model runs in two 
+ *                  rolling states, and only the states at the tabulated   
+ *                  times are kept and returned, or, if 'sink' is given,   
+ *                  handed to it as soon as they are known (and nothing is 
+ *                  returned).                                             
  */
-NArrPtr
-Blastoderm( int genindex, char *genotype, Input * inp, FILE * slog ) {
+static NArrPtr
+RunBlastoderm( int genindex, char *genotype, Input * inp, FILE * slog, int lanes, EqParms * lparms, int stream, TabSink sink, void *arg ) {
 
     SolverInput si;
     const double epsilon = EPSILON;     /* epsilons: very small in- */
@@ -110,12 +123,19 @@ Blastoderm( int genindex, char *genotype, Input * inp, FILE * slog ) {
     DArrPtr bias;               /* bias for given time & genotype */
 
     //static int       allocate;             /* flag: need to allocate or not? */
-    int i, ii, j;               /* loop counters */
-    int k;                      /* index of gene k in current nuc */
-    int ap;                     /* nuc. position on AP axis */
-    int lin;                    /* first lineage number at each ccycle */
+    int i, ii, j, c;            /* loop counters */
+    int lin;                    /* lineage index of the next ccycle */
 
     int rule;                   /* MITOSIS or INTERPHASE? */
+    int size;                   /* state size of one nucleus, all lanes */
+    unsigned long steps;        /* solver steps before the solver call */
+
+    DArrPtr tabtimes;           /* tabulated times (data or output) */
+    int *keep = NULL;           /* flags: entry is at a tabulated time */
+    double *rolling[2] = { NULL, NULL };        /* the two states of 'stream' */
+    int maxsize = 0;            /* largest state of all entries */
+    NArrPtr tab;                /* the kept states of 'stream' */
+    int ntab = 0;
 
 
     TList *entries = NULL;      /* temp linked list for times and */
@@ -128,7 +148,12 @@ Blastoderm( int genindex, char *genotype, Input * inp, FILE * slog ) {
      * gotic.c so that the derivative functions know which genotype they're    *
      * dealing with (i.e. they need to get the appropriate bcd gradient)       */
     InitDelaySolver(  );
+    NewDerivRun(  );
+    NewSolverRun(  );
     si.genindex = genindex;
+    si.lanes = lanes;
+    si.lparms = lparms;
+    si.tstop = 0.;
     si.all_fact_discons = SetFactDiscons( &( inp->his[genindex] ), &( inp->ext[genindex] ) );
 
     /* INITIALIZATION OF THE MODEL STRUCTS AND ARRAYS ************************* */
@@ -190,8 +215,9 @@ Blastoderm( int genindex, char *genotype, Input * inp, FILE * slog ) {
     }
 
     /* tabulated times */
-    for( i = 0; i < inp->sco.facts.tt[genindex].ptr.times.size; i++ ) {
-        entries = InsertTList( &( inp->zyg ), entries, inp->sco.facts.tt[genindex].ptr.times.array[i], PROPAGATE );
+    tabtimes = inp->sco.facts.tt[genindex].ptr.times;
+    for( i = 0; i < tabtimes.size; i++ ) {
+        entries = InsertTList( &( inp->zyg ), entries, tabtimes.array[i], PROPAGATE );
     }
     /* now we know the number of solutions we have to calculate, so we can     *
      * allocate and initialize the solution struct and the what2do array       */
@@ -201,30 +227,58 @@ Blastoderm( int genindex, char *genotype, Input * inp, FILE * slog ) {
     current = entries;
     for( i = 0; i < solution.size; i++ ) {
         solution.array[i].time = current->time;
-        solution.array[i].state.size = current->n;
-        solution.array[i].state.array = ( double * ) calloc( current->n, sizeof( double ) );
-        for( j = 0; j < current->n; j++ )       //check if this zeroing is really needed or it was just for testing purposes
-            solution.array[i].state.array[j] = 0;
+        solution.array[i].state.size = current->n * lanes;
+        if( !stream ) {
+            solution.array[i].state.array = ( double * ) calloc( current->n * lanes, sizeof( double ) );
+            for( j = 0; j < current->n * lanes; j++ )   //check if this zeroing is really needed or it was just for testing purposes
+                solution.array[i].state.array[j] = 0;
+        } else if( current->n * lanes > maxsize )
+            maxsize = current->n * lanes;
         what2do[i] = current->op;
         current = current->next;
     }
     /* free the linked list and save new tab times in oldtimes array */
     FreeTList( entries );
 
+    /* when streaming, the states of all entries take turns in two buffers, *
+     * and we only keep those at a tabulated time (both times are sorted);  *
+     * at a cell division there are two of them, before and after           */
+    tab.array = NULL;
+    tab.size = 0;
+    if( stream ) {
+        keep = ( int * ) calloc( solution.size, sizeof( int ) );
+        rolling[0] = ( double * ) calloc( maxsize, sizeof( double ) );
+        rolling[1] = ( double * ) calloc( maxsize, sizeof( double ) );
+        if( !keep || !rolling[0] || !rolling[1] )
+            error( "Blastoderm: could not allocate the rolling states" );
+        for( i = 0, j = 0; i < solution.size; i++ ) {
+            while( j < tabtimes.size && tabtimes.array[j] < solution.array[i].time - big_epsilon )
+                j++;
+            keep[i] = ( j < tabtimes.size && fabs( tabtimes.array[j] - solution.array[i].time ) < big_epsilon );
+            ntab += keep[i];
+        }
+        if( !sink && ntab > 0 ) {
+            tab.array = ( NucState * ) calloc( ntab, sizeof( NucState ) );
+            if( !tab.array )
+                error( "Blastoderm: could not allocate the tabulated states" );
+        }
+    }
+
     /* RUNNING THE MODEL ****************************************************** */
-    /* Before running the model, mutate zygotic params appropriately */
-    FreeMutant( inp->lparm );
-    inp->lparm = Mutate( genotype, inp->zyg.parm, &( inp->zyg.defs ) );
-    /*if (debug) {
-       fprintf(slog, "\n--------------------------------------------------");
-       fprintf(slog, "--------------------------------------------------\n");
-       fprintf(slog, "Blastoderm: mutated genotype to %s.\n", genotype);
-       } */
     /* Below is the loop that evaluates the solution and saves it in the solu- *
      * tion struct      
      *                                                        */
     // printf("\n SOLUTION BEFORE %lg %lg %lg %lg\n", solution.array[0].state.array[0], solution.array[0].state.array[1], solution.array[0].state.array[2], solution.array[0].state.array[3]);
     for( i = 0; i < solution.size; i++ ) {
+        /* streaming: state i is where state i-1 propagated to, state i+1   *
+         * starts out zeroed like the calloc'ed ones                        */
+        if( stream ) {
+            solution.array[i].state.array = rolling[i % 2];
+            if( i + 1 < solution.size ) {
+                solution.array[i + 1].state.array = rolling[( i + 1 ) % 2];
+                memset( rolling[( i + 1 ) % 2], 0, solution.array[i + 1].state.size * sizeof( double ) );
+            }
+        }
         // printf("%d) %lg %lg %lg %lg\n", i, solution.array[i].state.array[0], solution.array[i].state.array[1], solution.array[i].state.array[2], solution.array[i].state.array[3]);
         /* First we have to set the propagation rule in zygotic.c (either MITOSIS  *
          * or INTERPHASE) to make sure that the correct differential equations are *
@@ -256,13 +310,30 @@ Blastoderm( int genindex, char *genotype, Input * inp, FILE * slog ) {
                     //Here we choose if we want to "add" or "set" bias concentrations;
                     //just uncomment the line you need (and comment the other one)
                     for( ii = 0; ii < bias.size; ii++ )
-                        //solution.array[i].state.array[ii] += bias.array[ii]; //adding bias concentrations to the system
-                        solution.array[i].state.array[ii] = bias.array[ii];    //setting bias concentrations to the system
+                        for( c = 0; c < lanes; c++ )
+                            //solution.array[i].state.array[ii * lanes + c] += bias.array[ii]; //adding bias concentrations to the system
+                            solution.array[i].state.array[ii * lanes + c] = bias.array[ii];    //setting bias concentrations to the system
                 }
             }
             if( debug )
                 fprintf( slog, "Blastoderm: added bias at time %f.\n", solution.array[i].time );
         }
+
+        /* the state at a tabulated time is final once the bias is added */
+        if( stream && keep[i] ) {
+            if( sink ) {
+                ( *sink ) ( solution.array[i].time, solution.array[i].state.array, solution.array[i].state.size,
+                            i == solution.size - 1 || fabs( solution.array[i + 1].time - solution.array[i].time ) > big_epsilon, arg );
+            } else {
+                tab.array[tab.size].time = solution.array[i].time;
+                tab.array[tab.size].state.size = solution.array[i].state.size;
+                tab.array[tab.size].state.array = ( double * ) malloc( solution.array[i].state.size * sizeof( double ) );
+                if( !tab.array[tab.size].state.array )
+                    error( "Blastoderm: could not allocate the tabulated states" );
+                memcpy( tab.array[tab.size].state.array, solution.array[i].state.array, solution.array[i].state.size * sizeof( double ) );
+                tab.size++;
+            }
+        }
         /* The ops below can be executed in addition to ADD_BIAS but they cannot   *
          * be combined between themselves; if more than one op is set, the prio-   * 
          * rities are as follows: NO_OP > DIVIDE > PROPAGATE; please make sure     *
@@ -288,33 +359,24 @@ Blastoderm( int genindex, char *genotype, Input * inp, FILE * slog ) {
          * want to loose the most posterior daughter cell if we don't need it any  *
          * more at the later cycle                                                 *
          *                                                                         *
-         * This is implemented as follows below: lin is the lineage number of the  *
-         * most anterior cell of the next cell cycle; if it's odd numbered, we'll  *
-         * push off the most anterior daughter by subtracting the number of genes  * 
-         * from the daughter indices (i.e. we shift the solution array for the     *
-         * next cycle posteriorly by one nucleus); if on the other hand, the most  *
-         * posterior nucleus lies outside our new array, we just forget about it   */
+         * This is implemented with the lineage maps of InitLineageMaps(): lin is *
+         * the lineage index of the next cell cycle and lin_gather tells us which *
+         * mother each daughter nucleus of it descends from; if the most anterior *
+         * cell of the next cycle is odd numbered, its anterior sibling is pushed *
+         * off (the solution array for the next cycle is shifted posteriorly by  *
+         * one nucleus); if on the other hand, the most posterior nucleus lies    *
+         * outside our new array, we just forget about it; the lanes of a nucleus *
+         * are next to each other, so each daughter is one contiguous copy        */
         else if( what2do[i] & DIVIDE ) {
             //printf("%d-%d DIVIDE\n", i, what2do[i]);
-            lin = GetStartLin( solution.array[i + 1].time, inp->zyg.defs, inp->zyg.lin_start, &( inp->zyg.times ) );
-            for( j = 0; j < solution.array[i].state.size; j++ ) {
-                k = j % inp->zyg.defs.ngenes;   /* k: index of gene k in current nucleus */
-                ap = j / inp->zyg.defs.ngenes;  /* ap: rel. nucleus position on AP axis */
-
-                /* evaluate ii: index of anterior daughter nucleus */
-
-                if( lin % 2 )
-                    ii = 2 * ap * inp->zyg.defs.ngenes + k - inp->zyg.defs.ngenes;
-                else
-                    ii = 2 * ap * inp->zyg.defs.ngenes + k;
-
-                /* skip the first most anterior daughter nucleus in case lin is odd */
-                if( ii >= 0 )
-                    solution.array[i + 1].state.array[ii] = solution.array[i].state.array[j];
-                /* the second daughter only exists if it is still within the region */
-                if( ii + inp->zyg.defs.ngenes < solution.array[i + 1].state.size )
-                    solution.array[i + 1].state.array[ii + inp->zyg.defs.ngenes] = solution.array[i].state.array[j];
-            }
+            lin = GetStartLinIndex( solution.array[i + 1].time, &( inp->zyg.defs ), &( inp->zyg.times ) );
+            size = inp->zyg.defs.ngenes * lanes;
+            if( lin + 1 >= inp->zyg.nlinmaps
+                || solution.array[i].state.size != Index2NNuc( lin + 1, inp->zyg.full_nnucs ) * size
+                || solution.array[i + 1].state.size != Index2NNuc( lin, inp->zyg.full_nnucs ) * size )
+                error( "Blastoderm: no lineage map for the division at %g", solution.array[i].time );
+            GatherNuclei( solution.array[i + 1].state.array, solution.array[i].state.array, inp->zyg.lin_gather[lin * inp->zyg.nlinmaps + lin + 1],
+                          solution.array[i + 1].state.size / size, size );
             /* Divide the history of the delay solver */
             DivideHistory( solution.array[i].time, solution.array[i + 1].time, &( inp->zyg ) );
 
@@ -349,8 +411,16 @@ Blastoderm( int genindex, char *genotype, Input * inp, FILE * slog ) {
                printf("From %d, %lg %lg %lg %lg\n", i, solution.array[i].state.array[0], solution.array[i].state.array[1], solution.array[i].state.array[2], solution.array[i].state.array[3]);
                }
              */
+            /* up to the next op other than PROPAGATE, the equations stay the same; *
+             * solvers with dense output (Dopri5) may step across tout up to there  */
+            for( j = i + 1; j < solution.size - 1 && what2do[j] == PROPAGATE; j++ );
+            si.tstop = solution.array[j].time;
+
+            steps = solver_stats.steps;
             ( *ps ) ( solution.array[i].state.array, solution.array[i + 1].state.array, solution.array[i].time, solution.array[i + 1].time, inp->ste.stepsize,
                       inp->ste.accuracy, solution.array[i].state.size, slog, &si, inp );
+            /* a lockstep step is one step for each lane */
+            solver_stats.steps += ( lanes - 1 ) * ( solver_stats.steps - steps );
             /*
                if (debug) {
                printf("To %d, %lg %lg %lg %lg\n", i+1, solution.array[i+1].state.array[0], solution.array[i+1].state.array[1], solution.array[i+1].state.array[2], solution.array[i+1].state.array[3]);
@@ -358,6 +428,10 @@ Blastoderm( int genindex, char *genotype, Input * inp, FILE * slog ) {
              */
             jacSize += solution.array[i].state.size;
 
+            /* a run on a budget stops as soon as it diverges or runs out of it */
+            if( CheckState( solution.array[i + 1].state.array, solution.array[i + 1].state.size ) )
+                break;
+
         } else {                /* unknown op? -> error! */
             error( "op was %d!?", what2do[i] );
         }
@@ -371,9 +445,133 @@ Blastoderm( int genindex, char *genotype, Input * inp, FILE * slog ) {
     FreeFactDiscons( si.all_fact_discons.fact_discons );
     free( what2do );
     free( transitions );
+    if( stream ) {
+        free( keep );
+        free( rolling[0] );
+        free( rolling[1] );
+        free( solution.array );
+        return tab;
+    }
     return solution;
 }
 
+/**  Blastoderm: runs embryo model and returns an array of concentration 
+ *               arrays for each requested time (given by TabTimes) using  
+ *               stephint as a suggested stepsize and accuracy as the re-  
+ *               quired numerical accuracy (in case of adaptive stepsize   
+ *               solvers or global stepsize control) for the solver.       
+ *         NOTE: TabTimes *must* start from 0 and have increasing times.   
+ *               It includes times when bias is added, cell division times 
+ *               and times for which we have data and ends with the time   
+ *               of gastrulation.                                          
+ */
+NArrPtr
+Blastoderm( int genindex, char *genotype, Input * inp, FILE * slog ) {
+
+    /* Before running the model, mutate zygotic params appropriately; they *
+     * go into the buffer of inp->lparm, nothing is allocated              */
+    MutateParm( genotype, inp->zyg.parm, &( inp->lparm ), &( inp->zyg.defs ) );
+    /*if (debug) {
+       fprintf(slog, "\n--------------------------------------------------");
+       fprintf(slog, "--------------------------------------------------\n");
+       fprintf(slog, "Blastoderm: mutated genotype to %s.\n", genotype);
+       } */
+    return RunBlastoderm( genindex, genotype, inp, slog, 1, NULL, 0, NULL, NULL );
+}
+
+/**  BlastodermStream: like Blastoderm, but keeps only two states of the  
+ *                     model at a time instead of one per entry of the     
+ *                     time table; returns the states at the tabulated     
+ *                     times only, or, if 'sink' is not NULL, passes them  
+ *                     to 'sink' as the model goes and returns an empty    
+ *                     solution                                            
+ */
+NArrPtr
+BlastodermStream( int genindex, char *genotype, Input * inp, FILE * slog, TabSink sink, void *arg ) {
+
+    MutateParm( genotype, inp->zyg.parm, &( inp->lparm ), &( inp->zyg.defs ) );
+    return RunBlastoderm( genindex, genotype, inp, slog, 1, NULL, 1, sink, arg );
+}
+
+/** SizeLanes: makes lane_parms at least 'lanes' buffers of at least     
+ *             'size' doubles; the buffers only ever grow, so the smaller  
+ *             tail batches of ScoreBatch() don't reallocate them (Free-   
+ *             Lanes() releases them)                                      
+ */
+static void
+SizeLanes( int lanes, int size ) {
+    int c;
+
+    if( lanes <= nlanes && size <= lane_size )
+        return;
+    if( lanes < nlanes )
+        lanes = nlanes;
+    if( size < lane_size )
+        size = lane_size;
+    FreeLanes(  );
+    lane_parms = ( EqParms * ) malloc( lanes * sizeof( EqParms ) );
+    if( !lane_parms )
+        error( "BlastodermBatch: could not allocate parameters" );
+    for( c = 0; c < lanes; c++ )
+        if( !( lane_parms[c].R = ( double * ) malloc( size * sizeof( double ) ) ) )
+            error( "BlastodermBatch: could not allocate parameters" );
+    nlanes = lanes;
+    lane_size = size;
+}
+
+/** FreeLanes: frees the lane parameters kept by BlastodermBatch() */
+void
+FreeLanes( void ) {
+    int c;
+
+    for( c = 0; c < nlanes; c++ )
+        FreeMutant( lane_parms[c] );
+    free( lane_parms );
+    lane_parms = NULL;
+    nlanes = 0;
+    lane_size = 0;
+}
+
+/**  BlastodermBatch: like Blastoderm, but runs the model for 'nsets'     
+ *                    parameter sets at once, in lockstep (see Lockstep-   
+ *                    Solver() in solvers.c for the solvers that allow     
+ *                    this); the solution of parameter set c is returned   
+ *                    in solutions[c], which must have room for 'nsets';   
+ *                    like BlastodermStream, it only keeps the states at   
+ *                    the tabulated times                                  
+ */
+void
+BlastodermBatch( int genindex, char *genotype, Input * inp, EqParms * parms, int nsets, NArrPtr * solutions, FILE * slog ) {
+
+    void ( *deriv ) ( double *, double, double *, int, SolverInput *, Input * ) = p_deriv;
+    NArrPtr wide;
+    int c, i, j, n;
+
+    /* the mutated parameters of the lanes stay allocated between calls */
+    SizeLanes( nsets, ParmSize( &( inp->zyg.defs ) ) );
+    for( c = 0; c < nsets; c++ )
+        MutateParm( genotype, parms[c], &lane_parms[c], &( inp->zyg.defs ) );
+
+    p_deriv = DvdtOrigBatch;
+    wide = RunBlastoderm( genindex, genotype, inp, slog, nsets, lane_parms, 1, NULL, NULL );
+    p_deriv = deriv;
+
+    /* split the lanes into one solution per parameter set */
+    for( c = 0; c < nsets; c++ ) {
+        solutions[c].size = wide.size;
+        solutions[c].array = ( NucState * ) calloc( wide.size, sizeof( NucState ) );
+        for( i = 0; i < wide.size; i++ ) {
+            n = wide.array[i].state.size / nsets;
+            solutions[c].array[i].time = wide.array[i].time;
+            solutions[c].array[i].state.size = n;
+            solutions[c].array[i].state.array = ( double * ) malloc( n * sizeof( double ) );
+            for( j = 0; j < n; j++ )
+                solutions[c].array[i].state.array[j] = wide.array[i].state.array[j * nsets + c];
+        }
+    }
+    FreeSolution( &wide );
+}
+
 /**  FreeSolution: frees memory of the solution structure created by 
  *                 Blastoderm() or gut functions                           
  */
@@ -886,67 +1084,40 @@ FreeInterpObject( InterpObject * interp_obj ) {
         free( interp_obj->fact_discons );
 }
 
+/** GatherNuclei: copies nucleus map[d] of 'in' to nucleus d of 'out' for 
+ *                the nnuc nuclei of 'out', each 'width' doubles wide; the  
+ *                nuclei are copied from the last one down, so 'out' may be 
+ *                the same array as 'in' (or start after it) as long as     
+ *                map[d] <= d, which is the case for the mothers of nuclei  
+ */
+void
+GatherNuclei( double *out, const double *in, const int *map, int nnuc, int width ) {
+    int d, k;
+    double *o;
+    const double *src;
+
+    for( d = nnuc - 1; d >= 0; d-- ) {
+        o = out + d * width;
+        src = in + map[d] * width;
+        if( o != src )
+            for( k = 0; k < width; k++ )
+                o[k] = src[k];
+    }
+}
+
 void
 Go_Forward( double *output, double *input, int output_ind, int input_ind, Zygote * zyg, int num_genes ) {
 
-    double *y;
-    int output_lin, size, newsize;
-    int k, ap, j, ii;
-
-    y = NULL;
-    size = 0;
-
-    output_lin = Index2StartLin( output_ind, zyg->full_lin_start );
-    newsize = Index2NNuc( output_ind, zyg->full_nnucs ) * num_genes;
-
-    //printf("output lineage start, indices:%d, %d, %d\n", output_lin, input_ind, output_ind);
-
-    if( output_ind < input_ind - 1 ) {
-        size = Index2NNuc( output_ind + 1, zyg->full_nnucs ) * num_genes;
-        y = ( double * ) calloc( size, sizeof( double ) );
-        /*              printf("Passing on to another fwd with targets %d %d %d\n",size,output_ind+1,input_ind); */
-        //printf("Go_FW\n");
-        Go_Forward( y, input, output_ind + 1, input_ind, zyg, num_genes );
-    } else if( output_ind == input_ind - 1 ) {
-        size = Index2NNuc( input_ind, zyg->full_nnucs ) * num_genes;
-        y = ( double * ) calloc( size, sizeof( double ) );
-        /*              printf("Goin' to do the tranfer:%d %d\n",size,newsize); */
-        y = memcpy( y, input, size * sizeof( double ) );
-    } else if( output_ind == input_ind ) {
-        output = memcpy( output, input, newsize * sizeof( double ) );
+    if( output_ind == input_ind ) {
+        memcpy( output, input, Index2NNuc( output_ind, zyg->full_nnucs ) * num_genes * sizeof( double ) );
         return;
-    } else {
-        //printf("====\n");
-        //printf("input: input_ind=%d, full_nnucs=%d\n", input_ind, zyg->full_nnucs[input_ind]);
-        //printf("output: output_ind=%d, full_nnucs=%d\n", output_ind, zyg->full_nnucs[output_ind]);
-
-        error( "Go_Forward(): You are trying to go from nnucs %d to %d!", Index2NNuc( input_ind, zyg->full_nnucs ), Index2NNuc( output_ind, zyg->full_nnucs ) );
     }
+    if( output_ind > input_ind || input_ind >= zyg->nlinmaps )
+        error( "Go_Forward(): You are trying to go from nnucs %d to %d!", Index2NNuc( input_ind, zyg->full_nnucs ), Index2NNuc( output_ind, zyg->full_nnucs ) );
 
-    for( j = 0; j < size; j++ ) {
-
-        k = j % num_genes;      /* k: index of gene k in current nucleus */
-        ap = j / num_genes;     /* ap: rel. nucleus position on AP axis */
-
-        /* evaluate ii: index of anterior daughter nucleus */
-
-        if( output_lin % 2 )
-            ii = 2 * ap * num_genes + k - num_genes;
-        else
-            ii = 2 * ap * num_genes + k;
-
-        /* skip the first most anterior daughter nucleus in case output_lin is odd */
-
-        if( ii >= 0 )
-            output[ii] = y[j];
-
-        /* the second daughter only exists if it is still within the region */
-
-        if( ii + num_genes < newsize )
-            output[ii + num_genes] = y[j];
-    }
+    /* every nucleus inherits the concentrations of its ancestor in input */
 
-    free( y );
+    GatherNuclei( output, input, zyg->lin_gather[output_ind * zyg->nlinmaps + input_ind], Index2NNuc( output_ind, zyg->full_nnucs ), num_genes );
 
     return;
 }
@@ -954,63 +1125,42 @@ Go_Forward( double *output, double *input, int output_ind, int input_ind, Zygote
 void
 Go_Backward( double *output, double *input, int output_ind, int input_ind, Zygote * zyg, int num_genes ) {
 
-    double *y;
-    int output_lin, input_lin, size, newsize;
-    int k, ap, j, ii;
+    double *y, *out;
+    const int *daughters;
+    int i, m, k, nnuc;
 
-    y = NULL;
-    size = 0;
-    
-    output_lin = Index2StartLin( output_ind, zyg->full_lin_start );
-    input_lin = Index2StartLin( input_ind, zyg->full_lin_start );
-    newsize = Index2NNuc( output_ind, zyg->full_nnucs ) * num_genes;
-
-    /*  printf("output lineage start, indices:%d, %d, %d\n",output_lin,output_ind,input_ind); */
-
-    if( output_ind > input_ind + 1 ) {
-        size = Index2NNuc( output_ind - 1, zyg->full_nnucs ) * num_genes;
-        y = ( double * ) calloc( size, sizeof( double ) );
-        /*              printf("Passing on to another bkd with targets %d %d %d\n",size,output_ind-1,input_ind); */
-        Go_Backward( y, input, output_ind - 1, input_ind, zyg, num_genes );
-        input_lin = Index2StartLin( output_ind - 1, zyg->full_lin_start );
-    } else if( output_ind == input_ind + 1 ) {
-        size = Index2NNuc( input_ind, zyg->full_nnucs ) * num_genes;
-        y = ( double * ) calloc( size, sizeof( double ) );
-        /*              printf("Goin' to do the tranfer\n"); */
-        memcpy( y, input, size * sizeof( double ) );
-    } else if( output_ind == input_ind ) {
-        memcpy( output, input, newsize * sizeof( double ) );
+    if( output_ind == input_ind ) {
+        memcpy( output, input, Index2NNuc( output_ind, zyg->full_nnucs ) * num_genes * sizeof( double ) );
         return;
-    } else
+    }
+    if( output_ind < input_ind || output_ind >= zyg->nlinmaps )
         error( "Go_Backward(): You are trying to go from nnucs %d to %d!", Index2NNuc( input_ind, zyg->full_nnucs ),
                Index2NNuc( output_ind, zyg->full_nnucs ) );
 
-    for( j = 0; j < newsize; j++ ) {
-
-        k = j % num_genes;      /* k: index of gene k in current nucleus */
-        ap = j / num_genes;     /* ap: rel. nucleus position on AP axis */
-
-        /* evaluate ii: index of anterior daughter nucleus */
-
-        if( input_lin % 2 )
-            ii = 2 * ap * num_genes + k - num_genes;
-        else
-            ii = 2 * ap * num_genes + k;
-
-        /* skip the first most anterior daughter nucleus in case output_lin is odd */
-
-        if( ii < 0 )
-            output[j] = y[ii + num_genes];
-
-        if( ( ii >= 0 ) && ( ii + num_genes < size ) )
-            output[j] = .5 * ( y[ii] + y[ii + num_genes] );
-
-        if( ii + num_genes >= size )
-            output[j] = y[ii];
+    /* one division at a time: a mother gets the mean of its two daughters, *
+     * or the concentrations of the only one within the region              */
+
+    y = input;
+    for( i = input_ind; i < output_ind; i++ ) {
+        nnuc = Index2NNuc( i + 1, zyg->full_nnucs );
+        if( i + 1 == output_ind )
+            out = output;
+        else if( !( out = ( double * ) malloc( nnuc * num_genes * sizeof( double ) ) ) )
+            error( "Go_Backward(): could not allocate memory" );
+
+        daughters = zyg->lin_daughters[i];
+        for( m = 0; m < nnuc; m++ ) {
+            if( daughters[2 * m] == daughters[2 * m + 1] )
+                memcpy( out + m * num_genes, y + daughters[2 * m] * num_genes, num_genes * sizeof( double ) );
+            else
+                for( k = 0; k < num_genes; k++ )
+                    out[m * num_genes + k] = .5 * ( y[daughters[2 * m] * num_genes + k] + y[daughters[2 * m + 1] * num_genes + k] );
+        }
 
+        if( y != input )
+            free( y );
+        y = out;
     }
 
-    free( y );
-
     return;
 }
@@ -92,6 +92,39 @@ void ( *ps ) ( double *, double *, double, double, double, double, int, FILE *,
  */
 NArrPtr Blastoderm( int genindex, char *genotype, Input * inp, FILE * slog );
 
+/**  TabSink: takes the 'size' concentrations 'state' of the model at the 
+ *            tabulated time 'time' from BlastodermStream(); a tabulated   
+ *            time at a cell division has two states, before and after the 
+ *            division; 'final' is set for all states but the one before   
+ *            (ConvertAnswer() only picks the final ones)                  
+ */
+typedef void ( *TabSink ) ( double time, const double *state, int size, int final, void *arg );
+
+/**  BlastodermStream: like Blastoderm, but runs the model in two rolling 
+ *                     states instead of one state per time step, and only 
+ *                     keeps the states at the tabulated times; these are  
+ *                     returned, or, if 'sink' is not NULL, passed to      
+ *                     'sink' (with 'arg') as soon as they are known, and  
+ *                     an empty solution is returned                       
+ */
+NArrPtr BlastodermStream( int genindex, char *genotype, Input * inp, FILE * slog, TabSink sink, void *arg );
+
+/**  BlastodermBatch: like BlastodermStream, but runs the model for      
+ *                    'nsets' parameter sets 'parms' at once, in lockstep, 
+ *                    as one wide system; only for the fixed stepsize      
+ *                    solvers and DvdtOrig (see LockstepSolver() in        
+ *                    solvers.h). The states of parameter set c at the     
+ *                    tabulated times are returned in solutions[c]; free   
+ *                    them with FreeSolution().                            
+ */
+void BlastodermBatch( int genindex, char *genotype, Input * inp, EqParms * parms, int nsets, NArrPtr * solutions, FILE * slog );
+
+/**  FreeLanes: frees the mutated parameters that BlastodermBatch() keeps
+ *              from one call to the next; call it with FreeSolvers() when
+ *              done with the model
+ */
+void FreeLanes( void );
+
 //double *BlastodermJac( int genindex, char *genotype, DArrPtr tabtimes, double stephint, double accuracy, FILE * slog );
 
 /**  ConvertAnswer: little function that gets rid of bias times, division 
@@ -149,6 +182,18 @@ FactDiscons SetFactDiscons( InterpObject * hist_interp_object, InterpObject * ex
 /** FreeFactDiscons: free FactDiscons object. FactDiscons object is made from History and ExternalInputs */
 void FreeFactDiscons( double *fact_discons );
 
+/** GatherNuclei: copies nucleus map[d] of 'in' to nucleus d of 'out' for 
+ *                the nnuc nuclei of 'out', each 'width' doubles wide; works 
+ *                in place if map[d] <= d (see InitLineageMaps())            
+ */
+void GatherNuclei( double *out, const double *in, const int *map, int nnuc, int width );
+
+/** Go_Forward, Go_Backward: map concentrations of the nuclei of cycle   
+ *                input_ind to those of cycle output_ind (indices of       
+ *                full_lin_start) by the lineage maps; going forward every 
+ *                nucleus inherits its ancestor's concentrations, going    
+ *                backward a mother gets the mean of its daughters         
+ */
 void Go_Forward( double *output, double *input, int output_ind, int input_ind, Zygote * zyg, int num_genes );
 void Go_Backward( double *output, double *input, int output_ind, int input_ind, Zygote * zyg, int num_genes );
 void History( double t, double t_size, double *yd, int n, InterpObject hist_interp_object, int ngenes, Zygote * zyg );
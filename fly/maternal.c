@@ -157,8 +157,6 @@ static const double full_div_durations[TOTAL_DIVS] = { 5.1, 3.3, 3.0, 3.3, 3.0,
 //static int         bt_init_flag = 0;                   /* flag for BTtable */
 //static int         d_flag       = 0;        /* flag for first call to GetD */
 //static int         rule_flag    = 0;     /* flag for first call to GetRule */
-static int theta_flag = 0;      /* flag for first call to
-                                   Theta */
 
 
 
@@ -390,7 +388,8 @@ InitNNucs( Zygote * zyg ) {
 
 /**  InitFullNNucs: takes the global defs.nnucs and calculates number of nucs 
  *              for each cleavage cycle which are then stored in reverse   
- *              order in the static nnucs[] array                          
+ *              order in the static nnucs[] array; does nothing if they    
+ *              are there already                                          
  *   CAUTION:   defs struct and lin_start need to be initialized before!   
  */
 void
@@ -427,6 +426,84 @@ InitFullNNucs( Zygote * zyg, int *full_lin_start ) {
        printf("History lineages %d, nnucs %d\n", full_lin_start[i],full_nnucs[i]); */
 
     zyg->full_nnucs = full_nnucs;
+    InitLineageMaps( zyg );
+}
+
+/**  InitLineageMaps: tabulates for each pair of cleavage cycles which 
+ *              nucleus of the earlier cycle each nucleus of the later one 
+ *              descends from, and the daughters of each nucleus one divi- 
+ *              sion later; the mother of nucleus d is (d + 1) / 2 if the  
+ *              most anterior lineage of the later cycle is odd, d / 2 if  
+ *              it is even (see the DIVIDE rule in Blastoderm()); maps of  
+ *              an earlier call are freed first                            
+ *   CAUTION:   full_lin_start and full_nnucs need to be initialized before!
+ */
+void
+InitLineageMaps( Zygote * zyg ) {
+    int n = zyg->defs.full_ccycles;
+    int from, to, i, d, m, a, b;
+    int *map;
+
+    FreeLineageMaps( zyg );     /* the maps of an earlier call, if any */
+    zyg->nlinmaps = n;
+    if( !( zyg->lin_gather = ( int ** ) calloc( n * n, sizeof( int * ) ) ) )
+        error( "InitLineageMaps: could not allocate lin_gather array" );
+    if( !( zyg->lin_daughters = ( int ** ) calloc( n, sizeof( int * ) ) ) )
+        error( "InitLineageMaps: could not allocate lin_daughters array" );
+
+    for( to = 0; to < n - 1; to++ ) {
+
+        /* mothers of the nuclei of cycle 'to', any number of divisions back */
+
+        for( from = to + 1; from < n; from++ ) {
+            if( !( map = ( int * ) malloc( zyg->full_nnucs[to] * sizeof( int ) ) ) )
+                error( "InitLineageMaps: could not allocate lineage map" );
+            for( d = 0; d < zyg->full_nnucs[to]; d++ ) {
+                m = d;
+                for( i = to; i < from; i++ )
+                    m = ( zyg->full_lin_start[i] % 2 ) ? ( m + 1 ) / 2 : m / 2;
+                map[d] = m;
+            }
+            zyg->lin_gather[to * n + from] = map;
+        }
+
+        /* daughters of the nuclei of cycle 'to + 1'; a daughter outside the *
+         * region is replaced by its sibling                                 */
+
+        if( !( map = ( int * ) malloc( 2 * zyg->full_nnucs[to + 1] * sizeof( int ) ) ) )
+            error( "InitLineageMaps: could not allocate lineage map" );
+        for( m = 0; m < zyg->full_nnucs[to + 1]; m++ ) {
+            a = 2 * m - ( zyg->full_lin_start[to] % 2 );
+            b = a + 1;
+            if( a < 0 )
+                a = b;
+            if( b >= zyg->full_nnucs[to] )
+                b = a;
+            map[2 * m] = a;
+            map[2 * m + 1] = b;
+        }
+        zyg->lin_daughters[to] = map;
+    }
+}
+
+/** FreeLineageMaps: frees the maps made by InitLineageMaps() */
+void
+FreeLineageMaps( Zygote * zyg ) {
+    int i;
+
+    if( zyg->lin_gather ) {
+        for( i = 0; i < zyg->nlinmaps * zyg->nlinmaps; i++ )
+            free( zyg->lin_gather[i] );
+        free( zyg->lin_gather );
+    }
+    if( zyg->lin_daughters ) {
+        for( i = 0; i < zyg->nlinmaps; i++ )
+            free( zyg->lin_daughters[i] );
+        free( zyg->lin_daughters );
+    }
+    zyg->lin_gather = NULL;
+    zyg->lin_daughters = NULL;
+    zyg->nlinmaps = 0;
 }
 
 
@@ -896,21 +973,18 @@ Theta( double time, Zygote * zyg ) {
     int i;
     int ndivs;
 
-    static double *dt;          /* pointer to division time table */
-    static double *dd;          /* pointer to division duration table */
+    double *dt;                 /* pointer to division time table */
+    double *dd;                 /* pointer to division duration table */
 
     ndivs = zyg->defs.ndivs;
 
-    if( !theta_flag ) {         /* only do this once */
-        if( olddivstyle ) {     /* get pointers to division time table */
-            dt = ( double * ) old_divtimes;     /* and division duration table */
-            dd = ( double * ) old_div_duration;
-        } else {
-            dt = ( double * ) zyg->times.full_div_times;
-            dd = ( double * ) zyg->times.full_div_durations;
-
-        }
-        theta_flag = 1;
+    /* not cached: zyg is not necessarily the same Zygote on every call */
+    if( olddivstyle ) {         /* get pointers to division time table */
+        dt = ( double * ) old_divtimes; /* and division duration table */
+        dd = ( double * ) old_div_duration;
+    } else {
+        dt = ( double * ) zyg->times.full_div_times;
+        dd = ( double * ) zyg->times.full_div_durations;
     }
 
     /* checks if we're in a mitosis; we need the 10*DBL_EPSILON kludge for gcc *
@@ -152,6 +152,9 @@ typedef struct SolverInput {
     double time;                
     int genindex;
     FactDiscons all_fact_discons;
+    int lanes;                  /* parameter sets run in lockstep */
+    EqParms *lparms;            /* and their parameters (lanes > 1 only) */
+    double tstop;               /* equations and state change next at tstop */
 } SolverInput;
 
 /** @brief Valid param range */
@@ -166,10 +169,29 @@ typedef struct ParamList {
     Range *param_range;         /* pointers to corresponding range limits */
 } ParamList;
 
+/** @brief The search space as flat arrays, see InitBounds() in score.c; 
+ *         one entry per parameter, tweaked or not, in the order in which  
+ *         Translate() goes through them (R, T, E, m, h, d, lambda, tau)   
+ */
+typedef struct Bounds {
+    int n;                      /* number of entries */
+    double *lower;              /* lower limits */
+    double *upper;              /* upper limits */
+    double *weight;             /* factor of the parameter in the penalty, 0 if none */
+    double *value;              /* the parameters being checked */
+    double **param;             /* where the parameters are in the EqParms */
+    int *fold;                  /* 1 for R and lambda, which are checked without sign */
+    int *tweak;                 /* entry of each parameter of the ParamList */
+    int pen[5];                 /* penalty of T, E, m, h: entries pen[i] to pen[i+1]-1 */
+    double Lambda;              /* penalty Lambda, see GetPenalty() */
+} Bounds;
+
 typedef struct PArrPtr {
     int size;                   /* size of the ParamList array */
     ParamList *array;           /* points to 1st element of ParamList array */
     double *pen_vec;            /* penalty vector: see score.h, struct SearchSpace */
+    Bounds *bounds;             /* the limits as flat arrays, see InitBounds() */
+    int identity;               /* 1 if the ParamList is the EqParms buffer in order */
 } PArrPtr;
 
 /** @brief General struct used for sized array of doubles */
@@ -364,6 +386,9 @@ typedef struct Zygote {
     int *full_nnucs;
     int *lin_start;
     int *full_lin_start;
+    int nlinmaps;               /* cycles covered by the lineage maps */
+    int **lin_gather;           /* [to * nlinmaps + from]: the nucleus of cycle index 'from' each nucleus of 'to' descends from */
+    int **lin_daughters;        /* [i]: both daughters in cycle index i of each nucleus of i + 1 */
 
     int nalleles;
     int ndp;
@@ -583,11 +608,26 @@ int count_Slist( Slist * start );
 
 /**  InitFullNNucs: takes the global defs.nnucs and calculates number of nucs 
  *              for each cleavage cycle which are then stored in reverse   
- *              order in the static nnucs[] array                          
+ *              order in the static nnucs[] array; does nothing if they
+ *              are there already
  *   CAUTION:   defs struct and lin_start need to be initialized before!   
  */
 void InitFullNNucs( Zygote * zyg, int *full_lin_start );
 
+/**  InitLineageMaps: tabulates for each pair of cleavage cycles (as indices
+ *              of full_lin_start) which nucleus of the earlier cycle each 
+ *              nucleus of the later one descends from, and the daughters  
+ *              of each nucleus one division later; Go_Forward(), Go_Back- 
+ *              ward(), Blastoderm() and DivideHistory() use these maps    
+ *              instead of working out the lineages element by element;    
+ *              called by InitFullNNucs(); maps of an earlier call are
+ *              freed first
+ */
+void InitLineageMaps( Zygote * zyg );
+
+/** FreeLineageMaps: frees the maps made by InitLineageMaps() */
+void FreeLineageMaps( Zygote * zyg );
+
 /** Index2StartLin: get starting lineage from index */
 int Index2StartLin( int index, int *full_lin_start );
 
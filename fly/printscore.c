@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>             /* for getopt */
+#include <getopt.h>             /* for getopt_long */
 
 #include <error.h>
 #include <integrate.h>
@@ -26,19 +27,26 @@
 #include <score.h>
 #include <solvers.h>
 #include <zygotic.h>
+#include <flysim.h>
 
 
 /* *Constants *************************************************************/
 
 const char *OPTS = ":a:Df:g:Ghi:m:opqr:s:vx:";  /* command line option string */
 
+/* long options; --serve has no short form, 'S' is only used internally */
+static struct option LONG_OPTS[] = {
+    {"serve", optional_argument, NULL, 'S'},
+    {NULL, 0, NULL, 0}
+};
+
 
 /*** Help, usage and version messages **************************************/
 
 static const char usage[] =
     "Usage: printscore [-a <accuracy>] [-D] [-f <float_prec>] [-g <g(u)>] [-G]\n"
     "                  [-h] [-i <stepsize>] [-m <score_method>] [-o] [-p] \n"
-    "                  [-s <solver>] [-v] [-x <sect_title>]\n" 
+    "                  [-s <solver>] [-v] [-x <sect_title>] [--serve[=<socket>]]\n" 
     "                  <datafile>\n";
 
 static const char help[] =
@@ -58,7 +66,9 @@ static const char help[] =
     "  -p                  prints penalty in addition to score and RMS\n"
     "  -s <solver>         choose ODE solver\n"
     "  -v                  print version and compilation date\n"
-    "  -x <sect_title>     uses equation paramters from section <sect_title>\n\n" "Please report bugs to <yoginho@usa.net>. Thank you!\n";
+    "  -x <sect_title>     uses equation paramters from section <sect_title>\n"
+    "  --serve[=<socket>]  keeps running and answers requests from stdin (or\n"
+    "                      from clients of Unix socket <socket>), see README\n\n" "Please report bugs to <yoginho@usa.net>. Thank you!\n";
 
 // GLOBAL CONSTANTS
 
@@ -99,6 +109,12 @@ main( int argc, char **argv ) {
 
     char *section_title;        /* parameter section name */
 
+    int serve = 0;              /* flag for --serve */
+    char *socket_name = NULL;   /* socket for --serve=<socket> */
+    char *solver_name = "rck";          /* solver and g(u) as given by -s and -g */
+    char gofu_name = 0;         /*   for handing them to fly_open() */
+    FlySim *sim;                /* handle for --serve */
+
     /* two format strings */
 
     char *format;               /* output format string */
@@ -155,7 +171,7 @@ main( int argc, char **argv ) {
 
     /* following part parses command line for options and their arguments      */
     optarg = NULL;
-    while( ( c = getopt( argc, argv, OPTS ) ) != -1 )
+    while( ( c = getopt_long( argc, argv, OPTS, LONG_OPTS, NULL ) ) != -1 )
         switch ( c ) {
         case 'a':
             accuracy = atof( optarg );
@@ -175,6 +191,7 @@ main( int argc, char **argv ) {
             break;
         case 'g':              /* -g choose g(u) function */
             pd = DvdtOrig;
+            gofu_name = optarg[0];
             if( !( strcmp( optarg, "s" ) ) )
                 gofu = Sqrt;
             else if( !( strcmp( optarg, "t" ) ) )
@@ -222,38 +239,13 @@ main( int argc, char **argv ) {
             error( "printscore: -r is not supported anymore, use -g instead" );
             break;
         case 's':              /* -s sets solver to be used */
-            if( !( strcmp( optarg, "a" ) ) )
-                ps = Adams;
-            else if( !( strcmp( optarg, "bd" ) ) )
-                ps = BaDe;
-            else if( !( strcmp( optarg, "bs" ) ) )
-                ps = BuSt;
-            else if( !( strcmp( optarg, "e" ) ) )
-                ps = Euler;
-            else if( !( strcmp( optarg, "h" ) ) )
-                ps = Heun;
-            else if( !( strcmp( optarg, "mi" ) ) || !( strcmp( optarg, "m" ) ) )
-                ps = Milne;
-            else if( !( strcmp( optarg, "me" ) ) )
-                ps = Meuler;
-            else if( !( strcmp( optarg, "r4" ) ) || !( strcmp( optarg, "r" ) ) )
-                ps = Rk4;
-            else if( !( strcmp( optarg, "r2" ) ) )
-                ps = Rk2;
-            else if( !( strcmp( optarg, "rck" ) ) )
-                ps = Rkck;
-            else if( !( strcmp( optarg, "rf" ) ) )
-                ps = Rkf;
-            else if( !( strcmp( optarg, "sd" ) ) )
-                ps = SoDe;
-            else if( !( strcmp( optarg, "kr" ) ) )
-                ps = Krylov;
-            /*
-               else if (!(strcmp(optarg, "bnd")))
-               ps = Band;
-             */
-            else
-                error( "printscore: bad solver (%s), use: a,bd,bs,e,h,kr,mi,me,r{2,4,ck,f}", optarg );
+            solver_name = optarg;
+            if( !( ps = SolverByName( optarg ) ) )
+                error( "printscore: bad solver (%s), use: " SOLVER_NAMES, optarg );
+            break;
+        case 'S':              /* --serve answers requests, see fly_serve() */
+            serve = 1;
+            socket_name = optarg;
             break;
         case 'v':              /* -v prints version number */
             //fprintf(stderr, verstring, *argv, VERS, USR, MACHINE, COMPILER, FLAGS, __DATE__, __TIME__);
@@ -276,6 +268,25 @@ main( int argc, char **argv ) {
     if( ( argc - ( optind - 1 ) ) != 2 )
         PrintMsg( usage, 1 );
 
+    /* --serve: set up once and answer requests until told to stop */
+
+    if( serve ) {
+        if( method != 0 )
+            warning( "printscore: --serve always uses the wls score, -m is ignored" );
+        sim = fly_open( argv[optind], section_title, solver_name, gofu_name, stepsize, accuracy );
+        if( !sim )
+            error( "printscore: could not set up %s for --serve", argv[optind] );
+        if( socket_name ) {
+            if( fly_serve_socket( sim, socket_name, ndigits ) )
+                error( "printscore: could not listen on socket %s", socket_name );
+        } else {
+            fly_serve( sim, stdin, stdout, ndigits );
+        }
+        fly_close( sim );
+        free( section_title );
+        return 0;
+    }
+
     /* dynamic allocation of output format strings */
 
     precision = ( char * ) calloc( MAX_RECORD, sizeof( char ) );
@@ -453,17 +464,11 @@ main( int argc, char **argv ) {
     free( inp.zyg.defs.egene_ids );
     free( inp.zyg.defs.gene_ids );
     free( inp.zyg.nnucs );
+    FreeLineageMaps( &( inp.zyg ) );
     free( inp.zyg.full_nnucs );
     free( inp.zyg.full_lin_start );
     free( inp.zyg.lin_start );
-    free( inp.zyg.parm.E );
-    free( inp.zyg.parm.R );
-    free( inp.zyg.parm.T );
-    free( inp.zyg.parm.d );
-    free( inp.zyg.parm.h );
-    free( inp.zyg.parm.lambda );
-    free( inp.zyg.parm.m );
-    free( inp.zyg.parm.tau );
+    FreeMutant( inp.zyg.parm );
 
     for( i = 0; i < inp.zyg.nalleles; i++ ) {
         free( inp.zyg.bias.bt[i].genotype );
@@ -494,11 +499,14 @@ main( int argc, char **argv ) {
     free( inp.twe.tautweak );
 
     free( inp.tra.array );
+    FreeBounds( &( inp.tra ) );
 
     FreeMutant( inp.lparm );
     FreeHistory( inp.zyg.nalleles, inp.his );
     FreeExternalInputs( inp.zyg.nalleles, inp.ext );
     FreeZygote(  );
+    FreeSolvers(  );
+    FreeLanes(  );
 
     free( precision );
     free( format );
@@ -19,11 +19,13 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <string.h>
+#include <time.h>
 
 #include "score.h"              /* obviously */
 #include "integrate.h"          /* for blastoderm and EPSILON and stuff */
 #include "fly_io.h"             /* i/o of parameters and data */
 #include "solvers.h"            /* for compare() */
+#include "zygotic.h"            /* for CopyParm() and FreeMutant() */
 
 #include "ioTools.h"
 
@@ -502,21 +504,72 @@ InitStepsize( double step, double acc, FILE * slog, char *infile ) {
 
 /*** REAL SCORING CODE HERE ************************************************/
 
-/** Score: as the name says, score runs the simulation, gets a solution 
- *          and then compares it to the data using the Eval least squares  
- *          function                                                       
- *   NOTE:  both InitZygote and InitScoring have to be called first!     
- *
+/** InstallParams: puts the parameter vector x (in the order of the tweak 
+ *                  table) into the model, R and lambda without sign, as   
+ *                  CheckParameters() would leave them                     
  */
-void
-Score( Input * inp, ScoreOutput * out, int jacobian ) {
+static void
+InstallParams( Input * inp, const double *x ) {
+    Bounds *b = inp->tra.bounds;
+    int j;
+
+    /* every parameter tweaked: x is laid out like the EqParms buffer */
+    if( inp->tra.identity ) {
+        memcpy( inp->zyg.parm.R, x, inp->tra.size * sizeof( double ) );
+        for( j = 0; j < inp->zyg.defs.ngenes; j++ ) {
+            inp->zyg.parm.R[j] = fabs( inp->zyg.parm.R[j] );
+            inp->zyg.parm.lambda[j] = fabs( inp->zyg.parm.lambda[j] );
+        }
+        return;
+    }
+    for( j = 0; j < inp->tra.size; j++ )
+        *( inp->tra.array[j].param ) = b->fold[b->tweak[j]] ? fabs( x[j] ) : x[j];
+}
+
+/** CheckParameters: makes R and lambda positive, checks the parameters 
+ *                    against the search space and calculates the penalty  
+ *                    into out->penalty; returns 0 and sets out->score to  
+ *                    FORBIDDEN_MOVE if they are out of bounds             
+ */
+static int
+CheckParameters( Input * inp, ScoreOutput * out ) {
+    int ii;
+    double penalty;
+
+    /* The following will be called after parms are tweaked, hence it must    *
+     * check signs. If it appears cleaner, sign checking could be done by the *
+     * tweaker                                                                */
+    for( ii = 0; ii < inp->zyg.defs.ngenes; ii++ ) {
+        if( inp->zyg.parm.R[ii] < 0 )
+            inp->zyg.parm.R[ii] = -inp->zyg.parm.R[ii];
+        if( inp->zyg.parm.lambda[ii] < 0 )
+            inp->zyg.parm.lambda[ii] = -inp->zyg.parm.lambda[ii];
+    }
+
+    /* all the limits and the penalty at once, see CheckBounds() */
+    penalty = CheckBounds( inp, NULL );
+    if( penalty == FORBIDDEN_MOVE ) {
+        out->score = FORBIDDEN_MOVE;
+        return 0;
+    }
+    out->penalty = penalty;
+
+    return 1;
+}
+
+/** RunScore: the part of Score() after the bounds check: runs the model 
+ *             for all genotypes and sums up their squared differences     
+ *             into out->score; out->penalty has to be set already         
+ */
+static void
+RunScore( Input * inp, ScoreOutput * out ) {
     // printf("Score\n");
 
     //name of the output dir
     //extern char *outname;
     ScoreEval eval;
 
-    int i, j, ii;
+    int i, j;
     double totalscore = 0;
     // file pointer
     //FILE *fp;
@@ -528,176 +581,35 @@ Score( Input * inp, ScoreOutput * out, int jacobian ) {
     // summed squared differences
     double chisq = 0;
 
-    // variable for penalty
-    double penalty = 0;
+    // set if a model run was stopped by its budget (see SolverBudget)
+    int aborted = 0;
+
+    // wall clock time of the model runs, for solver_stats
+    struct timespec tic, toc;
 
     /* debugging mode: need debugging file name */
     if( debug ) {
         debugfile = ( char * ) calloc( MAX_RECORD, sizeof( char ) );
     }
 
-    // printf("Scoring initialized.\n");
-
-    /*if( !tt_init_flag ) {          // tt_init_flag is a flag static to score.c        //REMOVE? - InitTTs is done in getFacts() function
-       InitTTs();                       // initializes tabulated times (tt)
-       } */
-
-    /* The following will be called after parms are tweaked, hence it must    *
-     * check signs. If it appears cleaner, sign checking could be done by the *
-     * tweaker                                                                */
-    // printf("Score: checking limits... \n");
-    for( ii = 0; ii < inp->zyg.defs.ngenes; ii++ ) {
-        if( inp->zyg.parm.R[ii] < 0 )
-            inp->zyg.parm.R[ii] = -inp->zyg.parm.R[ii];
-        if( inp->zyg.parm.lambda[ii] < 0 )
-            inp->zyg.parm.lambda[ii] = -inp->zyg.parm.lambda[ii];
-    }
-    /* The following fors and ifs check the searchspace in such a way as to   *
-     * return after as few calculations as possible                           */
-    for( i = 0; i < inp->zyg.defs.ngenes; i++ ) {
-        if( inp->zyg.parm.R[i] > inp->sco.searchspace->Rlim[i]->upper ) {
-            //printf("OUT_OF_BOUND_R: %.10lf > %.10lf | %d\n", inp->zyg.parm.R[i], inp->sco.searchspace->Rlim[i]->upper, i);
-            out->score = FORBIDDEN_MOVE;
-            return;
-        }
-        if( inp->zyg.parm.R[i] < inp->sco.searchspace->Rlim[i]->lower ) {
-            //printf("OUT_OF_BOUND_R: %.10lf < %.10lf | %d\n", inp->zyg.parm.R[i], inp->sco.searchspace->Rlim[i]->lower, i);
-            out->score = FORBIDDEN_MOVE;
-            return;
-        }
-        if( inp->zyg.parm.lambda[i] > inp->sco.searchspace->lambdalim[i]->upper ) {
-            //printf("OUT_OF_BOUND_lambda: %.10lf > %.10lf | %d\n", inp->zyg.parm.lambda[i], inp->sco.searchspace->lambdalim[i]->upper, i);
-            out->score = FORBIDDEN_MOVE;
-            return;
-        }
-        if( inp->zyg.parm.lambda[i] < inp->sco.searchspace->lambdalim[i]->lower ) {
-            //printf("OUT_OF_BOUND_lambda: %.10lf < %.10lf | %d\n", inp->zyg.parm.lambda[i], inp->sco.searchspace->lambdalim[i]->lower, i);
-            out->score = FORBIDDEN_MOVE;
-            return;
-        }
-        if( inp->zyg.parm.tau[i] > inp->sco.searchspace->taulim[i]->upper ) {
-            //printf("OUT_OF_BOUND_tau>\n");
-            out->score = FORBIDDEN_MOVE;
-            return;
-        }
-        if( inp->zyg.parm.tau[i] < inp->sco.searchspace->taulim[i]->lower ) {
-            //printf("OUT_OF_BOUND_tau<\n");
-            out->score = FORBIDDEN_MOVE;
-            return;
-        }
-    }
-    // printf("SCR STEP2\n");
-    if( ( inp->zyg.defs.diff_schedule == 'A' ) || ( inp->zyg.defs.diff_schedule == 'C' ) ) {
-        if( inp->zyg.parm.d[0] > inp->sco.searchspace->dlim[0]->upper ) {
-            //printf("OUT_OF_BOUND_d: %.10lf > %.10lf\n", inp->zyg.parm.d[0], inp->sco.searchspace->dlim[0]->upper);
-            out->score = FORBIDDEN_MOVE;
-            return;
-        }
-        if( inp->zyg.parm.d[0] < inp->sco.searchspace->dlim[0]->lower ) {
-            //printf("OUT_OF_BOUND_d: %.10lf < %.10lf\n", inp->zyg.parm.d[0], inp->sco.searchspace->dlim[0]->lower);
-            out->score = FORBIDDEN_MOVE;
-            return;
-        }
-    } else {
-        for( i = 0; i < inp->zyg.defs.ngenes; i++ ) {
-            if( inp->zyg.parm.d[i] > inp->sco.searchspace->dlim[i]->upper ) {
-                //printf("OUT_OF_BOUND_d: %.10lf > %.10lf for i = %d\n", inp->zyg.parm.d[i], inp->sco.searchspace->dlim[i]->upper, i);
-                out->score = FORBIDDEN_MOVE;
-                return;
-            }
-            if( inp->zyg.parm.d[i] < inp->sco.searchspace->dlim[i]->lower ) {
-                //printf("OUT_OF_BOUND_d: %.10lf < %.10lf for i = %d\n", inp->zyg.parm.d[i], inp->sco.searchspace->dlim[i]->lower, i);
-                out->score = FORBIDDEN_MOVE;
-                return;
-            }
-        }
-    }
-    
-    /* Penalty stuff below:
-     * With asym limits, it is easier now to always check for limits. In case
-     * we are doing partly limits, partly penalty, we still need to check for
-     * the limits... so the test if pen_vec == NULL is not sufficient.
-     *
-     * Perhaps in the future (if this part of the code appears to be a 
-     * bottleneck) we can make a new test for only limits or only penalty, but
-     * as said above, now it is simply easier to just check for penalties
-     * always.
-     */
-    /* If you're using limits on contributors to u, check'em here */
-    // printf("Score: Checking the penalties...\n");
-    /*if( inp->sco.searchspace->pen_vec == NULL ) {*/
-    for( i = 0; i < inp->zyg.defs.ngenes; i++ ) {
-        for( j = 0; j < inp->zyg.defs.ngenes; j++ ) {
-            if( inp->zyg.parm.T[( i * inp->zyg.defs.ngenes ) + j] > inp->sco.searchspace->Tlim[( i * inp->zyg.defs.ngenes ) + j]->upper ) {
-                // printf("OUT_OF_BOUND_T: %.10lf > %.10lf | %d | %d\n", inp->zyg.parm.T[(i * inp->zyg.defs.ngenes) + j], inp->sco.searchspace->Tlim[(i * inp->zyg.defs.ngenes) + j]->upper, i, j);
-                out->score = FORBIDDEN_MOVE;
-                return;
-            }
-            if( inp->zyg.parm.T[( i * inp->zyg.defs.ngenes ) + j] < inp->sco.searchspace->Tlim[( i * inp->zyg.defs.ngenes ) + j]->lower ) {
-                // printf("OUT_OF_BOUND_T: %.10lf < %.10lf | %d | %d\n", inp->zyg.parm.T[(i * inp->zyg.defs.ngenes) + j], inp->sco.searchspace->Tlim[(i * inp->zyg.defs.ngenes) + j]->lower, i, j);
-                out->score = FORBIDDEN_MOVE;
-                return;
-            }
-        }
-        for( j = 0; j < inp->zyg.defs.egenes; j++ ) {
-            if( inp->zyg.parm.E[( i * inp->zyg.defs.egenes ) + j] > inp->sco.searchspace->Elim[( i * inp->zyg.defs.egenes ) + j]->upper ) {
-                // printf("OUT_OF_BOUND_E: %.10lf > %.10lf | %d | %d\n", inp->zyg.parm.E[(i * inp->zyg.defs.egenes) + j], inp->sco.searchspace->Elim[(i * inp->zyg.defs.egenes) + j]->upper, i, j);
-                out->score = FORBIDDEN_MOVE;
-                return;
-            }
-            if( inp->zyg.parm.E[( i * inp->zyg.defs.egenes ) + j] < inp->sco.searchspace->Elim[( i * inp->zyg.defs.egenes ) + j]->lower ) {
-                // printf("OUT_OF_BOUND_E: %.10lf < %.10lf | %d | %d\n", inp->zyg.parm.E[(i * inp->zyg.defs.egenes) + j], inp->sco.searchspace->Elim[(i * inp->zyg.defs.egenes) + j]->lower, i, j);
-                out->score = FORBIDDEN_MOVE;
-                return;
-            }
-        }
-        if( inp->zyg.parm.m[i] > inp->sco.searchspace->mlim[i]->upper ) {
-            // printf("OUT_OF_BOUND_m: %.10lf > %.10lf for i = %d\n", inp->zyg.parm.m[i], inp->sco.searchspace->mlim[i]->upper, i);
-            out->score = FORBIDDEN_MOVE;
-            return;
-        }
-        if( inp->zyg.parm.m[i] < inp->sco.searchspace->mlim[i]->lower ) {
-            // printf("OUT_OF_BOUND_m: %.10lf < %.10lf for i = %d\n", inp->zyg.parm.m[i], inp->sco.searchspace->mlim[i]->lower, i);
-            out->score = FORBIDDEN_MOVE;
-            return;
-        }
-        if( inp->zyg.parm.h[i] > inp->sco.searchspace->hlim[i]->upper ) {
-            // printf("OUT_OF_BOUND_h: %.10lf > %.10lf for i = %d\n", inp->zyg.parm.h[i], inp->sco.searchspace->hlim[i]->upper, i);
-            out->score = FORBIDDEN_MOVE;
-            return;
-        }
-        if( inp->zyg.parm.h[i] < inp->sco.searchspace->hlim[i]->lower ) {
-            // printf("OUT_OF_BOUND_h: %.10lf < %.10lf for i = %d\n", inp->zyg.parm.h[i], inp->sco.searchspace->hlim[i]->lower, i);
-            out->score = FORBIDDEN_MOVE;
-            return;
-        }
-    }
-    out->penalty = 0;
-
-    /* if you're going to calculate penalty on u, do it here */
-    /* following lines calculate exp of sum of squares penalty function */
-
-    /*} else {*/
-    if( inp->sco.searchspace->pen_vec != NULL ) {    
-        penalty = GetPenalty( inp, inp->sco.searchspace );
-        if( penalty == FORBIDDEN_MOVE ) {
-            //printf("FORBIDDEN_MOVE_Penalty\n");
-            out->score = FORBIDDEN_MOVE;
-            return;
-        }
-    /*if (penalty > 0) {
-       printf( "PENALTY = %lg\n", penalty);
-    }*/
-    out->penalty = penalty;
-    }
-
     // printf("Penalty computed.\n");
 
     /* runs the model and sums squared differences for all genotypes */
     // printf("%d\n", inp->zyg.nalleles);
     // printf("%d\n", inp->zyg.nnucs);
+    clock_gettime( CLOCK_MONOTONIC, &tic );
     for( i = 0; i < inp->zyg.nalleles; i++ ) {
-        answer = Blastoderm( i, inp->sco.facts.facttype[i].genotype, inp, inp->ste.slogptr );
+        /* Eval only looks at the data times, the debugging output and the guts *
+         * want the state at every step of the model                            */
+        StartBudget( 1 );
+        if( debug || gutparms.flag )
+            answer = Blastoderm( i, inp->sco.facts.facttype[i].genotype, inp, inp->ste.slogptr );
+        else
+            answer = BlastodermStream( i, inp->sco.facts.facttype[i].genotype, inp, inp->ste.slogptr, NULL, NULL );
+        if( ( aborted = StopBudget(  ) ) ) {
+            FreeSolution( &answer );
+            break;
+        }
         if( debug ) {
             sprintf( debugfile, "%s.%s.pout", inp->ste.filename, inp->sco.facts.facttype[i].genotype );
             fp = fopen( debugfile, "w" );
@@ -738,7 +650,17 @@ Score( Input * inp, ScoreOutput * out, int jacobian ) {
         free( debugfile );
     }
     nbScore++;
+    clock_gettime( CLOCK_MONOTONIC, &toc );
+    solver_stats.scores++;
+    solver_stats.score_time += ( toc.tv_sec - tic.tv_sec ) + 1e-9 * ( toc.tv_nsec - tic.tv_nsec );
     // printf("\n%d\n", nbScore);
+
+    /* the model didn't finish, there is nothing to compare */
+    if( aborted ) {
+        out->score = FORBIDDEN_MOVE;
+        out->penalty = 0;
+        return;
+    }
     
     out->score = chisq;
     // printf("%lf\n", out->score);
@@ -762,6 +684,196 @@ Score( Input * inp, ScoreOutput * out, int jacobian ) {
         
 }
 
+/** Score: as the name says, score runs the simulation, gets a solution 
+ *          and then compares it to the data using the Eval least squares  
+ *          function                                                       
+ *   NOTE:  both InitZygote and InitScoring have to be called first!     
+ *
+ */
+void
+Score( Input * inp, ScoreOutput * out, int jacobian ) {
+    if( CheckParameters( inp, out ) )
+        RunScore( inp, out );
+}
+
+/** ScoreParams: scores the parameter vector x (in the order of the tweak 
+ *                table); x is checked against the search space before it 
+ *                goes into the model, so a vector out of bounds gets      
+ *                FORBIDDEN_MOVE without touching inp                      
+ */
+void
+ScoreParams( Input * inp, const double *x, ScoreOutput * out ) {
+    double penalty;
+
+    penalty = CheckBounds( inp, x );
+    if( penalty == FORBIDDEN_MOVE ) {
+        out->score = FORBIDDEN_MOVE;
+        out->penalty = 0;
+        return;
+    }
+    InstallParams( inp, x );
+    out->penalty = penalty;
+    RunScore( inp, out );
+}
+
+
+/** ScoreBatch: scores 'nsets' parameter sets (in the order of the tweak
+ *               table) into cost[] (score plus penalty, as Score() does)  
+ *               by running their model in lockstep, see BlastodermBatch() 
+ */
+void
+ScoreBatch( Input * inp, double **params, int nsets, double *cost ) {
+    ScoreOutput out;
+    ScoreEval eval;
+    EqParms *parms;
+    NArrPtr *answers;
+    double *chisq, *penalty;
+    int *lane;
+    int c, i, n;
+    int aborted = 0;            /* set if the lockstep run was stopped */
+    struct timespec tic, toc;
+
+    out.score = 1e38;
+    out.penalty = 0;
+    out.size_resid_arr = 0;
+    out.jacobian = NULL;
+    out.residuals = NULL;
+
+    /* one by one: no lockstep solver, debug output or guts */
+    if( nsets < 2 || !LockstepSolver( ps ) || debug || gutparms.flag ) {
+        for( c = 0; c < nsets; c++ ) {
+            ScoreParams( inp, params[c], &out );
+            cost[c] = out.score + out.penalty;
+        }
+        free( out.residuals );
+        return;
+    }
+
+    parms = ( EqParms * ) malloc( nsets * sizeof( EqParms ) );
+    answers = ( NArrPtr * ) malloc( nsets * sizeof( NArrPtr ) );
+    chisq = ( double * ) calloc( 2 * nsets, sizeof( double ) );
+    lane = ( int * ) malloc( nsets * sizeof( int ) );
+    if( !parms || !answers || !chisq || !lane )
+        error( "ScoreBatch: could not allocate memory" );
+    penalty = chisq + nsets;
+
+    /* the sets out of bounds are done before they get near the model, the *
+     * others get a lane                                                   */
+    for( c = 0, n = 0; c < nsets; c++ ) {
+        if( ( penalty[n] = CheckBounds( inp, params[c] ) ) == FORBIDDEN_MOVE ) {
+            cost[c] = FORBIDDEN_MOVE;
+            continue;
+        }
+        InstallParams( inp, params[c] );
+        parms[n] = CopyParm( inp->zyg.parm, &( inp->zyg.defs ) );
+        lane[n++] = c;
+    }
+
+    clock_gettime( CLOCK_MONOTONIC, &tic );
+    for( i = 0; n > 0 && i < inp->zyg.nalleles && !aborted; i++ ) {
+        StartBudget( n );
+        BlastodermBatch( i, inp->sco.facts.facttype[i].genotype, inp, parms, n, answers, inp->ste.slogptr );
+        aborted = StopBudget(  );
+        for( c = 0; c < n; c++ ) {
+            if( !aborted ) {
+                Eval( &eval, &answers[c], i, inp );
+                chisq[c] += eval.chisq;
+                free( eval.residuals );
+            }
+            FreeSolution( &answers[c] );
+        }
+    }
+    clock_gettime( CLOCK_MONOTONIC, &toc );
+    nbScore += n;
+    solver_stats.scores += n;
+    solver_stats.score_time += ( toc.tv_sec - tic.tv_sec ) + 1e-9 * ( toc.tv_nsec - tic.tv_nsec );
+
+    /* a lane that diverges stops all of them: the sets get their own runs, *
+     * so that only the bad ones score FORBIDDEN_MOVE                       */
+    for( c = 0; c < n; c++ ) {
+        if( aborted ) {
+            ScoreParams( inp, params[lane[c]], &out );
+            cost[lane[c]] = out.score + out.penalty;
+        } else
+            cost[lane[c]] = chisq[c] + penalty[c];
+        FreeMutant( parms[c] );
+    }
+    free( out.residuals );
+    free( parms );
+    free( answers );
+    free( chisq );
+    free( lane );
+}
+
+/** ScreenScore: like Score, but with the single precision solver if the 
+ *                current one has such a version; returns 1 if it was used 
+ */
+int
+ScreenScore( Input * inp, ScoreOutput * out ) {
+    SolverFunc keep = ps;
+    SolverFunc single = SinglePrecisionSolver( ps );
+
+    if( !single ) {
+        Score( inp, out, 0 );
+        return 0;
+    }
+
+    LastStop(  );               /* forget the runs before this one */
+    ps = single;
+    Score( inp, out, 0 );
+    ps = keep;
+
+    /* overflow or the like in float (which stops the run, see CheckState()): *
+     * this one needs the real thing; a set out of bounds or over its budget  *
+     * would do no better in double                                           */
+    if( !isfinite( out->score ) || !isfinite( out->penalty ) || LastStop(  ) == RUN_DIVERGED ) {
+        Score( inp, out, 0 );
+        return 0;
+    }
+    return 1;
+}
+
+/** RankAgreement: Spearman rank correlation of a and b; the rank of a     
+ *                  value is the number of smaller values plus half of the 
+ *                  number of equal ones (the mean rank of a tie)          
+ */
+double
+RankAgreement( const double *a, const double *b, int n ) {
+    int i, j;
+    double ra, rb, ma, mb, sab = 0., saa = 0., sbb = 0.;
+    double *rank;
+
+    if( n < 2 )
+        return 1.;
+
+    rank = ( double * ) malloc( 2 * n * sizeof( double ) );
+    if( !rank )
+        error( "RankAgreement: could not allocate memory" );
+
+    for( i = 0; i < n; i++ ) {
+        ra = rb = 0.;
+        for( j = 0; j < n; j++ ) {
+            ra += ( a[j] < a[i] ) ? 1. : ( a[j] == a[i] ) ? 0.5 : 0.;
+            rb += ( b[j] < b[i] ) ? 1. : ( b[j] == b[i] ) ? 0.5 : 0.;
+        }
+        rank[i] = ra;
+        rank[n + i] = rb;
+    }
+
+    /* both rank vectors have the same mean; ranks are all equal only for ties */
+    ma = mb = 0.5 * n;
+    for( i = 0; i < n; i++ ) {
+        sab += ( rank[i] - ma ) * ( rank[n + i] - mb );
+        saa += ( rank[i] - ma ) * ( rank[i] - ma );
+        sbb += ( rank[n + i] - mb ) * ( rank[n + i] - mb );
+    }
+    free( rank );
+
+    if( saa == 0. || sbb == 0. )
+        return ( saa == sbb ) ? 1. : 0.;
+    return sab / sqrt( saa * sbb );
+}
+
 
 /** Eval: scores the summed squared differences between equation solution 
  *         and data. Because the times for states written to the Solution  
@@ -1019,6 +1131,169 @@ GetLimits( Input * inp ) {
     return inp->sco.searchspace;
 }
 
+/*** THE SEARCH SPACE AS FLAT ARRAYS **************************************/
+
+/** AddBound: appends the parameter 'param' with limits 'lim' (none if   
+ *             NULL) and penalty factor 'weight' to the bounds 'b'; like   
+ *             in GetPenalty(), only a parameter with a limit at DBL_MAX   
+ *             has a penalty                                               
+ */
+static void
+AddBound( Bounds * b, double *param, Range * lim, double weight, int fold ) {
+    b->param[b->n] = param;
+    b->lower[b->n] = lim ? lim->lower : -HUGE_VAL;
+    b->upper[b->n] = lim ? lim->upper : HUGE_VAL;
+    b->weight[b->n] = 0.;
+    if( lim && ( fabs( lim->lower + DBL_MAX ) < EPSILON || fabs( lim->upper - DBL_MAX ) < EPSILON ) )
+        b->weight[b->n] = weight;
+    b->fold[b->n] = fold;
+    b->value[b->n] = *param;
+    b->n++;
+}
+
+/** InitBounds: compiles the search space into plist->bounds */
+void
+InitBounds( Input * inp, PArrPtr * plist ) {
+    SearchSpace *limits = inp->sco.searchspace;
+    EqParms *parm = &( inp->zyg.parm );
+    int ngenes = inp->zyg.defs.ngenes;
+    int egenes = inp->zyg.defs.egenes;
+    int max_elem = ngenes * ngenes + ngenes * egenes + 6 * ngenes + plist->size;
+    double mmax = 0., *vmax = NULL;
+    Bounds *b;
+    int i, j, k;
+
+    FreeBounds( plist );
+    b = ( Bounds * ) calloc( 1, sizeof( Bounds ) );
+    if( !b )
+        error( "InitBounds: could not allocate memory" );
+    b->lower = ( double * ) malloc( 4 * max_elem * sizeof( double ) );
+    b->param = ( double ** ) malloc( max_elem * sizeof( double * ) );
+    b->fold = ( int * ) malloc( ( max_elem + plist->size ) * sizeof( int ) );
+    if( !b->lower || !b->param || !b->fold )
+        error( "InitBounds: could not allocate memory" );
+    b->upper = b->lower + max_elem;
+    b->weight = b->upper + max_elem;
+    b->value = b->weight + max_elem;
+    b->tweak = b->fold + max_elem;
+
+    /* the penalty vector is Lambda, mmax, vmax[ngenes + egenes] */
+    if( limits->pen_vec != NULL ) {
+        b->Lambda = limits->pen_vec[0];
+        mmax = limits->pen_vec[1];
+        vmax = limits->pen_vec + 2;
+    }
+
+    /* same order as in Translate() */
+    for( i = 0; i < ngenes; i++ )
+        AddBound( b, &parm->R[i], limits->Rlim[i], 0., 1 );
+    b->pen[0] = b->n;
+    for( i = 0; i < ngenes; i++ )
+        for( j = 0; j < ngenes; j++ )
+            AddBound( b, &parm->T[i * ngenes + j], limits->Tlim[i * ngenes + j], vmax ? vmax[j] : 0., 0 );
+    b->pen[1] = b->n;
+    for( i = 0; i < ngenes; i++ )
+        for( j = 0; j < egenes; j++ )
+            AddBound( b, &parm->E[i * egenes + j], limits->Elim[i * egenes + j], vmax ? vmax[ngenes + j] : 0., 0 );
+    b->pen[2] = b->n;
+    for( i = 0; i < ngenes; i++ )
+        AddBound( b, &parm->m[i], limits->mlim[i], mmax, 0 );
+    b->pen[3] = b->n;
+    for( i = 0; i < ngenes; i++ )
+        AddBound( b, &parm->h[i], limits->hlim[i], vmax ? 1. : 0., 0 );
+    b->pen[4] = b->n;
+    if( ( inp->zyg.defs.diff_schedule == 'A' ) || ( inp->zyg.defs.diff_schedule == 'C' ) )
+        AddBound( b, &parm->d[0], limits->dlim[0], 0., 0 );
+    else
+        for( i = 0; i < ngenes; i++ )
+            AddBound( b, &parm->d[i], limits->dlim[i], 0., 0 );
+    for( i = 0; i < ngenes; i++ )
+        AddBound( b, &parm->lambda[i], limits->lambdalim[i], 0., 1 );
+    for( i = 0; i < ngenes; i++ )
+        AddBound( b, &parm->tau[i], limits->taulim[i], 0., 0 );
+
+    /* no penalty at all without penalty vector */
+    if( vmax == NULL )
+        for( i = 1; i < 5; i++ )
+            b->pen[i] = b->pen[0];
+
+    /* find the entries of the tweaked parameters; one that Score() never  *
+     * checked (like d[1] with a single diffusion constant) gets no limits */
+    for( j = 0; j < plist->size; j++ ) {
+        for( k = 0; k < b->n && b->param[k] != plist->array[j].param; k++ );
+        if( k == b->n )
+            AddBound( b, plist->array[j].param, NULL, 0., 0 );
+        b->tweak[j] = k;
+    }
+
+    /* fixed R and lambda are positive from now on, as after a Score() */
+    for( k = 0; k < b->n; k++ )
+        if( b->fold[k] && *( b->param[k] ) < 0 )
+            b->value[k] = *( b->param[k] ) = -*( b->param[k] );
+
+    plist->bounds = b;
+}
+
+/** FreeBounds: frees plist->bounds */
+void
+FreeBounds( PArrPtr * plist ) {
+    if( plist->bounds == NULL )
+        return;
+    free( plist->bounds->lower );
+    free( plist->bounds->param );
+    free( plist->bounds->fold );
+    free( plist->bounds );
+    plist->bounds = NULL;
+}
+
+/** CheckBounds: checks the parameters against the flat search space and 
+ *                calculates their penalty like GetPenalty() does          
+ */
+double
+CheckBounds( Input * inp, const double *x ) {
+    Bounds *b = inp->tra.bounds;
+    double *v = b->value;
+    const double *lower = b->lower, *upper = b->upper;
+    const int *fold = b->fold;
+    double penalty = 0., sum, a;
+    int i, k, n = b->n, outside = 0;
+
+    /* the vector goes into the entries of the tweaked parameters, the     *
+     * others keep their values                                            */
+    if( x != NULL )
+        for( k = 0; k < inp->tra.size; k++ )
+            v[b->tweak[k]] = x[k];
+    else
+        for( k = 0; k < b->n; k++ )
+            v[k] = *( b->param[k] );
+
+    /* no early exit and no pointers, so the compiler can vectorize this */
+    for( k = 0; k < n; k++ ) {
+        a = fold[k] ? fabs( v[k] ) : v[k];
+        outside |= ( a < lower[k] ) | ( a > upper[k] );
+    }
+    if( outside )
+        return FORBIDDEN_MOVE;
+    if( b->pen[0] == b->pen[4] )
+        return 0.;
+
+    /* summed up per parameter (T, E, m, h) as in GetPenalty(), so that it *
+     * is the same bit for bit; one without penalty adds an exact zero     */
+    for( i = 0; i < 4; i++ ) {
+        sum = 0.;
+        for( k = b->pen[i]; k < b->pen[i + 1]; k++ ) {
+            a = v[k] * b->weight[k];
+            sum += a * a;
+        }
+        penalty += sum;
+    }
+    if( b->Lambda * penalty > 88.7228391 )
+        return FORBIDDEN_MOVE;
+    penalty = exp( b->Lambda * penalty ) - 2.718281828459045;
+
+    return ( penalty < 0 ) ? 0 : penalty;
+}
+
 /**
 Experimental feature: how to calculate penalties in the new model
 @author Anton Crombach 
@@ -1080,7 +1355,9 @@ GetPenalty( Input * inp, SearchSpace * limits ) {
     static int donethis = 0;
     int i;
     
-    parm = &( inp->lparm );
+    /* the parameters being scored; inp->lparm still holds the mutated ones *
+     * of the previous model run at this point                               */
+    parm = &( inp->zyg.parm );
     if( limits->pen_vec == NULL ) 
         return -1;
     
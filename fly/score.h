@@ -130,6 +130,38 @@ double checkBound( TheProblem defs, SearchSpace limits );
  */
 void Score( Input * inp, ScoreOutput * out, int jacobian );
 
+/** ScoreParams: like Score, for the parameter vector x in the order of 
+ *                the tweak table; x is checked against the search space   
+ *                (see CheckBounds()) before it goes into inp, so a vector 
+ *                out of bounds gets FORBIDDEN_MOVE without touching the   
+ *                model                                                    
+ */
+void ScoreParams( Input * inp, const double *x, ScoreOutput * out );
+
+/** ScoreBatch: scores 'nsets' parameter sets, params[c] in the order of
+ *               the tweak table, and returns their score plus penalty in  
+ *               cost[c]; with a lockstep solver (see LockstepSolver() in  
+ *               solvers.h) the model runs of all sets are integrated at   
+ *               once, otherwise it just calls Score() for each of them.   
+ *               The parameters of the last set are left in inp.           
+ */
+void ScoreBatch( Input * inp, double **params, int nsets, double *cost );
+
+/** ScreenScore: like Score, but runs the model with the single precision
+ *                version of the solver (see SinglePrecisionSolver() in    
+ *                solvers.c) if there is one; good enough for ranking      
+ *                parameter sets. A non-finite single precision score is   
+ *                replaced by the double precision one. Returns 1 if the   
+ *                single precision solver was used, 0 otherwise.           
+ */
+int ScreenScore( Input * inp, ScoreOutput * out );
+
+/** RankAgreement: Spearman rank correlation of a and b (of size n), e.g. 
+ *                  of single and double precision costs; ties get their   
+ *                  mean rank; returns 1 for n < 2                         
+ */
+double RankAgreement( const double *a, const double *b, int n );
+
 double ScoreNoCheck( void );
 
 /*
@@ -172,6 +204,26 @@ DArrPtr GetTTimes( char *genotype );
  */
 SearchSpace *GetLimits( Input * inp );
 
+/** InitBounds: compiles the limits of all parameters and the penalty    
+ *               vector into the flat arrays of plist->bounds (see struct  
+ *               Bounds in maternal.h); Translate() calls it, call it again
+ *               whenever inp->sco.searchspace changes                     
+ */
+void InitBounds( Input * inp, PArrPtr * plist );
+
+/** FreeBounds: frees plist->bounds */
+void FreeBounds( PArrPtr * plist );
+
+/** CheckBounds: the filter in front of the model: checks the parameter  
+ *                vector x (in the order of the tweak table; the fixed     
+ *                parameters as they are in inp) or, if x is NULL, all the 
+ *                parameters in inp against the search space, R and lambda 
+ *                without sign; returns FORBIDDEN_MOVE if they are out of  
+ *                bounds, their penalty (as GetPenalty()) otherwise        
+ *      CAUTION: InitBounds must be called first!                          
+ */
+double CheckBounds( Input * inp, const double *x );
+
 /** GetPenalty: calculates penalty from static limits, vmax and mmax 
  *      CAUTION: InitPenalty must be called first!                         
  */
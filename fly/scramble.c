@@ -348,17 +348,11 @@ main( int argc, char **argv ) {
     free( inp.zyg.defs.egene_ids );
     free( inp.zyg.defs.gene_ids );
     free( inp.zyg.nnucs );
+    FreeLineageMaps( &( inp.zyg ) );
     free( inp.zyg.full_nnucs );
     free( inp.zyg.full_lin_start );
     free( inp.zyg.lin_start );
-    free( inp.zyg.parm.E );
-    free( inp.zyg.parm.R );
-    free( inp.zyg.parm.T );
-    free( inp.zyg.parm.d );
-    free( inp.zyg.parm.h );
-    free( inp.zyg.parm.lambda );
-    free( inp.zyg.parm.m );
-    free( inp.zyg.parm.tau );
+    FreeMutant( inp.zyg.parm );
 
     for( i = 0; i < inp.zyg.nalleles; i++ ) {
         free( inp.zyg.bias.bt[i].genotype );
@@ -107,6 +107,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <limits.h>
+#include <time.h>
 
 #include <error.h>
 #include <solvers.h>
@@ -116,21 +117,38 @@
 
 //#include "fly_opt.h"
 
+/*** GLOBAL VARIABLES ******************************************************/
+
+SolverStats solver_stats;       /* always-on work counters, see solvers.h */
+SolverBudget solver_budget;     /* work limits of a model run, see solvers.h */
+
 /*** STATIC VARIABLES AND MACROS *******************************************/
 
 double *d;                      /* D's used for Neville extrapolation in BuSt() */
 double *hpoints;                /* stepsizes h (=H/n) which we try in BuSt() */
 double maxdel, mindel;
 int numdel;                     /* delay parameters used by DCERk32, y_delayed */
-int gridstart;                  /* for the heuristic */
 double *delay;                  /* static array set in SoDe, used by DCERk32 */
+
+/* the history of the delay solver is a ring buffer of grid points: grid   *
+ * point i (counted from the start of the model run) is in slot HIST(i);   *
+ * only the points from gridstart on are kept, the older ones are more     *
+ * than maxdel in the past and will not be looked up any more              */
+
+int gridstart;                  /* last grid point more than maxdel in the past */
 int gridpos;                    /* where you are in the grid */
+int histcap;                    /* number of slots in the ring buffer */
+double gridtime0;               /* time of grid point 0, history before it */
 double *tdone;                  /* the grid */
 double **derivv1;               /* intermediate derivatives for the Cash-Karp formula */
 double **derivv2;
 double **derivv3;
 double **derivv4;
 double **vdonne;
+int *histsize;                  /* room for the arrays of a slot */
+int histmax;                    /* largest size of the arrays (cycle 14) */
+
+#define HIST( i ) ( ( i ) % histcap )
 
 /* three macros used in various solvers below */
 
@@ -253,6 +271,7 @@ Euler( double *vin, double *vout, double tin, double tout, double stephint, doub
         }
     }
 
+    solver_stats.steps += nsteps;
     if( debug )
         WriteSolvLog( "Euler", tin, tout, stepsize, nsteps, nd, slog );
 
@@ -368,6 +387,7 @@ Meuler( double *vin, double *vout, double tin, double tout, double stephint, dou
         }
     }
 
+    solver_stats.steps += nsteps;
     if( debug )
         WriteSolvLog( "Meuler", tin, tout, stepsize, nsteps, nd, slog );
 
@@ -485,6 +505,7 @@ Heun( double *vin, double *vout, double tin, double tout, double stephint, doubl
         }
     }
 
+    solver_stats.steps += nsteps;
     if( debug )
         WriteSolvLog( "Heun", tin, tout, stepsize, nsteps, nd, slog );
 
@@ -602,6 +623,7 @@ Rk2( double *vin, double *vout, double tin, double tout, double stephint, double
         }
     }
 
+    solver_stats.steps += nsteps;
     if( debug )
         WriteSolvLog( "Rk2", tin, tout, stepsize, nsteps, nd, slog );
 
@@ -754,12 +776,194 @@ Rk4( double *vin, double *vout, double tin, double tout, double stephint, double
         }
     }
 
+    solver_stats.steps += nsteps;
     if( debug )
         WriteSolvLog( "Rk4", tin, tout, stepsize, nsteps, nd, slog );
 
     return;
 }
 
+/*** IMEX SOLVER ***********************************************************
+ *                                                                         *
+ *   The linear part of the equations, diffusion between neighbouring      *
+ *   nuclei and protein decay, is what makes them stiff:                   *
+ *                                                                         *
+ *        (L v)[ap][k] = D[k] * (v[ap-1][k] - 2 v[ap][k] + v[ap+1][k])     *
+ *                       - lambda[k] * v[ap][k]                            *
+ *                                                                         *
+ *   (no diffusion through the walls). Imex treats L implicitly and the    *
+ *   rest of the derivative, N(v) = dv/dt - L v, i.e. regulated protein    *
+ *   synthesis, explicitly. L couples nuclei of the same gene only, so the *
+ *   implicit stages need one tridiagonal solve per gene.                  *
+ *                                                                         *
+ *   Imex is stable at stepsizes where Rk4 blows up (-i 4), but it is only *
+ *   second order: on output/dm_hkgn53_sss (chisq 131774.99 by Rkck at     *
+ *   1e-8) it gives 1508335.6 at -i 4, 149657.7 at -i 1, 132704.5 at -i    *
+ *   0.5, 131716.6 at -i 0.2 and 131747.6 at -i 0.1; on dm_hkgn58_sss      *
+ *   (2520.25) 2988.9 at -i 4 and 2519.76 at -i 0.1. A relative error of   *
+ *   2e-4 thus takes -i 0.1, while Rk4 gets there at -i 0.2 and -i 1.      *
+ *                                                                         *
+ ***************************************************************************/
+
+/** ImexLinear: lv = L v for n / ngenes nuclei */
+static void
+ImexLinear( const double *v, double *lv, int n, int ngenes, const double *D, const double *lambda ) {
+    int i, k;
+
+    for( i = 0; i < n; i++ ) {
+        k = i % ngenes;
+        lv[i] = -lambda[k] * v[i];
+        if( i >= ngenes )
+            lv[i] += D[k] * ( v[i - ngenes] - v[i] );
+        if( i + ngenes < n )
+            lv[i] += D[k] * ( v[i + ngenes] - v[i] );
+    }
+}
+
+/** ImexSolve: solves (I - h L) x = r by the Thomas algorithm; cp and inv
+ *              hold the factorization made by ImexFactor(); x may be r    
+ */
+static void
+ImexSolve( const double *r, double *x, int n, int ngenes, const double *e, const double *cp, const double *inv ) {
+    int i;
+
+    for( i = 0; i < ngenes; i++ )
+        x[i] = r[i] * inv[i];
+    for( ; i < n; i++ )
+        x[i] = ( r[i] - e[i % ngenes] * x[i - ngenes] ) * inv[i];
+    for( i = n - ngenes - 1; i >= 0; i-- )
+        x[i] -= cp[i] * x[i + ngenes];
+}
+
+/** ImexFactor: factorizes I - h L for ImexSolve(); e gets the (constant) 
+ *               off-diagonal of each gene, cp the modified super-diagonal 
+ *               and inv the inverted pivots                               
+ */
+static void
+ImexFactor( double h, int n, int ngenes, const double *D, const double *lambda, double *e, double *cp, double *inv ) {
+    int i, k;
+    double b;
+
+    for( k = 0; k < ngenes; k++ )
+        e[k] = -h * D[k];
+    for( i = 0; i < n; i++ ) {
+        k = i % ngenes;
+        b = 1. + h * lambda[k];
+        if( i >= ngenes )
+            b += h * D[k];
+        if( i + ngenes < n )
+            b += h * D[k];
+        if( i >= ngenes )
+            b -= e[k] * cp[i - ngenes];
+        inv[i] = 1. / b;
+        cp[i] = e[k] * inv[i];
+    }
+}
+
+/** Imex: propagates vin (of size n) from tin to tout by the second order 
+ *         IMEX Runge-Kutta method ARS(2,2,2) (Ascher, Ruuth & Spiteri     
+ *         1997, Appl Numer Math 25, 151-67) with fixed stepsize; diffu-   
+ *         sion and decay are implicit (L-stable), so the stepsize is only 
+ *         limited by the regulation; the result is returned by vout       
+ */
+void
+Imex( double *vin, double *vout, double tin, double tout, double stephint, double accuracy, int n, FILE * slog, SolverInput * si, Input * inp ) {
+    int i;                      /* local loop counter */
+
+    const double gamma = 1. - 1. / sqrt( 2. );  /* ARS(2,2,2) coefficients */
+    const double delta = 1. - 1. / ( 2. * gamma );
+
+    int ngenes = inp->zyg.defs.ngenes;
+    double *D;                  /* diffusion coefficients of this interval */
+    double *e, *cp, *inv;       /* factorization of I - gamma h L */
+    double *buf;                /* one block for all arrays below */
+    double *y;                  /* v at current time */
+    double *y2;                 /* second stage */
+    double *f;                  /* derivative */
+    double *n1, *n2;            /* explicit parts N of the stages */
+    double *ly2;                /* L times the second stage */
+
+    double deltat;              /* tout - tin */
+    double t;                   /* current time */
+    double m;                   /* used to calculate number of steps */
+    double stepsize;            /* real stepsize */
+    int step;                   /* loop counter for steps */
+    int nsteps;                 /* number of steps we have to take */
+
+    /* the do-nothing case; too small steps dealt with under usual */
+
+    if( tin == tout )
+        return;
+
+    buf = ( double * ) malloc( ( 2 * ngenes + 8 * n ) * sizeof( double ) );
+    if( !buf )
+        error( "Imex: could not allocate memory" );
+    D = buf;
+    e = D + ngenes;
+    cp = e + ngenes;
+    inv = cp + n;
+    y2 = inv + n;
+    f = y2 + n;
+    n1 = f + n;
+    n2 = n1 + n;
+    ly2 = n2 + n;
+    y = ly2 + n;
+
+    deltat = tout - tin;        /* how far do we have to propagate? */
+    m = floor( deltat / stephint + 0.5 );       /* see comment on stephint above */
+    if( m < 1. )
+        m = 1.;                 /* we'll have to do at least one step */
+
+    stepsize = deltat / m;      /* real stepsize calculated here */
+    nsteps = ( int ) m;         /* int number of steps */
+    t = tin;                    /* set current time */
+
+    if( t == t + stepsize )
+        error( "Imex: stephint of %g too small!", stephint );
+
+    /* D only changes between cleavage cycles, i.e. not within [tin, tout] */
+    GetD( tin, inp->lparm.d, D, &( inp->zyg ) );
+    ImexFactor( gamma * stepsize, n, ngenes, D, inp->lparm.lambda, e, cp, inv );
+
+    for( i = 0; i < n; i++ )
+        y[i] = vin[i];
+
+    for( step = 0; step < nsteps; step++ ) {
+
+        /* first stage is explicit: N1 = f(y) - L y */
+        p_deriv( y, t, f, n, si, inp );
+        ImexLinear( y, n1, n, ngenes, D, inp->lparm.lambda );
+        for( i = 0; i < n; i++ )
+            n1[i] = f[i] - n1[i];
+
+        /* second stage: (I - gamma h L) Y2 = y + gamma h N1 */
+        for( i = 0; i < n; i++ )
+            y2[i] = y[i] + gamma * stepsize * n1[i];
+        ImexSolve( y2, y2, n, ngenes, e, cp, inv );
+
+        p_deriv( y2, t + gamma * stepsize, f, n, si, inp );
+        ImexLinear( y2, ly2, n, ngenes, D, inp->lparm.lambda );
+        for( i = 0; i < n; i++ )
+            n2[i] = f[i] - ly2[i];
+
+        /* last stage is the new y (stiffly accurate):                       *
+         * (I - gamma h L) y' = y + h (delta N1 + (1-delta) N2 + (1-gamma) L Y2) */
+        for( i = 0; i < n; i++ )
+            y[i] += stepsize * ( delta * n1[i] + ( 1. - delta ) * n2[i] + ( 1. - gamma ) * ly2[i] );
+        ImexSolve( y, y, n, ngenes, e, cp, inv );
+
+        t += stepsize;
+    }
+
+    for( i = 0; i < n; i++ )
+        vout[i] = y[i];
+    free( buf );
+
+    solver_stats.steps += nsteps;
+    if( debug )
+        WriteSolvLog( "Imex", tin, tout, stepsize, nsteps, 2 * nsteps, slog );
+}
+
 /** Rkck: propagates vin (of size n) from tin to tout by the Runge-Kutta 
  *         Cash-Karp method, which is an adaptive-stepsize Rk method; it   
  *         uses a fifth-order Rk formula with an embedded forth-oder for-  
@@ -925,18 +1129,23 @@ Rkck( double *vin, double *vout, double tin, double tout, double stephint, doubl
             if( verror_max <= 1.0 )
                 break;
 
+            solver_stats.rejected++;
             hnext = SAFETY * h * pow( verror_max, -0.25 );
             /* decrease stepsize by no more than a factor of 10; check for underflows */
             h = ( hnext > 0.1 * h ) ? hnext : 0.1 * h;
             //printf("h=%lg\n", h);
-            if( h < DBL_EPSILON )
-                error( "Rkck: stepsize underflow" );
+            if( h < DBL_EPSILON ) {
+                if( !AbortRun(  ) )
+                    error( "Rkck: stepsize underflow" );
+                break;
+            }
         }
         /* advance the current time by last stepsize */
 
         t += h;
+        solver_stats.steps++;
 
-        if( t >= tout )
+        if( t >= tout || OverBudget(  ) )
             break;              /* that was the last iteration */
 
         /* increase stepsize according to error (5th order) for next iteration */
@@ -974,6 +1183,257 @@ Rkck( double *vin, double *vout, double tin, double tout, double stephint, doubl
     //exit(1);
 }
 
+/*** SINGLE PRECISION SOLVERS **********************************************
+ *                                                                         *
+ *   Rk4Single and RkckSingle are float versions of Rk4 and Rkck for       *
+ *   screening runs (see ScreenScore() in score.c): they have the usual    *
+ *   solver interface, but keep the state and derivatives as floats and    *
+ *   call DvdtOrigSingle directly; only time is kept in double. They are   *
+ *   good enough to rank parameter sets, not to score them exactly.        *
+ *                                                                         *
+ ***************************************************************************/
+
+/* float state cannot resolve relative errors much below this */
+#define SINGLE_MIN_ACCURACY 1e-5
+
+/** Rk4Single: propagates vin (of size n) from tin to tout by the Fourth- 
+ *              Order Runge-Kutta method in single precision; the result is
+ *              returned by vout                                           
+ */
+void
+Rk4Single( double *vin, double *vout, double tin, double tout, double stephint, double accuracy, int n, FILE * slog, SolverInput * si, Input * inp ) {
+    int i, step, nsteps;
+    float *v, *vtemp, *deriv1, *deriv2, *deriv3, *deriv4;
+    float h, hh, h6;
+    double deltat, m, stepsize, t;
+
+    if( tin == tout )
+        return;
+
+    v = ( float * ) malloc( 6 * n * sizeof( float ) );
+    if( !v )
+        error( "Rk4Single: could not allocate memory" );
+    vtemp = v + n;
+    deriv1 = vtemp + n;
+    deriv2 = deriv1 + n;
+    deriv3 = deriv2 + n;
+    deriv4 = deriv3 + n;
+
+    deltat = tout - tin;
+    m = floor( deltat / stephint + 0.5 );
+    if( m < 1. )
+        m = 1.;
+    stepsize = deltat / m;
+    nsteps = ( int ) m;
+    t = tin;
+
+    if( t == t + stepsize )
+        error( "Rk4Single: stephint of %g too small!", stephint );
+
+    h = ( float ) stepsize;
+    hh = 0.5f * h;
+    h6 = h / 6.f;
+
+    for( i = 0; i < n; i++ )
+        v[i] = ( float ) vin[i];
+
+    for( step = 0; step < nsteps; step++ ) {
+        DvdtOrigSingle( v, t, deriv1, n, si, inp );
+        for( i = 0; i < n; i++ )
+            vtemp[i] = v[i] + hh * deriv1[i];
+        DvdtOrigSingle( vtemp, t + 0.5 * stepsize, deriv2, n, si, inp );
+        for( i = 0; i < n; i++ )
+            vtemp[i] = v[i] + hh * deriv2[i];
+        DvdtOrigSingle( vtemp, t + 0.5 * stepsize, deriv3, n, si, inp );
+        for( i = 0; i < n; i++ )
+            vtemp[i] = v[i] + h * deriv3[i];
+        DvdtOrigSingle( vtemp, t + stepsize, deriv4, n, si, inp );
+
+        for( i = 0; i < n; i++ )
+            v[i] += h6 * ( deriv1[i] + 2.f * deriv2[i] + 2.f * deriv3[i] + deriv4[i] );
+
+        t = tin + ( step + 1 ) * stepsize;
+    }
+
+    for( i = 0; i < n; i++ )
+        vout[i] = v[i];
+    free( v );
+
+    solver_stats.steps += nsteps;
+    if( debug )
+        WriteSolvLog( "Rk4Single", tin, tout, stepsize, nsteps, 4 * nsteps, slog );
+}
+
+/** RkckSingle: propagates vin (of size n) from tin to tout by the Runge- 
+ *               Kutta Cash-Karp method in single precision; accuracies    
+ *               below SINGLE_MIN_ACCURACY are raised to it; the result is 
+ *               returned by vout                                          
+ */
+void
+RkckSingle( double *vin, double *vout, double tin, double tout, double stephint, double accuracy, int n, FILE * slog, SolverInput * si, Input * inp ) {
+
+    int i;
+    float *vnow, *vnext, *vswap, *vtemp, *buf;
+    float *deriv1, *deriv2, *deriv3, *deriv4, *deriv5, *deriv6;
+    float hf, err;
+    double verror_max;
+    double t = tin;
+    double h = stephint;
+    double hnext;
+    const double SAFETY = 0.9;
+
+    /* Cash-Karp parameters, see Rkck() */
+    const float b21 = 0.2f, b31 = 3.f / 40.f, b32 = 9.f / 40.f, b41 = 0.3f, b42 = -0.9f, b43 = 1.2f,
+        b51 = -11.f / 54.f, b52 = 2.5f, b53 = -70.f / 27.f, b54 = 35.f / 27.f,
+        b61 = 1631.f / 55296.f, b62 = 175.f / 512.f, b63 = 575.f / 13824.f, b64 = 44275.f / 110592.f, b65 = 253.f / 4096.f;
+    const float c1 = 37.f / 378.f, c3 = 250.f / 621.f, c4 = 125.f / 594.f, c6 = 512.f / 1771.f;
+    const float dc1 = c1 - 2825.f / 27648.f, dc3 = c3 - 18575.f / 48384.f, dc4 = c4 - 13525.f / 55296.f,
+        dc5 = -277.f / 14336.f, dc6 = c6 - 0.25f;
+
+    if( tin == tout )
+        return;
+
+    if( accuracy < SINGLE_MIN_ACCURACY )
+        accuracy = SINGLE_MIN_ACCURACY;
+
+    buf = ( float * ) malloc( 9 * n * sizeof( float ) );
+    if( !buf )
+        error( "RkckSingle: could not allocate memory" );
+    vnow = buf;
+    vnext = vnow + n;
+    vtemp = vnext + n;
+    deriv1 = vtemp + n;
+    deriv2 = deriv1 + n;
+    deriv3 = deriv2 + n;
+    deriv4 = deriv3 + n;
+    deriv5 = deriv4 + n;
+    deriv6 = deriv5 + n;
+
+    for( i = 0; i < n; i++ )
+        vnow[i] = ( float ) vin[i];
+
+    if( tin + h >= tout )
+        h = tout - tin;
+    while( t < tout ) {
+
+        /* one step; repeat it with a smaller h until the error is small enough */
+        while( 1 ) {
+            hf = ( float ) h;
+            DvdtOrigSingle( vnow, t, deriv1, n, si, inp );
+            for( i = 0; i < n; i++ )
+                vtemp[i] = vnow[i] + hf * ( b21 * deriv1[i] );
+            DvdtOrigSingle( vtemp, t + 0.2 * h, deriv2, n, si, inp );
+            for( i = 0; i < n; i++ )
+                vtemp[i] = vnow[i] + hf * ( b31 * deriv1[i] + b32 * deriv2[i] );
+            DvdtOrigSingle( vtemp, t + 0.3 * h, deriv3, n, si, inp );
+            for( i = 0; i < n; i++ )
+                vtemp[i] = vnow[i] + hf * ( b41 * deriv1[i] + b42 * deriv2[i] + b43 * deriv3[i] );
+            DvdtOrigSingle( vtemp, t + 0.6 * h, deriv4, n, si, inp );
+            for( i = 0; i < n; i++ )
+                vtemp[i] = vnow[i] + hf * ( b51 * deriv1[i] + b52 * deriv2[i] + b53 * deriv3[i] + b54 * deriv4[i] );
+            DvdtOrigSingle( vtemp, t + h, deriv5, n, si, inp );
+            for( i = 0; i < n; i++ )
+                vtemp[i] = vnow[i] + hf * ( b61 * deriv1[i] + b62 * deriv2[i] + b63 * deriv3[i] + b64 * deriv4[i] + b65 * deriv5[i] );
+            DvdtOrigSingle( vtemp, t + 0.875 * h, deriv6, n, si, inp );
+
+            verror_max = 0.;
+            for( i = 0; i < n; i++ ) {
+                vnext[i] = vnow[i] + hf * ( c1 * deriv1[i] + c3 * deriv3[i] + c4 * deriv4[i] + c6 * deriv6[i] );
+                err = hf * ( dc1 * deriv1[i] + dc3 * deriv3[i] + dc4 * deriv4[i] + dc5 * deriv5[i] + dc6 * deriv6[i] );
+                if( vnext[i] != 0.f )
+                    err = fabsf( err / vnext[i] );
+                else
+                    err = err / FLT_EPSILON;
+                if( err > verror_max )
+                    verror_max = err;
+            }
+            verror_max /= accuracy;
+
+            if( verror_max <= 1.0 )
+                break;
+
+            solver_stats.rejected++;
+            hnext = SAFETY * h * pow( verror_max, -0.25 );
+            h = ( hnext > 0.1 * h ) ? hnext : 0.1 * h;
+            if( h < DBL_EPSILON ) {
+                if( !AbortRun(  ) )
+                    error( "RkckSingle: stepsize underflow" );
+                break;
+            }
+        }
+
+        t += h;
+        solver_stats.steps++;
+
+        vswap = vnow;
+        vnow = vnext;
+        vnext = vswap;
+
+        if( t >= tout || OverBudget(  ) )
+            break;
+
+        h = h * pow( verror_max, -0.20 );
+        if( t + h >= tout )
+            h = tout - t;
+    }
+
+    for( i = 0; i < n; i++ )
+        vout[i] = vnow[i];
+    free( buf );
+}
+
+/** SinglePrecisionSolver: returns the single precision version of solver
+ *                          's', or NULL if there is none for it or for   
+ *                          the derivative function in p_deriv            
+ */
+SolverFunc
+SinglePrecisionSolver( SolverFunc s ) {
+
+    if( p_deriv != DvdtOrig )
+        return NULL;
+    if( s == Rk4 )
+        return Rk4Single;
+    if( s == Rkck )
+        return RkckSingle;
+    return NULL;
+}
+
+/** LockstepSolver: returns 1 if solver 's' can run several parameter sets
+ *                   in lockstep (see BlastodermBatch() in integrate.c);   
+ *                   these are the fixed stepsize solvers, which take the  
+ *                   same steps whatever the parameters, and only with     
+ *                   DvdtOrig, which has a batched version                 
+ */
+int
+LockstepSolver( SolverFunc s ) {
+
+    if( p_deriv != DvdtOrig )
+        return 0;
+    return ( s == Euler || s == Meuler || s == Heun || s == Rk2 || s == Rk4 );
+}
+
+/* the solvers by their -s names; r and m are the old names of r4 and mi */
+static const struct {
+    const char *name;
+    SolverFunc solver;
+} solver_names[] = {
+    {"a", Adams}, {"bd", BaDe}, {"bs", BuSt}, {"dp", Dopri5}, {"e", Euler}, {"h", Heun},
+    {"im", Imex}, {"mi", Milne}, {"m", Milne}, {"me", Meuler}, {"r4", Rk4}, {"r", Rk4},
+    {"r2", Rk2}, {"rck", Rkck}, {"rf", Rkf}, {"sd", SoDe}, {"kr", Krylov},
+    {NULL, NULL}
+};
+
+/** SolverByName: returns the solver called 'name' (see SOLVER_NAMES) */
+SolverFunc
+SolverByName( const char *name ) {
+    int i;
+
+    for( i = 0; name && solver_names[i].name; i++ )
+        if( !strcmp( name, solver_names[i].name ) )
+            return solver_names[i].solver;
+    return NULL;
+}
+
 /** Rkf: propagates vin (of size n) from tin to tout by the Runge-Kutta 
  *        Fehlberg method, which is a the original adaptive-stepsize Rk    
  *        method (Cash-Karp is an improved version of this); it uses a     
@@ -1138,21 +1598,26 @@ Rkf( double *vin, double *vout, double tin, double tout, double stephint, double
             if( verror_max <= 1.0 )
                 break;
 
+            solver_stats.rejected++;
             hnext = SAFETY * h * pow( verror_max, -0.25 );
 
             /* decrease stepsize by no more than a factor of 10; check for underflows */
 
             h = ( hnext > 0.1 * h ) ? hnext : 0.1 * h;
-            if( h < DBL_EPSILON )
-                error( "Rkf: stepsize underflow" );
+            if( h < DBL_EPSILON ) {
+                if( !AbortRun(  ) )
+                    error( "Rkf: stepsize underflow" );
+                break;
+            }
 
         }
 
         /* advance the current time by last stepsize */
 
         t += h;
+        solver_stats.steps++;
 
-        if( t >= tout )
+        if( t >= tout || OverBudget(  ) )
             break;              /* that was the last iteration */
 
         /* increase stepsize according to error for next iteration */
@@ -1191,6 +1656,257 @@ Rkf( double *vin, double *vout, double tin, double tout, double stephint, double
 
 }
 
+/*** DORMAND-PRINCE SOLVER *************************************************
+ *                                                                         *
+ *   Dopri5 keeps its last accepted step between calls: if a call starts   *
+ *   where the previous one ended (same tin, same v's), it goes on from    *
+ *   the end of that step instead of from tin. Steps are not cut at tout   *
+ *   but may go on up to si->tstop, the next time at which Blastoderm()    *
+ *   changes the equations or the state (division, mitosis, bias); v at    *
+ *   tout is then read from the dense output of the step across it.        *
+ *                                                                         *
+ ***************************************************************************/
+
+static struct {
+    int size;                   /* size of the arrays below */
+    int valid;                  /* 1: the last step can be gone on from */
+    int n;                      /* size of the last step */
+    int genindex;               /* genotype of the last step */
+    double tstop;               /* si->tstop of the last call */
+    double tout;                /* tout of the last call ... */
+    double *vout;               /* ... and its vout */
+    double t0, t1;              /* last step went from t0 to t1 ... */
+    double *y1;                 /* ... ended in y1 ... */
+    double *f1;                 /* ... with derivatives f1 (first same as last) */
+    double *rcont;              /* dense output coefficients of that step */
+    double h;                   /* stepsize of next step */
+    double errold;              /* error of the last step, for the PI control */
+} dopri = { 0, 0, 0, -1, 0., 0., NULL, 0., 0., NULL, NULL, NULL, 0., 0. };
+
+/** Dopri5: propagates vin (of size n) from tin to tout by the Dormand- 
+ *           Prince 5(4) method (Hairer, Norsett & Wanner 1993, Solving    
+ *           Ordinary Differential Equations I, p. 178), an adaptive Rk    
+ *           method with a fifth-order formula, an embedded fourth-order   
+ *           one for the error and a fourth-order interpolant (dense out-  
+ *           put); the last stage of a step is the first of the next, so   
+ *           an accepted step takes 6 derivatives; the stepsize is con-    
+ *           trolled by a PI controller; the result is returned by vout    
+ */
+void
+Dopri5( double *vin, double *vout, double tin, double tout, double stephint, double accuracy, int n, FILE * slog, SolverInput * si, Input * inp ) {
+
+    static const double
+        c2 = 1.0 / 5.0, c3 = 3.0 / 10.0, c4 = 4.0 / 5.0, c5 = 8.0 / 9.0,
+        a21 = 1.0 / 5.0,
+        a31 = 3.0 / 40.0, a32 = 9.0 / 40.0,
+        a41 = 44.0 / 45.0, a42 = -56.0 / 15.0, a43 = 32.0 / 9.0,
+        a51 = 19372.0 / 6561.0, a52 = -25360.0 / 2187.0, a53 = 64448.0 / 6561.0, a54 = -212.0 / 729.0,
+        a61 = 9017.0 / 3168.0, a62 = -355.0 / 33.0, a63 = 46732.0 / 5247.0, a64 = 49.0 / 176.0, a65 = -5103.0 / 18656.0,
+        a71 = 35.0 / 384.0, a73 = 500.0 / 1113.0, a74 = 125.0 / 192.0, a75 = -2187.0 / 6784.0, a76 = 11.0 / 84.0,
+        e1 = 71.0 / 57600.0, e3 = -71.0 / 16695.0, e4 = 71.0 / 1920.0, e5 = -17253.0 / 339200.0, e6 = 22.0 / 525.0, e7 = -1.0 / 40.0,
+        d1 = -12715105075.0 / 11282082432.0, d3 = 87487479700.0 / 32700410799.0, d4 = -10690763975.0 / 1880347072.0,
+        d5 = 701980252875.0 / 199316789632.0, d6 = -1453857185.0 / 822651844.0, d7 = 69997945.0 / 29380423.0;
+
+    const double SAFETY = 0.9;  /* safety margin for new stepsizes */
+    const double BETA = 0.04;   /* PI control: weight of the previous error */
+    const double EXPO = 0.2 - 0.75 * BETA;      /* ... and of the current one */
+    const double FACMIN = 0.1;  /* stepsize changes at most by these factors */
+    const double FACMAX = 5.0;
+
+    int i;
+    int last;                   /* this step ends at tlimit */
+    int rejected = 0;           /* the previous attempt was rejected */
+
+    double *buf;                /* one block for all arrays below */
+    double *k2, *k3, *k4, *k5, *k6, *k7;        /* intermediate derivatives */
+    double *ytemp, *ynew;
+    double *y, *f;              /* v and its derivatives at t */
+
+    double t;                   /* the current time */
+    double tlimit;              /* steps must not go beyond this */
+    double h, err, fac, theta, theta1, ydiff, bspl;
+
+    /* the do-nothing case; too small steps dealt with under usual */
+
+    if( tin == tout )
+        return;
+
+    if( n > dopri.size ) {
+        free( dopri.vout );
+        dopri.vout = ( double * ) malloc( 9 * n * sizeof( double ) );
+        if( !dopri.vout )
+            error( "Dopri5: could not allocate memory" );
+        dopri.y1 = dopri.vout + n;
+        dopri.f1 = dopri.y1 + n;
+        dopri.rcont = dopri.f1 + n;
+        dopri.size = n;
+        dopri.valid = 0;        /* nothing to go on from */
+    }
+
+    buf = ( double * ) malloc( 8 * n * sizeof( double ) );
+    if( !buf )
+        error( "Dopri5: could not allocate memory" );
+    k2 = buf;
+    k3 = k2 + n;
+    k4 = k3 + n;
+    k5 = k4 + n;
+    k6 = k5 + n;
+    k7 = k6 + n;
+    ytemp = k7 + n;
+    ynew = ytemp + n;
+    y = dopri.y1;
+    f = dopri.f1;
+
+    tlimit = ( si->tstop > tout ) ? si->tstop : tout;
+
+    /* go on from the last step if we are asked for the next stretch of the    *
+     * same trajectory, otherwise start afresh at tin                          */
+
+    if( dopri.valid && dopri.n == n && tin == dopri.tout && si->tstop == dopri.tstop && si->genindex == dopri.genindex
+        && !memcmp( vin, dopri.vout, n * sizeof( double ) ) ) {
+        t = dopri.t1;
+        h = dopri.h;
+    } else {
+        memcpy( y, vin, n * sizeof( double ) );
+        t = tin;
+        p_deriv( y, t, f, n, si, inp );
+        h = stephint;
+        dopri.t0 = dopri.t1 = tin;
+        dopri.errold = 1e-4;
+    }
+    dopri.valid = 0;            /* in case a derivative function bails out */
+
+    while( t < tout ) {
+
+        last = ( t + h >= tlimit );
+        if( last )
+            h = tlimit - t;
+
+        /* do the Runge-Kutta thing here: calculate intermediate derivatives */
+
+        for( i = 0; i < n; i++ )
+            ytemp[i] = y[i] + h * a21 * f[i];
+        p_deriv( ytemp, t + c2 * h, k2, n, si, inp );
+        for( i = 0; i < n; i++ )
+            ytemp[i] = y[i] + h * ( a31 * f[i] + a32 * k2[i] );
+        p_deriv( ytemp, t + c3 * h, k3, n, si, inp );
+        for( i = 0; i < n; i++ )
+            ytemp[i] = y[i] + h * ( a41 * f[i] + a42 * k2[i] + a43 * k3[i] );
+        p_deriv( ytemp, t + c4 * h, k4, n, si, inp );
+        for( i = 0; i < n; i++ )
+            ytemp[i] = y[i] + h * ( a51 * f[i] + a52 * k2[i] + a53 * k3[i] + a54 * k4[i] );
+        p_deriv( ytemp, t + c5 * h, k5, n, si, inp );
+        for( i = 0; i < n; i++ )
+            ytemp[i] = y[i] + h * ( a61 * f[i] + a62 * k2[i] + a63 * k3[i] + a64 * k4[i] + a65 * k5[i] );
+        p_deriv( ytemp, t + h, k6, n, si, inp );
+        for( i = 0; i < n; i++ )
+            ynew[i] = y[i] + h * ( a71 * f[i] + a73 * k3[i] + a74 * k4[i] + a75 * k5[i] + a76 * k6[i] );
+        p_deriv( ynew, t + h, k7, n, si, inp );
+
+        /* maximum relative error of the embedded formula, as in Rkck() */
+
+        err = 0.;
+        for( i = 0; i < n; i++ ) {
+            ytemp[i] = h * ( e1 * f[i] + e3 * k3[i] + e4 * k4[i] + e5 * k5[i] + e6 * k6[i] + e7 * k7[i] );
+            if( ynew[i] != 0. )
+                err = DMAX( fabs( ytemp[i] / ynew[i] ), err );
+            else
+                err = DMAX( fabs( ytemp[i] ) / DBL_EPSILON, err );
+        }
+        err /= accuracy;
+
+        fac = pow( err, EXPO );
+
+        if( err > 1.0 ) {       /* reject the step and try again */
+            solver_stats.rejected++;
+            h /= DMIN( 1. / FACMIN, fac / SAFETY );
+            rejected = 1;
+            if( h < DBL_EPSILON ) {
+                if( !AbortRun(  ) )
+                    error( "Dopri5: stepsize underflow" );
+                break;
+            }
+            continue;
+        }
+
+        /* accepted: keep the dense output coefficients, then move on */
+
+        for( i = 0; i < n; i++ ) {
+            ydiff = ynew[i] - y[i];
+            bspl = h * f[i] - ydiff;
+            dopri.rcont[i] = y[i];
+            dopri.rcont[n + i] = ydiff;
+            dopri.rcont[2 * n + i] = bspl;
+            dopri.rcont[3 * n + i] = ydiff - h * k7[i] - bspl;
+            dopri.rcont[4 * n + i] = h * ( d1 * f[i] + d3 * k3[i] + d4 * k4[i] + d5 * k5[i] + d6 * k6[i] + d7 * k7[i] );
+        }
+        memcpy( y, ynew, n * sizeof( double ) );
+        memcpy( f, k7, n * sizeof( double ) );
+        dopri.t0 = t;
+        t = last ? tlimit : t + h;
+        dopri.t1 = t;
+        solver_stats.steps++;
+
+        /* PI stepsize control; no increase right after a rejection */
+
+        fac /= pow( dopri.errold, BETA );
+        fac = DMAX( 1. / FACMAX, DMIN( 1. / FACMIN, fac / SAFETY ) );
+        dopri.errold = DMAX( err, 1e-4 );
+        if( rejected && fac < 1. )
+            fac = 1.;
+        rejected = 0;
+        h /= fac;
+
+        if( last || OverBudget(  ) )
+            break;
+    }
+
+    /* a run stopped by its budget leaves no trajectory to go on from (valid *
+     * is still 0 from above)                                                 */
+
+    if( OverBudget(  ) ) {
+        free( buf );
+        return;
+    }
+
+    /* v at tout: end of the last step or its dense output */
+
+    if( tout == t )
+        memcpy( vout, y, n * sizeof( double ) );
+    else {
+        theta = ( tout - dopri.t0 ) / ( dopri.t1 - dopri.t0 );
+        theta1 = 1. - theta;
+        for( i = 0; i < n; i++ )
+            vout[i] = dopri.rcont[i] + theta * ( dopri.rcont[n + i] + theta1 * ( dopri.rcont[2 * n + i]
+                                                                                  + theta * ( dopri.rcont[3 * n + i] + theta1 * dopri.rcont[4 * n + i] ) ) );
+    }
+
+    dopri.valid = 1;
+    dopri.n = n;
+    dopri.genindex = si->genindex;
+    dopri.tstop = si->tstop;
+    dopri.tout = tout;
+    dopri.h = h;
+    memcpy( dopri.vout, vout, n * sizeof( double ) );
+
+    free( buf );
+}
+
+/** NewSolverRun: forgets the last step of Dopri5 */
+void
+NewSolverRun( void ) {
+    dopri.valid = 0;
+}
+
+/** FreeSolvers: frees the step kept by Dopri5 */
+void
+FreeSolvers( void ) {
+    free( dopri.vout );
+    dopri.vout = dopri.y1 = dopri.f1 = dopri.rcont = NULL;
+    dopri.size = 0;
+    dopri.valid = 0;
+}
+
 /**    Milne: propagates vin (of size n) from tin to tout by Milne-Simpson 
  *            which is a predictor-corrector method; the result is retur-  
  *            ned by vout                                                  
@@ -1541,6 +2257,7 @@ Milne( double *vin, double *vout, double tin, double tout, double stephint, doub
 
     }
 
+    solver_stats.steps += nsteps;
     if( debug )
         WriteSolvLog( "Milne", tin, tout, stepsize, nsteps, nd, slog );
 
@@ -1858,6 +2575,7 @@ Adams( double *vin, double *vout, double tin, double tout, double stephint, doub
         }
     }
 
+    solver_stats.steps += nsteps;
     if( debug )
         WriteSolvLog( "Adams", tin, tout, stepsize, nsteps, nd, slog );
 
@@ -1921,7 +2639,7 @@ BuSt( double *vin, double *vout, double tin, double tout, double stephint, doubl
         if( t + ht > tout )
             ht = tout - t;
 
-    } while( t < tout );
+    } while( t < tout && !OverBudget(  ) );
 
     /* clean up and go home */
 
@@ -2101,8 +2819,11 @@ bsstep( double *v, double *deriv, int n, double *t, double htry, double accuracy
         for( k = 1; k <= kmax; k++ ) {
 
             tnew = ( *t ) + h;
-            if( tnew == ( *t ) )
-                error( "BuSt: stepsize underflow in bsstep\n" );
+            if( tnew == ( *t ) ) {
+                if( !AbortRun(  ) )
+                    error( "BuSt: stepsize underflow in bsstep\n" );
+                goto cleanup;   /* the run stops, t stays where it was */
+            }
 
             /* propagate the equations from t to t+h with nseq[k] steps using vsav and *
              * deriv as input; mmid returns vseq                                       */
@@ -2173,9 +2894,13 @@ bsstep( double *v, double *deriv, int n, double *t, double htry, double accuracy
 
         h *= red;
         reduct = 1;
+        solver_stats.rejected++;
+        if( OverBudget(  ) )
+            goto cleanup;
     }
 
     /* we've taken a successful step */
+    solver_stats.steps++;
 
     *t = tnew;
     *hdid = h;
@@ -2212,6 +2937,7 @@ bsstep( double *v, double *deriv, int n, double *t, double htry, double accuracy
         }
     }
 
+  cleanup:
     /* clean up */
 
     free( d );
@@ -2427,7 +3153,7 @@ BaDe( double *vin, double *vout, double tin, double tout, double stephint, doubl
         if( t + ht > tout )
             ht = tout - t;
 
-    } while( t < tout );
+    } while( t < tout && !OverBudget(  ) );
 
     /* clean up and go home */
 
@@ -2487,7 +3213,9 @@ stifbs( double *v, double *deriv, int n, double *t, double htry, double accuracy
     double *err;                /* normalized error estimates */
 
     double *dfdt;
-    double **jac;               /* the Jacobian matrix */
+    double **jac;               /* the Jacobian (block diagonals, rows of ngenes) */
+    double *jacbuf;             /* storage of the Jacobian */
+    int ng = inp->zyg.defs.ngenes;      /* block size */
 
     double h;                   /* stepsize for solver method used below */
     double hest;                /* square of h passed to extrapolation function */
@@ -2537,12 +3265,20 @@ stifbs( double *v, double *deriv, int n, double *t, double htry, double accuracy
     if( !( dfdt = ( double * ) calloc( n, sizeof( double ) ) ) )
         error( "BaDe: error allocating dfdt.\n" );
 
-    if( !( jac = ( double ** ) calloc( n, sizeof( double * ) ) ) )
+    /* the Jacobian is block tridiagonal (see JacobnOrig() in zygotic.c), we   *
+     * only store the three block diagonals: 3 * ngenes rows per nucleus       */
+
+    if( n % ng )
+        error( "BaDe: %d equations are not a multiple of %d genes.\n", n, ng );
+
+    if( !( jac = ( double ** ) calloc( 3 * n, sizeof( double * ) ) ) )
         error( "BaDe: error allocating jac.\n" );
 
-    for( i = 0; i < n; i++ )
-        if( !( jac[i] = ( double * ) calloc( n, sizeof( double ) ) ) )
-            error( "BaDe: error allocating jac's second dimension.\n" );
+    if( !( jacbuf = ( double * ) calloc( 3 * n * ng, sizeof( double ) ) ) )
+        error( "BaDe: error allocating jac's second dimension.\n" );
+
+    for( i = 0; i < 3 * n; i++ )
+        jac[i] = jacbuf + i * ng;
 
     if( !( err = ( double * ) calloc( KMAXX, sizeof( double ) ) ) )
         error( "BaDe: error allocating err.\n" );
@@ -2616,6 +3352,7 @@ stifbs( double *v, double *deriv, int n, double *t, double htry, double accuracy
     /* evaluate jacobian */
 
     p_jacobn( *t, v, dfdt, jac, n, si, inp );
+    solver_stats.jacobians++;
 
     /* new integration or stepsize? -> re-establish the order window */
 
@@ -2633,8 +3370,11 @@ stifbs( double *v, double *deriv, int n, double *t, double htry, double accuracy
         for( k = 1; k <= kmax; k++ ) {
 
             tnew = ( *t ) + h;
-            if( tnew == ( *t ) )
-                error( "BaDe: stepsize underflow in stifbs.\n" );
+            if( tnew == ( *t ) ) {
+                if( !AbortRun(  ) )
+                    error( "BaDe: stepsize underflow in stifbs.\n" );
+                goto cleanup;   /* the run stops, t stays where it was */
+            }
 
             /* propagate the equations from t to t+h with nseq[k] steps using vsav and *
              * deriv as input; dfdt are the function derivs and jac is the Jacobian    *
@@ -2706,9 +3446,13 @@ stifbs( double *v, double *deriv, int n, double *t, double htry, double accuracy
 
         h *= red;
         reduct = 1;
+        solver_stats.rejected++;
+        if( OverBudget(  ) )
+            goto cleanup;
     }
 
     /* we've taken a successful step */
+    solver_stats.steps++;
 
     *t = tnew;
     *hdid = h;
@@ -2745,10 +3489,10 @@ stifbs( double *v, double *deriv, int n, double *t, double htry, double accuracy
         }
     }
 
+  cleanup:
     /* clean up */
 
-    for( i = 0; i < n; i++ )
-        free( jac[i] );
+    free( jacbuf );
     free( jac );
 
     free( d );
@@ -2772,11 +3516,11 @@ stifbs( double *v, double *deriv, int n, double *t, double htry, double accuracy
 void
 simpr( double *vin, double *vout, double *deriv, double *dfdt, double **jac, double tin, double htot, int nstep, int n, SolverInput * si, Input * inp ) {
     /* func prototypes: these funcs should not be visible outside solvers.c    *
-     *          lubcmp: does DU decomposition of a matrix                      *
-     *          lubksb: solves linear system a * b                             */
+     *         btrdcmp: does LU decomposition of a block tridiagonal matrix    *
+     *         btrbksb: solves linear system a * b with that decomposition     */
 
-    void ludcmp( double **a, int n, int *indx, double *d );
-    void lubksb( double **a, int n, int *indx, double *b );
+    void btrdcmp( double **a, int m, int ng, int *indx );
+    void btrbksb( double **a, int m, int ng, int *indx, double *b );
 
     /*** variables *************************************************************/
 
@@ -2784,14 +3528,17 @@ simpr( double *vin, double *vout, double *deriv, double *dfdt, double **jac, dou
 
     double t;                   /* current time */
     double h;                   /* small (h) stepsize (equals htot / nstep) */
-    double d;                   /* d indicates if eve/odd rows were switched in ludcmp */
+
+    int ng = inp->zyg.defs.ngenes;      /* block size */
+    int m = n / ng;             /* number of nuclei (blocks) */
 
     int *indx;                  /* array for permutated row indices of matrix a */
 
     double *del;                /* delta: difference in v between steps */
     double *vtemp;              /* array for temp derivs and v's */
 
-    double **a;                 /* matrix [1 - hf'] */
+    double **a;                 /* matrix [1 - hf'], block diagonals as in jac */
+    double *abuf;               /* storage of a */
 
     /* allocate arrays */
 
@@ -2800,29 +3547,31 @@ simpr( double *vin, double *vout, double *deriv, double *dfdt, double **jac, dou
     del = ( double * ) calloc( n, sizeof( double ) );
     vtemp = ( double * ) calloc( n, sizeof( double ) );
 
-    a = ( double ** ) calloc( n, sizeof( double * ) );
-    for( i = 0; i < n; i++ )
-        a[i] = ( double * ) calloc( n, sizeof( double ) );
+    a = ( double ** ) calloc( 3 * n, sizeof( double * ) );
+    abuf = ( double * ) calloc( 3 * n * ng, sizeof( double ) );
+    for( i = 0; i < 3 * n; i++ )
+        a[i] = abuf + i * ng;
 
     /* calculate h from H and n */
 
     h = htot / nstep;
 
-    /* set up the matrix [1 - hf'] */
+    /* set up the matrix [1 - hf']; the unit matrix only touches the diagonal  *
+     * blocks, i.e. rows ng...2ng-1 of each nucleus                            */
 
-    for( i = 0; i < n; i++ ) {
-        for( j = 0; j < n; j++ )
+    for( i = 0; i < 3 * n; i++ )
+        for( j = 0; j < ng; j++ )
             a[i][j] = -h * jac[i][j];
-        ++a[i][i];
-    }
+    for( i = 0; i < n; i++ )
+        ++a[3 * ( i - i % ng ) + ng + i % ng][i % ng];
 
     /* the following is slightly bizarre */
 
     /* do LU decomposition of matrix [1 - hf']; this is needed for all steps   *
      * below, which use linearization of the equations to get estimates of the *
-     * derivatives at the endpoint of a step (which is done in lubksb)         */
+     * derivatives at the endpoint of a step (which is done in btrbksb)        */
 
-    ludcmp( a, n, indx, &d );
+    btrdcmp( a, m, ng, indx );
 
     /* do the first step */
 
@@ -2834,7 +3583,7 @@ simpr( double *vin, double *vout, double *deriv, double *dfdt, double **jac, dou
 
     for( i = 0; i < n; i++ )
         vout[i] = h * ( deriv[i] + h * dfdt[i] );
-    lubksb( a, n, indx, vout );
+    btrbksb( a, m, ng, indx, vout );
 
     for( i = 0; i < n; i++ )
         vtemp[i] = vin[i] + ( del[i] = vout[i] );
@@ -2850,7 +3599,7 @@ simpr( double *vin, double *vout, double *deriv, double *dfdt, double **jac, dou
 
         for( j = 0; j < n; j++ )
             vout[j] = h * vout[j] - del[j];
-        lubksb( a, n, indx, vout );
+        btrbksb( a, m, ng, indx, vout );
 
         /* take the step */
 
@@ -2869,7 +3618,7 @@ simpr( double *vin, double *vout, double *deriv, double *dfdt, double **jac, dou
 
     for( i = 0; i < n; i++ )
         vout[i] = h * vout[i] - del[i];
-    lubksb( a, n, indx, vout );
+    btrbksb( a, m, ng, indx, vout );
 
     /* take the last step */
 
@@ -2878,8 +3627,7 @@ simpr( double *vin, double *vout, double *deriv, double *dfdt, double **jac, dou
 
     /* clean up */
 
-    for( i = 0; i < n; i++ )
-        free( a[i] );
+    free( abuf );
     free( a );
 
     free( vtemp );
@@ -3043,8 +3791,217 @@ lubksb( double **a, int n, int *indx, double *b ) {
     }
 }
 
+/**  btrdcmp: does an LU decomposition of the block tridiagonal matrix a 
+ *            (block Thomas algorithm); a holds 3 * ng rows of ng per block 
+ *            row, the left block (A), the diagonal block (B) and the right 
+ *            block (C) as the Jacobian of JacobnOrig(); m is the number of 
+ *            block rows. With B'(0) = B(0) and                            
+ *                                                                         
+ *                G(i)  = B'(i)^-1 C(i)                                    
+ *                B'(i) = B(i) - A(i) G(i-1)                               
+ *                                                                         
+ *            the diagonal blocks are replaced by the LU decompositions    
+ *            (ludcmp) of the B', the right blocks by the G; A is left as  
+ *            it is; indx returns the row permutations of the B'. This     
+ *            costs O(m * ng^3) instead of O((m * ng)^3) for ludcmp() of   
+ *            the full matrix.                                             
+ */
+void
+btrdcmp( double **a, int m, int ng, int *indx ) {
+    int i, j, k, l;             /* loop counters */
+    double d;                   /* row interchange parity, not used */
+    double *col;                /* a column of C(i) and G(i) */
+    double **A, **B, **C, **G;  /* blocks of the current block row */
+
+    col = ( double * ) calloc( ng, sizeof( double ) );
+
+    for( i = 0; i < m; i++ ) {
+        A = a + 3 * i * ng;
+        B = A + ng;
+        C = B + ng;
+
+        /* B'(i) = B(i) - A(i) G(i-1); G(i-1) is in the right block above */
+
+        if( i > 0 ) {
+            G = A - ng;
+            for( j = 0; j < ng; j++ )
+                for( l = 0; l < ng; l++ )
+                    if( A[j][l] != 0. )
+                        for( k = 0; k < ng; k++ )
+                            B[j][k] -= A[j][l] * G[l][k];
+        }
+
+        ludcmp( B, ng, indx + i * ng, &d );
+
+        /* G(i) = B'(i)^-1 C(i), column by column (not needed for last row) */
+
+        if( i < m - 1 ) {
+            for( k = 0; k < ng; k++ ) {
+                for( j = 0; j < ng; j++ )
+                    col[j] = C[j][k];
+                lubksb( B, ng, indx + i * ng, col );
+                for( j = 0; j < ng; j++ )
+                    C[j][k] = col[j];
+            }
+        }
+    }
+
+    free( col );
+}
+
+/**  btrbksb: solves a * x = b for the block tridiagonal matrix a, which 
+ *            is passed as the decomposition returned by btrdcmp(); the    
+ *            right hand side b also returns the solution x; m and ng are  
+ *            the number and the size of the blocks                        
+ */
+void
+btrbksb( double **a, int m, int ng, int *indx, double *b ) {
+    int i, j, k;                /* loop counters */
+    double **A, **G;            /* left block and G of the current block row */
+    double *bi;                 /* right hand side of the current block row */
+
+    /* forward: y(i) = B'(i)^-1 (b(i) - A(i) y(i-1)) */
+
+    for( i = 0; i < m; i++ ) {
+        A = a + 3 * i * ng;
+        bi = b + i * ng;
+        if( i > 0 )
+            for( j = 0; j < ng; j++ )
+                for( k = 0; k < ng; k++ )
+                    bi[j] -= A[j][k] * bi[k - ng];
+        lubksb( A + ng, ng, indx + i * ng, bi );
+    }
+
+    /* backward: x(i) = y(i) - G(i) x(i+1) */
+
+    for( i = m - 2; i >= 0; i-- ) {
+        G = a + ( 3 * i + 2 ) * ng;
+        bi = b + i * ng;
+        for( j = 0; j < ng; j++ )
+            for( k = 0; k < ng; k++ )
+                bi[j] -= G[j][k] * bi[ng + k];
+    }
+}
+
+/*** WORK BUDGET OF A MODEL RUN *******************************************/
+
+/* the run on a budget: where the counters and the clock started, and  *
+ * whether it has been stopped                                         */
+static struct {
+    int on;
+    RunStop aborted;
+    RunStop last;               /* of the last run, see LastStop() */
+    int runs;                   /* lanes of a lockstep run share its budget */
+    unsigned long derivs;
+    unsigned long steps;
+    double start;
+} budget_run;
+
+/** BudgetClock: monotonic wall clock time in seconds */
+static double
+BudgetClock( void ) {
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/** StartBudget: puts the next model run on the budget solver_budget */
+void
+StartBudget( int runs ) {
+    budget_run.on = 1;
+    budget_run.aborted = RUN_FINISHED;
+    budget_run.runs = runs;
+    budget_run.derivs = solver_stats.derivs;
+    budget_run.steps = solver_stats.steps + solver_stats.rejected;
+    budget_run.start = ( solver_budget.seconds > 0. ) ? BudgetClock(  ) : 0.;
+}
+
+/** StopBudget: ends the budget of the current run and counts it in  
+ *               solver_stats if it was stopped                       
+ */
+RunStop
+StopBudget( void ) {
+    RunStop aborted = budget_run.aborted;
+
+    budget_run.on = 0;
+    budget_run.aborted = RUN_FINISHED;
+    budget_run.last = aborted;
+    solver_stats.aborted += ( aborted != RUN_FINISHED );
+    return aborted;
+}
+
+/** LastStop: why the last run was stopped, then forgets it */
+RunStop
+LastStop( void ) {
+    RunStop last = budget_run.last;
+
+    budget_run.last = RUN_FINISHED;
+    return last;
+}
+
+/** OverBudget: checks the current run against its budget */
+int
+OverBudget( void ) {
+    if( !budget_run.on || budget_run.aborted )
+        return budget_run.aborted;
+    if( ( solver_budget.derivs && solver_stats.derivs - budget_run.derivs > solver_budget.derivs * budget_run.runs )
+        || ( solver_budget.steps && solver_stats.steps + solver_stats.rejected - budget_run.steps > solver_budget.steps * budget_run.runs )
+        || ( solver_budget.seconds > 0. && BudgetClock(  ) - budget_run.start > solver_budget.seconds * budget_run.runs ) )
+        budget_run.aborted = RUN_OVER_BUDGET;
+    return budget_run.aborted;
+}
+
+/** AbortRun: stops the current run if it is on a budget */
+int
+AbortRun( void ) {
+    if( budget_run.on && !budget_run.aborted )
+        budget_run.aborted = RUN_OVER_BUDGET;
+    NewSolverRun(  );
+    return budget_run.on;
+}
+
+/** CheckState: stops the current run if its state has diverged; the  
+ *               loop has no branches, so it costs next to nothing     
+ */
+int
+CheckState( const double *v, int n ) {
+    const double bound = ( solver_budget.max_conc > 0. ) ? solver_budget.max_conc : DBL_MAX;
+    int i, bad = 0;
+
+    if( !budget_run.on )
+        return 0;
+    /* NaN fails the comparison too */
+    for( i = 0; i < n; i++ )
+        bad |= !( fabs( v[i] ) <= bound );
+    if( bad && !budget_run.aborted )
+        budget_run.aborted = RUN_DIVERGED;
+    return OverBudget(  );
+}
+
+
 /*** DEBUGGING AND SOLVER LOG FUNCS ***************************************/
 
+/** WriteSolverStats: writes the work done since the snapshot 'since' as
+ *                     tab separated columns (derivs, steps, rejected steps,
+ *                     Jacobians, CVODE steps, CVODE rhs evaluations, model
+ *                     runs in Score() and their mean time in ms, model runs
+ *                     stopped by their budget), then moves the snapshot up
+ *                     to now; no newline is written
+ */
+void
+WriteSolverStats( FILE * fp, SolverStats * since ) {
+    SolverStats now = solver_stats;
+    unsigned long scores = now.scores - since->scores;
+    double ms = scores ? 1000. * ( now.score_time - since->score_time ) / scores : 0.;
+
+    fprintf( fp, "%lu\t%lu\t%lu\t%lu\t%lu\t%lu\t%lu\t%g\t%lu",
+             now.derivs - since->derivs, now.steps - since->steps, now.rejected - since->rejected,
+             now.jacobians - since->jacobians, now.cv_steps - since->cv_steps, now.cv_rhs - since->cv_rhs, scores, ms,
+             now.aborted - since->aborted );
+    *since = now;
+}
+
 void
 WriteSolvLog( char *solver, double tin, double tout, double h, int n, int nderivs, FILE * slog ) {
     double nds;                 /* Number of Derivative evaluations per Step */
@@ -3240,12 +4197,108 @@ CE( double t, double *vans, double tbegin, double *v_at_tbegin, double ech, doub
 
 }
 
+/** GrowHistory: makes room for cap grid points in the history of the 
+ *               delay solver; the grid points that are kept move to their 
+ *               new slots                                                 
+ */
+static void
+GrowHistory( int cap ) {
+    int i, old, slot;
+    double *t2 = ( double * ) calloc( cap, sizeof( double ) );
+    double **v2 = ( double ** ) calloc( cap, sizeof( double * ) );
+    double **d1 = ( double ** ) calloc( cap, sizeof( double * ) );
+    double **d2 = ( double ** ) calloc( cap, sizeof( double * ) );
+    double **d3 = ( double ** ) calloc( cap, sizeof( double * ) );
+    double **d4 = ( double ** ) calloc( cap, sizeof( double * ) );
+    int *size2 = ( int * ) calloc( cap, sizeof( int ) );
+
+    if( !t2 || !v2 || !d1 || !d2 || !d3 || !d4 || !size2 )
+        error( "GrowHistory: could not allocate memory" );
+
+    /* only called on a full (or empty) ring, so every slot is moved */
+
+    for( i = gridstart; i <= gridpos; i++ ) {
+        old = HIST( i );
+        slot = i % cap;
+        t2[slot] = tdone[old];
+        v2[slot] = vdonne[old];
+        d1[slot] = derivv1[old];
+        d2[slot] = derivv2[old];
+        d3[slot] = derivv3[old];
+        d4[slot] = derivv4[old];
+        size2[slot] = histsize[old];
+    }
+
+    free( tdone );
+    free( vdonne );
+    free( derivv1 );
+    free( derivv2 );
+    free( derivv3 );
+    free( derivv4 );
+    free( histsize );
+    tdone = t2;
+    vdonne = v2;
+    derivv1 = d1;
+    derivv2 = d2;
+    derivv3 = d3;
+    derivv4 = d4;
+    histsize = size2;
+    histcap = cap;
+}
+
+/** AddGridPoint: appends time t and v (of size n) to the history of the 
+ *                delay solver, with zero derivatives; the slot of the     
+ *                oldest grid point is reused unless it is still needed;   
+ *                slots have room for histmax, so that DivideHistory() can 
+ *                expand them in place                                     
+ */
+static void
+AddGridPoint( double t, double *v, int n ) {
+    int slot;
+
+    if( gridpos + 1 - gridstart >= histcap )
+        GrowHistory( histcap ? 2 * histcap : 16 );
+
+    gridpos++;
+    slot = HIST( gridpos );
+
+    /* vdonne and the derivatives of a slot share one block */
+
+    if( histsize[slot] < n ) {
+        free( vdonne[slot] );
+        histsize[slot] = ( n > histmax ) ? n : histmax;
+        if( !( vdonne[slot] = ( double * ) malloc( 5 * histsize[slot] * sizeof( double ) ) ) )
+            error( "AddGridPoint: could not allocate memory" );
+    }
+    memset( vdonne[slot], 0, 5 * n * sizeof( double ) );
+    derivv1[slot] = vdonne[slot] + n;
+    derivv2[slot] = derivv1[slot] + n;
+    derivv3[slot] = derivv2[slot] + n;
+    derivv4[slot] = derivv3[slot] + n;
+
+    tdone[slot] = t;
+    memcpy( vdonne[slot], v, n * sizeof( double ) );
+    if( gridpos == 0 )
+        gridtime0 = t;
+
+    /* move on the oldest grid point we still need */
+
+    while( gridstart < gridpos && tdone[HIST( gridstart + 1 )] < t - maxdel )
+        gridstart++;
+}
+
+/**  y_delayed: fills vd[vc][dc] with v at rktimes[vc] - tau[dc] from the 
+ *              history of the delay solver (or the initial history before  
+ *              grid point 0); delayed times within the current step are    
+ *              iterated; returns 1 if that iteration did not converge      
+ */
 int
-y_delayed( double ***vd, int n, double *rktimes, double *tau,
-           double *grid, double **vdone, double **deriv1, double **deriv2, double
-           **deriv3, double **deriv4, int gridsize, double accu, SolverInput * si, Input * inp ) {
+y_delayed( double ***vd, int n, double *rktimes, double *tau, double accu, SolverInput * si, Input * inp ) {
 
     int i, j, vc, dc, it;
+    int lo, hi;                 /* bounds of the binary search */
+    int last = HIST( gridpos ); /* slots of the last two grid points */
+    int prev = HIST( gridpos > 0 ? gridpos - 1 : gridpos );
     double t, ech;
     double *vtemp, *vnext, *vprev, *dummy;
     double *drv1, *drv2, *drv3, *drv4;
@@ -3279,39 +4332,54 @@ y_delayed( double ***vd, int n, double *rktimes, double *tau,
 
         for( dc = 0; dc < numdel; dc++ )
             if( tau[dc] == 0. )
-                vd[vc][dc] = memcpy( vd[vc][dc], vdone[gridsize - 1], sizeof( double ) * n );
-            else if( t - tau[dc] <= grid[0] )
+                vd[vc][dc] = memcpy( vd[vc][dc], vdonne[last], sizeof( double ) * n );
+            else if( t - tau[dc] <= gridtime0 )
                 History( t - tau[dc], t, vd[vc][dc], n, inp->his[si->genindex], inp->zyg.defs.ngenes, &( inp->zyg ) );
-            else if( t - tau[dc] <= grid[gridsize - 1] ) {
+            else if( t - tau[dc] <= tdone[last] ) {
+
+                /* binary search for the first grid point at or after t - tau; it is *
+                 * after gridstart, since t - tau >= t(now) - maxdel                 */
 
-                j = 0;
-                while( ( j < gridsize ) && ( t - tau[dc] > grid[j] ) )
-                    j++;
+                lo = gridstart + 1;
+                hi = gridpos;
+                while( lo < hi ) {
+                    j = lo + ( hi - lo ) / 2;
+                    if( t - tau[dc] > tdone[HIST( j )] )
+                        lo = j + 1;
+                    else
+                        hi = j;
+                }
+                j = lo;
 
-                if( j >= gridsize ) {
+                if( t - tau[dc] > tdone[HIST( j )] || t - tau[dc] <= tdone[HIST( j - 1 )] ) {
                     printf( "y_past:time requested not in grid, bailing!\n" );
                     exit( 1 );
                 }
 
-                if( ( j == gridsize - 1 ) && ( t - tau[dc] == grid[gridsize - 1] ) ) {
-                    vd[vc][dc] = memcpy( vd[vc][dc], vdone[gridsize - 1], sizeof( double ) * n );
+                if( ( j == gridpos ) && ( t - tau[dc] == tdone[last] ) ) {
+                    vd[vc][dc] = memcpy( vd[vc][dc], vdonne[last], sizeof( double ) * n );
                     /*                          for (i=0; i<n; i++)
                        printf("t=%f, t-del=%f, vdone[%d]=%f,"
                        "vpast[%d]=%f\n", 
                        t,t-tau[dc],j,vdone[j][i],i,vd[vc][dc][i]); */
                 } else {
 
-                    CE( t - tau[dc], vd[vc][dc], grid[j - 1], vdone[j - 1], grid[j] - grid[j - 1], deriv1[j - 1], deriv2[j - 1], deriv3[j - 1], deriv4[j - 1],
-                        n );
+                    i = HIST( j - 1 );
+                    CE( t - tau[dc], vd[vc][dc], tdone[i], vdonne[i], tdone[HIST( j )] - tdone[i], derivv1[i], derivv2[i], derivv3[i], derivv4[i], n );
                     /*                                  for (i=0; i<n; i++)
                        printf("t=%f, t-del=%f, vdone[%d]=%f," 
                        "vpast[%d]=%f\n",
                        t,t-tau[dc],j,vdone[j-1][i],i,vd[vc][dc][i]); */
                 }
-            } else if( t - tau[dc] > grid[gridsize - 1] ) {
+            } else if( t - tau[dc] > tdone[last] ) {
+
+                /* extrapolate the last step as a first guess for the iteration below */
 
-                CE( t - tau[dc], vd[vc][dc], grid[gridsize - 2], vdone[gridsize - 2], grid[gridsize - 1] - grid[gridsize - 2], deriv1[gridsize - 2],
-                    deriv2[gridsize - 2], deriv3[gridsize - 2], deriv4[gridsize - 2], n );
+                if( prev == last )
+                    memcpy( vd[vc][dc], vdonne[last], sizeof( double ) * n );
+                else
+                    CE( t - tau[dc], vd[vc][dc], tdone[prev], vdonne[prev], tdone[last] - tdone[prev], derivv1[prev],
+                        derivv2[prev], derivv3[prev], derivv4[prev], n );
                 /*                              for (i=0; i<n; i++)
                    printf("IterInit [%.6f,%.6f], t-del=%.6f,"
                    "vd[%d][%d]=%.6f\n", 
@@ -3326,8 +4394,8 @@ y_delayed( double ***vd, int n, double *rktimes, double *tau,
     }
 
     /* Now lets do the promised iteration, if required ofcourse! */
-    if( rktimes[3] - mindel > grid[gridsize - 1] ) {
-        d_deriv( vdone[gridsize - 1], vd[0], rktimes[0], drv1, n, si, inp );
+    if( rktimes[3] - mindel > tdone[last] ) {
+        d_deriv( vdonne[last], vd[0], rktimes[0], drv1, n, si, inp );
 
         it = 0;
         verror_max = 100.;
@@ -3337,15 +4405,15 @@ y_delayed( double ***vd, int n, double *rktimes, double *tau,
             /*                  printf("Iteration No.%d, error: %f\n",it,verror_max); */
 
             for( i = 0; i < n; i++ )
-                vtemp[i] = vdone[gridsize - 1][i] + ech * ( b21 * drv1[i] );
+                vtemp[i] = vdonne[last][i] + ech * ( b21 * drv1[i] );
             d_deriv( vtemp, vd[1], rktimes[1], drv2, n, si, inp );
 
             for( i = 0; i < n; i++ )
-                vtemp[i] = vdone[gridsize - 1][i] + ech * ( b32 * drv2[i] );
+                vtemp[i] = vdonne[last][i] + ech * ( b32 * drv2[i] );
             d_deriv( vtemp, vd[2], rktimes[2], drv3, n, si, inp );
 
             for( i = 0; i < n; i++ )
-                vnext[i] = vdone[gridsize - 1][i] + ech * ( c1 * drv1[i] + c2 * drv2[i] + c3 * drv3[i] );
+                vnext[i] = vdonne[last][i] + ech * ( c1 * drv1[i] + c2 * drv2[i] + c3 * drv3[i] );
             d_deriv( vnext, vd[3], rktimes[3], drv4, n, si, inp );
 
             for( vc = 0; vc < 4; vc++ ) {
@@ -3353,8 +4421,8 @@ y_delayed( double ***vd, int n, double *rktimes, double *tau,
                 t = rktimes[vc];
 
                 for( dc = 0; dc < numdel; dc++ )
-                    if( t - tau[dc] > grid[gridsize - 1] ) {
-                        CE( t - tau[dc], vd[vc][dc], grid[gridsize - 1], vdone[gridsize - 1], ech, drv1, drv2, drv3, drv4, n );
+                    if( t - tau[dc] > tdone[last] ) {
+                        CE( t - tau[dc], vd[vc][dc], tdone[last], vdonne[last], ech, drv1, drv2, drv3, drv4, n );
 
                         /*                                      for (i=0; i<n; i++)
                            printf("[%.6f,%.6f], t-del=%.6f,"
@@ -3484,44 +4552,12 @@ DCERk32( double **vatt, int n, double *tarray, int tpoints, double *darray, int
     vnow = vatt[0];
     vnext = v[0];
 
-    /* allocate more grid and derivs */
-    gridpos++;
-    if( !( tdone = ( double * ) realloc( tdone, ( gridpos + 1 ) * sizeof( double ) ) ) ) {
-        printf( "Could not allocate memory for tdone\n" );
-        exit( 1 );
-    }
-
-    if( !( vdonne = ( double ** ) realloc( vdonne, ( gridpos + 1 ) * sizeof( double * ) ) ) ) {
-        printf( "Could not allocate memory for vdonne\n" );
-        exit( 1 );
-    }
-
-    if( !( derivv1 = ( double ** ) realloc( derivv1, ( gridpos + 1 ) * sizeof( double * ) ) ) ) {
-        printf( "Could not allocate memory for derivv1\n" );
-        exit( 1 );
+    /* add the start to the history */
+    if( !histcap ) {
+        histmax = inp->zyg.defs.nnucs * inp->zyg.defs.ngenes;
+        GrowHistory( ( int ) ( maxdel / stephint ) + 16 );
     }
-
-    if( !( derivv2 = ( double ** ) realloc( derivv2, ( gridpos + 1 ) * sizeof( double * ) ) ) ) {
-        printf( "Could not allocate memory for derivv2\n" );
-        exit( 1 );
-    }
-
-    if( !( derivv3 = ( double ** ) realloc( derivv3, ( gridpos + 1 ) * sizeof( double * ) ) ) ) {
-        printf( "Could not allocate memory for derivv3 \n" );
-        exit( 1 );
-    }
-
-    if( !( derivv4 = ( double ** ) realloc( derivv4, ( gridpos + 1 ) * sizeof( double * ) ) ) ) {
-        printf( "Could not allocate memory for derivv4\n" );
-        exit( 1 );
-    }
-    derivv1[gridpos] = ( double * ) calloc( n, sizeof( double ) );
-    derivv2[gridpos] = ( double * ) calloc( n, sizeof( double ) );
-    derivv3[gridpos] = ( double * ) calloc( n, sizeof( double ) );
-    derivv4[gridpos] = ( double * ) calloc( n, sizeof( double ) );
-    vdonne[gridpos] = ( double * ) calloc( n, sizeof( double ) );
-    tdone[gridpos] = t;
-    memcpy( vdonne[gridpos], vnow, sizeof( *vnow ) * n );
+    AddGridPoint( t, vnow, n );
 
 
     /* initial stepsize cannot be bigger than total time */
@@ -3562,7 +4598,7 @@ DCERk32( double **vatt, int n, double *tarray, int tpoints, double *darray, int
     /* we need to calculate derivv1 only the first time, since if the
        previous step was a success, we can use the last derivv4, and if it is
        was a failure, we don't have to recalculate it */
-    while( y_delayed( v_delayed, n, tms, delay, tdone, vdonne, derivv1, derivv2, derivv3, derivv4, gridpos + 1, accuracy, si, inp ) ) {
+    while( y_delayed( v_delayed, n, tms, delay, accuracy, si, inp ) ) {
         printf( "Rejected Iteration for [%f,%f]!\n", t, t + h );
         h = 0.5 * h;
         tms[0] = t;
@@ -3579,7 +4615,7 @@ DCERk32( double **vatt, int n, double *tarray, int tpoints, double *darray, int
         }
     }
 
-    d_deriv( vnow, v_delayed[0], t, derivv1[gridpos], n, si, inp );
+    d_deriv( vnow, v_delayed[0], t, derivv1[HIST( gridpos )], n, si, inp );
 
     while( t < tarray[tpoints - 1] ) {
 
@@ -3593,37 +4629,37 @@ DCERk32( double **vatt, int n, double *tarray, int tpoints, double *darray, int
             tms[2] = t + a3 * h;
             tms[3] = t + h;
 
-            if( !y_delayed( v_delayed, n, tms, delay, tdone, vdonne, derivv1, derivv2, derivv3, derivv4, gridpos + 1, accuracy, si, inp ) ) {
+            if( !y_delayed( v_delayed, n, tms, delay, accuracy, si, inp ) ) {
 
                 /* do the Runge-Kutta thing here: calulate intermediate 
                    derivatives */
                 for( i = 0; i < n; i++ )
-                    vtemp[i] = vnow[i] + h * ( b21 * derivv1[gridpos][i] );
+                    vtemp[i] = vnow[i] + h * ( b21 * derivv1[HIST( gridpos )][i] );
 
-                d_deriv( vtemp, v_delayed[1], t + a2 * h, derivv2[gridpos], n, si, inp );
+                d_deriv( vtemp, v_delayed[1], t + a2 * h, derivv2[HIST( gridpos )], n, si, inp );
 
                 for( i = 0; i < n; i++ )
-                    vtemp[i] = vnow[i] + h * ( b32 * derivv2[gridpos][i] );
+                    vtemp[i] = vnow[i] + h * ( b32 * derivv2[HIST( gridpos )][i] );
 
-                d_deriv( vtemp, v_delayed[2], t + a3 * h, derivv3[gridpos], n, si, inp );
+                d_deriv( vtemp, v_delayed[2], t + a3 * h, derivv3[HIST( gridpos )], n, si, inp );
 
                 /* ... then feed them to the Rk32 formula */
 
                 for( i = 0; i < n; i++ )
-                    vnext[i] = vnow[i] + h * ( c1 * derivv1[gridpos][i] + c2 * derivv2[gridpos][i] + c3 * derivv3[gridpos][i] );
+                    vnext[i] = vnow[i] + h * ( c1 * derivv1[HIST( gridpos )][i] + c2 * derivv2[HIST( gridpos )][i] + c3 * derivv3[HIST( gridpos )][i] );
 
                 /* Now calculate k4 for the embedded 4-stage formula, if this step is
                    succesful, it will get used as derivv1 (k1) in the next step */
                 //              for (i=0; i<10; i++) {
-                //                  printf("%d gridpos=%d; derivv1=%lg; derivv2=%lg; derivv3=%lg; h=%lg\n", i, gridpos, derivv1[gridpos][i], derivv2[gridpos][i], derivv3[gridpos][i], h);
+                //                  printf("%d gridpos=%d; derivv1=%lg; derivv2=%lg; derivv3=%lg; h=%lg\n", i, gridpos, derivv1[HIST( gridpos )][i], derivv2[HIST( gridpos )][i], derivv3[HIST( gridpos )][i], h);
                 //              }
-                d_deriv( vnext, v_delayed[3], t + h, derivv4[gridpos], n, si, inp );
+                d_deriv( vnext, v_delayed[3], t + h, derivv4[HIST( gridpos )], n, si, inp );
                 /* calculate the error estimate using the embedded formula */
 
                 for( i = 0; i < n; i++ ) {
-                    verror[i] = h * ( dc1 * derivv1[gridpos][i] + dc2 * derivv2[gridpos][i] + dc3 * derivv3[gridpos][i] + dc4 * derivv4[gridpos][i] );
+                    verror[i] = h * ( dc1 * derivv1[HIST( gridpos )][i] + dc2 * derivv2[HIST( gridpos )][i] + dc3 * derivv3[HIST( gridpos )][i] + dc4 * derivv4[HIST( gridpos )][i] );
                 }
-                //printf("verror=%lg, h=%lg, dc1=%lg, deriv1=%lg, dc2=%lg, deriv2=%lg, dc3=%lg, deriv3=%lg, dc4=%lg, deriv4=%lg\n", verror[0], h, dc1, derivv1[gridpos][0], dc2, derivv2[gridpos][0], dc3, derivv3[gridpos][0], dc4, derivv4[gridpos][0]);
+                //printf("verror=%lg, h=%lg, dc1=%lg, deriv1=%lg, dc2=%lg, deriv2=%lg, dc3=%lg, deriv3=%lg, dc4=%lg, deriv4=%lg\n", verror[0], h, dc1, derivv1[HIST( gridpos )][0], dc2, derivv2[HIST( gridpos )][0], dc3, derivv3[HIST( gridpos )][0], dc4, derivv4[HIST( gridpos )][0]);
                 /* find the maximum error */
                 verror_max = 0.;
                 for( i = 0; i < n; i++ ) {
@@ -3639,7 +4675,7 @@ DCERk32( double **vatt, int n, double *tarray, int tpoints, double *darray, int
                 /*      for (i=0; i<n; i++) 
                    printf("The deriv1[%d]=%.10f deriv2[%d]=%.10f deriv3[%d]=%.10f "
                    "deriv4[%d]=%.10f verror[%d]=%.10f verror_max=%.10f \n",i,
-                   derivv1[gridpos][i],i, derivv2[gridpos][i],i,derivv3[gridpos][i],i,derivv4[gridpos][i],i,
+                   derivv1[HIST( gridpos )][i],i, derivv2[HIST( gridpos )][i],i,derivv3[HIST( gridpos )][i],i,derivv4[HIST( gridpos )][i],i,
                    verror[i],verror_max);
                  */
                 /* scale error according to desired accuracy */
@@ -3655,6 +4691,7 @@ DCERk32( double **vatt, int n, double *tarray, int tpoints, double *darray, int
                 }
 
                 /*        printf("Step size %f rejected!\n",h); */
+                solver_stats.rejected++;
 
                 /* kludge for going back to the original position in the discontinuity
                    array if the step is rejected */
@@ -3692,6 +4729,7 @@ DCERk32( double **vatt, int n, double *tarray, int tpoints, double *darray, int
 
             } else {
                 /*              printf("Rejected Iteration for [%f,%f]!\n",t,t+h); */
+                solver_stats.rejected++;
                 h = 0.5 * h;
 
                 if( ( h > mindel ) && ( h <= 2. * mindel ) )
@@ -3723,7 +4761,7 @@ DCERk32( double **vatt, int n, double *tarray, int tpoints, double *darray, int
            exchange the pointers */
         while( ( tarray[tpos] < t + h ) && ( tpos < tpoints ) ) {
 
-            CE( tarray[tpos], vatt[tpos], t, vnow, h, derivv1[gridpos], derivv2[gridpos], derivv3[gridpos], derivv4[gridpos], n );
+            CE( tarray[tpos], vatt[tpos], t, vnow, h, derivv1[HIST( gridpos )], derivv2[HIST( gridpos )], derivv3[HIST( gridpos )], derivv4[HIST( gridpos )], n );
             /*          printf("Vatt: %d %f %f %f %f %f\n",
                tpos,tarray[tpos],vatt[tpos][0],vnow[0],t,t+h); */
 
@@ -3746,6 +4784,7 @@ DCERk32( double **vatt, int n, double *tarray, int tpoints, double *darray, int
         vnext = v[toggle];
 
         t += h;
+        solver_stats.steps++;
 
 
         /*    if (t >= tarray[tpoints - 1])
@@ -3796,58 +4835,14 @@ DCERk32( double **vatt, int n, double *tarray, int tpoints, double *darray, int
         }
 
 
-        /* allocate more grid and derivs */
+        /* add the new grid point to the history */
 
-        gridpos++;
-        if( !( tdone = ( double * ) realloc( tdone, ( gridpos + 1 ) * sizeof( double ) ) ) ) {
-            printf( "Could not allocate memory for tdone\n" );
-            exit( 1 );
-        }
-
-        if( !( vdonne = ( double ** ) realloc( vdonne, ( gridpos + 1 ) * sizeof( double * ) ) ) ) {
-            printf( "Could not allocate memory for vdonne\n" );
-            exit( 1 );
-        }
-
-        if( !( derivv1 = ( double ** ) realloc( derivv1, ( gridpos + 1 ) * sizeof( double * ) ) ) ) {
-            printf( "Could not allocate memory for derivv1\n" );
-            exit( 1 );
-        }
-
-        if( !( derivv2 = ( double ** ) realloc( derivv2, ( gridpos + 1 ) * sizeof( double * ) ) ) ) {
-            printf( "Could not allocate memory for derivv2\n" );
-            exit( 1 );
-        }
-
-        if( !( derivv3 = ( double ** ) realloc( derivv3, ( gridpos + 1 ) * sizeof( double * ) ) ) ) {
-            printf( "Could not allocate memory for derivv3 \n" );
-            exit( 1 );
-        }
-
-        if( !( derivv4 = ( double ** ) realloc( derivv4, ( gridpos + 1 ) * sizeof( double * ) ) ) ) {
-            printf( "Could not allocate memory for derivv4\n" );
-            exit( 1 );
-        }
-        derivv1[gridpos] = ( double * ) calloc( n, sizeof( double ) );
-        derivv2[gridpos] = ( double * ) calloc( n, sizeof( double ) );
-        derivv3[gridpos] = ( double * ) calloc( n, sizeof( double ) );
-        derivv4[gridpos] = ( double * ) calloc( n, sizeof( double ) );
-        vdonne[gridpos] = ( double * ) calloc( n, sizeof( double ) );
-        tdone[gridpos] = t;
-
-        if( t - maxdel > tdone[0] ) {
-            while( t - maxdel >= tdone[gridstart] )
-                gridstart++;
-
-            gridstart--;
-        }
-
-        memcpy( vdonne[gridpos], vnow, sizeof( *vnow ) * n );
+        AddGridPoint( t, vnow, n );
 
 
         /* put present derivv4 into future derivv1 */
 
-        memcpy( derivv1[gridpos], derivv4[gridpos - 1], sizeof( **derivv4 ) * n );
+        memcpy( derivv1[HIST( gridpos )], derivv4[HIST( gridpos - 1 )], sizeof( **derivv4 ) * n );
     }
 
     /*       for (j=0; j<=gridpos;j++)
@@ -3879,10 +4874,9 @@ DCERk32( double **vatt, int n, double *tarray, int tpoints, double *darray, int
         free( v_delayed[vc] );
     }
 
-    /* Put zeroes in derivv1[gridpos], all the rest are zero anyways */
+    /* Put zeroes in derivv1[HIST( gridpos )], all the rest are zero anyways */
 
-    free( derivv1[gridpos] );
-    derivv1[gridpos] = ( double * ) calloc( n, sizeof( double ) );
+    memset( derivv1[HIST( gridpos )], 0, n * sizeof( double ) );
 
 
     free( v );
@@ -3896,13 +4890,8 @@ FreeDelaySolver( void ) {
 
     int j;
 
-    for( j = 0; j <= gridpos; j++ ) {
-        free( derivv1[j] );
-        free( derivv2[j] );
-        free( derivv3[j] );
-        free( derivv4[j] );
+    for( j = 0; j < histcap; j++ )
         free( vdonne[j] );
-    }
 
     free( derivv1 );
     free( derivv2 );
@@ -3910,6 +4899,8 @@ FreeDelaySolver( void ) {
     free( derivv4 );
     free( vdonne );
     free( tdone );
+    free( histsize );
+    histcap = 0;
 
 }
 
@@ -3918,60 +4909,58 @@ InitDelaySolver( void ) {
 
     gridpos = -1;
     gridstart = 0;
+    histcap = 0;
     tdone = NULL;
     vdonne = NULL;
     derivv1 = NULL;
     derivv2 = NULL;
     derivv3 = NULL;
     derivv4 = NULL;
+    histsize = NULL;
+    histmax = 0;
 
 }
 
 void
 DivideHistory( double t1, double t2, Zygote * zyg ) {
-    double *blug;
-    int i, size;
-
-    if( ( size =
-          GetNNucs( &( zyg->defs ), zyg->nnucs, t2, &( zyg->times ) ) * zyg->defs.ngenes ) > GetNNucs( &( zyg->defs ), zyg->nnucs, t1,
-                                                                                                       &( zyg->times ) ) * zyg->defs.ngenes )
-        for( i = 0; i <= gridpos; i++ ) {
-            blug = ( double * ) calloc( size, sizeof( double ) );
-            Go_Forward( blug, vdonne[i], GetStartLinIndex( t2, &( zyg->defs ), &( zyg->times ) ), GetStartLinIndex( t1, &( zyg->defs ), &( zyg->times ) ), zyg,
-                        zyg->defs.ngenes );
-
-            free( vdonne[i] );
-            vdonne[i] = blug;
-
-            blug = ( double * ) calloc( size, sizeof( double ) );
-            Go_Forward( blug, derivv1[i], GetStartLinIndex( t2, &( zyg->defs ), &( zyg->times ) ), GetStartLinIndex( t1, &( zyg->defs ), &( zyg->times ) ), zyg,
-                        zyg->defs.ngenes );
-
-            free( derivv1[i] );
-            derivv1[i] = blug;
+    int i, j, size, oldsize, nnuc, slot;
+    int lin1, lin2;
+    const int *map;
+    double **arrays[5];
 
-            blug = ( double * ) calloc( size, sizeof( double ) );
-            Go_Forward( blug, derivv2[i], GetStartLinIndex( t2, &( zyg->defs ), &( zyg->times ) ), GetStartLinIndex( t1, &( zyg->defs ), &( zyg->times ) ), zyg,
-                        zyg->defs.ngenes );
-
-            free( derivv2[i] );
-            derivv2[i] = blug;
-
-            blug = ( double * ) calloc( size, sizeof( double ) );
-            Go_Forward( blug, derivv3[i], GetStartLinIndex( t2, &( zyg->defs ), &( zyg->times ) ), GetStartLinIndex( t1, &( zyg->defs ), &( zyg->times ) ), zyg,
-                        zyg->defs.ngenes );
-
-            free( derivv3[i] );
-            derivv3[i] = blug;
-
-            blug = ( double * ) calloc( size, sizeof( double ) );
-            Go_Forward( blug, derivv4[i], GetStartLinIndex( t2, &( zyg->defs ), &( zyg->times ) ), GetStartLinIndex( t1, &( zyg->defs ), &( zyg->times ) ), zyg,
-                        zyg->defs.ngenes );
-
-            free( derivv4[i] );
-            derivv4[i] = blug;
+    size = GetNNucs( &( zyg->defs ), zyg->nnucs, t2, &( zyg->times ) ) * zyg->defs.ngenes;
+    if( size <= GetNNucs( &( zyg->defs ), zyg->nnucs, t1, &( zyg->times ) ) * zyg->defs.ngenes )
+        return;
 
+    lin1 = GetStartLinIndex( t1, &( zyg->defs ), &( zyg->times ) );
+    lin2 = GetStartLinIndex( t2, &( zyg->defs ), &( zyg->times ) );
+    if( lin2 >= lin1 || lin1 >= zyg->nlinmaps )
+        error( "DivideHistory: no lineage map from %g to %g", t1, t2 );
+    map = zyg->lin_gather[lin2 * zyg->nlinmaps + lin1];
+    nnuc = Index2NNuc( lin2, zyg->full_nnucs );
+    oldsize = Index2NNuc( lin1, zyg->full_nnucs ) * zyg->defs.ngenes;
+    arrays[0] = vdonne;
+    arrays[1] = derivv1;
+    arrays[2] = derivv2;
+    arrays[3] = derivv3;
+    arrays[4] = derivv4;
+
+    /* the arrays of a slot are in one block, vdonne first; they are expanded *
+     * in place, the last one first, so nothing is overwritten before it has  *
+     * been copied (see GatherNuclei())                                       */
+
+    for( i = gridstart; i <= gridpos; i++ ) {
+        slot = HIST( i );
+        if( histsize[slot] < size ) {
+            if( !( vdonne[slot] = ( double * ) realloc( vdonne[slot], 5 * size * sizeof( double ) ) ) )
+                error( "DivideHistory: could not allocate memory" );
+            histsize[slot] = size;
         }
+        for( j = 4; j >= 0; j-- )
+            GatherNuclei( vdonne[slot] + j * size, vdonne[slot] + j * oldsize, map, nnuc, zyg->defs.ngenes );
+        for( j = 1; j < 5; j++ )
+            arrays[j][slot] = vdonne[slot] + j * size;
+    }
 
 }
 
@@ -4306,6 +5295,21 @@ CheckFlag( void *flagvalue, char *funcname, int opt ) {
     return 0;
 }
 
+/** AddCVodeStats: adds the work of the last CVODE run to solver_stats; the
+ *                  rhs evaluations are counted as derivs by DvdtOrig() too
+ */
+static void
+AddCVodeStats( void ) {
+    long int nst = 0, nfe = 0, nje = 0;
+
+    CVodeGetNumSteps( cvode_mem, &nst );
+    CVodeGetNumRhsEvals( cvode_mem, &nfe );
+    CVDlsGetNumJacEvals( cvode_mem, &nje );
+    solver_stats.cv_steps += nst;
+    solver_stats.cv_rhs += nfe;
+    solver_stats.jacobians += nje;
+}
+
 /**  Krylov: propagates vin (of size n) from tin to tout by BDF (Backward  
  *           Differential Formulas and use of a Newton-Krylov method with  
  *           preconditioning to avoid the costly computation of the        
@@ -4364,8 +5368,12 @@ Krylov( double *vin, double *vout, double tin, double tout, double stephint, dou
     CVodeSetStopTime( cvode_mem, tstop );
     /* old code, works if networks would always be well-behaved */
     flag = CVode( cvode_mem, tout, vars, &t, CV_NORMAL );
-    if( CheckFlag( &flag, "CVode", 1 ) )
+    AddCVodeStats(  );
+    /* a failed run has no good output; on a budget, it is stopped */
+    if( CheckFlag( &flag, "CVode", 1 ) ) {
+        AbortRun(  );
         return;
+    }
     /* copy vars into vout */
     for( i = 0; i < n; ++i ) {
         vout[i] = NV_Ith_S( vars, i );
@@ -35,6 +35,53 @@ void ( *p_deriv_lite ) ( double *, double, double *, int, SolverInput *, Input *
 void ( *d_deriv ) ( double *, double **, double, double *, int, SolverInput *, Input * );
 void ( *p_jacobn ) ( double, double *, double *, double **, int, SolverInput *, Input * );
 
+/* the generic solver interface, see solvers.c */
+typedef void ( *SolverFunc ) ( double *, double *, double, double, double, double, int, FILE *, SolverInput *, Input * );
+
+
+/*** SOLVER STATISTICS *****************************************************/
+
+/** SolverStats: running totals of the work done by the derivative
+ *                functions, the solvers and Score(); they are always
+ *                counted and only ever go up, so the work of an optimizer
+ *                iteration is the difference of two snapshots
+ */
+typedef struct SolverStats {
+    unsigned long derivs;       /* derivative evaluations */
+    unsigned long steps;        /* accepted solver steps */
+    unsigned long rejected;     /* rejected (repeated) solver steps */
+    unsigned long jacobians;    /* Jacobian evaluations */
+    unsigned long cv_steps;     /* internal CVODE steps (kr solver) */
+    unsigned long cv_rhs;       /* CVODE right hand side evaluations */
+    unsigned long scores;       /* Score() calls that ran the model */
+    double score_time;          /* seconds spent running the model in Score() */
+    unsigned long aborted;      /* model runs stopped by their budget */
+} SolverStats;
+
+extern SolverStats solver_stats;
+
+/** SolverBudget: the most work one model run in Score() may take (see
+ *                 StartBudget()), 0 meaning no limit; a run that goes over
+ *                 it, or whose concentrations become non-finite or exceed
+ *                 max_conc, is stopped and scores FORBIDDEN_MOVE, so that
+ *                 pathological parameter sets can't grind for minutes
+ */
+typedef struct SolverBudget {
+    unsigned long derivs;       /* derivative evaluations */
+    unsigned long steps;        /* accepted and rejected solver steps */
+    double seconds;             /* wall clock time */
+    double max_conc;            /* largest concentration */
+} SolverBudget;
+
+extern SolverBudget solver_budget;
+
+/** RunStop: why a model run on a budget was stopped (see StopBudget()) */
+typedef enum RunStop {
+    RUN_FINISHED = 0,           /* it wasn't */
+    RUN_OVER_BUDGET,            /* too much work, or the solver gave up */
+    RUN_DIVERGED                /* a concentration not finite or beyond max_conc */
+} RunStop;
+
 
 
 
@@ -80,6 +127,18 @@ void Rk2( double *vin, double *vout, double tin, double tout, double stephint, d
 void Rk4( double *vin, double *vout, double tin, double tout, double stephint, double accuracy, int n, FILE * slog, SolverInput * si, Input * inp );
 
 
+/** Imex: propagates vin (of size n) from tin to tout by the second order 
+ *         IMEX Runge-Kutta method ARS(2,2,2) with fixed stepsize; diffu-  
+ *         sion and decay are integrated implicitly (one tridiagonal solve 
+ *         per gene and stage), the regulated synthesis explicitly, so     
+ *         that the stepsize is limited by the regulation only; being      
+ *         second order, it needs stepsizes of about 0.1 (-i 0.1) for a    
+ *         chisq within 2e-4 of the exact one (see solvers.c); the         
+ *         result is returned by vout                                      
+ */
+void Imex( double *vin, double *vout, double tin, double tout, double stephint, double accuracy, int n, FILE * slog, SolverInput * si, Input * inp );
+
+
 /** Rkck: propagates vin (of size n) from tin to tout by the Runge-Kutta 
  *         Cash-Karp method, which is an adaptive-stepsize Rk method; it   
  *         uses a fifth-order Rk formula with an embedded forth-oder for-  
@@ -104,6 +163,52 @@ void Rkck( double *vin, double *vout, double tin, double tout, double stephint,
  */
 void Rkf( double *vin, double *vout, double tin, double tout, double stephint, double accuracy, int n, FILE * slog, SolverInput * si, Input * inp );
 
+/** Dopri5: propagates vin (of size n) from tin to tout by the Dormand- 
+ *           Prince 5(4) method, an adaptive Rk method with PI stepsize    
+ *           control and dense output; steps may go beyond tout up to      
+ *           si->tstop and are then continued by the next call if it goes  
+ *           on from tout with the v's returned in vout                    
+ */
+void Dopri5( double *vin, double *vout, double tin, double tout, double stephint, double accuracy, int n, FILE * slog, SolverInput * si, Input * inp );
+
+
+
+/** Rk4Single: Rk4 in single precision (float state and derivatives, see
+ *              DvdtOrigSingle); for screening runs only                   
+ */
+void Rk4Single( double *vin, double *vout, double tin, double tout, double stephint, double accuracy, int n, FILE * slog, SolverInput * si, Input * inp );
+
+
+/** RkckSingle: Rkck in single precision; accuracies below 1e-5 are raised
+ *               to 1e-5, which is about what a float state can resolve    
+ */
+void RkckSingle( double *vin, double *vout, double tin, double tout, double stephint, double accuracy, int n, FILE * slog, SolverInput * si, Input * inp );
+
+
+/** SinglePrecisionSolver: returns the single precision version of solver
+ *                          's' (Rk4Single for Rk4, RkckSingle for Rkck)   
+ *                          if the derivative function is DvdtOrig, NULL   
+ *                          otherwise                                      
+ */
+SolverFunc SinglePrecisionSolver( SolverFunc s );
+
+/* the solver names for -s, for usage and error messages */
+#define SOLVER_NAMES "a,bd,bs,dp,e,h,im,kr,mi,me,r{2,4,ck,f},sd"
+
+/** SolverByName: returns the solver with the -s name 'name' (one of
+ *                 SOLVER_NAMES, or r and m for r4 and mi), NULL if there
+ *                 is none; this is the one list of solver names, so a new
+ *                 solver only has to go in there
+ */
+SolverFunc SolverByName( const char *name );
+
+/** LockstepSolver: returns 1 if solver 's' can integrate several parameter
+ *                   sets in lockstep as one wide system (the fixed step-  
+ *                   size solvers Euler, Meuler, Heun, Rk2 and Rk4, with   
+ *                   DvdtOrig as derivative function), 0 otherwise         
+ */
+int LockstepSolver( SolverFunc s );
+
 
 
 /**    Milne: propagates vin (of size n) from tin to tout by Milne-Simpson 
@@ -179,6 +284,15 @@ void Krylov( double *vin, double *vout, double tin, double tout, double stephint
 
 int InitKrylovVariables( double *vin, int n );
 
+/** NewSolverRun: tells the solvers that a new model run (or an aborted
+ *                one) starts, so Dopri5 doesn't go on from a step of
+ *                the last run; called by Blastoderm() next to NewDerivRun()
+ */
+void NewSolverRun( void );
+
+/** FreeSolvers: frees the memory kept by the solvers between calls */
+void FreeSolvers( void );
+
 int InitBandSolver( realtype tzero, double stephint, double rel_tol, double abs_tol );
 void FreeBandSolver( void );
 
@@ -190,6 +304,51 @@ int my_f_band( realtype t, N_Vector y, N_Vector ydot, void *extra_data );
 /** WriteSolvLog: write to solver log file */
 void WriteSolvLog( char *solver, double tin, double tout, double h, int n, int nderivs, FILE * slog );
 
+/** WriteSolverStats: writes the work done since the snapshot 'since' as
+ *                     tab separated columns (derivative evaluations,
+ *                     accepted and rejected steps, Jacobians, CVODE steps
+ *                     and rhs evaluations, model runs in Score() and their
+ *                     mean time in ms, model runs stopped by their budget)
+ *                     and moves 'since' up to now
+ */
+void WriteSolverStats( FILE * fp, SolverStats * since );
+
+/** StartBudget: puts the next model run, of 'runs' lockstep lanes (1 if
+ *                not in lockstep), on the budget solver_budget (times
+ *                'runs'); the adaptive solvers check it after every step,
+ *                Blastoderm() after every interval
+ */
+void StartBudget( int runs );
+
+/** StopBudget: ends the budget of the current run; returns why it was
+ *               stopped (and counts it in solver_stats.aborted if it was),
+ *               RUN_FINISHED if it wasn't
+ */
+RunStop StopBudget( void );
+
+/** LastStop: why the last run ended by StopBudget() was stopped; reading
+ *             it resets it to RUN_FINISHED, so that a caller can tell its
+ *             own run from older ones
+ */
+RunStop LastStop( void );
+
+/** OverBudget: returns 1 if the current run has been stopped or has just
+ *               gone over its budget, 0 otherwise or if it has no budget
+ */
+int OverBudget( void );
+
+/** AbortRun: stops the current run (e.g. on a stepsize underflow) and
+ *             returns 1 if it is on a budget; returns 0 otherwise, so the
+ *             caller can give up the usual way
+ */
+int AbortRun( void );
+
+/** CheckState: stops the current run (as RUN_DIVERGED) if it is on a
+ *               budget and any of the 'n' concentrations 'v' is not finite
+ *               or beyond solver_budget.max_conc; returns OverBudget()
+ */
+int CheckState( const double *v, int n );
+
 /**
  * Delay solver - by Manu?
  */
@@ -199,8 +358,7 @@ double *Construct_Discont_Array( double range, double *taus, int n, double *star
 
 int compare( double *x, double *y );
 
-int y_delayed( double ***vd, int n, double *rktimes, double *tau, double *grid, double **vdone, double **deriv1, double **deriv2, double **deriv3,
-               double **deriv4, int gridsize, double accu, SolverInput * si, Input * inp );
+int y_delayed( double ***vd, int n, double *rktimes, double *tau, double accu, SolverInput * si, Input * inp );
 
 void DCERk32( double **vatt, int n, double *tarray, int tpoints, double *darray, int dpoints, double stephint, double accuracy, SolverInput * si, Input * inp );
 
@@ -54,7 +54,9 @@
  *
  * The PArrPtr that is returned also includes pointers to the 
  * corresponding parameter ranges for each parameter, although 
- * this feature is not yet used anywhere in the annealing code
+ * this feature is not yet used anywhere in the annealing code; the
+ * limits of all parameters also end up in the flat arrays of 
+ * PArrPtr.bounds (see InitBounds())
  *
  * CAUTION: InitZygote and InitScoring have to be called first!        
  */
@@ -163,5 +165,14 @@ Translate( Input * inp ) {
     // finish up initializing PArrPtr
     plist.size = index;
     plist.array = p;
+
+    /* all parameters tweaked: a parameter vector is the EqParms buffer */
+    plist.identity = ( index == ParmSize( &( inp->zyg.defs ) ) );
+    for( i = 0; plist.identity && i < index; i++ )
+        plist.identity = ( p[i].param == parm->R + i );
+
+    /* the limits of all parameters as flat arrays in the same order */
+    plist.bounds = NULL;
+    InitBounds( inp, &plist );
     return plist;
 }
@@ -19,6 +19,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>             /* for getopt */
+#include <getopt.h>             /* for getopt_long */
 #include <time.h>               /* for time calculation */
 #include <sys/resource.h>       /* for time calculation */
 
@@ -29,19 +30,26 @@
 #include <zygotic.h>
 #include <score.h>
 #include <fly_io.h>
+#include <flysim.h>
 
 
 /*** Constants *************************************************************/
 
 const char *OPTS = ":a:Df:g:Ghi:j:op:r:s:t:vx:z:";      /* cmd line opt string */
 
+/* long options; --serve has no short form, 'S' is only used internally */
+static struct option LONG_OPTS[] = {
+    {"serve", optional_argument, NULL, 'S'},
+    {NULL, 0, NULL, 0}
+};
+
 /*** Help, usage and version messages **************************************/
 
 static const char usage[] =
     "Usage: unfold [-a <accuracy>] [-D] [-f <float_prec>] [-g <g(u)>] [-G]\n"
     "              [-h] [-i <stepsize>] [-j <timefile>] [-o] [-p <pstep>]\n"
     "              [-s <solver>] [-t <time>] [-v] [-x <sect_title>]\n" 
-    "              [-z <gast_time>]\n" 
+    "              [-z <gast_time>] [--serve[=<socket>]]\n" 
     "              <datafile> [<genotype>]\n";
 
 static const char help[] =
@@ -65,7 +73,9 @@ static const char help[] =
     "  -v                  print version and compilation date\n"
     "  -x <sect_title>     uses equation paramters from section <sect_title>\n\n"
     "  -z <gast_time>      set custom gastrulation time (max. 10'000'000 (min));\n"
-    "                      custom gastrulation MUST be later than the normal one\n" "Please report bugs to <yoginho@usa.net>. Thank you!\n";
+    "                      custom gastrulation MUST be later than the normal one\n"
+    "  --serve[=<socket>]  keeps running and answers requests from stdin (or\n"
+    "                      from clients of Unix socket <socket>), see README\n\n" "Please report bugs to <yoginho@usa.net>. Thank you!\n";
 
 // static const char verstring[] =
 //     "%s version %s\n" 
@@ -89,6 +99,24 @@ static const char help[] =
 
 const int OUT_OF_BOUND = -1;
 
+/** TabPrinter: where PrintTab() prints the model output */
+typedef struct TabPrinter {
+    FILE *fp;
+    int ndigits;
+    Zygote *zyg;
+} TabPrinter;
+
+/** PrintTab: prints the output of the model at a tabulated time as soon *
+ *            as BlastodermStream() has it, the same states ConvertAnswer *
+ *            would keep                                                  */
+static void
+PrintTab( double time, const double *state, int size, int final, void *arg ) {
+    TabPrinter *tp = ( TabPrinter * ) arg;
+
+    if( final )
+        PrintBlastodermState( tp->fp, time, state, size, tp->ndigits, tp->zyg );
+}
+
 /** unfold.c main function */
 int
 main( int argc, char **argv ) {
@@ -119,11 +147,18 @@ main( int argc, char **argv ) {
 
     char *section_title;        /* parameter section name */
 
+    int serve = 0;              /* flag for --serve */
+    char *socket_name = NULL;   /* socket for --serve=<socket> */
+    char *solver_name = "r4";           /* solver and g(u) as given by -s and -g */
+    char gofu_name = 0;         /*   for handing them to fly_open() */
+    FlySim *sim;                /* handle for --serve */
+
     /* stuff used as input/output for blastoderm */
 
     NArrPtr answer;             /* model output is stored in this */
     NArrPtr outtab;             /* times to be output */
     NArrPtr goutput;            /* output of guts is stored in this */
+    TabPrinter printer;         /* prints the output as the model runs */
     DArrPtr tt;                 /* array with times for which there's data */
 
     int genindex = 0;           /* genotype index */
@@ -179,7 +214,7 @@ main( int argc, char **argv ) {
     /* modified from original getopt manpage                                   */
 
     optarg = NULL;
-    while( ( c = getopt( argc, argv, OPTS ) ) != -1 )
+    while( ( c = getopt_long( argc, argv, OPTS, LONG_OPTS, NULL ) ) != -1 )
         switch ( c ) {
         case 'a':
             accuracy = atof( optarg );
@@ -198,6 +233,7 @@ main( int argc, char **argv ) {
             break;
         case 'g':              /* -g choose g(u) function */
             pd = DvdtOrig;
+            gofu_name = optarg[0];
             if( !( strcmp( optarg, "s" ) ) )
                 gofu = Sqrt;
             else if( !( strcmp( optarg, "t" ) ) )
@@ -250,36 +286,9 @@ main( int argc, char **argv ) {
             error( "unfold: -r is not supported anymore, use -g instead" );
             break;
         case 's':              /* -s sets solver to be used */
-            if( !( strcmp( optarg, "a" ) ) )
-                ps = Adams;
-            else if( !( strcmp( optarg, "bd" ) ) )
-                ps = BaDe;
-            else if( !( strcmp( optarg, "bs" ) ) )
-                ps = BuSt;
-            else if( !( strcmp( optarg, "e" ) ) )
-                ps = Euler;
-            else if( !( strcmp( optarg, "h" ) ) )
-                ps = Heun;
-            else if( !( strcmp( optarg, "mi" ) ) || !( strcmp( optarg, "m" ) ) )
-                ps = Milne;
-            else if( !( strcmp( optarg, "me" ) ) )
-                ps = Meuler;
-            else if( !( strcmp( optarg, "r4" ) ) || !( strcmp( optarg, "r" ) ) )
-                ps = Rk4;
-            else if( !( strcmp( optarg, "r2" ) ) )
-                ps = Rk2;
-            else if( !( strcmp( optarg, "rck" ) ) )
-                ps = Rkck;
-            else if( !( strcmp( optarg, "rf" ) ) )
-                ps = Rkf;
-            else if( !( strcmp( optarg, "sd" ) ) )
-                ps = SoDe;
-            else if( !( strcmp( optarg, "kr" ) ) )
-                ps = Krylov;
-            /*else if (!(strcmp(optarg, "bnd")))
-               ps = Band; */
-            else
-                error( "unfold: invalid solver (%s), use: a,bd,bs,e,h,kr,mi,me,r{2,4,ck,f}", optarg );
+            solver_name = optarg;
+            if( !( ps = SolverByName( optarg ) ) )
+                error( "unfold: invalid solver (%s), use: " SOLVER_NAMES, optarg );
             break;
         case 't':
             if( timefile )
@@ -290,6 +299,10 @@ main( int argc, char **argv ) {
             if( ( time < 0 ) && ( time != -999999999 ) )
                 error( "unfold: the time (%g) doesn't make sense", time );
             break;
+        case 'S':              /* --serve answers requests, see fly_serve() */
+            serve = 1;
+            socket_name = optarg;
+            break;
         case 'v':              /* -v prints version message */
             //fprintf(stderr, verstring, *argv, VERS, USR, MACHINE, COMPILER, FLAGS, __DATE__, __TIME__);
             exit( 0 );
@@ -320,6 +333,23 @@ main( int argc, char **argv ) {
     if( ( argc - ( optind - 1 ) ) < 2 || ( argc - ( optind - 1 ) ) > 4 )
         PrintMsg( usage, 1 );
 
+    /* --serve: set up once and answer requests until told to stop */
+
+    if( serve ) {
+        sim = fly_open( argv[optind], section_title, solver_name, gofu_name, stepsize, accuracy );
+        if( !sim )
+            error( "unfold: could not set up %s for --serve", argv[optind] );
+        if( socket_name ) {
+            if( fly_serve_socket( sim, socket_name, ndigits ) )
+                error( "unfold: could not listen on socket %s", socket_name );
+        } else {
+            fly_serve( sim, stdin, stdout, ndigits );
+        }
+        fly_close( sim );
+        free( section_title );
+        return 0;
+    }
+
     /* let's get started and open the data file here */
 
     infile = argv[optind];
@@ -478,13 +508,22 @@ main( int argc, char **argv ) {
     }
     free( inp.sco.facts.tt[genindex].ptr.times.array );
     inp.sco.facts.tt[genindex].ptr.times = tt;
-    /* Run the model... */
+    /* Run the model... only debugging needs all of its steps; the guts  *
+     * need the tabulated times, and the plain output is printed as the  *
+     * model goes, so it never holds more than two states                */
 
-    for( i = 0; i < 1; ++i ) {
-        if( i > 0 ) {
-            FreeSolution( &answer );
-        }
+    if( debug )
         answer = Blastoderm( genindex, genotype, &inp, slog );
+    else if( guts )
+        answer = BlastodermStream( genindex, genotype, &inp, slog, NULL, NULL );
+    else {
+        printer.fp = stdout;
+        printer.ndigits = ndigits;
+        printer.zyg = &( inp.zyg );
+        printf( "$output\n\n" );
+        answer = BlastodermStream( genindex, genotype, &inp, slog, PrintTab, &printer );
+        printf( "$$\n" );
+        fflush( stdout );
     }
     /* if debugging: print out the innards of the model to unfold.out */
 
@@ -501,7 +540,12 @@ main( int argc, char **argv ) {
     /* strip output of anything that's not in tt */
     
 
-    outtab = ConvertAnswer( answer, tt );
+    if( debug || guts )
+        outtab = ConvertAnswer( answer, tt );
+    else {
+        outtab.size = 0;
+        outtab.array = NULL;
+    }
  //   printf("HAS TO BE AROUND 241.96 AND IS %lg\n\n", outtab.array[3].state.array[1]); //TESTING FOR BERTA
 
     //printf("outtabsize %d, answersize %d, ttsize %d\n", outtab.size, answer.size, tt.size);
@@ -530,6 +574,9 @@ main( int argc, char **argv ) {
         fakezyg.lin_start = inp.zyg.lin_start;
         fakezyg.defs = inp.zyg.defs;
         fakezyg.full_nnucs = NULL;
+        fakezyg.nlinmaps = 0;
+        fakezyg.lin_gather = NULL;
+        fakezyg.lin_daughters = NULL;
         fakezyg.nnucs = NULL;
         fakezyg.bcdtype = NULL;
         fakezyg.times = inp.zyg.times;
@@ -553,7 +600,7 @@ main( int argc, char **argv ) {
 
         /* code for printing model output */
 
-    } else {
+    } else if( debug ) {
         PrintBlastoderm( stdout, outtab, "output\n", ndigits, &( inp.zyg ) );
     }
 
@@ -566,6 +613,8 @@ main( int argc, char **argv ) {
     FreeSolution( &answer );
     FreeExternalInputs( inp.zyg.nalleles, inp.ext );
     FreeZygote(  );
+    FreeSolvers(  );
+    FreeLanes(  );
     free( extinp_polation );
     free( polation );
     for( i = 0; i < inp.zyg.nalleles; i++ ) {
@@ -586,16 +635,10 @@ main( int argc, char **argv ) {
     free( inp.zyg.defs.egene_ids );
     free( inp.zyg.defs.gene_ids );
     free( inp.zyg.nnucs );
+    FreeLineageMaps( &( inp.zyg ) );
     free( inp.zyg.full_nnucs );
     free( inp.zyg.full_lin_start );
-    free( inp.zyg.parm.E );
-    free( inp.zyg.parm.R );
-    free( inp.zyg.parm.T );
-    free( inp.zyg.parm.d );
-    free( inp.zyg.parm.h );
-    free( inp.zyg.parm.lambda );
-    free( inp.zyg.parm.m );
-    free( inp.zyg.parm.tau );
+    FreeMutant( inp.zyg.parm );
     for( i = 0; i < inp.zyg.nalleles; i++ ) {
         free( inp.zyg.bias.bt[i].genotype );
         free( inp.zyg.bias.bt[i].ptr.times.array );
@@ -39,12 +39,6 @@
 #include "ioTools.h"
 
 
-
-//test
-#include <sys/time.h>           /* for time calculation */
-struct timeval start, end;      /* time_t is defined on <time.h> and <sys/types.h> as long */
-//endtest
-
 // following is a superfast vector square root function available for DEC
 /*#ifdef ALPHA_DU
 extern void vsqrt_();
@@ -60,6 +54,12 @@ const int MITOSIS = 1;
 
 /* diffusion coefficients */
 static double *D;
+static int D_size = 0;          /* D is shared by all Zygotes, keep the largest */
+
+/* bumped by NewDerivRun() at the start of each Blastoderm run; the derivative
+ * functions below cache D and the bicoid gradient and recompute them whenever
+ * the run (and thus genotype, parameters or problem) changes */
+static unsigned long deriv_run = 0;
 
 /* following arrays are used by DvdtOrig */
 double *vinput;                 /* vinput, bot2 and bot are used for */
@@ -97,11 +97,17 @@ InitZygote( FILE * fp, void ( *pd ) ( double *, double, double *, int, SolverInp
     zyg.nalleles = 0;
     zyg.full_lin_start = NULL;
     zyg.full_nnucs = NULL;
+    zyg.nlinmaps = 0;
+    zyg.lin_gather = NULL;
+    zyg.lin_daughters = NULL;
 
 
     /* read equation parameters and the problem */
     zyg.defs = ReadTheProblem( fp );
-    D = ( double * ) calloc( zyg.defs.ngenes, sizeof( double ) );       /* contains info about diffusion sched. */
+    if( zyg.defs.ngenes > D_size ) {    /* contains info about diffusion sched. */
+        D = ( double * ) realloc( D, zyg.defs.ngenes * sizeof( double ) );
+        D_size = zyg.defs.ngenes;
+    }
 
     /* install bicoid and bias and nnucs in maternal.c */
     zyg.bcdtype = InitBicoid( fp, &zyg );
@@ -122,19 +128,25 @@ InitZygote( FILE * fp, void ( *pd ) ( double *, double, double *, int, SolverInp
 void
 FreeZygote( void ) {
     free( D );
+    D = NULL;
+    D_size = 0;
+}
+
+/** NewDerivRun: tells the derivative functions that a new model run 
+ *                starts, so that they don't reuse D and bicoid from the   
+ *                previous one                                             
+ */
+void
+NewDerivRun( void ) {
+    deriv_run++;
 }
 
-/** FreeMutant: frees mutated parameter struct */
+/** FreeMutant: frees mutated parameter struct (or any other one, they 
+ *               all live in a single buffer that starts at R)             
+ */
 void
 FreeMutant( EqParms lparm ) {
     free( lparm.R );
-    free( lparm.T );
-    free( lparm.E );
-    free( lparm.m );
-    free( lparm.h );
-    free( lparm.d );
-    free( lparm.lambda );
-    free( lparm.tau );
 }
 
 /*** DERIVATIVE FUNCTIONS **************************************************/
@@ -184,11 +196,14 @@ DvdtOrig( double *v, double t, double *vdot, int n, SolverInput * si, Input * in
 
     static int num_nucs = 0;    /* store the number of nucs for next step */
     static int bcd_index = 0;   /* the *next* array in bicoid struct for bcd */
+    static unsigned long run = 0;       /* run for which D and bcd are valid */
     static DArrPtr bcd;         /* pointer to appropriate bicoid struct */
     double *v_ext;              /* array to hold the external input
                                    concentrations at time t */
     int allele = si->genindex;
 
+    solver_stats.derivs++;
+
     vinput = ( double * ) calloc( inp->zyg.defs.ngenes * inp->zyg.defs.nnucs, sizeof( double ) );
     bot2 = ( double * ) calloc( inp->zyg.defs.ngenes * inp->zyg.defs.nnucs, sizeof( double ) );
     bot = ( double * ) calloc( inp->zyg.defs.ngenes * inp->zyg.defs.nnucs, sizeof( double ) );
@@ -199,7 +214,8 @@ DvdtOrig( double *v, double t, double *vdot, int n, SolverInput * si, Input * in
     m = n / inp->zyg.defs.ngenes;       /* m is the number of nuclei */
     /* inp->zyg.defs.ngenes is the number of
      * genes per nucleus */
-    if( m != num_nucs ) {       /* time-varying quantities only vary by ccycle */
+    if( m != num_nucs || run != deriv_run ) {   /* time-varying quantities only vary by ccycle */
+        run = deriv_run;
 
         GetD( t, inp->lparm.d, D, &( inp->zyg ) );
         /* get diff coefficients, according to diff schedule */
@@ -254,8 +270,6 @@ DvdtOrig( double *v, double t, double *vdot, int n, SolverInput * si, Input * in
 
     if( gofu == Sqrt ) {
 
-        gettimeofday( &start, NULL );   //start the timer
-
         for( base = 0, base1 = 0, ap = 0; base < n; base += inp->zyg.defs.ngenes, base1 += inp->zyg.defs.egenes, ap++ ) {
             for( i = base; i < base + inp->zyg.defs.ngenes; i++ ) {
 
@@ -272,17 +286,12 @@ DvdtOrig( double *v, double t, double *vdot, int n, SolverInput * si, Input * in
             }
         }
 
-        gettimeofday( &end, NULL );     //start the timer
-        //printf("beforehalfG %ld\n", ((end.tv_sec * 1000000 + end.tv_usec) - (start.tv_sec * 1000000 + start.tv_usec)));
-
 #ifdef ALPHA_DU
         vsqrt_( bot2, &incx, bot, &incy, &n );  /* superfast DEC vector function */
 #else
         for( i = 0; i < n; i++ )        /* slow traditional style sqrt */
             bot[i] = sqrt( bot2[i] );
 #endif
-        gettimeofday( &end, NULL );     //start the timer
-        //printf("halfG %ld\n", ((end.tv_sec * 1000000 + end.tv_usec) - (start.tv_sec * 1000000 + start.tv_usec)));
         /* next loop does the rest of the equation (R, Ds and lambdas) */
         /* store result in vdot[] */
         if( n == inp->zyg.defs.ngenes ) {       /* first part: one nuc, no diffusion */
@@ -329,9 +338,6 @@ DvdtOrig( double *v, double t, double *vdot, int n, SolverInput * si, Input * in
             }
         }
 
-        gettimeofday( &end, NULL );     //start the timer
-        //printf("endG %ld\n", ((end.tv_sec * 1000000 + end.tv_usec) - (start.tv_sec * 1000000 + start.tv_usec)));
-
 
         /***************************************************************************
          *                                                                         *
@@ -667,6 +673,317 @@ DvdtOrig( double *v, double t, double *vdot, int n, SolverInput * si, Input * in
     return;
 }
 
+/** DvdtOrigSingle: single precision version of DvdtOrig for screening runs
+ *                   (see ScreenScore() in score.c); same equations and
+ *                   g(u)'s, but state, derivatives, parameters and all
+ *                   arithmetic are float. The state is transposed to one
+ *                   array per gene, so that all loops below run over the
+ *                   nuclei with unit stride and get vectorized, with twice
+ *                   as many values per vector instruction as in double.
+ *                   Only called by the single precision solvers.
+ */
+void
+DvdtOrigSingle( const float *v, double t, float *vdot, int n, SolverInput * si, Input * inp ) {
+
+    int ngenes = inp->zyg.defs.ngenes;
+    int egenes = inp->zyg.defs.egenes;
+    int m = n / ngenes;         /* number of nuclei */
+    int ap, i, j, k;
+    int allele = si->genindex;
+    float rule;                 /* 0 during mitosis: no regulation */
+    float a, b, c;
+    float *uk, *vk, *dk;
+    DArrPtr bcd;
+
+    static int num_nucs = 0;    /* nuclei for which D and bcd are valid */
+    static unsigned long run = 0;       /* run for which the floats are valid */
+    static int size = 0, psize = 0;     /* allocated workspace and parameters */
+    static float *fT, *fE, *fm, *fh, *fR, *flambda, *fD;        /* float copies of lparm and D */
+    static float *fbcd, *fext, *vs, *u, *ds;    /* per gene: state, u and g(u), vdot */
+    static double *dD, *ext;
+
+    solver_stats.derivs++;
+
+    /* (re)allocate the workspace; it only ever grows */
+    if( ngenes * ( ngenes + egenes + 5 ) > psize ) {
+        psize = ngenes * ( ngenes + egenes + 5 );
+        fT = ( float * ) realloc( fT, psize * sizeof( float ) );
+        dD = ( double * ) realloc( dD, ngenes * sizeof( double ) );
+        if( !fT || !dD )
+            error( "DvdtOrigSingle: could not allocate parameters" );
+        run = deriv_run - 1;    /* pointers below moved: copy again */
+    }
+    fE = fT + ngenes * ngenes;
+    fm = fE + ngenes * egenes;
+    fh = fm + ngenes;
+    fR = fh + ngenes;
+    flambda = fR + ngenes;
+    fD = flambda + ngenes;
+    if( m * ( ngenes + egenes ) > size ) {
+        size = m * ( ngenes + egenes );
+        fbcd = ( float * ) realloc( fbcd, m * sizeof( float ) );
+        fext = ( float * ) realloc( fext, ( m * egenes + 1 ) * sizeof( float ) );
+        ext = ( double * ) realloc( ext, ( m * egenes + 1 ) * sizeof( double ) );
+        vs = ( float * ) realloc( vs, 3 * m * ngenes * sizeof( float ) );
+        if( !fbcd || !fext || !ext || !vs )
+            error( "DvdtOrigSingle: could not allocate workspace" );
+        num_nucs = 0;           /* fbcd moved: get bicoid again */
+    }
+    u = vs + m * ngenes;
+    ds = u + m * ngenes;
+
+    /* parameters of this run (genotype), D and bicoid of this cleavage cycle */
+    if( run != deriv_run ) {
+        for( i = 0; i < ngenes * ngenes; i++ )
+            fT[i] = ( float ) inp->lparm.T[i];
+        for( i = 0; i < ngenes * egenes; i++ )
+            fE[i] = ( float ) inp->lparm.E[i];
+        for( k = 0; k < ngenes; k++ ) {
+            fm[k] = ( float ) inp->lparm.m[k];
+            fh[k] = ( float ) inp->lparm.h[k];
+            fR[k] = ( float ) inp->lparm.R[k];
+            flambda[k] = ( float ) inp->lparm.lambda[k];
+        }
+    }
+    if( m != num_nucs || run != deriv_run ) {
+        run = deriv_run;
+        num_nucs = m;
+        GetD( t, inp->lparm.d, dD, &( inp->zyg ) );
+        for( k = 0; k < ngenes; k++ )
+            fD[k] = ( float ) dD[k];
+        bcd = GetBicoid( t, allele, inp->zyg.bcdtype, &( inp->zyg ) );
+        if( bcd.size != m )
+            error( "DvdtOrigSingle: %d nuclei don't match Bicoid!", m );
+        for( ap = 0; ap < m; ap++ )
+            fbcd[ap] = ( float ) bcd.array[ap];
+    }
+    rule = Theta( t, &( inp->zyg ) ) ? 0.f : 1.f;
+
+    /* external inputs and state, one array per gene */
+    ExternalInputs( t, t, ext, m * egenes, inp->ext[allele], egenes, &( inp->zyg ) );
+    for( ap = 0; ap < m; ap++ )
+        for( j = 0; j < egenes; j++ )
+            fext[j * m + ap] = ( float ) ext[ap * egenes + j];
+    for( ap = 0; ap < m; ap++ )
+        for( k = 0; k < ngenes; k++ )
+            vs[k * m + ap] = v[ap * ngenes + k];
+
+    /* u = h + m * bcd + E * ext + T * v */
+    for( k = 0; k < ngenes; k++ ) {
+        uk = u + k * m;
+        a = fh[k];
+        b = fm[k];
+        for( ap = 0; ap < m; ap++ )
+            uk[ap] = a + b * fbcd[ap];
+        for( j = 0; j < egenes; j++ ) {
+            a = fE[k * egenes + j];
+            vk = fext + j * m;
+            for( ap = 0; ap < m; ap++ )
+                uk[ap] += a * vk[ap];
+        }
+        for( j = 0; j < ngenes; j++ ) {
+            a = fT[k * ngenes + j];
+            vk = vs + j * m;
+            for( ap = 0; ap < m; ap++ )
+                uk[ap] += a * vk[ap];
+        }
+    }
+
+    /* g(u), in place; it includes the factor 1/2 of the sqrt and tanh forms */
+    if( gofu == Sqrt ) {
+        for( i = 0; i < n; i++ )
+            u[i] = 0.5f + 0.5f * u[i] / sqrtf( 1.f + u[i] * u[i] );
+    } else if( gofu == Tanh ) {
+        for( i = 0; i < n; i++ )
+            u[i] = 0.5f * ( tanhf( u[i] ) + 1.f );
+    } else if( gofu == Exp ) {
+        for( i = 0; i < n; i++ )
+            u[i] = 1.f / ( 1.f + expf( -2.f * u[i] ) );
+    } else if( gofu == Hvs ) {
+        for( i = 0; i < n; i++ )
+            u[i] = ( u[i] >= 0.f ) ? 1.f : 0.f;
+    } else if( gofu != Kolja )  /* Kolja: g(u) = u */
+        error( "DvdtOrigSingle: unknown g(u)" );
+
+    /* decay, regulation and diffusion (none through the walls) */
+    for( k = 0; k < ngenes; k++ ) {
+        vk = vs + k * m;
+        uk = u + k * m;
+        dk = ds + k * m;
+        a = -flambda[k];
+        b = rule * fR[k];
+        c = fD[k];
+        for( ap = 0; ap < m; ap++ )
+            dk[ap] = a * vk[ap] + b * uk[ap];
+        if( m > 1 ) {
+            dk[0] += c * ( vk[1] - vk[0] );
+            for( ap = 1; ap < m - 1; ap++ )
+                dk[ap] += c * ( ( vk[ap - 1] - vk[ap] ) + ( vk[ap + 1] - vk[ap] ) );
+            dk[m - 1] += c * ( vk[m - 2] - vk[m - 1] );
+        }
+    }
+
+    for( ap = 0; ap < m; ap++ )
+        for( k = 0; k < ngenes; k++ )
+            vdot[ap * ngenes + k] = ds[k * m + ap];
+}
+
+
+
+/** DvdtOrigBatch: DvdtOrig for si->lanes parameter sets at once (see 
+ *                  BlastodermBatch() in integrate.c); v and vdot hold the  
+ *                  state of lane c of gene k in nucleus ap at              
+ *                  [(ap * ngenes + k) * lanes + c] and the parameters of   
+ *                  the lanes are in si->lparms. The parameters are kept    
+ *                  lane-innermost as well, so that the loops over the      
+ *                  lanes get vectorized. Each lane does the same arith-    
+ *                  metic as DvdtOrig, in the same order.                   
+ */
+void
+DvdtOrigBatch( double *v, double t, double *vdot, int n, SolverInput * si, Input * inp ) {
+
+    int ngenes = inp->zyg.defs.ngenes;
+    int egenes = inp->zyg.defs.egenes;
+    int K = si->lanes;
+    int m = n / ( ngenes * K ); /* number of nuclei */
+    int ap, i, j, k, c;
+    int allele = si->genindex;
+    int l_rule;                 /* 0 during mitosis: no regulation */
+    int size;
+    double a, vdot1;
+    double *u, *vi, *vdi, *va, *vp, *T, *E, *Dk;
+    EqParms *lp = si->lparms;
+
+    static int num_nucs = 0;    /* nuclei for which D and bcd are valid */
+    static unsigned long run = 0;       /* run for which the parameters are valid */
+    static int lanes = 0, psize = 0, esize = 0;
+    static double *pT, *pE, *pm, *ph, *pR, *plambda, *pD;      /* parameters [..][lane] */
+    static double *Dc, *v_ext, *ulane;
+    static DArrPtr bcd;
+
+    solver_stats.derivs += K;
+
+    /* (re)allocate the parameter and work arrays; they only ever grow */
+    size = ngenes * ( ngenes + egenes + 5 ) * K;
+    if( size > psize || K > lanes ) {
+        psize = size > psize ? size : psize;
+        lanes = K > lanes ? K : lanes;
+        pT = ( double * ) realloc( pT, psize * sizeof( double ) );
+        Dc = ( double * ) realloc( Dc, ngenes * sizeof( double ) );
+        ulane = ( double * ) realloc( ulane, lanes * sizeof( double ) );
+        if( !pT || !Dc || !ulane )
+            error( "DvdtOrigBatch: could not allocate parameters" );
+        run = deriv_run - 1;    /* pointers below moved: copy again */
+    }
+    pE = pT + ngenes * ngenes * K;
+    pm = pE + ngenes * egenes * K;
+    ph = pm + ngenes * K;
+    pR = ph + ngenes * K;
+    plambda = pR + ngenes * K;
+    pD = plambda + ngenes * K;
+    if( m * egenes + 1 > esize ) {
+        esize = m * egenes + 1;
+        v_ext = ( double * ) realloc( v_ext, esize * sizeof( double ) );
+        if( !v_ext )
+            error( "DvdtOrigBatch: could not allocate external inputs" );
+    }
+
+    /* parameters of this run (genotype), D and bicoid of this cleavage cycle */
+    if( run != deriv_run ) {
+        for( c = 0; c < K; c++ ) {
+            for( i = 0; i < ngenes * ngenes; i++ )
+                pT[i * K + c] = lp[c].T[i];
+            for( i = 0; i < ngenes * egenes; i++ )
+                pE[i * K + c] = lp[c].E[i];
+            for( k = 0; k < ngenes; k++ ) {
+                pm[k * K + c] = lp[c].m[k];
+                ph[k * K + c] = lp[c].h[k];
+                pR[k * K + c] = lp[c].R[k];
+                plambda[k * K + c] = lp[c].lambda[k];
+            }
+        }
+    }
+    if( m != num_nucs || run != deriv_run ) {
+        run = deriv_run;
+        num_nucs = m;
+        for( c = 0; c < K; c++ ) {
+            GetD( t, lp[c].d, Dc, &( inp->zyg ) );
+            for( k = 0; k < ngenes; k++ )
+                pD[k * K + c] = Dc[k];
+        }
+        bcd = GetBicoid( t, allele, inp->zyg.bcdtype, &( inp->zyg ) );
+        if( bcd.size != m )
+            error( "DvdtOrigBatch: %d nuclei don't match Bicoid!", m );
+    }
+    l_rule = !( Theta( t, &( inp->zyg ) ) );
+    ExternalInputs( t, t, v_ext, m * egenes, inp->ext[allele], egenes, &( inp->zyg ) );
+
+    u = ulane;
+    for( ap = 0; ap < m; ap++ ) {
+        for( k = 0; k < ngenes; k++ ) {
+            i = ( ap * ngenes + k ) * K;        /* first lane of gene k in nucleus ap */
+            vi = v + i;
+            vdi = vdot + i;
+
+            /* u, summed up in the same order as in DvdtOrig */
+            for( c = 0; c < K; c++ )
+                u[c] = ph[k * K + c] + pm[k * K + c] * bcd.array[ap];
+            for( j = 0; j < egenes; j++ ) {
+                E = pE + ( k * egenes + j ) * K;
+                a = v_ext[ap * egenes + j];
+                for( c = 0; c < K; c++ )
+                    u[c] += E[c] * a;
+            }
+            for( j = 0; j < ngenes; j++ ) {
+                T = pT + ( k * ngenes + j ) * K;
+                for( c = 0; c < K; c++ )
+                    u[c] += T[c] * v[( ap * ngenes + j ) * K + c];
+            }
+
+            /* g(u) as in DvdtOrig, without the factor 1/2 of sqrt and tanh */
+            a = 1.;
+            if( gofu == Sqrt ) {
+                a = 0.5;
+                for( c = 0; c < K; c++ )
+                    u[c] = 1 + u[c] / sqrt( 1 + u[c] * u[c] );
+            } else if( gofu == Tanh ) {
+                a = 0.5;
+                for( c = 0; c < K; c++ )
+                    u[c] = tanh( u[c] ) + 1;
+            } else if( gofu == Exp ) {
+                for( c = 0; c < K; c++ )
+                    u[c] = 1 / ( 1 + exp( -2.0 * u[c] ) );
+            } else if( gofu == Hvs ) {
+                for( c = 0; c < K; c++ )
+                    u[c] = ( u[c] >= 0. ) ? 1. : 0.;
+            }
+
+            /* decay and regulation */
+            for( c = 0; c < K; c++ ) {
+                vdot1 = -plambda[k * K + c] * vi[c];
+                vdot1 += l_rule * pR[k * K + c] * a * u[c];
+                vdi[c] = vdot1;
+            }
+
+            /* diffusion; none through the walls */
+            if( m == 1 )
+                continue;
+            Dk = pD + k * K;
+            va = ( ap > 0 ) ? vi - ngenes * K : vi;     /* same gene, anterior */
+            vp = ( ap < m - 1 ) ? vi + ngenes * K : vi; /* and posterior nucleus */
+            if( ap == 0 )
+                for( c = 0; c < K; c++ )
+                    vdi[c] += Dk[c] * ( vp[c] - vi[c] );
+            else if( ap == m - 1 )
+                for( c = 0; c < K; c++ )
+                    vdi[c] += Dk[c] * ( va[c] - vi[c] );
+            else
+                for( c = 0; c < K; c++ )
+                    vdi[c] += Dk[c] * ( ( va[c] - vi[c] ) + ( vp[c] - vi[c] ) );
+        }
+    }
+}
+
 
 
 /*** JACOBIAN FUNCTION(S) **************************************************/
@@ -702,6 +1019,14 @@ DvdtOrig( double *v, double t, double *vdot, int n, SolverInput * si, Input * in
  *         Yab = Rg'(u)                                                    
  *         Da  = D{a}                                                      
  *                                                                         
+ * Only the three block diagonals are stored: jac has 3 * ngenes rows of   
+ * ngenes per nucleus i, the block left of the diagonal (coupling to nuc-  
+ * leus i-1, rows 3i*ngenes...), the diagonal block and the block right of 
+ * it (coupling to nucleus i+1); entries that are always zero (the off-    
+ * diagonals of the D blocks, the left block of the first nucleus and the  
+ * right block of the last) are not written, so jac has to be zeroed by    
+ * the caller.                                                             
+ *                                                                         
  */
 void
 JacobnOrig( double t, double *v, double *dfdt, double **jac, int n, SolverInput * si, Input * inp ) {
@@ -720,8 +1045,8 @@ JacobnOrig( double t, double *v, double *dfdt, double **jac, int n, SolverInput
 
     static int num_nucs = 0;    /* store the number of nucs for next step */
     static int bcd_index = 0;   /* the *next* array in bicoid struct for bcd */
-    DArrPtr bcd = ( const struct DArrPtr ){ 0 }; 
-                                /* pointer to appropriate bicoid struct */
+    static unsigned long run = 0;       /* run for which D and bcd are valid */
+    static DArrPtr bcd;         /* pointer to appropriate bicoid struct */
 
     int allele = si->genindex;
 
@@ -732,7 +1057,8 @@ JacobnOrig( double t, double *v, double *dfdt, double **jac, int n, SolverInput
     /* get D parameters and bicoid gradient according to cleavage cycle */
 
     m = n / inp->zyg.defs.ngenes;       /* m is the number of nuclei */
-    if( m != num_nucs ) {       /* time-varying quantities only vary by ccycle */
+    if( m != num_nucs || run != deriv_run ) {   /* time-varying quantities only vary by ccycle */
+        run = deriv_run;
         GetD( t, inp->lparm.d, D, &( inp->zyg ) );
         /* get diff coefficients, according to diff schedule */
         if( num_nucs > m )      /* started a new iteration in score */
@@ -819,15 +1145,15 @@ JacobnOrig( double t, double *v, double *dfdt, double **jac, int n, SolverInput
                                 vdot1 -= inp->lparm.lambda[k];
                             }
                         }
-                        jac[i][j] = vdot1;
+                        jac[3 * base + inp->zyg.defs.ngenes + k][kk] = vdot1;
 
                     }
 
                     if( base > 0 )
-                        jac[i][i - inp->zyg.defs.ngenes] = D[k];
+                        jac[3 * base + k][k] = D[k];
 
                     if( base < n - inp->zyg.defs.ngenes )
-                        jac[i][i + inp->zyg.defs.ngenes] = D[k];
+                        jac[3 * base + 2 * inp->zyg.defs.ngenes + k][k] = D[k];
 
                 }
             }
@@ -902,15 +1228,15 @@ JacobnOrig( double t, double *v, double *dfdt, double **jac, int n, SolverInput
                                 vdot1 -= inp->lparm.lambda[k];
                             }
                         }
-                        jac[i][j] = vdot1;
+                        jac[3 * base + inp->zyg.defs.ngenes + k][kk] = vdot1;
 
                     }
 
                     if( base > 0 )
-                        jac[i][i - inp->zyg.defs.ngenes] = D[k];
+                        jac[3 * base + k][k] = D[k];
 
                     if( base < n - inp->zyg.defs.ngenes )
-                        jac[i][i + inp->zyg.defs.ngenes] = D[k];
+                        jac[3 * base + 2 * inp->zyg.defs.ngenes + k][k] = D[k];
 
                 }
             }
@@ -950,15 +1276,15 @@ JacobnOrig( double t, double *v, double *dfdt, double **jac, int n, SolverInput
                         vdot1 = 0.;
                     }
 
-                    jac[i][j] = vdot1;
+                    jac[3 * base + inp->zyg.defs.ngenes + k][kk] = vdot1;
 
                 }
 
                 if( base > 0 )
-                    jac[i][i - inp->zyg.defs.ngenes] = D[k];
+                    jac[3 * base + k][k] = D[k];
 
                 if( base < n - inp->zyg.defs.ngenes )
-                    jac[i][i + inp->zyg.defs.ngenes] = D[k];
+                    jac[3 * base + 2 * inp->zyg.defs.ngenes + k][k] = D[k];
 
             }
         }
@@ -1108,6 +1434,7 @@ CalcRhs( double *v, double t, double *guts, int n, int gn, int numguts, int whic
 
     static int num_nucs = 0;    // store the number of nucs for next step
     static int bcd_index = 0;   // the *next* array in bicoid struct for bcd
+    static unsigned long run = 0;       // run for which D and bcd are valid
 
     static DArrPtr bcd;         // pointer to appropriate bicoid struct
     double *v_ext;              // array to hold the external input concentrations at time t
@@ -1121,7 +1448,8 @@ CalcRhs( double *v, double t, double *guts, int n, int gn, int numguts, int whic
 
     m = n / inp->zyg.defs.ngenes;       // m is the current number of nuclei
 
-    if( m != num_nucs ) {
+    if( m != num_nucs || run != deriv_run ) {
+        run = deriv_run;
         GetD( t, inp->lparm.d, D, &( inp->zyg ) );
         num_nucs = m;
         bcd = GetBicoid( t, allele, inp->zyg.bcdtype, &( inp->zyg ) );
@@ -1411,14 +1739,24 @@ GetGutsComps( char *geneidstring, char *egeneidstring, char **specsin, unsigned
 /** Mutate: calls mutator functions according to genotype string */
 EqParms
 Mutate( char *g_type, EqParms parm, TheProblem * defs ) {
+    EqParms lparm;
+
+    lparm = AllocParm( defs );  /* make local copy of parameters to be mutated */
+    MutateParm( g_type, parm, &lparm, defs );
+    return lparm;
+}
+
+/** MutateParm: like Mutate, but into the buffer of 'lparm' */
+void
+MutateParm( char *g_type, EqParms parm, EqParms * lparm, TheProblem * defs ) {
     int i;
     int c;
 
     char *record;
 
-    EqParms lparm;
-
-    lparm = CopyParm( parm, defs );     /* make local copy of parameters to be mutated */
+    /* lay it out again, the buffer may have been used for another problem */
+    *lparm = LayParm( lparm->R, defs );
+    memcpy( lparm->R, parm.R, ParmSize( defs ) * sizeof( double ) );
 
     record = g_type;
     c = ( int ) *record;
@@ -1427,15 +1765,14 @@ Mutate( char *g_type, EqParms parm, TheProblem * defs ) {
         if( c == 'W' )
             continue;
         else if( c == 'R' )
-            R_Mutate( i, &lparm );
+            R_Mutate( i, lparm );
         else if( c == 'S' )
-            RT_Mutate( i, defs->ngenes, &lparm );
+            RT_Mutate( i, defs->ngenes, lparm );
         else if( c == 'T' )
-            T_Mutate( i, defs->ngenes, &lparm );
+            T_Mutate( i, defs->ngenes, lparm );
         else
             error( "Mutate: unrecognized letter in genotype string!" );
     }
-    return lparm;
 }
 
 /** T_Mutate: mutates genes by setting all their T matrix entries 
@@ -1477,45 +1814,50 @@ RT_Mutate( int gene, int ngenes, EqParms * lparm ) {
     /* Don't need to zero param.thresh in (trans acting) mutants */
 }
 
-/** CopyParm: copies all the parameters into the lparm struct */
+/** ParmSize: number of doubles in the buffer of an EqParms struct */
+int
+ParmSize( TheProblem * defs ) {
+    int nd = ( ( defs->diff_schedule == 'A' ) || ( defs->diff_schedule == 'C' ) ) ? 1 : defs->ngenes;
+
+    return defs->ngenes * ( 5 + defs->ngenes + defs->egenes ) + nd;
+}
+
+/** LayParm: points the arrays of an EqParms struct into 'buf' */
 EqParms
-CopyParm( EqParms orig_parm, TheProblem * defs ) {
-    int i, j;                   /* local loop counters */
+LayParm( double *buf, TheProblem * defs ) {
+    EqParms l_parm;
+
+    l_parm.R = buf;
+    l_parm.T = l_parm.R + defs->ngenes;
+    l_parm.E = l_parm.T + defs->ngenes * defs->ngenes;
+    l_parm.m = l_parm.E + defs->ngenes * defs->egenes;
+    l_parm.h = l_parm.m + defs->ngenes;
+    l_parm.d = l_parm.h + defs->ngenes;
+    if( ( defs->diff_schedule == 'A' ) || ( defs->diff_schedule == 'C' ) )
+        l_parm.lambda = l_parm.d + 1;
+    else
+        l_parm.lambda = l_parm.d + defs->ngenes;
+    l_parm.tau = l_parm.lambda + defs->ngenes;
+    return l_parm;
+}
 
-    EqParms l_parm;             /* copy of parm struct to be returned */
+/** AllocParm: allocates an EqParms struct with all parameters zero */
+EqParms
+AllocParm( TheProblem * defs ) {
+    double *buf;
 
-    l_parm.R = ( double * ) calloc( defs->ngenes, sizeof( double ) );
-    l_parm.T = ( double * ) calloc( defs->ngenes * defs->ngenes, sizeof( double ) );
-    l_parm.E = ( double * ) calloc( defs->ngenes * defs->egenes, sizeof( double ) );
-    l_parm.m = ( double * ) calloc( defs->ngenes, sizeof( double ) );
-    l_parm.h = ( double * ) calloc( defs->ngenes, sizeof( double ) );
-    if( ( defs->diff_schedule == 'A' ) || ( defs->diff_schedule == 'C' ) ) {
-        l_parm.d = ( double * ) malloc( sizeof( double ) );
-    } else {
-        l_parm.d = ( double * ) calloc( defs->ngenes, sizeof( double ) );
-    }
-    l_parm.lambda = ( double * ) calloc( defs->ngenes, sizeof( double ) );
-    l_parm.tau = ( double * ) calloc( defs->ngenes, sizeof( double ) );
-
-    for( i = 0; i < defs->ngenes; i++ ) {
-        l_parm.R[i] = orig_parm.R[i];
-        for( j = 0; j < defs->ngenes; j++ )
-            l_parm.T[( i * defs->ngenes ) + j] = orig_parm.T[( i * defs->ngenes ) + j];
-        for( j = 0; j < defs->egenes; j++ )
-            l_parm.E[( i * defs->egenes ) + j] = orig_parm.E[( i * defs->egenes ) + j];
-        l_parm.m[i] = orig_parm.m[i];
-        l_parm.h[i] = orig_parm.h[i];
-        l_parm.lambda[i] = orig_parm.lambda[i];
-        l_parm.tau[i] = orig_parm.tau[i];
-    }
+    if( !( buf = ( double * ) calloc( ParmSize( defs ), sizeof( double ) ) ) )
+        error( "AllocParm: could not allocate parameters" );
+    return LayParm( buf, defs );
+}
 
-    if( ( defs->diff_schedule == 'A' ) || ( defs->diff_schedule == 'C' ) ) {
-        l_parm.d[0] = orig_parm.d[0];
-    } else {
-        for( i = 0; i < defs->ngenes; i++ )
-            l_parm.d[i] = orig_parm.d[i];
-    }
+/** CopyParm: copies all the parameters into the lparm struct */
+EqParms
+CopyParm( EqParms orig_parm, TheProblem * defs ) {
+    EqParms l_parm;             /* copy of parm struct to be returned */
 
+    l_parm = AllocParm( defs );
+    memcpy( l_parm.R, orig_parm.R, ParmSize( defs ) * sizeof( double ) );
     return l_parm;
 }
 
@@ -1561,18 +1903,22 @@ DvdtDelay( double *v, double **vd, double t, double *vdot, int n, SolverInput *
 
     static int num_nucs = 0;    /* store the number of nucs for next step */
     static int bcd_index = 0;   /* the *next* array in bicoid struct for bcd */
+    static unsigned long run = 0;       /* run for which D and bcd are valid */
     static DArrPtr bcd;         /* pointer to appropriate bicoid struct */
     double **v_ext;             /* array to hold the external input
                                    concentrations at time t */
     int allele = si->genindex;
 
+    solver_stats.derivs++;
+
     vinput = ( double * ) calloc( inp->zyg.defs.ngenes * inp->zyg.defs.nnucs, sizeof( double ) );
     bot2 = ( double * ) calloc( inp->zyg.defs.ngenes * inp->zyg.defs.nnucs, sizeof( double ) );
     bot = ( double * ) calloc( inp->zyg.defs.ngenes * inp->zyg.defs.nnucs, sizeof( double ) );
 
     /* get D parameters and bicoid gradient according to cleavage cycle */
     m = n / inp->zyg.defs.ngenes;       /* m is the number of nuclei */
-    if( m != num_nucs ) {       /* time-varying quantities only vary by ccycle */
+    if( m != num_nucs || run != deriv_run ) {   /* time-varying quantities only vary by ccycle */
+        run = deriv_run;
         GetD( t, inp->lparm.d, D, &( inp->zyg ) );
         /* get diff coefficients, according to diff schedule */
         if( num_nucs > m )      /* started a new iteration in score */
@@ -2115,10 +2461,15 @@ Dvdt_sqrt( double *v, double t, double *vdot, int n, SolverInput * si, Input * i
     static int num_nucs = 0;
     // the next array in bicoid struct for Bcd
     static int bcd_index = 0;
+    // run for which D and bcd are valid
+    static unsigned long run = 0;
     // pointer to appropriate bicoid struct
     static DArrPtr bcd;
 
-    if( num_nucs != MM ) {
+    solver_stats.derivs++;
+
+    if( num_nucs != MM || run != deriv_run ) {
+        run = deriv_run;
         // get D parameters according to cleavage cycle
         // NOTE: time-varying quantities only vary by ccycle
         GetD( t, inp->lparm.d, D, &( inp->zyg ) );
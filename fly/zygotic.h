@@ -77,7 +77,15 @@ Zygote InitZygote( FILE * fp, void ( *pd ) (  ), void ( *pj ) (  ), Input * inp,
 /** FreeZygote: frees memory for D */
 void FreeZygote( void );
 
-/** FreeMutant: frees mutated parameter struct */
+/** NewDerivRun: tells the derivative functions that a new model run 
+ *                starts, so that they don't reuse D and bicoid from the   
+ *                previous one                                             
+ */
+void NewDerivRun( void );
+
+/** FreeMutant: frees mutated parameter struct (or any other one, they 
+ *               all live in a single buffer that starts at R)             
+ */
 void FreeMutant( EqParms lparm );
 
 
@@ -92,6 +100,18 @@ void FreeMutant( EqParms lparm );
  */
 void DvdtOrig( double *v, double t, double *vdot, int n, SolverInput * si, Input * inp );
 
+/** DvdtOrigSingle: single precision (float) version of DvdtOrig, used by
+ *                   the single precision solvers for screening runs
+ */
+void DvdtOrigSingle( const float *v, double t, float *vdot, int n, SolverInput * si, Input * inp );
+
+/** DvdtOrigBatch: DvdtOrig for si->lanes parameter sets integrated in 
+ *                  lockstep (see BlastodermBatch() in integrate.c); the    
+ *                  lanes of a gene in a nucleus are next to each other in  
+ *                  v and vdot, their parameters are in si->lparms          
+ */
+void DvdtOrigBatch( double *v, double t, double *vdot, int n, SolverInput * si, Input * inp );
+
 /**  DvdtDelay: the delay derivative function; implements the equations 
  *             as discussed in the delay report,                    
  *             plus different g(u) functions.					    
@@ -155,6 +175,9 @@ void Dvdt_diffusion( double *v, double t, double *vdot, int n, int m, double *D,
  *         Yab = Rg'(u)                                                    
  *         Da  = D{a}                                                      
  *                                                                         
+ * jac only holds the three block diagonals, 3 * ngenes rows of ngenes     
+ * per nucleus (see zygotic.c); it has to be zeroed by the caller          
+ *                                                                         
  */
 void JacobnOrig( double t, double *v, double *dfdt, double **jac, int n, SolverInput * si, Input * inp );
 
@@ -202,6 +225,12 @@ char *GetGutsComps( char *geneidstring, char *egeneidstring, char **specsin, uns
 /** Mutate: calls mutator functions according to genotype string */
 EqParms Mutate( char *g_type, EqParms parm, TheProblem * defs );
 
+/** MutateParm: like Mutate, but overwrites the parameters in 'lparm'  
+ *               (an EqParms of the same problem) instead of allocating    
+ *               new ones                                                  
+ */
+void MutateParm( char *g_type, EqParms parm, EqParms * lparm, TheProblem * defs );
+
 /** T_Mutate: mutates genes by setting all their T matrix entries 
  *             to zero. Used to simulate mutants that express a   
  *             non-functional protein.                            
@@ -223,6 +252,21 @@ void R_Mutate( int gene, EqParms * lparm );
  */
 void RT_Mutate( int gene, int ngenes, EqParms * lparm );
 
+/** ParmSize: number of doubles in the buffer of an EqParms struct */
+int ParmSize( TheProblem * defs );
+
+/** LayParm: points the arrays of an EqParms struct into the buffer 'buf'
+ *            of ParmSize() doubles, one after the other in the order R,   
+ *            T, E, m, h, d, lambda, tau (the order of Translate())        
+ */
+EqParms LayParm( double *buf, TheProblem * defs );
+
+/** AllocParm: allocates an EqParms struct in a single buffer, see       
+ *              LayParm(); all EqParms are allocated like this, so that    
+ *              CopyParm() and MutateParm() can copy them in one go        
+ */
+EqParms AllocParm( TheProblem * defs );
+
 /** CopyParm: copies all the parameters into the lparm struct */
 EqParms CopyParm( EqParms orig_parm, TheProblem * defs );
 
@@ -115,6 +115,7 @@ void deallocate_ssParam(SSType *ssParams){
 
 	free(ssParams->min_real_var);
 	free(ssParams->max_real_var);
+	free(ssParams->dist_weights);
 
 	for (int i = 0; i < ssParams->nreal; ++i){
 		free(ssParams->freqs_matrix[i]);
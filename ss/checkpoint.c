@@ -0,0 +1,132 @@
+/**
+ *
+ *   @file checkpoint.c
+ *
+ *****************************************************************
+ *
+ *   writing and restoring checkpoints of a Scatter Search run
+ *
+ *   A checkpoint holds everything that changes during the main
+ *   loop (iteration and stats counters, Reference Set, frequency
+ *   and probability matrices, random generator state and the
+ *   length of the log files), so that a resumed run continues
+ *   exactly where the checkpointed run was. The file format and
+ *   the writer thread are in utils/checkpoint.c.
+ *
+ */
+
+#include "ss.h"
+#include "error.h"
+#include "checkpoint.h"
+
+
+/**
+ * @brief      Serialize the state of the search and hand it over to the background
+ * checkpoint writer. It should be called at the end of an iteration.
+ *
+ * @param      ssParams  The ss parameters
+ */
+void write_checkpoint(SSType *ssParams){
+
+	CkptBuffer *b = NewCkptBuffer("ss");
+
+	/* Dimensions, only used for checking that the checkpoint fits the run */
+	CkptPut(b, &(ssParams->nreal), sizeof(int));
+	CkptPut(b, &(ssParams->ref_set_size), sizeof(int));
+	CkptPut(b, &(ssParams->p), sizeof(int));
+
+	/* Counters */
+	CkptPut(b, &(ssParams->n_iter), sizeof(int));
+	CkptPut(b, &(ssParams->n_refinement), sizeof(int));
+	CkptPut(b, &(ssParams->n_ref_set_update), sizeof(int));
+	CkptPut(b, &(ssParams->n_duplicates), sizeof(int));
+	CkptPut(b, &(ssParams->n_flatzone_detected), sizeof(int));
+	CkptPut(b, &(ssParams->n_function_evals), sizeof(int));
+	CkptPut(b, &(ssParams->n_regen), sizeof(int));
+	CkptPut(b, &(ssParams->n_duplicate_replaced), sizeof(int));
+
+	CkptPut(b, &(ssParams->last_n_ref_set_update), sizeof(int));
+	CkptPut(b, &(ssParams->last_n_refinement), sizeof(int));
+	CkptPut(b, &(ssParams->last_n_duplicates), sizeof(int));
+	CkptPut(b, &(ssParams->last_n_function_evals), sizeof(int));
+	CkptPut(b, &(ssParams->last_n_flatzone_detected), sizeof(int));
+
+	/* Reference Set, `best` always points to its first member */
+	for (int i = 0; i < ssParams->ref_set_size; ++i){
+		CkptPut(b, ssParams->ref_set->members[i].params, ssParams->nreal * sizeof(double));
+		CkptPut(b, &(ssParams->ref_set->members[i].cost), sizeof(double));
+	}
+
+	for (int i = 0; i < ssParams->nreal; ++i){
+		CkptPut(b, ssParams->freqs_matrix[i], ssParams->p * sizeof(int));
+		CkptPut(b, ssParams->probs_matrix[i], ssParams->p * sizeof(double));
+	}
+
+	CkptPutRand(b);
+
+	CkptPutLog(b, stats_file);
+	CkptPutHist(b, ref_set_history_log);
+	CkptPutHist(b, best_sols_history_log);
+	CkptPutLog(b, freqs_matrix_file);
+
+	WriteCheckpoint(b, ssParams->checkpoint_filename);
+}
+
+/**
+ * @brief      Restore the state of the search from `ssParams->checkpoint_filename`.
+ * It assumes that `init_ssParams` and `init_report_files` are already called.
+ *
+ * @param      ssParams  The ss parameters
+ */
+void restore_checkpoint(SSType *ssParams){
+
+	int nreal, ref_set_size, p;
+
+	printf("Resuming from %s...\n", ssParams->checkpoint_filename);
+
+	CkptBuffer *b = ReadCheckpoint(ssParams->checkpoint_filename, "ss");
+
+	CkptGet(b, &nreal, sizeof(int));
+	CkptGet(b, &ref_set_size, sizeof(int));
+	CkptGet(b, &p, sizeof(int));
+	if (nreal != ssParams->nreal || ref_set_size != ssParams->ref_set_size || p != ssParams->p)
+		error("restore_checkpoint: checkpoint was written for a different problem or ss section");
+
+	CkptGet(b, &(ssParams->n_iter), sizeof(int));
+	CkptGet(b, &(ssParams->n_refinement), sizeof(int));
+	CkptGet(b, &(ssParams->n_ref_set_update), sizeof(int));
+	CkptGet(b, &(ssParams->n_duplicates), sizeof(int));
+	CkptGet(b, &(ssParams->n_flatzone_detected), sizeof(int));
+	CkptGet(b, &(ssParams->n_function_evals), sizeof(int));
+	CkptGet(b, &(ssParams->n_regen), sizeof(int));
+	CkptGet(b, &(ssParams->n_duplicate_replaced), sizeof(int));
+
+	CkptGet(b, &(ssParams->last_n_ref_set_update), sizeof(int));
+	CkptGet(b, &(ssParams->last_n_refinement), sizeof(int));
+	CkptGet(b, &(ssParams->last_n_duplicates), sizeof(int));
+	CkptGet(b, &(ssParams->last_n_function_evals), sizeof(int));
+	CkptGet(b, &(ssParams->last_n_flatzone_detected), sizeof(int));
+
+	for (int i = 0; i < ssParams->ref_set_size; ++i){
+		CkptGet(b, ssParams->ref_set->members[i].params, ssParams->nreal * sizeof(double));
+		CkptGet(b, &(ssParams->ref_set->members[i].cost), sizeof(double));
+	}
+	ssParams->best = &(ssParams->ref_set->members[0]);
+
+	for (int i = 0; i < ssParams->nreal; ++i){
+		CkptGet(b, ssParams->freqs_matrix[i], ssParams->p * sizeof(int));
+		CkptGet(b, ssParams->probs_matrix[i], ssParams->p * sizeof(double));
+	}
+
+	CkptGetRand(b);
+
+	/* Drop whatever was logged after the checkpoint was taken */
+	CkptGetLog(b, stats_file);
+	CkptGetHist(b, ref_set_history_log);
+	CkptGetHist(b, best_sols_history_log);
+	CkptGetLog(b, freqs_matrix_file);
+
+	FreeCkptBuffer(b);
+
+	printf("Continuing after iteration %d, best cost: %lf\n", ssParams->n_iter, ssParams->best->cost);
+}
@@ -27,12 +27,8 @@
  */
 double objective_function( double *s, SSType *ssParams, Input *inp, ScoreOutput *out ) {
 
-	/* copy array of individual into another */
-    for ( int i = 0; i < inp->tra.size; ++i ) {
-        *( inp->tra.array[i].param  ) = s[i];
-    }
-
-    Score( inp, out, 0 );
+    /* out of bounds is rejected before the parameters go into the model */
+    ScoreParams( inp, s, out );
     ssParams->n_function_evals++;
     return out->score + out->penalty;
 }
@@ -46,6 +42,27 @@ void evaluate_ind(SSType *ssParams, individual *ind, Input *inp,
 	ind->cost = objective_function(ind->params, ssParams, inp, out);
 }
 
+/**
+ * @brief      What the master needs to score parameter sets itself while the
+ * workers of the farm are busy, see farm_score()
+ */
+typedef struct FarmLocal {
+	Input *inp;
+	ScoreOutput *out;
+} FarmLocal;
+
+/**
+ * @brief      Like objective_function(), for FarmEvaluate(); the function
+ * evaluations are counted by evaluate_set()
+ */
+static double farm_score( const double *s, void *arg ) {
+
+	FarmLocal *local = (FarmLocal *)arg;
+
+	ScoreParams( local->inp, s, local->out );
+	return local->out->score + local->out->penalty;
+}
+
 /**
  * @brief      Evaluate cost of each individual in a set
  * 
@@ -53,8 +70,106 @@ void evaluate_ind(SSType *ssParams, individual *ind, Input *inp,
  */
 void evaluate_set(SSType *ssParams, Set *set, int set_size, Input *inp, ScoreOutput *out) {
 
+	if ( ssParams->farm ){
+		// Hand the set to the workers, the master scores what it can meanwhile
+		double **params = (double **)malloc(set_size * sizeof(double *));
+		double *cost = (double *)malloc(set_size * sizeof(double));
+		FarmLocal local = { inp, out };
+
+		for (int i = 0; i < set_size; ++i)
+			params[i] = set->members[i].params;
+		FarmEvaluate(ssParams->farm, params, set_size, cost, farm_score, &local);
+		for (int i = 0; i < set_size; ++i)
+			set->members[i].cost = cost[i];
+		ssParams->n_function_evals += set_size;
+
+		free(params);
+		free(cost);
+		return;
+	}
+
+	if ( ssParams->lockstep > 1 ){
+		// Run the model for `lockstep` individuals at once
+		double **params = (double **)malloc(set_size * sizeof(double *));
+		double *cost = (double *)malloc(set_size * sizeof(double));
+
+		for (int i = 0; i < set_size; ++i)
+			params[i] = set->members[i].params;
+		for (int i = 0; i < set_size; i += ssParams->lockstep)
+			ScoreBatch(inp, params + i, MIN(ssParams->lockstep, set_size - i), cost + i);
+		for (int i = 0; i < set_size; ++i)
+			set->members[i].cost = cost[i];
+		ssParams->n_function_evals += set_size;
+
+		free(params);
+		free(cost);
+		return;
+	}
+
 	for (int i = 0; i < set_size; ++i)
 	{
 		evaluate_ind(ssParams, &(set->members[i]), inp, out);
 	}
 }
+
+/**
+ * @brief      Evaluate the cost of each individual in a set with the single
+ * precision solver, see ScreenScore(). The costs are only good for ranking,
+ * members that may enter the Reference Set have to go through rescore_set().
+ *
+ * @return     Number of individuals that were really scored in single
+ * precision; 0 means the solver or the model has no single precision version.
+ */
+int screen_set(SSType *ssParams, Set *set, int set_size, Input *inp, ScoreOutput *out) {
+
+	int n_single = 0;
+
+	for (int i = 0; i < set_size; ++i)
+	{
+		for (int j = 0; j < inp->tra.size; ++j)
+			*( inp->tra.array[j].param ) = set->members[i].params[j];
+
+		n_single += ScreenScore(inp, out);
+		ssParams->n_function_evals++;
+		set->members[i].cost = out->score + out->penalty;
+	}
+	return n_single;
+}
+
+/**
+ * @brief      Evaluate the best members of a screened set whose (single
+ * precision) cost is below `threshold` again in double precision. The set is
+ * sorted by its screening cost first; members below `threshold` beyond the
+ * first `limit` ones get `threshold` as their cost, so that they cannot enter
+ * the Reference Set with an inexact cost.
+ *
+ * @param      n_rescored  Number of evaluated members
+ *
+ * @return     Rank agreement (Spearman) of the single and double precision
+ * costs of the evaluated members.
+ */
+double rescore_set(SSType *ssParams, Set *set, int set_size, double threshold, int limit, Input *inp, ScoreOutput *out, int *n_rescored) {
+
+	double *single = (double *)malloc(set_size * sizeof(double));
+	double *full = (double *)malloc(set_size * sizeof(double));
+	double rho;
+	int n = 0;
+
+	quick_sort_set(ssParams, set, set_size);
+	for (int i = 0; i < set_size && set->members[i].cost < threshold; ++i)
+	{
+		if ( n == limit ){
+			set->members[i].cost = threshold;
+			continue;
+		}
+		single[n] = set->members[i].cost;
+		evaluate_ind(ssParams, &(set->members[i]), inp, out);
+		full[n++] = set->members[i].cost;
+	}
+	rho = RankAgreement(single, full, n);
+
+	free(single);
+	free(full);
+	*n_rescored = n;
+	return rho;
+}
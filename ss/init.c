@@ -37,6 +37,12 @@ void init_ssParams(SSType *ssParams){
 	ssParams->n_duplicate_replaced = 0;
 	ssParams->n_iter = 0;
 
+	ssParams->last_n_ref_set_update    = 0;
+	ssParams->last_n_refinement        = 0;
+	ssParams->last_n_duplicates        = 0;
+	ssParams->last_n_function_evals    = 0;
+	ssParams->last_n_flatzone_detected = 0;
+
 	// Initialize the Reference Set
 	ssParams->ref_set             = (Set *)malloc(sizeof(Set));
 	allocate_set_memory(ssParams, ssParams->ref_set, ssParams->ref_set_size, ssParams->nreal);
@@ -60,6 +66,13 @@ void init_ssParams(SSType *ssParams){
 	ssParams->freqs_matrix        = (int **)malloc(ssParams->nreal * sizeof(int *));
 	ssParams->probs_matrix        = (double **)malloc(ssParams->nreal * sizeof(double *));
 	
+	// Weighting parameters by 1 / range^2 puts them on the same scale in distances
+	ssParams->dist_weights = NULL;
+	if ( ssParams->perform_normalize_distances ){
+		ssParams->dist_weights = (double *)malloc(ssParams->nreal * sizeof(double));
+		DistWeights(ssParams->min_real_var, ssParams->max_real_var, ssParams->nreal, ssParams->dist_weights);
+	}
+
 	// Generating the sub regions matrixes
 	ssParams->min_boundary_matrix = (double **)malloc( ssParams->nreal * sizeof(double *));
 	ssParams->max_boundary_matrix = (double **)malloc( ssParams->nreal * sizeof(double *));
@@ -109,19 +122,20 @@ void init_report_files(SSType *ssParams, Files *files) {
 #endif
 	char *temp_fname = (char *) calloc(MAX_RECORD + 1, sizeof(char));
 	char *mode = "w";
-	if (ssParams->perform_warm_start)
+	if (ssParams->perform_warm_start || ssParams->perform_resume)
 		mode = "a+";
 
+	/* Checkpoint lives next to the other output files */
+	ssParams->checkpoint_filename = (char *) calloc(MAX_RECORD + 1, sizeof(char));
+	sprintf(ssParams->checkpoint_filename, "%s.ckpt", files->outputfile);
+
 #ifdef DEBUG
-	sprintf(temp_fname, "%s_ref_history", files->outputfile);
-	ref_set_history_file = fopen(temp_fname, mode);
-    if( !ref_set_history_file )
-        file_error( "fly_X error opening refset history file" );
-
-	sprintf(temp_fname, "%s_best_history", files->outputfile);
-	best_sols_history_file = fopen(temp_fname, mode);
-    if( !best_sols_history_file )
-        file_error( "fly_X error opening best history file" );
+	/* Binary logs, written in the background; convert them with histlog2txt */
+	sprintf(temp_fname, "%s_ref_history.bin", files->outputfile);
+	ref_set_history_log = OpenHistLog(temp_fname, ssParams->nreal, mode[0] == 'a');
+
+	sprintf(temp_fname, "%s_best_history.bin", files->outputfile);
+	best_sols_history_log = OpenHistLog(temp_fname, ssParams->nreal, mode[0] == 'a');
 #endif
 
 #ifdef STATS
@@ -135,7 +149,10 @@ void init_report_files(SSType *ssParams, Files *files) {
 	stats_file = fopen(temp_fname, mode);
     if( !stats_file )
         file_error( "fly_X error opening statistics log file" );
-	write_stats_header(stats_file);
+
+	/* A resumed run continues the log of the checkpointed run */
+	if (!ssParams->perform_resume)
+		write_stats_header(stats_file);
 
 	free(temp_fname);
 }	
@@ -230,62 +247,45 @@ void init_ref_set(SSType *ssParams){
 	/************************************************************/
 	/* Expanding the ref_set by applying the diversity distance */
 	/************************************************************/
-	
-	// dist_matrix will store the distances between the rest of scatter_set and the ref_set
-	double **dist_matrix = (double **)malloc( (m - h) * sizeof(double *));;
-	for (int i = 0; i < (m - h); ++i){
-		dist_matrix[i] = (double *)malloc( (b) * sizeof(double));
-	}
-
-	double *min_dists = (double *)malloc((m - h) * sizeof(double));
 
-	int min_index = 0;
-	int max_index = 0;
+	// Each step adds the member of the rest of the scatter_set whose minimum distance to
+	// the ref_set is maximal; MaxMinSelect keeps these minimum distances up to date
+	// instead of recomputing the whole distance matrix after each selection.
+	double **selected = (double **)malloc( h * sizeof(double *));
+	double **rest = (double **)malloc( (m - h) * sizeof(double *));
+	int *picked = (int *)malloc( (b - h) * sizeof(int));
+	char *is_picked = (char *)calloc( (m - h), sizeof(char));
 
-	int i = 0;
-	for (int k = h; k < b; ++k, --m)		// Iterate through the ref_set for expanding
-	{										// --m reduces the depth that the second `for` should go through it
-											// since the array is being shifted to the left after each iteration
+	for (int i = 0; i < h; ++i)
+		selected[i] = ssParams->ref_set->members[i].params;
+	for (int i = h; i < m; ++i)
+		rest[i - h] = ssParams->scatter_set->members[i].params;
 
-		for (i = h; i < m; ++i)				// Iterate through the rest of scatter_set
-		{							 
+	MaxMinSelect(selected, h, rest, m - h, b - h, ssParams->dist_weights, ssParams->nreal, picked);
 
-			for (int j = 0; j < k; ++j)		// Iterate trhough the selected members of ref_set
-			{								
-				/* Computing the distance */
-				dist_matrix[i - (b / 2)][j] = euclidean_distance(ssParams, &(ssParams->scatter_set->members[i]), &(ssParams->ref_set->members[j]));
-			}
+	for (int k = h; k < b; ++k){
+		copy_ind(ssParams, &(ssParams->ref_set->members[k]), &(ssParams->scatter_set->members[h + picked[k - h]]));
+		is_picked[picked[k - h]] = 1;
+	}
 
-			// Find the minimum of each row into a new variable, then finding it's max
-			min_dists[i - (b / 2)] = min(dist_matrix[i - (b / 2)], k, &min_index);
+	// The selected members are taken out of the scatter_set, the rest is shifted to the left
+	int left = h;
+	for (int i = h; i < m; ++i){
+		if ( !is_picked[i - h] ){
+			if ( left != i )
+				copy_ind(ssParams, &(ssParams->scatter_set->members[left]), &(ssParams->scatter_set->members[i]));
+			left++;
 		}
-		
-		// Now, the min_dists of vectors to all the members of R is computed,
-		// we could compute the maximum of them and also it's index
-		
-		// Finding the place of the max/min distance
-		max(min_dists, i - (b / 2), &max_index); 
-
-		// Adding the vector in max_index to the ref_set
-		copy_ind(ssParams, &(ssParams->ref_set->members[k]), &(ssParams->scatter_set->members[h + max_index]));
-
-		// After assigment, the rest of should be shift into the left form the position that the 
-		// vector is selected
-		
-		// It could be done more complicated!
-		delete_and_shift(ssParams, ssParams->scatter_set, ssParams->scatter_set_size, (b / 2) + max_index);
-
 	}
 
 	#ifdef STATS
 		write_int_matrix(ssParams, ssParams->freqs_matrix, ssParams->nreal, ssParams->p, freqs_matrix_file, 0, 'w');
 	#endif
 
-	free(min_dists);
-	for (int i = 0; i < (ssParams->scatter_set_size - b/2); ++i){
-		free(dist_matrix[i]);
-	}
-	free(dist_matrix);
+	free(selected);
+	free(rest);
+	free(picked);
+	free(is_picked);
 }
 
 /**
@@ -50,6 +50,28 @@ void write_ind(SSType *ssParams, individual *ind, int member_length, FILE *fpt,
 
 }
 
+/**
+ * @brief      Queue a Set in a binary history log. The records are written by the
+ * log's background thread, use `histlog2txt` to get the `write_set` text format.
+ *
+ */
+void log_set(SSType *ssParams, Set *set, int set_size, HistLog *log, int iter){
+
+	for (int i = 0; i < set_size; ++i)
+	{
+		log_ind(ssParams, &(set->members[i]), log, iter);
+	}
+}
+
+/**
+ * @brief      Queue an individual in a binary history log
+ *
+ */
+void log_ind(SSType *ssParams, individual *ind, HistLog *log, int iter){
+
+	HistLogWrite(log, iter, ind->params, ind->cost);
+}
+
 /**
  * @brief      Print a Set to the terminal
  *
@@ -196,11 +218,11 @@ void write_double_matrix(SSType *ssParams, double **matrix, int row, int col, FI
 }
 
 /**
- * @brief      Use WriteParameters() function to write paramters of Reference Set to 
- * individual output file. Output file names is genrated based on the ssParams->inname (input file name)
- * as follow: 'inname_parm_%6d.fout'
+ * @brief      Write paramters of Reference Set to individual output files
+ * 'outputfile_ref_%02d'. The output file is read once into a template (see
+ * ReadParmTemplate()) and every member only gets its own $eqparms section.
  *
- * @param      inp       Input struct to be modified and passed to WriteParamters()
+ * @param      inp       Input struct to be modified and passed to WriteParmTemplate()
  */
 void write_refset_eqparms( SSType *ssParams, Files *files, Input *inp ){
 
@@ -209,7 +231,14 @@ void write_refset_eqparms( SSType *ssParams, Files *files, Input *inp ){
 
 	/* File name */    
     char *out_fname= (char *) calloc(MAX_RECORD + 1, sizeof(char));
-    char *shell_cmd= (char *) calloc(MAX_RECORD + 1, sizeof(char));
+    char seed[MAX_RECORD];
+
+    ParmTemplate *tmpl = ReadParmTemplate( files->outputfile, "eqparms" );
+
+    // Replacing the seed in the output file with the random seed drawn.
+    // Only if seed set to [random]
+    sprintf( seed, "\nseed:\n%d\n", ssParams->seed );
+    ReplaceInTemplate( tmpl, "\nseed:\n[random]\n", seed );
 
     for(int i = 0; i < ssParams->ref_set_size; i++ )
     {
@@ -219,23 +248,12 @@ void write_refset_eqparms( SSType *ssParams, Files *files, Input *inp ){
         	*(ptab[h].param) = ssParams->ref_set->members[i].params[h];
         }
 
-        /* Copy input file to the one we want to change */
         sprintf( out_fname, "%s_ref_%02d", files->outputfile, i );
-        sprintf( shell_cmd, "cp -f %s %s", files->outputfile, out_fname );
-		if( -1 == system( shell_cmd ) )
-	        error( "WriteParameters: error writing output file" );
-
-        WriteParameters(out_fname, &(inp->zyg.parm), "eqparms", 8, inp->zyg.defs);
-
-        // Replacing the seed in the output file with the random seed drawn.
-        // Only if seed set to [random]
-        sprintf( shell_cmd, "perl -0pi -e 's/$ss\nseed:\n\\[random\\]\n/$ss\nseed:\n%d\n/' %s", ssParams->seed, out_fname );
-        if( -1 == system( shell_cmd ) )
-	        error( "WriteParameters: could not replace random seed" );
+        WriteParmTemplate( tmpl, out_fname, &(inp->zyg.parm), "eqparms", 8, inp->zyg.defs );
     } //End of for loop
     
+    FreeParmTemplate( tmpl );
     free(out_fname);
-    free(shell_cmd);
 }
 
 /**
@@ -243,7 +261,7 @@ void write_refset_eqparms( SSType *ssParams, Files *files, Input *inp ){
  */
 void write_stats_header( FILE *fp ) {
 
-	fprintf( fp, "# %s %s %s %s %s %s %s %s %s %s\n", 
+	fprintf( fp, "# %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s\n", 
 		"Iterations", 
 		"Accumulated_function_evaluations",
 		"Min_cost_refset",
@@ -253,6 +271,15 @@ void write_stats_header( FILE *fp ) {
 		"Local_searches",
 		"Flatzones",
 		"Duplicates",
-		"Candidate_set_size" );
+		"Candidate_set_size",
+		"Derivative_evaluations",
+		"Solver_steps",
+		"Rejected_steps",
+		"Jacobian_evaluations",
+		"CVODE_steps",
+		"CVODE_rhs_evaluations",
+		"Model_runs",
+		"Mean_score_time_ms",
+		"Aborted_model_runs" );
 	fflush( fp );
 }
@@ -8,9 +8,12 @@
  */
 
 #include "ss.h"
+#include "checkpoint.h"
+#include "solvers.h"
+#include "error.h"
 
-FILE *ref_set_history_file;
-FILE *best_sols_history_file;
+HistLog *ref_set_history_log;
+HistLog *best_sols_history_log;
 FILE *freqs_matrix_file;
 FILE *freq_mat_final_file;
 FILE *prob_mat_final_file;
@@ -51,12 +54,29 @@ void InitSS(Input *inp, SSType *ssParams, Files *files){
 	// Allocate memory of ssParams variables, and initialize some parameters
 	init_ssParams(ssParams);
 
-	if ( !ssParams->perform_warm_start ){
+	if ( ssParams->perform_resume ){
+		// Everything, including the random generator, comes from the checkpoint
+		restore_checkpoint(ssParams);
+	}
+	else if ( !ssParams->perform_warm_start ){
 
 		init_scatter_set(ssParams, ssParams->scatter_set);
-		evaluate_set(ssParams, ssParams->scatter_set, ssParams->scatter_set_size, inp, &out);
+		if ( !ssParams->perform_screening )
+			evaluate_set(ssParams, ssParams->scatter_set, ssParams->scatter_set_size, inp, &out);
+		else if ( !screen_set(ssParams, ssParams->scatter_set, ssParams->scatter_set_size, inp, &out) ){
+			warning("InitSS: solver has no single precision version, no screening");
+			ssParams->perform_screening = 0;
+		}
 
 		init_ref_set(ssParams);
+
+		// The refSet was picked by the screening costs, now it gets the exact ones
+		if ( ssParams->perform_screening ){
+			int n;
+			double rho = rescore_set(ssParams, ssParams->ref_set, ssParams->ref_set_size, HUGE_VAL,
+				ssParams->ref_set_size, inp, &out, &n);
+			printf("Screening: rank agreement of single and double precision costs %.3f (%d sets)\n", rho, n);
+		}
 		quick_sort_set(ssParams, ssParams->ref_set, ssParams->ref_set_size);
 
 		// Initialize the best solution
@@ -73,8 +93,10 @@ void InitSS(Input *inp, SSType *ssParams, Files *files){
 	}	
 
 #ifdef DEBUG
-	write_set(ssParams, ssParams->ref_set, ssParams->ref_set_size, ssParams->nreal, ref_set_history_file, 0, 'w');
-	write_ind(ssParams, ssParams->best, ssParams->nreal, best_sols_history_file, 0, 'w');
+	if ( !ssParams->perform_resume ){
+		log_set(ssParams, ssParams->ref_set, ssParams->ref_set_size, ref_set_history_log, 0);
+		log_ind(ssParams, ssParams->best, best_sols_history_log, 0);
+	}
 #endif
 }
 
@@ -86,23 +108,39 @@ void InitSS(Input *inp, SSType *ssParams, Files *files){
  */
 void RunSS(Input *inp, SSType *ssParams, Files *files){
 
-	int n_ref_set_update    = 0;
-	int n_refinement        = 0;
-	int n_duplicates        = 0;
-	int n_function_evals    = 0;
-	int n_flatzone_detected = 0;
+	int n_ref_set_update    = ssParams->last_n_ref_set_update;
+	int n_refinement        = ssParams->last_n_refinement;
+	int n_duplicates        = ssParams->last_n_duplicates;
+	int n_function_evals    = ssParams->last_n_function_evals;
+	int n_flatzone_detected = ssParams->last_n_flatzone_detected;
+	SolverStats work        = solver_stats;	/* solver work since the last stats line */
+	double screen_rho       = 0;	/* rank agreement of the screened candidates, */
+	int screen_n            = 0;	/* weighted by the number of rescored ones */
 	// bool wasChanged = false;
 
 	printf("Starting the optimization procedure...\n");
-	for (ssParams->n_iter = 1; ssParams->n_iter < ssParams->max_iter; 
-		++ssParams->n_iter)
+	for (ssParams->n_iter = (ssParams->perform_resume ? ssParams->n_iter + 1 : 1); 
+		ssParams->n_iter < ssParams->max_iter; ++ssParams->n_iter)
 	{
 		// Selecting the SubSets List
 		select_subsets_list(ssParams, ssParams->ref_set, ssParams->ref_set_size);
 
 		// Generate new candidates
 		generate_candiates(ssParams);
-		evaluate_set(ssParams, ssParams->candidates_set, ssParams->candidates_set_size, inp, &out);
+		if ( ssParams->perform_screening && ssParams->n_iter <= ssParams->screen_iters ){
+			// Only candidates that can make it into the refSet (at most ref_set_size) need their exact cost
+			int n;
+			screen_set(ssParams, ssParams->candidates_set, ssParams->candidates_set_size, inp, &out);
+			double rho = rescore_set(ssParams, ssParams->candidates_set, ssParams->candidates_set_size,
+				ssParams->ref_set->members[ssParams->ref_set_size - 1].cost, ssParams->ref_set_size, inp, &out, &n);
+			screen_rho += rho * n;
+			screen_n += n;
+			if ( ssParams->n_iter == ssParams->screen_iters || ssParams->n_iter == ssParams->max_iter - 1 )
+				printf("Screening: rank agreement of single and double precision costs %.3f (%d candidates)\n",
+					screen_n ? screen_rho / screen_n : 1., screen_n);
+		}
+		else
+			evaluate_set(ssParams, ssParams->candidates_set, ssParams->candidates_set_size, inp, &out);
 
 		// Update refSet by replacing new candidates
 		update_ref_set(ssParams);
@@ -115,15 +153,12 @@ void RunSS(Input *inp, SSType *ssParams, Files *files){
 		quick_sort_set(ssParams, ssParams->ref_set, ssParams->ref_set_size);
 		
 #ifdef DEBUG
-		// Append the ref_set to the file
-		write_set(ssParams, ssParams->ref_set, ssParams->ref_set_size, 
-			ssParams->nreal, ref_set_history_file, ssParams->n_iter, 'w');
-		fflush(ref_set_history_file);
-
-		// Append the best solution to the sol history file
-		write_ind(ssParams, ssParams->best, ssParams->nreal, 
-			best_sols_history_file, ssParams->n_iter, 'w');
-		fflush(best_sols_history_file);
+		// Append the ref_set to the history log
+		log_set(ssParams, ssParams->ref_set, ssParams->ref_set_size, 
+			ref_set_history_log, ssParams->n_iter);
+
+		// Append the best solution to the sol history log
+		log_ind(ssParams, ssParams->best, best_sols_history_log, ssParams->n_iter);
 #endif
 
 		// It basically check if all refSet members are in the same flat zone.
@@ -156,7 +191,7 @@ void RunSS(Input *inp, SSType *ssParams, Files *files){
 
 		/* output some basic statistics to log file */
 		if (ssParams->n_iter % 10 == 0) {
-			fprintf(stats_file, "%d\t%d\t%g\t%g\t%g\t%d\t%d\t%d\t%d\t%d\n", 
+			fprintf(stats_file, "%d\t%d\t%g\t%g\t%g\t%d\t%d\t%d\t%d\t%d\t", 
 				ssParams->n_iter, 
 				ssParams->n_function_evals/* -  n_function_evals*/,
 				ssParams->best->cost,
@@ -167,6 +202,8 @@ void RunSS(Input *inp, SSType *ssParams, Files *files){
 				ssParams->n_flatzone_detected -  n_flatzone_detected, 
 				ssParams->n_duplicates -  n_duplicates, 
 				ssParams->candidates_set_size);
+			WriteSolverStats(stats_file, &work);
+			fputc('\n', stats_file);
 
 #ifdef DEBUG
 			/* in debug mode we want it all immediately on disk */
@@ -190,15 +227,28 @@ void RunSS(Input *inp, SSType *ssParams, Files *files){
 			n_duplicates        = ssParams->n_duplicates;
 			n_function_evals    = ssParams->n_function_evals;
 			n_flatzone_detected = ssParams->n_flatzone_detected;
+
+			ssParams->last_n_ref_set_update    = n_ref_set_update;
+			ssParams->last_n_refinement        = n_refinement;
+			ssParams->last_n_duplicates        = n_duplicates;
+			ssParams->last_n_function_evals    = n_function_evals;
+			ssParams->last_n_flatzone_detected = n_flatzone_detected;
 		}
+
+		/* Periodic checkpoint, written in the background */
+		if (ssParams->checkpoint_freq > 0 && ssParams->n_iter % ssParams->checkpoint_freq == 0)
+			write_checkpoint(ssParams);
 	} // End of the main loop
 
+	/* Make sure the last checkpoint is on disk before we go on */
+	WaitCheckpoint();
+
 	/* AC: We do a last local search on the refset */
 	refine_set(ssParams, ssParams->ref_set, ssParams->ref_set_size, 'n', inp, &out);
 	quick_sort_set(ssParams, ssParams->ref_set, ssParams->ref_set_size);
 
 	/* Final output of basic statistics to log file */
-	fprintf(stats_file, "%d\t%d\t%g\t%g\t%g\t%d\t%d\t%d\t%d\t%d\n",
+	fprintf(stats_file, "%d\t%d\t%g\t%g\t%g\t%d\t%d\t%d\t%d\t%d\t",
 		ssParams->n_iter, 
 		ssParams->n_function_evals/* -  n_function_evals*/,
 		ssParams->best->cost,
@@ -209,6 +259,8 @@ void RunSS(Input *inp, SSType *ssParams, Files *files){
 		ssParams->n_flatzone_detected -  n_flatzone_detected, 
 		ssParams->n_duplicates -  n_duplicates, 
 		ssParams->candidates_set_size);
+	WriteSolverStats(stats_file, &work);
+	fputc('\n', stats_file);
 	/* Mark end-of-file */
 	fprintf(stats_file, "#eof\n");
 
@@ -241,11 +293,14 @@ void RunSS(Input *inp, SSType *ssParams, Files *files){
 
 	/* Write refset as output configuration files */
 	write_refset_eqparms(ssParams, files, inp);
+	if (ssParams->final_costs)
+		for (int i = 0; i < ssParams->ref_set_size; ++i)
+			ssParams->final_costs[i] = ssParams->ref_set->members[i].cost;
 	deallocate_ssParam(ssParams);
 
 #ifdef DEBUG
-	fclose(ref_set_history_file);
-	fclose(best_sols_history_file);
+	CloseHistLog(ref_set_history_log);
+	CloseHistLog(best_sols_history_log);
 #endif
 #ifdef STATS
 	fclose(freqs_matrix_file);
@@ -19,6 +19,9 @@
 
 #include "maternal.h"
 #include "../utils/random.h"
+#include "../utils/histlog.h"
+#include "../utils/distance.h"
+#include "../utils/farm.h"
 
 /* AC: Nelder-Mead local search */
 #include <gsl/gsl_rng.h>
@@ -116,8 +119,16 @@ typedef struct SSType
 	int candidates_set_size;			//!< Set of Candidate Set
 	
 	double dist_epsilon;				//!< Minimum Euclidean distance between two parameters vectors
+	int perform_normalize_distances;	//!< Whether to measure distances relative to the parameter ranges (`--normalize-distances`)
+	double *dist_weights;				//!< Per parameter weights used by the distance kernels, `NULL` for plain Euclidean distances
 	double fitness_epsilon;	 			//!< Minimum difference between the cost of two individuals
 
+	int perform_screening;				//!< Whether to screen parameter sets in single precision first (`--screen`)
+	int screen_iters;					//!< Number of iterations whose candidates are screened; the Scatter Set always is
+	int lockstep;						//!< Number of parameter sets evaluate_set() runs at once, see ScoreBatch() (`--lockstep`)
+	Farm *farm;							//!< Workers evaluate_set() hands its sets to (`--farm`), `NULL` for none
+	double *final_costs;				//!< If not `NULL`, RunSS() leaves the costs of the final refSet here (`--ensemble`)
+
 	int perform_ref_set_regen;			//!< Whether the Reference Set should be regenrated during the optimization or not.
 	int ref_set_regen_freq;				//!< The frequency of performing regenration on Reference Set.
 
@@ -130,6 +141,12 @@ typedef struct SSType
 	int n_function_evals;				//!< Number of function objective function evaluations
 	int n_regen;						//!< Number of refSet regenration performed
 	int n_duplicate_replaced;			//!< Number of duplicate ::individual being detected and replaced during the process
+
+	int last_n_ref_set_update;			//!< Value of `n_ref_set_update` at the last report in the stats file
+	int last_n_refinement;				//!< Value of `n_refinement` at the last report in the stats file
+	int last_n_duplicates;				//!< Value of `n_duplicates` at the last report in the stats file
+	int last_n_function_evals;			//!< Value of `n_function_evals` at the last report in the stats file
+	int last_n_flatzone_detected;		//!< Value of `n_flatzone_detected` at the last report in the stats file
 	
 	int **freqs_matrix;					//!< Frequencies of parameters being in sub-regions
 	double **probs_matrix;				//!< Probabilities of parameters being in sub-regions
@@ -140,6 +157,10 @@ typedef struct SSType
 
 	int perform_warm_start;				//!< Whether to perform warm start or not
 
+	int perform_resume;					//!< Whether to continue a run from its checkpoint (`--resume`)
+	int checkpoint_freq;				//!< Write a checkpoint every `checkpoint_freq` iterations, 0 disables checkpointing
+	char *checkpoint_filename;			//!< Filename of the checkpoint: `<outputfile>.ckpt`
+
 
 	int perform_flatzone_detection;		//!< Whether to detect if an individual is in a flat zone during the optimization or not
 
@@ -174,8 +195,8 @@ typedef struct SSType
 /*
 				Output Files [Global]
  */
-extern FILE *ref_set_history_file;
-extern FILE *best_sols_history_file;
+extern HistLog *ref_set_history_log;
+extern HistLog *best_sols_history_log;
 extern FILE *freqs_matrix_file;
 extern FILE *freq_mat_final_file;
 extern FILE *prob_mat_final_file;
@@ -263,10 +284,16 @@ void parse_int_row(SSType *ssParams, char *line, int *row);
 void init_warm_start(SSType *ssParams);
 void matrix_product(SSType *ssParams, double **A, int a_row, int a_col, double **B, int b_row, int b_col, double **P, int p_row, int p_col);
 
+// checkpoint.c
+void write_checkpoint(SSType *ssParams);
+void restore_checkpoint(SSType *ssParams);
+
 // report.c
 void init_report_files(SSType *ssParams, Files *files);
 void write_set(SSType *ssParams, Set *set, int set_size, int member_length, FILE *fpt, int iter, char mode);
 void write_ind(SSType *ssParams, individual *ind,  int member_length, FILE *fpt, int iter, char mode);
+void log_set(SSType *ssParams, Set *set, int set_size, HistLog *log, int iter);
+void log_ind(SSType *ssParams, individual *ind, HistLog *log, int iter);
 void print_set(SSType *ssParams, Set *set, int set_size, int member_length);
 void print_ind(SSType *ssParams, individual *ind, int member_length);
 void print_subsets_list(SSType *ssParams);
@@ -287,5 +314,7 @@ double var_cost_refset(SSType *ssParams, Set *set, int set_size);
 double objective_function(double *s, SSType *ssParams, Input *inp, ScoreOutput *out);
 void evaluate_ind(SSType *ssParams, individual *ind, Input *inp, ScoreOutput *out);
 void evaluate_set(SSType *ssParams, Set *set, int set_size, Input *inp, ScoreOutput *out);
+int screen_set(SSType *ssParams, Set *set, int set_size, Input *inp, ScoreOutput *out);
+double rescore_set(SSType *ssParams, Set *set, int set_size, double threshold, int limit, Input *inp, ScoreOutput *out, int *n_rescored);
 
 #endif
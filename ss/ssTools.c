@@ -26,16 +26,12 @@
 // }
 
 /**
- *	@brief Compute the Eculidean Distance between two individuals
+ *	@brief Compute the Eculidean Distance between two individuals. With
+ *	`--normalize-distances` each parameter is measured relative to its range.
  */
 double euclidean_distance(SSType *ssParams, individual *ind1, individual *ind2){
 
-	double distance = 0;
-	for (int i = 0; i < ssParams->nreal; ++i)
-	{
-		distance += (ind1->params[i] - ind2->params[i]) * (ind1->params[i] - ind2->params[i]);
-	}
-	return sqrt(distance);
+	return sqrt(SqDist(ind1->params, ind2->params, ssParams->dist_weights, ssParams->nreal));
 
 }
 
@@ -73,42 +69,12 @@ void matrix_product(SSType *ssParams, double **A, int a_row, int a_col, double *
  *
  */
 int closest_member(SSType *ssParams, Set *set, int set_size, individual *ind, int ind_index){
-	double dist;
-	double min;
-	int min_index;
-
-	if (ind_index == set_size - 1 ){
-		min = euclidean_distance(ssParams, ind, &(set->members[set_size - 2]));
-		min_index = set_size - 2;
-	}
-	else if (ind_index == 0){
-		min = euclidean_distance(ssParams, ind, &(set->members[1]));
-		min_index = 1;		
-	}
-	else{
-		min = euclidean_distance(ssParams, ind, &(set->members[ind_index - 1]));
-		min_index = ind_index - 1;		
-	}
-
 
+	double *rows[set_size];
 	for (int i = 0; i < set_size; ++i)
-	{
-		// printf("%d: ", i);
-		// printf("%lf, %d\n", min, min_index);
-		if ( i != ind_index ){
-			// printf("%d++@#\n", ind_index);
-			dist = euclidean_distance(ssParams, ind, &(set->members[i]));
-			if (dist < min ){
-				min = dist;
-				min_index = i;
-			}
+		rows[i] = set->members[i].params;
 
-		}
-		
-
-	}
-	// printf("====%d\n", min_index);
-	return min_index;
+	return NearestRow(ind->params, rows, set_size, ind_index, ssParams->dist_weights, ssParams->nreal, NULL);
 }
 
 
@@ -194,17 +160,12 @@ bool is_equal(SSType *ssParams, individual *ind1, individual *ind2){
  */
 int is_exist(SSType *ssParams, Set *set, int set_size, individual *ind){
 
-	int index = -1;
-	for (int i = set_size - 1; i >= 0; --i)
-	{
-		if ( is_equal(ssParams, &(set->members[i]), ind) ){
-			index = i;
-			break;
-		}
-
-	}
+	double *rows[set_size];
+	for (int i = 0; i < set_size; ++i)
+		rows[i] = set->members[i].params;
 
-	return index;
+	// The last match wins, like a scan from the end of the set
+	return FindWithin(ind->params, rows, set_size, ssParams->dist_weights, ssParams->nreal, ssParams->dist_epsilon, 1);
 }
 
 /**
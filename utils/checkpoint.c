@@ -0,0 +1,290 @@
+/**
+ *
+ *   @file checkpoint.c
+ *
+ *****************************************************************
+ *
+ *   functions for writing and reading binary checkpoint files
+ *   of the optimizers
+ *
+ *   A checkpoint is built in memory by the optimizer (which only
+ *   costs a few memcpy's) and then handed to a writer thread.
+ *   The writer puts it into '<fname>.tmp', syncs it to disk and
+ *   renames it over '<fname>', so an interrupted write never
+ *   destroys the previous checkpoint.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "error.h"
+#include "random.h"
+#include "checkpoint.h"
+
+
+/* STATIC VARIABLES ********************************************************/
+
+static pthread_t writer;        /* background writer thread */
+static int writer_active = 0;   /* is there a write in flight? */
+
+/* what the writer thread needs to know */
+typedef struct CkptJob {
+    CkptBuffer *buf;
+    char *fname;
+} CkptJob;
+
+
+/*** BUFFER FUNCTIONS ******************************************************/
+
+/** NewCkptBuffer: allocates an empty checkpoint buffer that starts with
+ *                  the magic string, the format version and 'kind'
+ */
+CkptBuffer *
+NewCkptBuffer( const char *kind ) {
+    CkptBuffer *b;
+    char magic[8] = CKPT_MAGIC;
+    char tag[8];
+    int version = CKPT_VERSION;
+
+    if( !( b = ( CkptBuffer * ) calloc( 1, sizeof( CkptBuffer ) ) ) )
+        error( "NewCkptBuffer: could not allocate buffer" );
+
+    memset( tag, 0, sizeof( tag ) );
+    strncpy( tag, kind, sizeof( tag ) - 1 );
+
+    CkptPut( b, magic, sizeof( magic ) );
+    CkptPut( b, &version, sizeof( int ) );
+    CkptPut( b, tag, sizeof( tag ) );
+    return b;
+}
+
+/** FreeCkptBuffer: frees a checkpoint buffer */
+void
+FreeCkptBuffer( CkptBuffer * b ) {
+    free( b->data );
+    free( b );
+}
+
+/** CkptPut: appends 'n' bytes at 'src' to the buffer */
+void
+CkptPut( CkptBuffer * b, const void *src, size_t n ) {
+    if( b->size + n > b->capacity ) {
+        b->capacity = 2 * ( b->size + n ) + 4096;
+        if( !( b->data = ( char * ) realloc( b->data, b->capacity ) ) )
+            error( "CkptPut: could not grow checkpoint buffer" );
+    }
+    memcpy( b->data + b->size, src, n );
+    b->size += n;
+}
+
+/** CkptGet: reads 'n' bytes from the buffer into 'dst' */
+void
+CkptGet( CkptBuffer * b, void *dst, size_t n ) {
+    if( b->pos + n > b->size )
+        error( "CkptGet: checkpoint is truncated or does not match this run" );
+    memcpy( dst, b->data + b->pos, n );
+    b->pos += n;
+}
+
+/** CkptPutRand: stores the dSFMT state as returned by GetDSFMTState()
+ *                 and the seed of the random streams
+ */
+void
+CkptPutRand( CkptBuffer * b ) {
+    char *state = GetDSFMTState(  );
+    size_t len = strlen( state ) + 1;
+    unsigned int seed = GetStreamSeed(  );
+
+    CkptPut( b, &len, sizeof( size_t ) );
+    CkptPut( b, state, len );
+    CkptPut( b, &seed, sizeof( unsigned int ) );
+    free( state );
+}
+
+/** CkptGetRand: restores what CkptPutRand() stored */
+void
+CkptGetRand( CkptBuffer * b ) {
+    size_t len;
+    char *state;
+    unsigned int seed;
+
+    CkptGet( b, &len, sizeof( size_t ) );
+    if( !( state = ( char * ) malloc( len ) ) )
+        error( "CkptGetRand: could not allocate random state" );
+    CkptGet( b, state, len );
+    RestoreRand( state );
+    CkptGet( b, &seed, sizeof( unsigned int ) );
+    SetStreamSeed( seed );
+    free( state );
+}
+
+/** CkptPutLog: flushes 'fp' and stores its current length */
+void
+CkptPutLog( CkptBuffer * b, FILE * fp ) {
+    long offset = -1;
+
+    if( fp ) {
+        fflush( fp );
+        fseek( fp, 0, SEEK_END );
+        offset = ftell( fp );
+    }
+    CkptPut( b, &offset, sizeof( long ) );
+}
+
+/** CkptGetLog: truncates 'fp' to the length stored by CkptPutLog */
+void
+CkptGetLog( CkptBuffer * b, FILE * fp ) {
+    long offset;
+    long length;
+
+    CkptGet( b, &offset, sizeof( long ) );
+    if( !fp || offset < 0 )
+        return;
+
+    fflush( fp );
+    fseek( fp, 0, SEEK_END );
+    length = ftell( fp );
+    if( length < offset ) {
+        warning( "CkptGetLog: log file is shorter than at checkpoint time" );
+        return;
+    }
+    if( ftruncate( fileno( fp ), ( off_t ) offset ) )
+        file_error( "CkptGetLog" );
+    fseek( fp, 0, SEEK_END );
+}
+
+/** CkptPutHist: waits for the history log writer and stores the length
+ *                of the log
+ */
+void
+CkptPutHist( CkptBuffer * b, HistLog * h ) {
+    long offset = -1;
+
+    if( h ) {
+        HistLogSync( h );
+        offset = HistLogOffset( h );
+    }
+    CkptPut( b, &offset, sizeof( long ) );
+}
+
+/** CkptGetHist: truncates a history log to the length stored by
+ *                CkptPutHist
+ */
+void
+CkptGetHist( CkptBuffer * b, HistLog * h ) {
+    long offset;
+
+    CkptGet( b, &offset, sizeof( long ) );
+    if( h && offset >= 0 )
+        HistLogTruncate( h, offset );
+}
+
+
+/*** WRITING AND READING ***************************************************/
+
+/** CkptWriter: the writer thread; writes the buffer to a temporary file,
+ *               syncs it and renames it to its final name
+ */
+static void *
+CkptWriter( void *arg ) {
+    CkptJob *job = ( CkptJob * ) arg;
+    char *tmpname;
+    FILE *fp;
+    int ok;
+
+    tmpname = ( char * ) calloc( strlen( job->fname ) + 5, sizeof( char ) );
+    sprintf( tmpname, "%s.tmp", job->fname );
+
+    fp = fopen( tmpname, "wb" );
+    ok = ( fp != NULL );
+    if( ok ) {
+        ok = ( fwrite( job->buf->data, 1, job->buf->size, fp ) == job->buf->size );
+        ok = ( fflush( fp ) == 0 ) && ok;
+        ok = ( fsync( fileno( fp ) ) == 0 ) && ok;
+        ok = ( fclose( fp ) == 0 ) && ok;
+    }
+    if( ok )
+        ok = ( rename( tmpname, job->fname ) == 0 );
+    if( !ok )
+        warning( "CkptWriter: could not write checkpoint %s", job->fname );
+
+    free( tmpname );
+    free( job->fname );
+    FreeCkptBuffer( job->buf );
+    free( job );
+    return NULL;
+}
+
+/** WriteCheckpoint: hands the buffer over to the background writer */
+void
+WriteCheckpoint( CkptBuffer * b, const char *fname ) {
+    CkptJob *job;
+
+    WaitCheckpoint(  );
+
+    if( !( job = ( CkptJob * ) malloc( sizeof( CkptJob ) ) ) )
+        error( "WriteCheckpoint: could not allocate writer job" );
+    job->buf = b;
+    job->fname = strdup( fname );
+
+    if( pthread_create( &writer, NULL, CkptWriter, job ) ) {
+        /* no thread for us, write it ourselves */
+        CkptWriter( job );
+        return;
+    }
+    writer_active = 1;
+}
+
+/** WaitCheckpoint: blocks until the last checkpoint is on disk */
+void
+WaitCheckpoint( void ) {
+    if( writer_active ) {
+        pthread_join( writer, NULL );
+        writer_active = 0;
+    }
+}
+
+/** ReadCheckpoint: reads a checkpoint file and checks its header */
+CkptBuffer *
+ReadCheckpoint( const char *fname, const char *kind ) {
+    CkptBuffer *b;
+    FILE *fp;
+    long length;
+    char magic[8];
+    char tag[8];
+    int version;
+
+    if( !( fp = fopen( fname, "rb" ) ) )
+        error( "ReadCheckpoint: could not open checkpoint %s", fname );
+
+    fseek( fp, 0, SEEK_END );
+    length = ftell( fp );
+    rewind( fp );
+
+    if( !( b = ( CkptBuffer * ) calloc( 1, sizeof( CkptBuffer ) ) ) )
+        error( "ReadCheckpoint: could not allocate buffer" );
+    b->size = b->capacity = ( size_t ) length;
+    if( !( b->data = ( char * ) malloc( b->capacity + 1 ) ) )
+        error( "ReadCheckpoint: could not allocate buffer" );
+    if( fread( b->data, 1, b->size, fp ) != b->size )
+        error( "ReadCheckpoint: error reading checkpoint %s", fname );
+    fclose( fp );
+
+    CkptGet( b, magic, sizeof( magic ) );
+    CkptGet( b, &version, sizeof( int ) );
+    CkptGet( b, tag, sizeof( tag ) );
+
+    if( strncmp( magic, CKPT_MAGIC, sizeof( magic ) ) )
+        error( "ReadCheckpoint: %s is not a checkpoint file", fname );
+    if( version != CKPT_VERSION )
+        error( "ReadCheckpoint: %s has format version %d, expected %d", fname, version, CKPT_VERSION );
+    if( strncmp( tag, kind, sizeof( tag ) ) )
+        error( "ReadCheckpoint: %s was not written by %s", fname, kind );
+
+    return b;
+}
@@ -0,0 +1,98 @@
+/**
+ *
+ *   @file checkpoint.h
+ *
+ *****************************************************************
+ *
+ *   functions for writing and reading binary checkpoint files
+ *   of the optimizers; the file is serialized into a memory
+ *   buffer on the optimizer thread and written to disk in the
+ *   background, using a temporary file and rename() so that a
+ *   checkpoint on disk is always complete
+ *
+ *****************************************************************/
+
+#ifndef CHECKPOINT_INCLUDED
+#define CHECKPOINT_INCLUDED
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "histlog.h"
+
+/* magic string at the start of every checkpoint file */
+#define CKPT_MAGIC   "FLYCKPT"
+/* bump this whenever the layout of a checkpoint changes */
+#define CKPT_VERSION 3
+
+/** CkptBuffer: a growing byte buffer; CkptPut appends at the end,
+ *               CkptGet reads from 'pos' onwards
+ */
+typedef struct CkptBuffer {
+    char *data;
+    size_t size;
+    size_t capacity;
+    size_t pos;
+} CkptBuffer;
+
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+/** NewCkptBuffer: allocates an empty checkpoint buffer that starts with
+ *                  the magic string, the format version and 'kind'
+ *                  (e.g. "ss" or "ess")
+ */
+CkptBuffer *NewCkptBuffer( const char *kind );
+
+/** FreeCkptBuffer: frees a checkpoint buffer */
+void FreeCkptBuffer( CkptBuffer * b );
+
+/** CkptPut: appends 'n' bytes at 'src' to the buffer */
+void CkptPut( CkptBuffer * b, const void *src, size_t n );
+
+/** CkptGet: reads 'n' bytes from the buffer into 'dst'; it is an error to
+ *            read past the end of the buffer
+ */
+void CkptGet( CkptBuffer * b, void *dst, size_t n );
+
+/** CkptPutRand, CkptGetRand: store and restore the state of the dSFMT
+ *                             random number generator and the seed of
+ *                             the random streams
+ */
+void CkptPutRand( CkptBuffer * b );
+void CkptGetRand( CkptBuffer * b );
+
+/** CkptPutLog: flushes 'fp' and stores its current length, so that a
+ *               resumed run can cut off whatever was logged after the
+ *               checkpoint was taken
+ */
+void CkptPutLog( CkptBuffer * b, FILE * fp );
+
+/** CkptGetLog: reads a log length stored by CkptPutLog and truncates 'fp'
+ *               (opened for appending) to that length
+ */
+void CkptGetLog( CkptBuffer * b, FILE * fp );
+
+/** CkptPutHist, CkptGetHist: same as CkptPutLog and CkptGetLog, for
+ *                             binary history logs; 'h' may be NULL
+ */
+void CkptPutHist( CkptBuffer * b, HistLog * h );
+void CkptGetHist( CkptBuffer * b, HistLog * h );
+
+/** WriteCheckpoint: hands the buffer over to a background thread that
+ *                    writes it to 'fname'; the buffer is freed by the
+ *                    writer. A previous write that is still in flight
+ *                    is waited for first.
+ */
+void WriteCheckpoint( CkptBuffer * b, const char *fname );
+
+/** WaitCheckpoint: blocks until the last checkpoint is on disk */
+void WaitCheckpoint( void );
+
+/** ReadCheckpoint: reads a checkpoint file and checks that it was
+ *                   written by this version for 'kind'; the returned
+ *                   buffer is positioned after the header
+ */
+CkptBuffer *ReadCheckpoint( const char *fname, const char *kind );
+
+#endif
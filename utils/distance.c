@@ -0,0 +1,224 @@
+/**
+ *
+ *   @file distance.c
+ *
+ *****************************************************************
+ *
+ *   distance kernels used by the optimizers
+ *
+ *   The kernels sum squared differences four parameters at a
+ *   time (with SSE2 if HAVE_SSE2 is defined, which the linux
+ *   build does for dSFMT anyway). The bounded kernel checks the
+ *   partial sum every eight parameters, so the rows that are
+ *   obviously too far away for a nearest neighbour or duplicate
+ *   test cost only a fraction of a full distance.
+ *
+ *****************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "error.h"
+#include "distance.h"
+
+
+/*** KERNELS ***************************************************************/
+
+/** SqDistRange: squared distance over parameters [from, to) */
+static double
+SqDistRange( const double *a, const double *b, const double *w, int from, int to ) {
+    double sum = 0.;
+    double d;
+    int i = from;
+
+#ifdef HAVE_SSE2
+    __m128d acc0 = _mm_setzero_pd(  );
+    __m128d acc1 = _mm_setzero_pd(  );
+    __m128d d0, d1;
+    double lanes[2];
+
+    if( w ) {
+        for( ; i + 4 <= to; i += 4 ) {
+            d0 = _mm_sub_pd( _mm_loadu_pd( a + i ), _mm_loadu_pd( b + i ) );
+            d1 = _mm_sub_pd( _mm_loadu_pd( a + i + 2 ), _mm_loadu_pd( b + i + 2 ) );
+            acc0 = _mm_add_pd( acc0, _mm_mul_pd( _mm_mul_pd( d0, d0 ), _mm_loadu_pd( w + i ) ) );
+            acc1 = _mm_add_pd( acc1, _mm_mul_pd( _mm_mul_pd( d1, d1 ), _mm_loadu_pd( w + i + 2 ) ) );
+        }
+    } else {
+        for( ; i + 4 <= to; i += 4 ) {
+            d0 = _mm_sub_pd( _mm_loadu_pd( a + i ), _mm_loadu_pd( b + i ) );
+            d1 = _mm_sub_pd( _mm_loadu_pd( a + i + 2 ), _mm_loadu_pd( b + i + 2 ) );
+            acc0 = _mm_add_pd( acc0, _mm_mul_pd( d0, d0 ) );
+            acc1 = _mm_add_pd( acc1, _mm_mul_pd( d1, d1 ) );
+        }
+    }
+    _mm_storeu_pd( lanes, _mm_add_pd( acc0, acc1 ) );
+    sum = lanes[0] + lanes[1];
+#else
+    double s0 = 0., s1 = 0., s2 = 0., s3 = 0.;
+    double d1, d2, d3;
+
+    for( ; i + 4 <= to; i += 4 ) {
+        d = a[i] - b[i];
+        d1 = a[i + 1] - b[i + 1];
+        d2 = a[i + 2] - b[i + 2];
+        d3 = a[i + 3] - b[i + 3];
+        if( w ) {
+            s0 += d * d * w[i];
+            s1 += d1 * d1 * w[i + 1];
+            s2 += d2 * d2 * w[i + 2];
+            s3 += d3 * d3 * w[i + 3];
+        } else {
+            s0 += d * d;
+            s1 += d1 * d1;
+            s2 += d2 * d2;
+            s3 += d3 * d3;
+        }
+    }
+    sum = ( s0 + s2 ) + ( s1 + s3 );
+#endif
+
+    for( ; i < to; i++ ) {
+        d = a[i] - b[i];
+        sum += w ? d * d * w[i] : d * d;
+    }
+    return sum;
+}
+
+/** DistWeights: fills 'w' with 1 / (hi - lo)^2 */
+void
+DistWeights( const double *lo, const double *hi, int n, double *w ) {
+    int i;
+
+    for( i = 0; i < n; i++ )
+        w[i] = ( hi[i] > lo[i] ) ? 1. / ( ( hi[i] - lo[i] ) * ( hi[i] - lo[i] ) ) : 1.;
+}
+
+/** SqDist: squared distance between 'a' and 'b' */
+double
+SqDist( const double *a, const double *b, const double *w, int n ) {
+    return SqDistRange( a, b, w, 0, n );
+}
+
+/** SqDistBounded: squared distance that gives up above 'bound' */
+double
+SqDistBounded( const double *a, const double *b, const double *w, int n, double bound ) {
+    double sum = 0.;
+    int i;
+
+    for( i = 0; i < n && sum <= bound; i += 8 )
+        sum += SqDistRange( a, b, w, i, ( i + 8 < n ) ? i + 8 : n );
+    return sum;
+}
+
+
+/*** SET OPERATIONS ********************************************************/
+
+/** NearestRow: index of the row closest to 'x' */
+int
+NearestRow( const double *x, double *const *rows, int nrows, int skip, const double *w, int n, double *d2 ) {
+    double best = HUGE_VAL;
+    double d;
+    int index = -1;
+    int i;
+
+    for( i = 0; i < nrows; i++ ) {
+        if( i == skip )
+            continue;
+        d = SqDistBounded( x, rows[i], w, n, best );
+        if( d < best || index < 0 ) {
+            best = d;
+            index = i;
+        }
+    }
+    if( d2 )
+        *d2 = best;
+    return index;
+}
+
+/** FindWithin: index of a row closer to 'x' than 'tol' */
+int
+FindWithin( const double *x, double *const *rows, int nrows, const double *w, int n, double tol, int reverse ) {
+    double tol2 = tol * tol;
+    int i;
+
+    if( reverse ) {
+        for( i = nrows - 1; i >= 0; i-- )
+            if( SqDistBounded( x, rows[i], w, n, tol2 ) < tol2 )
+                return i;
+    } else {
+        for( i = 0; i < nrows; i++ )
+            if( SqDistBounded( x, rows[i], w, n, tol2 ) < tol2 )
+                return i;
+    }
+    return -1;
+}
+
+/** MinSqDistUpdate: keeps the distance of each row to a set up to date */
+void
+MinSqDistUpdate( const double *x, double *const *rows, int nrows, const double *w, int n, double *mind ) {
+    double d;
+    int i;
+
+    for( i = 0; i < nrows; i++ ) {
+        d = SqDistBounded( x, rows[i], w, n, mind[i] );
+        if( d < mind[i] )
+            mind[i] = d;
+    }
+}
+
+/** MaxMinSelect: greedy max-min diversity selection */
+void
+MaxMinSelect( double *const *fixed, int nfixed, double *const *cand, int ncand, int nselect, const double *w, int n, int *picked ) {
+    double **rows;              /* candidates that are left */
+    int *index;                 /* their index in 'cand' */
+    double *mind;               /* their distance to the selected rows */
+    const double *x;
+    int left = ncand;
+    int best;
+    int i, k;
+
+    if( ncand <= 0 )
+        return;
+
+    rows = ( double ** ) malloc( ncand * sizeof( double * ) );
+    index = ( int * ) malloc( ncand * sizeof( int ) );
+    mind = ( double * ) malloc( ncand * sizeof( double ) );
+    if( !rows || !index || !mind )
+        error( "MaxMinSelect: could not allocate memory for %d candidates", ncand );
+
+    for( i = 0; i < ncand; i++ ) {
+        rows[i] = cand[i];
+        index[i] = i;
+        mind[i] = HUGE_VAL;
+    }
+    for( i = 0; i < nfixed; i++ )
+        MinSqDistUpdate( fixed[i], rows, left, w, n, mind );
+
+    for( k = 0; k < nselect && left > 0; k++ ) {
+        best = 0;
+        for( i = 1; i < left; i++ )
+            if( mind[i] > mind[best] )
+                best = i;
+
+        picked[k] = index[best];
+        x = rows[best];
+
+        /* drop the picked one, keeping the others in their order */
+        memmove( rows + best, rows + best + 1, ( left - best - 1 ) * sizeof( double * ) );
+        memmove( index + best, index + best + 1, ( left - best - 1 ) * sizeof( int ) );
+        memmove( mind + best, mind + best + 1, ( left - best - 1 ) * sizeof( double ) );
+        left--;
+
+        MinSqDistUpdate( x, rows, left, w, n, mind );
+    }
+
+    free( rows );
+    free( index );
+    free( mind );
+}
@@ -0,0 +1,69 @@
+/**
+ *
+ *   @file distance.h
+ *
+ *****************************************************************
+ *
+ *   distance kernels used by the optimizers for diversity
+ *   selection, duplicate detection and closest member lookups
+ *
+ *   All distances are squared (weighted) Euclidean distances
+ *   between parameter vectors of length 'n'. 'w' holds one
+ *   weight per parameter, usually 1 / range^2 so that every
+ *   parameter contributes on the same scale (see DistWeights());
+ *   NULL means plain Euclidean distance. A set of vectors is
+ *   passed as an array of row pointers, so the kernels work on
+ *   the members of a Set as well as on packed matrices.
+ *
+ *****************************************************************/
+
+#ifndef DISTANCE_INCLUDED
+#define DISTANCE_INCLUDED
+
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+/** DistWeights: fills 'w' with 1 / (hi - lo)^2 for each parameter; a
+ *                parameter with an empty range gets weight 1
+ */
+void DistWeights( const double *lo, const double *hi, int n, double *w );
+
+/** SqDist: squared distance between 'a' and 'b' */
+double SqDist( const double *a, const double *b, const double *w, int n );
+
+/** SqDistBounded: same as SqDist, but stops as soon as the partial sum
+ *                  exceeds 'bound' and returns that partial sum; use it
+ *                  when only distances below 'bound' are of interest
+ */
+double SqDistBounded( const double *a, const double *b, const double *w, int n, double bound );
+
+/** NearestRow: index of the row closest to 'x', leaving out row 'skip'
+ *               (-1 to consider all rows); its squared distance goes
+ *               into 'd2' if that is not NULL. Returns -1 if there is
+ *               no row to choose from. Ties go to the first row.
+ */
+int NearestRow( const double *x, double *const *rows, int nrows, int skip, const double *w, int n, double *d2 );
+
+/** FindWithin: index of a row whose distance to 'x' is below 'tol',
+ *               scanning from the first row (or from the last one if
+ *               'reverse' is set); -1 if there is none
+ */
+int FindWithin( const double *x, double *const *rows, int nrows, const double *w, int n, double tol, int reverse );
+
+/** MinSqDistUpdate: lowers mind[i] to the squared distance between 'x'
+ *                    and rows[i] where that is smaller; calling it for
+ *                    each vector added to a set keeps the distance of
+ *                    every row to that set up to date in O(nrows)
+ */
+void MinSqDistUpdate( const double *x, double *const *rows, int nrows, const double *w, int n, double *mind );
+
+/** MaxMinSelect: greedy max-min diversity selection; 'nfixed' rows of
+ *                 'fixed' are already selected, then 'nselect' of the
+ *                 'ncand' candidate rows are picked one at a time, each
+ *                 being the candidate farthest from everything selected
+ *                 so far. The picked candidate indices go into 'picked'
+ *                 in the order they were picked.
+ */
+void MaxMinSelect( double *const *fixed, int nfixed, double *const *cand, int ncand, int nselect, const double *w, int n, int *picked );
+
+#endif
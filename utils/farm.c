@@ -0,0 +1,623 @@
+/**
+ *
+ *   @file farm.c
+ *
+ *****************************************************************
+ *
+ *   master-worker evaluation of parameter sets over TCP
+ *
+ *   The master is single threaded: FarmEvaluate() polls the
+ *   listening socket and the workers, hands out batches to idle
+ *   workers and, in between, scores single parameter vectors
+ *   itself. Parameter vectors waiting to be scored are kept on
+ *   a stack of indices ('todo'); a batch that is lost with its
+ *   worker goes back onto it. A worker runs one batch at a time
+ *   and sends its heartbeats from a second thread, so that a
+ *   long batch doesn't look like a lost worker.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "error.h"
+#include "farm.h"
+
+
+/* how often and how long a worker tries to reach its master */
+#define FARM_CONNECT_TRIES 60
+#define FARM_CONNECT_WAIT  1
+
+/** Worker: a worker as seen by the master */
+typedef struct Worker {
+    int fd;
+    int ready;                  /* has it set up the problem? */
+    char name[64];              /* address:port, for messages */
+    char *buf;                  /* input not parsed yet */
+    int len, cap;
+    int *batch;                 /* indices of the vectors it is scoring */
+    int nbatch;                 /* 0: idle */
+    int id;                     /* id of that batch */
+    double sent;                /* when the batch was sent */
+    double last;                /* when we last heard from it */
+    double rate;                /* seconds per vector, 0: not known yet */
+} Worker;
+
+/** Farm: the master side */
+struct Farm {
+    int listenfd;
+    int nparams;
+    char *config;
+    Worker *workers;
+    int nworkers;
+    int id;                     /* id of the last batch */
+    int joined;                 /* workers that were ever ready */
+    long remote;                /* vectors scored by the workers */
+    long local;                 /* vectors scored by the master */
+    long resubmitted;           /* vectors of lost batches */
+};
+
+
+/*** HELPERS ***************************************************************/
+
+/** Now: monotonic wall clock time in seconds */
+static double
+Now( void ) {
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/** SendAll: writes 'len' bytes of 'buf' to 'fd'; returns -1 on failure,
+ *            which includes a send timeout (see AcceptWorker())
+ */
+static int
+SendAll( int fd, const char *buf, size_t len ) {
+    ssize_t k;
+
+    while( len > 0 ) {
+        k = send( fd, buf, len, MSG_NOSIGNAL );
+        if( k < 0 && errno == EINTR )
+            continue;
+        if( k <= 0 )
+            return -1;
+        buf += k;
+        len -= k;
+    }
+    return 0;
+}
+
+/** Text: a growing string for composing messages */
+typedef struct Text {
+    char *s;
+    size_t len, cap;
+} Text;
+
+/** TextAdd: appends printf-style output to 't' */
+static void
+TextAdd( Text * t, const char *fmt, ... ) {
+    va_list ap;
+    int k;
+
+    for( ;; ) {
+        va_start( ap, fmt );
+        k = vsnprintf( t->s + t->len, t->cap - t->len, fmt, ap );
+        va_end( ap );
+        if( k >= 0 && t->len + k < t->cap )
+            break;
+        t->cap = 2 * t->cap + k + 64;
+        if( !( t->s = ( char * ) realloc( t->s, t->cap ) ) )
+            error( "farm: could not allocate memory" );
+    }
+    t->len += k;
+}
+
+
+/*** MASTER ****************************************************************/
+
+/** OpenFarm: listens for workers on TCP 'port' */
+Farm *
+OpenFarm( int port, int nparams, const char *config ) {
+    Farm *f;
+    struct sockaddr_in addr;
+    int one = 1;
+
+    if( !( f = ( Farm * ) calloc( 1, sizeof( Farm ) ) ) )
+        error( "OpenFarm: could not allocate memory" );
+    f->nparams = nparams;
+    f->config = strdup( config );
+
+    if( ( f->listenfd = socket( AF_INET, SOCK_STREAM, 0 ) ) < 0 )
+        error( "OpenFarm: could not create socket: %s", strerror( errno ) );
+    setsockopt( f->listenfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof( one ) );
+
+    memset( &addr, 0, sizeof( addr ) );
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl( INADDR_ANY );
+    addr.sin_port = htons( port );
+    if( bind( f->listenfd, ( struct sockaddr * ) &addr, sizeof( addr ) ) < 0 || listen( f->listenfd, 64 ) < 0 )
+        error( "OpenFarm: could not listen on port %d: %s", port, strerror( errno ) );
+
+    printf( "Farm: waiting for workers on port %d\n", port );
+    return f;
+}
+
+/** FarmWorkers: number of workers that are ready */
+int
+FarmWorkers( Farm * f ) {
+    int i, n = 0;
+
+    for( i = 0; i < f->nworkers; i++ )
+        n += f->workers[i].ready;
+    return n;
+}
+
+/** AcceptWorker: takes a new connection and sends it the problem */
+static void
+AcceptWorker( Farm * f ) {
+    struct sockaddr_in addr;
+    socklen_t alen = sizeof( addr );
+    char ip[INET_ADDRSTRLEN];
+    Worker *w;
+    Text t = { NULL, 0, 0 };
+    struct timeval timeout = { FARM_TIMEOUT, 0 };
+    int fd, one = 1;
+
+    if( ( fd = accept( f->listenfd, ( struct sockaddr * ) &addr, &alen ) ) < 0 )
+        return;
+    setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof( one ) );
+    /* a worker that hangs without closing its connection stops reading; *
+     * sending to it then fails after FARM_TIMEOUT instead of blocking     */
+    setsockopt( fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof( timeout ) );
+
+    TextAdd( &t, "farm %d %d %s\n", FARM_VERSION, f->nparams, f->config );
+    if( SendAll( fd, t.s, t.len ) ) {
+        close( fd );
+        free( t.s );
+        return;
+    }
+    free( t.s );
+
+    if( !( f->workers = ( Worker * ) realloc( f->workers, ( f->nworkers + 1 ) * sizeof( Worker ) ) ) )
+        error( "AcceptWorker: could not allocate memory" );
+    w = f->workers + f->nworkers++;
+    memset( w, 0, sizeof( Worker ) );
+    w->fd = fd;
+    w->last = Now(  );
+    inet_ntop( AF_INET, &addr.sin_addr, ip, sizeof( ip ) );
+    snprintf( w->name, sizeof( w->name ), "%s:%d", ip, ntohs( addr.sin_port ) );
+}
+
+/** DropWorker: closes worker 'i' and puts its batch back onto 'todo' */
+static void
+DropWorker( Farm * f, int i, int *todo, int *ntodo, const char *why ) {
+    Worker *w = f->workers + i;
+    int j;
+
+    if( w->ready || w->nbatch )
+        warning( "Farm: lost worker %s (%s), %d parameter sets go to the others", w->name, why, w->nbatch );
+    for( j = w->nbatch - 1; j >= 0; j-- )
+        todo[( *ntodo )++] = w->batch[j];
+    f->resubmitted += w->nbatch;
+
+    close( w->fd );
+    free( w->buf );
+    free( w->batch );
+    f->workers[i] = f->workers[--f->nworkers];
+}
+
+/** SendBatch: sends worker 'w' a batch from the top of 'todo', sized to
+ *              take about FARM_BATCH_TIME seconds but at most a share of
+ *              what is left; returns -1 if the worker can't be reached
+ */
+static int
+SendBatch( Farm * f, Worker * w, double **params, int *todo, int *ntodo, int nshares ) {
+    Text t = { NULL, 0, 0 };
+    int k, j, p, res;
+
+    k = w->rate > 0. ? ( int ) ( FARM_BATCH_TIME / w->rate ) : 1;
+    j = ( *ntodo + 2 * nshares - 1 ) / ( 2 * nshares );
+    if( k > j )
+        k = j;
+    if( k < 1 )
+        k = 1;
+    if( k > *ntodo )
+        k = *ntodo;
+
+    if( !( w->batch = ( int * ) realloc( w->batch, k * sizeof( int ) ) ) )
+        error( "SendBatch: could not allocate memory" );
+    w->nbatch = k;
+    w->id = ++f->id;
+    TextAdd( &t, "score %d %d\n", w->id, k );
+    for( j = 0; j < k; j++ ) {
+        w->batch[j] = todo[--( *ntodo )];
+        for( p = 0; p < f->nparams; p++ )
+            TextAdd( &t, p ? " %.17g" : "%.17g", params[w->batch[j]][p] );
+        TextAdd( &t, "\n" );
+    }
+    w->sent = Now(  );
+    res = SendAll( w->fd, t.s, t.len );
+    free( t.s );
+    return res;
+}
+
+/** WorkerLine: handles one line from worker 'w'; returns the number of
+ *               costs it delivered, -1 if the worker has to go
+ */
+static int
+WorkerLine( Farm * f, Worker * w, char *line, double *costs ) {
+    char *s, *end;
+    int id, n, np, j;
+    double dt;
+
+    if( !strcmp( line, "alive" ) )
+        return 0;
+
+    if( sscanf( line, "ready %d", &np ) == 1 ) {
+        if( np != f->nparams ) {
+            warning( "Farm: worker %s has %d parameters instead of %d", w->name, np, f->nparams );
+            return -1;
+        }
+        w->ready = 1;
+        f->joined++;
+        printf( "Farm: worker %s joined (%d ready)\n", w->name, FarmWorkers( f ) );
+        return 0;
+    }
+
+    if( !strncmp( line, "error", 5 ) ) {
+        warning( "Farm: worker %s: %s", w->name, line );
+        return -1;
+    }
+
+    if( sscanf( line, "cost %d %d", &id, &n ) == 2 && id == w->id && n == w->nbatch && n > 0 ) {
+        s = line + 4;
+        strtol( s, &s, 10 );
+        strtol( s, &s, 10 );
+        for( j = 0; j < n; j++ ) {
+            costs[w->batch[j]] = strtod( s, &end );
+            if( end == s )
+                return -1;
+            s = end;
+        }
+        dt = ( Now(  ) - w->sent ) / n;
+        w->rate = w->rate > 0. ? .5 * ( w->rate + dt ) : dt;
+        w->nbatch = 0;
+        f->remote += n;
+        return n;
+    }
+
+    warning( "Farm: unexpected message from worker %s: %.40s", w->name, line );
+    return -1;
+}
+
+/** ReadWorker: reads what worker 'w' sent and handles complete lines;
+ *               returns the number of costs delivered, -1 if the worker
+ *               has to go
+ */
+static int
+ReadWorker( Farm * f, Worker * w, double *costs ) {
+    char *nl, *line;
+    int k, got = 0, r;
+
+    if( w->cap - w->len < 4096 ) {
+        w->cap = 2 * w->cap + 4096;
+        if( !( w->buf = ( char * ) realloc( w->buf, w->cap ) ) )
+            error( "ReadWorker: could not allocate memory" );
+    }
+    k = read( w->fd, w->buf + w->len, w->cap - w->len - 1 );
+    if( k < 0 && errno == EINTR )
+        return 0;
+    if( k <= 0 )
+        return -1;
+    w->len += k;
+    w->buf[w->len] = '\0';
+    w->last = Now(  );
+
+    line = w->buf;
+    while( ( nl = strchr( line, '\n' ) ) ) {
+        *nl = '\0';
+        if( ( r = WorkerLine( f, w, line, costs ) ) < 0 )
+            return -1;
+        got += r;
+        line = nl + 1;
+    }
+    w->len -= line - w->buf;
+    memmove( w->buf, line, w->len );
+    return got;
+}
+
+/** FarmEvaluate: scores 'n' parameter vectors with the workers */
+int
+FarmEvaluate( Farm * f, double **params, int n, double *costs, FarmScore local, void *arg ) {
+    struct pollfd *fds = NULL;
+    int *todo;
+    int ntodo, ndone, nlocal, nfds, i, k;
+    double now;
+
+    if( n <= 0 )
+        return 0;
+    if( !( todo = ( int * ) malloc( n * sizeof( int ) ) ) )
+        error( "FarmEvaluate: could not allocate memory" );
+    for( i = 0; i < n; i++ )
+        todo[i] = n - 1 - i;    /* the first vector on top */
+    ntodo = n;
+    ndone = 0;
+    nlocal = 0;
+
+    /* the time between two sets doesn't count against the workers */
+    now = Now(  );
+    for( i = 0; i < f->nworkers; i++ )
+        f->workers[i].last = now;
+
+    while( ndone < n ) {
+
+        /* keep every ready worker busy */
+        k = FarmWorkers( f ) + ( local != NULL );
+        for( i = 0; i < f->nworkers && ntodo > 0; i++ )
+            if( f->workers[i].ready && !f->workers[i].nbatch && SendBatch( f, f->workers + i, params, todo, &ntodo, k ) )
+                DropWorker( f, i--, todo, &ntodo, "connection broken or send timed out" );
+
+        /* see who has something to say; don't wait if there is work left *
+         * that the master can do itself                                  */
+        if( !( fds = ( struct pollfd * ) realloc( fds, ( f->nworkers + 1 ) * sizeof( struct pollfd ) ) ) )
+            error( "FarmEvaluate: could not allocate memory" );
+        fds[0].fd = f->listenfd;
+        fds[0].events = POLLIN;
+        for( i = 0; i < f->nworkers; i++ ) {
+            fds[i + 1].fd = f->workers[i].fd;
+            fds[i + 1].events = POLLIN;
+        }
+        nfds = f->nworkers + 1;
+        if( poll( fds, nfds, ( local && ntodo > 0 ) ? 0 : 1000 ) < 0 && errno != EINTR )
+            error( "FarmEvaluate: poll failed: %s", strerror( errno ) );
+
+        /* workers go from the back, so the indices of fds stay valid */
+        for( i = nfds - 2; i >= 0; i-- ) {
+            if( !( fds[i + 1].revents & ( POLLIN | POLLHUP | POLLERR ) ) )
+                continue;
+            if( ( k = ReadWorker( f, f->workers + i, costs ) ) < 0 )
+                DropWorker( f, i, todo, &ntodo, "connection closed" );
+            else
+                ndone += k;
+        }
+        if( fds[0].revents & POLLIN )
+            AcceptWorker( f );
+
+        now = Now(  );
+        for( i = f->nworkers - 1; i >= 0; i-- )
+            if( now - f->workers[i].last > FARM_TIMEOUT )
+                DropWorker( f, i, todo, &ntodo, "no heartbeat" );
+
+        /* and do some work in between */
+        if( local && ntodo > 0 ) {
+            i = todo[--ntodo];
+            costs[i] = local( params[i], arg );
+            ndone++;
+            nlocal++;
+        }
+    }
+
+    f->local += nlocal;
+    free( fds );
+    free( todo );
+    return nlocal;
+}
+
+/** CloseFarm: tells the workers to quit and frees everything */
+void
+CloseFarm( Farm * f, FILE * fp ) {
+    int i;
+
+    if( !f )
+        return;
+    for( i = 0; i < f->nworkers; i++ ) {
+        SendAll( f->workers[i].fd, "quit\n", 5 );
+        close( f->workers[i].fd );
+        free( f->workers[i].buf );
+        free( f->workers[i].batch );
+    }
+    close( f->listenfd );
+
+    if( fp )
+        fprintf( fp, "Farm: %d workers, %ld parameter sets scored by workers, %ld by the master, %ld resubmitted\n",
+                 f->joined, f->remote, f->local, f->resubmitted );
+
+    free( f->workers );
+    free( f->config );
+    free( f );
+}
+
+
+/*** WORKER ****************************************************************/
+
+/** Beat: the heartbeat thread of a worker */
+typedef struct Beat {
+    int fd;
+    int stop;
+    pthread_mutex_t lock;       /* for everything written to fd */
+    pthread_cond_t wake;
+} Beat;
+
+static void *
+HeartBeat( void *arg ) {
+    Beat *b = ( Beat * ) arg;
+    struct timespec until;
+
+    pthread_mutex_lock( &b->lock );
+    while( !b->stop ) {
+        clock_gettime( CLOCK_REALTIME, &until );
+        until.tv_sec += FARM_HEARTBEAT;
+        while( !b->stop && pthread_cond_timedwait( &b->wake, &b->lock, &until ) != ETIMEDOUT );
+        if( !b->stop )
+            SendAll( b->fd, "alive\n", 6 );
+    }
+    pthread_mutex_unlock( &b->lock );
+    return NULL;
+}
+
+/** Connect: connects to host:port, retrying while the master isn't up */
+static int
+Connect( const char *host, int port ) {
+    struct addrinfo hints, *res, *ai;
+    char service[16];
+    int fd, try, one = 1;
+
+    memset( &hints, 0, sizeof( hints ) );
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf( service, sizeof( service ), "%d", port );
+
+    for( try = 0; try < FARM_CONNECT_TRIES; try++ ) {
+        if( try )
+            sleep( FARM_CONNECT_WAIT );
+        if( getaddrinfo( host, service, &hints, &res ) )
+            continue;
+        for( ai = res; ai; ai = ai->ai_next ) {
+            if( ( fd = socket( ai->ai_family, ai->ai_socktype, ai->ai_protocol ) ) < 0 )
+                continue;
+            if( !connect( fd, ai->ai_addr, ai->ai_addrlen ) ) {
+                freeaddrinfo( res );
+                setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof( one ) );
+                return fd;
+            }
+            close( fd );
+        }
+        freeaddrinfo( res );
+    }
+    return -1;
+}
+
+/** FarmWork: the worker side */
+int
+FarmWork( const char *host, int port, FarmSetup setup, FarmBatch batch, void *arg, int die_after ) {
+    FILE *in;
+    Beat b;
+    pthread_t beat;
+    Text t = { NULL, 0, 0 };
+    char *line = NULL, *s, *end;
+    char why[256];
+    size_t cap = 0;
+    double *params = NULL, *costs = NULL;
+    int fd, version, nparams, np, off, id, n, i, p;
+    int nbatches = 0, res = -1;
+
+    if( ( fd = Connect( host, port ) ) < 0 ) {
+        warning( "FarmWork: could not connect to %s:%d", host, port );
+        return -1;
+    }
+    if( !( in = fdopen( fd, "r" ) ) )
+        error( "FarmWork: could not open connection" );
+
+    b.fd = fd;
+    b.stop = 0;
+    pthread_mutex_init( &b.lock, NULL );
+    pthread_cond_init( &b.wake, NULL );
+
+    /* the problem */
+    if( getline( &line, &cap, in ) <= 0 || sscanf( line, "farm %d %d %n", &version, &nparams, &off ) != 2 ) {
+        warning( "FarmWork: %s:%d is not a farm", host, port );
+        goto done;
+    }
+    line[strcspn( line, "\n" )] = '\0';
+    if( version != FARM_VERSION ) {
+        SendAll( fd, "error wrong protocol version\n", 29 );
+        warning( "FarmWork: master speaks protocol version %d, we speak %d", version, FARM_VERSION );
+        goto done;
+    }
+
+    if( pthread_create( &beat, NULL, HeartBeat, &b ) )
+        error( "FarmWork: could not start heartbeat thread" );
+
+    np = setup( line + off, arg, why, sizeof( why ) );
+    if( np >= 0 && np != nparams )
+        snprintf( why, sizeof( why ), "%d parameters instead of %d", np, nparams );
+    pthread_mutex_lock( &b.lock );
+    t.len = 0;
+    if( np == nparams )
+        TextAdd( &t, "ready %d\n", np );
+    else
+        TextAdd( &t, "error %s\n", why );
+    SendAll( fd, t.s, t.len );
+    pthread_mutex_unlock( &b.lock );
+    if( np != nparams ) {
+        warning( "FarmWork: %s", why );
+        goto stop;
+    }
+
+    /* the batches */
+    while( getline( &line, &cap, in ) > 0 ) {
+        if( !strncmp( line, "quit", 4 ) ) {
+            res = 0;
+            break;
+        }
+        if( sscanf( line, "score %d %d", &id, &n ) != 2 || n < 1 ) {
+            warning( "FarmWork: unexpected message from master: %.40s", line );
+            break;
+        }
+        params = ( double * ) realloc( params, ( size_t ) n * nparams * sizeof( double ) );
+        costs = ( double * ) realloc( costs, n * sizeof( double ) );
+        if( !params || !costs )
+            error( "FarmWork: could not allocate memory" );
+        for( i = 0; i < n; i++ ) {
+            if( getline( &line, &cap, in ) <= 0 )
+                goto stop;
+            for( s = line, p = 0; p < nparams; p++, s = end ) {
+                params[( size_t ) i * nparams + p] = strtod( s, &end );
+                if( end == s ) {
+                    warning( "FarmWork: bad parameter vector from master" );
+                    goto stop;
+                }
+            }
+        }
+
+        if( die_after > 0 && ++nbatches == die_after ) {
+            warning( "FarmWork: leaving without answering batch %d (-k)", nbatches );
+            goto stop;
+        }
+
+        batch( params, n, costs, arg );
+
+        t.len = 0;
+        TextAdd( &t, "cost %d %d", id, n );
+        for( i = 0; i < n; i++ )
+            TextAdd( &t, " %.17g", costs[i] );
+        TextAdd( &t, "\n" );
+        pthread_mutex_lock( &b.lock );
+        i = SendAll( fd, t.s, t.len );
+        pthread_mutex_unlock( &b.lock );
+        if( i )
+            break;
+    }
+
+  stop:
+    pthread_mutex_lock( &b.lock );
+    b.stop = 1;
+    pthread_cond_signal( &b.wake );
+    pthread_mutex_unlock( &b.lock );
+    pthread_join( beat, NULL );
+
+  done:
+    fclose( in );
+    pthread_mutex_destroy( &b.lock );
+    pthread_cond_destroy( &b.wake );
+    free( line );
+    free( params );
+    free( costs );
+    free( t.s );
+    return res;
+}
@@ -0,0 +1,104 @@
+/**
+ *
+ *   @file farm.h
+ *
+ *****************************************************************
+ *
+ *   master-worker evaluation of parameter sets over TCP
+ *
+ *   The optimizer (the master) listens on a TCP port; workers
+ *   (fly_worker) connect to it, load the problem once and then
+ *   score the batches of parameter vectors the master sends.
+ *   Workers may come and go at any time: a worker that closes
+ *   its connection, misses its heartbeats for FARM_TIMEOUT
+ *   seconds or doesn't take what the master sends within
+ *   FARM_TIMEOUT seconds is dropped and its batch goes to the
+ *   others. The batch sizes follow the speed of each worker, so
+ *   that every batch takes about FARM_BATCH_TIME seconds, and
+ *   get smaller towards the end of a set. The master scores parameter sets
+ *   itself while it waits, and all of them if no worker is
+ *   connected. No MPI or broker is needed; all workers may run
+ *   on localhost.
+ *
+ *   The protocol is line based text, numbers are printed with
+ *   17 significant digits, so costs arrive bit for bit:
+ *
+ *     master -> worker   farm <version> <nparams> <config>
+ *     worker -> master   ready <nparams>
+ *     master -> worker   score <id> <n>, then n lines of nparams numbers
+ *     worker -> master   cost <id> <n> <cost>...
+ *     worker -> master   alive (every FARM_HEARTBEAT seconds)
+ *     master -> worker   quit
+ *
+ *   A worker answers a farm line it can't set up with
+ *   'error <why>' and disconnects.
+ *
+ *****************************************************************/
+
+#ifndef FARM_INCLUDED
+#define FARM_INCLUDED
+
+#include <stdio.h>
+
+/* bump this whenever the protocol changes */
+#define FARM_VERSION    2
+/* seconds between the heartbeats of a worker */
+#define FARM_HEARTBEAT  2
+/* seconds without a message, or blocked in a send to it, after which *
+ * a worker counts as lost                                            */
+#define FARM_TIMEOUT    20
+/* seconds of work per batch the master aims at */
+#define FARM_BATCH_TIME 0.5
+
+/** Farm: the master side, see OpenFarm() */
+typedef struct Farm Farm;
+
+/** FarmScore: scores the parameter vector 'params' on the master */
+typedef double ( *FarmScore ) ( const double *params, void *arg );
+
+/** FarmSetup: sets up a worker for the 'config' string of the master;
+ *              returns the number of parameters, or -1 with the reason
+ *              in 'why' (of 'len' chars)
+ */
+typedef int ( *FarmSetup ) ( const char *config, void *arg, char *why, int len );
+
+/** FarmBatch: scores 'n' parameter vectors stored one after the other
+ *              in 'params' into 'costs' on a worker
+ */
+typedef void ( *FarmBatch ) ( const double *params, int n, double *costs, void *arg );
+
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+/** OpenFarm: listens for workers on TCP 'port' (all interfaces); every
+ *             worker gets 'config' (one line, no newline) to set itself
+ *             up for parameter vectors of 'nparams' doubles
+ */
+Farm *OpenFarm( int port, int nparams, const char *config );
+
+/** FarmEvaluate: scores the 'n' parameter vectors 'params' into 'costs'
+ *                 with the workers; 'local' (if not NULL) scores on the
+ *                 master while it waits and when no worker is there;
+ *                 returns the number of vectors scored by 'local'
+ */
+int FarmEvaluate( Farm * f, double **params, int n, double *costs, FarmScore local, void *arg );
+
+/** FarmWorkers: number of workers that are ready */
+int FarmWorkers( Farm * f );
+
+/** CloseFarm: tells the workers to quit, prints what the farm did to
+ *              'fp' (if not NULL) and frees everything
+ */
+void CloseFarm( Farm * f, FILE * fp );
+
+/** FarmWork: the worker side; connects to 'host':'port' (retrying for
+ *             a while if the master isn't up yet), sets up with 'setup'
+ *             and scores batches with 'batch' until the master says
+ *             quit or goes away; 'die_after' > 0 makes the worker exit
+ *             without answering its die_after-th batch (for testing the
+ *             resubmission of lost work). Returns 0 after quit, -1 if
+ *             the connection failed or broke.
+ */
+int FarmWork( const char *host, int port, FarmSetup setup, FarmBatch batch, void *arg, int die_after );
+
+#endif
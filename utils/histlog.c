@@ -0,0 +1,266 @@
+/**
+ *
+ *   @file histlog.c
+ *
+ *****************************************************************
+ *
+ *   binary history logs of the optimizers
+ *
+ *   The ring buffer has exactly one producer (the optimizer,
+ *   which moves 'head') and one consumer (the writer thread,
+ *   which moves 'tail'), so the records need no locks: each
+ *   side only publishes its own index with release semantics
+ *   and reads the other one with acquire semantics. A side
+ *   that has to wait for the other one (the writer for records,
+ *   the optimizer for room in a full ring or for the writer to
+ *   catch up) sleeps on a condition variable instead. The
+ *   optimizer only takes the lock to wake the writer if the
+ *   writer has said it is going to sleep; both sides store
+ *   their flag or index before they read the other one's
+ *   (sequentially consistent), so a wakeup cannot get lost.
+ *   The writer takes the lock once per batch of records.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "error.h"
+#include "histlog.h"
+
+
+/* size of the stdio buffer of the writer */
+#define HISTLOG_FILEBUF (1 << 20)
+
+/** HistLogThread: the writer thread and what the two sides wait on */
+typedef struct HistLogThread {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t more;        /* new records or closing, for the writer */
+    pthread_cond_t room;        /* records written, for the optimizer */
+    int sleeping;               /* writer waits (or is about to) on 'more' */
+    int failed;                 /* errno of a failed write, 0 if none */
+} HistLogThread;
+
+
+/*** WRITER THREAD *********************************************************/
+
+/** HistLogWriter: writes records from the ring buffer to the file until
+ *                  the log is closed and the ring is empty
+ */
+static void *
+HistLogWriter( void *arg ) {
+    HistLog *h = ( HistLog * ) arg;
+    HistLogThread *w = ( HistLogThread * ) h->writer;
+    unsigned long head, tail = h->tail;
+
+    for( ;; ) {
+        head = __atomic_load_n( &h->head, __ATOMIC_ACQUIRE );
+        if( tail == head ) {
+            pthread_mutex_lock( &w->lock );
+            __atomic_store_n( &w->sleeping, 1, __ATOMIC_SEQ_CST );
+            while( tail == ( head = __atomic_load_n( &h->head, __ATOMIC_SEQ_CST ) ) && !h->closing )
+                pthread_cond_wait( &w->more, &w->lock );
+            __atomic_store_n( &w->sleeping, 0, __ATOMIC_RELAXED );
+            pthread_mutex_unlock( &w->lock );
+            if( tail == head )
+                break;          /* closing, and everything is written */
+        }
+
+        /* after a failed write the records are dropped, the optimizer  *
+         * stops at its next HistLogWrite() (see HistLogCheck())        */
+        for( ; tail != head; tail++ )
+            if( !w->failed && fwrite( h->ring + ( tail % HISTLOG_RING ) * h->reclen, sizeof( double ), h->reclen, h->fp ) != ( size_t ) h->reclen )
+                __atomic_store_n( &w->failed, errno ? errno : EIO, __ATOMIC_RELEASE );
+
+        pthread_mutex_lock( &w->lock );
+        __atomic_store_n( &h->tail, tail, __ATOMIC_RELEASE );
+        pthread_cond_broadcast( &w->room );
+        pthread_mutex_unlock( &w->lock );
+    }
+    return NULL;
+}
+
+/** HistLogWait: waits until the writer has left at most 'left' records
+ *                in the ring
+ */
+static void
+HistLogWait( HistLog * h, unsigned long left ) {
+    HistLogThread *w = ( HistLogThread * ) h->writer;
+
+    if( h->head - __atomic_load_n( &h->tail, __ATOMIC_ACQUIRE ) <= left )
+        return;
+    pthread_mutex_lock( &w->lock );
+    while( h->head - __atomic_load_n( &h->tail, __ATOMIC_ACQUIRE ) > left )
+        pthread_cond_wait( &w->room, &w->lock );
+    pthread_mutex_unlock( &w->lock );
+}
+
+
+/** HistLogCheck: stops with an error if the writer could not write */
+static void
+HistLogCheck( HistLog * h, const char *func ) {
+    HistLogThread *w = ( HistLogThread * ) h->writer;
+    int failed = __atomic_load_n( &w->failed, __ATOMIC_ACQUIRE );
+
+    if( failed )
+        error( "%s: could not write to %s: %s", func, h->fname, strerror( failed ) );
+}
+
+
+/*** LOG FUNCTIONS *********************************************************/
+
+/** OpenHistLog: opens a history log and starts its writer thread */
+HistLog *
+OpenHistLog( const char *fname, int nparams, int append ) {
+    HistLog *h;
+    HistLogHeader hdr;
+    HistLogThread *w;
+    long length;
+
+    if( !( h = ( HistLog * ) calloc( 1, sizeof( HistLog ) ) ) )
+        error( "OpenHistLog: could not allocate history log" );
+
+    h->fname = strdup( fname );
+    h->nparams = nparams;
+    h->reclen = nparams + 2;
+
+    h->fp = NULL;
+    if( append )
+        h->fp = fopen( fname, "r+b" );
+
+    if( h->fp ) {
+        setvbuf( h->fp, NULL, _IOFBF, HISTLOG_FILEBUF );
+        /* continue an existing log */
+        if( ReadHistLogHeader( h->fp, fname ) != nparams )
+            error( "OpenHistLog: %s has records of a different size", fname );
+        fseek( h->fp, 0, SEEK_END );
+        length = ftell( h->fp );
+        h->nrecords = ( length - ( long ) sizeof( HistLogHeader ) ) / ( h->reclen * ( long ) sizeof( double ) );
+    } else {
+        if( !( h->fp = fopen( fname, "w+b" ) ) )
+            file_error( "OpenHistLog" );
+        setvbuf( h->fp, NULL, _IOFBF, HISTLOG_FILEBUF );
+        memset( &hdr, 0, sizeof( hdr ) );
+        memcpy( hdr.magic, HISTLOG_MAGIC, sizeof( hdr.magic ) );
+        hdr.version = HISTLOG_VERSION;
+        hdr.nparams = nparams;
+        if( fwrite( &hdr, sizeof( hdr ), 1, h->fp ) != 1 )
+            file_error( "OpenHistLog" );
+        h->nrecords = 0;
+    }
+
+    if( !( h->ring = ( double * ) malloc( HISTLOG_RING * h->reclen * sizeof( double ) ) ) )
+        error( "OpenHistLog: could not allocate ring buffer" );
+
+    if( !( w = ( HistLogThread * ) malloc( sizeof( HistLogThread ) ) ) )
+        error( "OpenHistLog: could not allocate writer thread" );
+    pthread_mutex_init( &w->lock, NULL );
+    pthread_cond_init( &w->more, NULL );
+    pthread_cond_init( &w->room, NULL );
+    w->sleeping = 0;
+    w->failed = 0;
+    h->writer = w;
+    if( pthread_create( &w->thread, NULL, HistLogWriter, h ) )
+        error( "OpenHistLog: could not start writer thread for %s", fname );
+
+    return h;
+}
+
+/** HistLogWrite: queues one record */
+void
+HistLogWrite( HistLog * h, int iter, const double *params, double cost ) {
+    HistLogThread *w = ( HistLogThread * ) h->writer;
+    double *slot;
+
+    HistLogCheck( h, "HistLogWrite" );
+
+    /* ring is full: let the writer catch up, never drop records */
+    HistLogWait( h, HISTLOG_RING - 1 );
+
+    slot = h->ring + ( h->head % HISTLOG_RING ) * h->reclen;
+    slot[0] = ( double ) iter;
+    memcpy( slot + 1, params, h->nparams * sizeof( double ) );
+    slot[h->reclen - 1] = cost;
+
+    __atomic_store_n( &h->head, h->head + 1, __ATOMIC_SEQ_CST );
+    if( __atomic_load_n( &w->sleeping, __ATOMIC_SEQ_CST ) ) {
+        pthread_mutex_lock( &w->lock );
+        pthread_cond_signal( &w->more );
+        pthread_mutex_unlock( &w->lock );
+    }
+    h->nrecords++;
+}
+
+/** HistLogSync: waits until all queued records are written and flushed */
+void
+HistLogSync( HistLog * h ) {
+    HistLogWait( h, 0 );
+    HistLogCheck( h, "HistLogSync" );
+    if( fflush( h->fp ) )
+        error( "HistLogSync: could not write to %s: %s", h->fname, strerror( errno ) );
+}
+
+/** HistLogOffset: returns the file length after all queued records */
+long
+HistLogOffset( HistLog * h ) {
+    return ( long ) sizeof( HistLogHeader ) + h->nrecords * h->reclen * ( long ) sizeof( double );
+}
+
+/** HistLogTruncate: cuts the log back to 'offset' bytes */
+void
+HistLogTruncate( HistLog * h, long offset ) {
+    HistLogSync( h );
+    if( offset > HistLogOffset( h ) ) {
+        warning( "HistLogTruncate: %s is shorter than at checkpoint time", h->fname );
+        return;
+    }
+    if( ftruncate( fileno( h->fp ), ( off_t ) offset ) )
+        file_error( "HistLogTruncate" );
+    fseek( h->fp, 0, SEEK_END );
+    h->nrecords = ( offset - ( long ) sizeof( HistLogHeader ) ) / ( h->reclen * ( long ) sizeof( double ) );
+}
+
+/** CloseHistLog: writes all queued records and closes the log */
+void
+CloseHistLog( HistLog * h ) {
+    HistLogThread *w = ( HistLogThread * ) h->writer;
+
+    pthread_mutex_lock( &w->lock );
+    h->closing = 1;
+    pthread_cond_signal( &w->more );
+    pthread_mutex_unlock( &w->lock );
+    pthread_join( w->thread, NULL );
+    HistLogCheck( h, "CloseHistLog" );
+    if( fclose( h->fp ) )
+        error( "CloseHistLog: could not write to %s: %s", h->fname, strerror( errno ) );
+
+    pthread_mutex_destroy( &w->lock );
+    pthread_cond_destroy( &w->more );
+    pthread_cond_destroy( &w->room );
+    free( w );
+    free( h->ring );
+    free( h->fname );
+    free( h );
+}
+
+/** ReadHistLogHeader: reads and checks the header of a history log */
+int
+ReadHistLogHeader( FILE * fp, const char *fname ) {
+    HistLogHeader hdr;
+
+    rewind( fp );
+    if( fread( &hdr, sizeof( hdr ), 1, fp ) != 1 )
+        error( "ReadHistLogHeader: %s is too short for a history log", fname );
+    if( strncmp( hdr.magic, HISTLOG_MAGIC, sizeof( hdr.magic ) ) )
+        error( "ReadHistLogHeader: %s is not a history log", fname );
+    if( hdr.version != HISTLOG_VERSION )
+        error( "ReadHistLogHeader: %s has format version %d, expected %d", fname, hdr.version, HISTLOG_VERSION );
+    return hdr.nparams;
+}
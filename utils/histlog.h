@@ -0,0 +1,95 @@
+/**
+ *
+ *   @file histlog.h
+ *
+ *****************************************************************
+ *
+ *   binary history logs of the optimizers
+ *
+ *   A history log is a fixed header followed by records of
+ *   float64 values: the iteration, the parameters and the
+ *   cost of one individual. Records are put into a lock-free
+ *   single-producer/single-consumer ring buffer by the
+ *   optimizer and written to disk by a background thread, so
+ *   logging does not stall the optimizer on slow file systems;
+ *   a lock is only taken when one side has to wake the other.
+ *   A failed write stops the optimizer at its next record.
+ *   histlog2txt converts a log to the tab-separated text format
+ *   written by write_set()/write_Set().
+ *
+ *****************************************************************/
+
+#ifndef HISTLOG_INCLUDED
+#define HISTLOG_INCLUDED
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* magic string at the start of every history log */
+#define HISTLOG_MAGIC   "FLYHIST"
+/* bump this whenever the layout of a history log changes */
+#define HISTLOG_VERSION 1
+/* number of records the ring buffer can hold */
+#define HISTLOG_RING    4096
+
+/** HistLogHeader: the fixed header of a history log file */
+typedef struct HistLogHeader {
+    char magic[8];
+    int version;
+    int nparams;                /* number of parameters per record */
+} HistLogHeader;
+
+/** HistLog: an open history log; a record is
+ *            iteration, nparams parameters, cost
+ */
+typedef struct HistLog {
+    FILE *fp;
+    char *fname;
+    int nparams;
+    int reclen;                 /* doubles per record: nparams + 2 */
+    long nrecords;              /* records in the file, including queued ones */
+
+    double *ring;               /* HISTLOG_RING records */
+    unsigned long head;         /* next slot to fill, owned by the optimizer */
+    unsigned long tail;         /* next slot to write, owned by the writer */
+    int closing;
+
+    void *writer;               /* background writer thread and its lock */
+} HistLog;
+
+
+/*** FUNCTION PROTOTYPES ***************************************************/
+
+/** OpenHistLog: opens a history log for records of 'nparams' parameters
+ *                and starts its writer thread; if 'append' is set, an
+ *                existing log is continued (its header must match)
+ */
+HistLog *OpenHistLog( const char *fname, int nparams, int append );
+
+/** HistLogWrite: queues one record; only blocks if the ring buffer is
+ *                 full, records are never dropped
+ */
+void HistLogWrite( HistLog * h, int iter, const double *params, double cost );
+
+/** HistLogSync: waits until all queued records are written and flushed */
+void HistLogSync( HistLog * h );
+
+/** HistLogOffset: returns the file length after all queued records */
+long HistLogOffset( HistLog * h );
+
+/** HistLogTruncate: cuts the log back to 'offset' bytes, as returned by
+ *                    HistLogOffset(); used when resuming a run
+ */
+void HistLogTruncate( HistLog * h, long offset );
+
+/** CloseHistLog: writes all queued records, stops the writer thread and
+ *                 closes the file
+ */
+void CloseHistLog( HistLog * h );
+
+/** ReadHistLogHeader: reads and checks the header of a history log;
+ *                      returns the number of parameters per record
+ */
+int ReadHistLogHeader( FILE * fp, const char *fname );
+
+#endif
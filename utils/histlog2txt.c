@@ -0,0 +1,63 @@
+/**
+ * @file histlog2txt.c
+ * Converts a binary history log (see histlog.h) of fly_ss or fly_ess to
+ * the tab-separated text format the optimizers used to write directly:
+ * iteration, parameters with 5 decimals and the cost, one individual
+ * per line.
+ *
+ * USAGE:
+ *  histlog2txt <history_log> [<text_file>]
+ *
+ * Without <text_file> the text goes to stdout.
+ **************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <float.h>
+#include "error.h"
+#include "histlog.h"
+
+
+// GLOBAL CONSTANTS (needed by error.c)
+
+const int MAX_PRECISION = 16;
+const double FORBIDDEN_MOVE = DBL_MAX;
+const int OUT_OF_BOUND = -1;
+
+static const char usage[] = "Usage: histlog2txt <history_log> [<text_file>]\n";
+
+int
+main( int argc, char **argv ) {
+
+    FILE *in;
+    FILE *out = stdout;
+    double *rec;
+    int nparams;
+    int i;
+
+    if( argc < 2 || argc > 3 )
+        PrintMsg( usage, 1 );
+
+    if( !( in = fopen( argv[1], "rb" ) ) )
+        file_error( "histlog2txt" );
+    if( argc == 3 && !( out = fopen( argv[2], "w" ) ) )
+        file_error( "histlog2txt" );
+
+    nparams = ReadHistLogHeader( in, argv[1] );
+    rec = ( double * ) malloc( ( nparams + 2 ) * sizeof( double ) );
+
+    /* a partial record at the end (killed run) is silently dropped */
+    while( fread( rec, sizeof( double ), nparams + 2, in ) == ( size_t ) ( nparams + 2 ) ) {
+        if( ( int ) rec[0] != -1 )
+            fprintf( out, "%d\t", ( int ) rec[0] );
+        for( i = 1; i <= nparams; i++ )
+            fprintf( out, "%.5lf\t", rec[i] );
+        fprintf( out, "%lf\n", rec[nparams + 1] );
+    }
+
+    free( rec );
+    fclose( in );
+    if( out != stdout )
+        fclose( out );
+    return 0;
+}
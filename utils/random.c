@@ -18,6 +18,7 @@
  *                                                               
  */
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <dSFMT.h>
 #include <dSFMT_str_state.h>
@@ -30,6 +31,55 @@
 
 static dsfmt_t dsfmt;
 
+/* the key of the random streams */
+static unsigned int stream_seed = 0;
+
+
+/*** PHILOX ****************************************************************/
+
+/* multipliers and key increments of Philox4x32 (Salmon et al., SC 2011) */
+#define PHILOX_M0 0xD2511F53U
+#define PHILOX_M1 0xCD9E8D57U
+#define PHILOX_W0 0x9E3779B9U
+#define PHILOX_W1 0xBB67AE85U
+#define PHILOX_ROUNDS 10
+
+/** Philox: encrypts counter 'ctr' with 'key' into 'out' */
+static void
+Philox( const unsigned int *key, const unsigned int *ctr, unsigned int *out ) {
+    unsigned int k0 = key[0], k1 = key[1];
+    unsigned int c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    unsigned long long p0, p1;
+    int r;
+
+    for( r = 0; r < PHILOX_ROUNDS; r++ ) {
+        p0 = ( unsigned long long ) PHILOX_M0 * c0;
+        p1 = ( unsigned long long ) PHILOX_M1 * c2;
+        c0 = ( unsigned int ) ( p1 >> 32 ) ^ c1 ^ k0;
+        c2 = ( unsigned int ) ( p0 >> 32 ) ^ c3 ^ k1;
+        c1 = ( unsigned int ) p1;
+        c3 = ( unsigned int ) p0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+/** NextWord: returns the next random word of stream 's' */
+static unsigned int
+NextWord( RandStream * s ) {
+    if( s->pos == 4 ) {
+        if( !++s->ctr[0] )
+            ++s->ctr[1];
+        Philox( s->key, s->ctr, s->out );
+        s->pos = 0;
+    }
+    return s->out[s->pos++];
+}
+
 /*** RANDOM NUMBER FUNCTIONS ***********************************************/
 
 /** InitRand: initializes dSFMT random number generator by making seed 
@@ -38,6 +88,7 @@ static dsfmt_t dsfmt;
 void
 InitRand( int seed ) {
     dsfmt_init_gen_rand(&dsfmt, seed);
+    stream_seed = ( unsigned int ) seed;
 }
 
 /** RestoreRand: restores dSFMT random number generator state by making seed 
@@ -80,3 +131,70 @@ GetDSFMTState( void ) {
     p = dsfmt_state_to_str(&dsfmt, prefix);
     return p;
 }
+
+/** GetStreamSeed, SetStreamSeed: the seed the random streams are keyed
+ *                                 with
+ */
+unsigned int
+GetStreamSeed( void ) {
+    return stream_seed;
+}
+
+void
+SetStreamSeed( unsigned int seed ) {
+    stream_seed = seed;
+}
+
+
+/*** RANDOM STREAMS ********************************************************/
+
+/** InitStream: starts stream (kind, iteration, index) */
+void
+InitStream( RandStream * s, unsigned int kind, unsigned int iteration, unsigned int index ) {
+    s->key[0] = stream_seed;
+    s->key[1] = kind;
+    s->ctr[0] = 0;
+    s->ctr[1] = 0;
+    s->ctr[2] = index;
+    s->ctr[3] = iteration;
+    Philox( s->key, s->ctr, s->out );
+    s->pos = 0;
+}
+
+/** StreamReal: returns the next random real number in [0, 1) of 's' */
+double
+StreamReal( RandStream * s ) {
+    unsigned int a = NextWord( s ) >> 5;        /* 27 bits */
+    unsigned int b = NextWord( s ) >> 6;        /* 26 bits */
+
+    return ( a * 67108864.0 + b ) * ( 1.0 / 9007199254740992.0 );
+}
+
+/** StreamInt: returns the next random integer between 0 and max of 's' */
+int
+StreamInt( RandStream * s, int max ) {
+    return ( ( int ) ( StreamReal( s ) * max ) ) % max;
+}
+
+/** GetStreamState: returns the state of stream 's' as a string */
+char *
+GetStreamState( const RandStream * s ) {
+    char *p = ( char * ) malloc( 128 );
+
+    if( p )
+        sprintf( p, "philox %u %u %u %u %u %u %d", s->key[0], s->key[1], s->ctr[0], s->ctr[1], s->ctr[2], s->ctr[3], s->pos );
+    return p;
+}
+
+/** RestoreStream: sets stream 's' to 'state' from GetStreamState() */
+int
+RestoreStream( RandStream * s, const char *state ) {
+    RandStream t;
+
+    if( sscanf( state, "philox %u %u %u %u %u %u %d", &t.key[0], &t.key[1], &t.ctr[0], &t.ctr[1], &t.ctr[2], &t.ctr[3], &t.pos ) != 7
+        || t.pos < 0 || t.pos > 4 )
+        return -1;
+    Philox( t.key, t.ctr, t.out );
+    *s = t;
+    return 0;
+}
@@ -11,11 +11,27 @@
  *   functions for initializing and running dSFMT() random     
  *   number generator                                            
  *                                                               
+ *   Besides the one sequential dSFMT generator there are random  
+ *   streams: Philox4x32-10 counter based generators keyed by the 
+ *   seed of InitRand(), a kind, an iteration and an index. The   
+ *   numbers of a stream only depend on these, not on what was    
+ *   drawn before or elsewhere, so work that draws from its own   
+ *   stream gives the same results in any order or on any number  
+ *   of threads.                                                  
+ *                                                               
  *****************************************************************/
 
 #ifndef RANDOM_INCLUDED
 #define RANDOM_INCLUDED
 
+/** RandStream: state of a random stream, see InitStream() */
+typedef struct RandStream {
+    unsigned int key[2];        /* seed and kind */
+    unsigned int ctr[4];        /* block number (2 words), index, iteration */
+    unsigned int out[4];        /* current block of random words */
+    int pos;                    /* next unused word of 'out' */
+} RandStream;
+
 
 /*** FUNCTION PROTOTYPES ***************************************************/
 
@@ -45,4 +61,31 @@ int RandomInt( int max );
  */
 char *GetDSFMTState( void );
 
+/** GetStreamSeed, SetStreamSeed: the seed the random streams are keyed
+ *                                 with (set by InitRand()); used for
+ *                                 saving it next to the dSFMT state
+ */
+unsigned int GetStreamSeed( void );
+void SetStreamSeed( unsigned int seed );
+
+/** InitStream: starts stream (kind, iteration, index); different kinds
+ *               keep the streams of different uses apart
+ */
+void InitStream( RandStream * s, unsigned int kind, unsigned int iteration, unsigned int index );
+
+/** StreamReal: returns the next random real number in [0, 1) of stream
+ *               's', with 53 random bits
+ */
+double StreamReal( RandStream * s );
+
+/** StreamInt: returns the next random integer between 0 and max of 's' */
+int StreamInt( RandStream * s, int max );
+
+/** GetStreamState: returns the state of stream 's' as a string (to be 
+ *                   freed), RestoreStream() sets a stream back to it;    
+ *                   returns -1 if 'state' is no stream state            
+ */
+char *GetStreamState( const RandStream * s );
+int RestoreStream( RandStream * s, const char *state );
+
 #endif